@@ -27,13 +27,18 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "tensorrt/laboratory/core/profiler.h"
 #include "tensorrt/laboratory/core/thread_pool.h"
 #include "tensorrt/laboratory/infer_bench.h"
 #include "tensorrt/laboratory/inference_manager.h"
 #include "tensorrt/laboratory/model.h"
+#include "tensorrt/laboratory/model_repository.h"
 #include "tensorrt/laboratory/runtime.h"
 
 #ifdef PLAYGROUND_USE_MPI
@@ -48,7 +53,7 @@ using trtlab::TensorRT::InferBench;
 using trtlab::TensorRT::InferBenchKey;
 using trtlab::TensorRT::InferenceManager;
 using trtlab::TensorRT::ManagedRuntime;
-using trtlab::TensorRT::Model;
+using trtlab::TensorRT::ModelRepository;
 using trtlab::TensorRT::Runtime;
 using trtlab::TensorRT::StandardRuntime;
 
@@ -67,6 +72,7 @@ static bool ValidateEngine(const char* flagname, const std::string& value)
 
 DEFINE_string(engine, "/path/to/tensorrt.engine", "TensorRT serialized engine");
 DEFINE_validator(engine, &ValidateEngine);
+DEFINE_string(repository, "", "Model repository; benchmarks the latest version of each model");
 DEFINE_string(runtime, "default", "TensorRT Runtime");
 DEFINE_int32(seconds, 5, "Approximate number of seconds for the timing loop");
 DEFINE_int32(contexts, 1, "Number of Execution Contexts");
@@ -75,6 +81,9 @@ DEFINE_int32(cudathreads, 1, "Number Cuda Launcher Threads");
 DEFINE_int32(respthreads, 1, "Number Response Sync Threads");
 DEFINE_int32(replicas, 1, "Number of Replicas of the Model to load");
 DEFINE_int32(batch_size, 0, "Overrides the max batch_size of the provided engine");
+DEFINE_int32(concurrency, 0, "Max requests in flight (default: limited by buffers)");
+DEFINE_string(json, "", "Write the benchmark results as JSON to this file");
+DEFINE_string(trace, "", "Write a Chrome trace of the timed loop to this file");
 
 int main(int argc, char* argv[])
 {
@@ -107,15 +116,37 @@ int main(int argc, char* argv[])
         LOG(FATAL) << "Invalid TensorRT Runtime";
     }
 
-    std::vector<std::shared_ptr<Model>> models;
+    InferBench::ModelsList models;
+    std::unique_ptr<ModelRepository> repository;
 
-    models.push_back(runtime->DeserializeEngine(FLAGS_engine));
-    resources->RegisterModel("0", models.back());
+    if(!FLAGS_repository.empty())
+    {
+        repository = std::make_unique<ModelRepository>(FLAGS_repository, resources, runtime);
+        repository->Poll();
+        for(const auto& name : repository->Models())
+        {
+            models.push_back(repository->GetModel(name));
+        }
+        CHECK(!models.empty()) << "No models found in " << FLAGS_repository;
+    }
+    else
+    {
+        models.push_back(runtime->DeserializeEngine(FLAGS_engine));
+        resources->RegisterModel("0", models.back());
+    }
     resources->AllocateResources();
 
-    auto batch_size = FLAGS_batch_size ? FLAGS_batch_size : models.back()->GetMaxBatchSize();
+    auto batch_size = FLAGS_batch_size;
+    if(!batch_size)
+    {
+        batch_size = models.back()->GetMaxBatchSize();
+        for(const auto& model : models)
+        {
+            batch_size = std::min(batch_size, model->GetMaxBatchSize());
+        }
+    }
 
-    for(int i = 1; i < FLAGS_replicas; i++)
+    for(int i = 1; i < FLAGS_replicas && !repository; i++)
     {
         models.push_back(runtime->DeserializeEngine(FLAGS_engine));
         resources->RegisterModel(ModelName(i), models.back());
@@ -127,7 +158,9 @@ int main(int argc, char* argv[])
 
         // if testing mps - sync all processes before executing timed loop
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
-        auto results = benchmark.Run(models, batch_size, FLAGS_seconds);
+        trtlab::Profiler::Enable(!FLAGS_trace.empty());
+        auto results = benchmark.Run(models, batch_size, FLAGS_seconds, 0.0, FLAGS_concurrency);
+        trtlab::Profiler::Enable(false);
         MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
         // todo: perform an mpi_allreduce to collect the per process timings
         //       for a simplified report
@@ -141,6 +174,20 @@ int main(int argc, char* argv[])
                   << "; inf/sec: " << (*results)[kInferencesPerSecond]
                   << "; batches/sec: " << (*results)[kBatchesPerSecond]
                   << "; execution time per batch: " << (*results)[kExecutionTimePerBatch];
+        LOG(INFO) << "Latency (seconds): p50: " << (*results)[kLatencyP50]
+                  << "; p90: " << (*results)[kLatencyP90] << "; p99: " << (*results)[kLatencyP99]
+                  << "; p99.9: " << (*results)[kLatencyP999]
+                  << "; max: " << (*results)[kLatencyMax];
+
+        if(!FLAGS_json.empty())
+        {
+            std::ofstream json(FLAGS_json);
+            json << InferBench::ToJSON(*results) << std::endl;
+        }
+        if(!FLAGS_trace.empty())
+        {
+            trtlab::Profiler::WriteChromeTrace(FLAGS_trace);
+        }
     }
 
     return 0;
@@ -115,7 +115,7 @@ class Inference final
 
             // This thread only async copies buffers H2D
             auto model = GetResources()->GetModel(ModelName(replica++));
-            auto buffers = GetResources()->GetBuffers(); // <=== Limited Resource; May Block !!!
+            auto buffers = GetResources()->GetBuffers(model); // <=== Limited Resource; May Block!!
             auto bindings = buffers->CreateBindings(model);
             auto promise = std::make_shared<std::promise<void>>();
             futures.push_back(promise->get_future());
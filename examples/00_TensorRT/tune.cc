@@ -0,0 +1,117 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fstream>
+#include <sstream>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/auto_tuner.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/runtime.h"
+
+using trtlab::TensorRT::AutoTuner;
+using trtlab::TensorRT::DenseModel;
+using trtlab::TensorRT::Runtime;
+using trtlab::TensorRT::StandardRuntime;
+using trtlab::TensorRT::TuningOptions;
+using trtlab::TensorRT::TuningSpace;
+
+template<typename T>
+static std::vector<T> ParseList(const std::string& values)
+{
+    std::vector<T> list;
+    std::istringstream stream(values);
+    std::string value;
+    while(std::getline(stream, value, ','))
+    {
+        list.push_back(static_cast<T>(std::stoul(value)));
+    }
+    return list;
+}
+
+DEFINE_string(engine, "", "TensorRT serialized engine (default: a DenseModel on the CPU)");
+DEFINE_int32(dense_batch_size, 32, "Max batch size of the DenseModel stand-in");
+DEFINE_int32(dense_inputs, 1024, "Inputs of the DenseModel stand-in");
+DEFINE_int32(dense_outputs, 256, "Outputs of the DenseModel stand-in");
+DEFINE_double(slo_ms, 10.0, "p99 latency SLO in milliseconds");
+DEFINE_double(seconds, 1.0, "Approximate number of seconds per trial");
+DEFINE_int32(concurrency, 16, "Max requests in flight");
+DEFINE_string(executions, "1,2,4", "Execution Contexts to search");
+DEFINE_string(buffers, "0", "Buffers to search; 0 is 2x contexts");
+DEFINE_string(batch_sizes, "", "Batch sizes to search (default: powers of 2 up to the max)");
+DEFINE_string(pre_threads, "1,2,4", "Pre-processing threads to search");
+DEFINE_string(post_threads, "1,2", "Post-processing threads to search");
+DEFINE_string(json, "", "Write the best configuration as JSON to this file");
+
+int main(int argc, char* argv[])
+{
+    FLAGS_alsologtostderr = 1; // Log to console
+    ::google::InitGoogleLogging("TensorRT Tuner");
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+
+    AutoTuner::ModelFactory factory;
+    if(FLAGS_engine.empty())
+    {
+        factory = [] {
+            return std::make_shared<DenseModel>(FLAGS_dense_batch_size, FLAGS_dense_inputs,
+                                                FLAGS_dense_outputs);
+        };
+    }
+    else
+    {
+        std::shared_ptr<Runtime> runtime = std::make_shared<StandardRuntime>();
+        factory = [runtime] { return runtime->DeserializeEngine(FLAGS_engine); };
+    }
+
+    TuningSpace space;
+    space.executions = ParseList<int>(FLAGS_executions);
+    space.buffers = ParseList<int>(FLAGS_buffers);
+    space.batch_sizes = ParseList<uint32_t>(FLAGS_batch_sizes);
+    space.pre_threads = ParseList<uint32_t>(FLAGS_pre_threads);
+    space.post_threads = ParseList<uint32_t>(FLAGS_post_threads);
+
+    TuningOptions options;
+    options.latency_slo = FLAGS_slo_ms / 1000.0;
+    options.seconds = FLAGS_seconds;
+    options.concurrency = FLAGS_concurrency;
+
+    AutoTuner tuner(factory, space, options);
+    auto best = tuner.Run();
+    if(!best)
+    {
+        LOG(ERROR) << "No configuration meets the " << FLAGS_slo_ms << " ms SLO";
+        return 1;
+    }
+
+    if(!FLAGS_json.empty())
+    {
+        std::ofstream json(FLAGS_json);
+        json << AutoTuner::ToJSON(*best) << std::endl;
+    }
+    return 0;
+}
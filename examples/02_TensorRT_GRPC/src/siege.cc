@@ -57,6 +57,7 @@
 #include <thread>
 
 #include "inference.grpc.pb.h"
+#include "nvrpc/client/flow_controller.h"
 
 #include "tensorrt/laboratory/core/utils.h"
 
@@ -65,6 +66,8 @@ using grpc::ClientAsyncResponseReader;
 using grpc::ClientContext;
 using grpc::CompletionQueue;
 using grpc::Status;
+using nvrpc::client::FlowControlPolicy;
+using nvrpc::client::FlowController;
 using ssd::BatchInput;
 using ssd::BatchPredictions;
 using ssd::Inference;
@@ -74,9 +77,8 @@ static int g_BatchSize = 1;
 class GreeterClient
 {
   public:
-    explicit GreeterClient(std::shared_ptr<Channel> channel, int max_outstanding)
-        : stub_(Inference::NewStub(channel)), m_OutstandingMessageCount(0),
-          m_MaxOutstandingMessageCount(max_outstanding)
+    explicit GreeterClient(std::shared_ptr<Channel> channel, const FlowControlPolicy& policy)
+        : stub_(Inference::NewStub(channel)), m_FlowController(policy)
     {
     }
 
@@ -84,15 +86,12 @@ class GreeterClient
     void SayHello(const size_t batch_id, const int batch_size, char* bytes, uint64_t total)
     {
         // Data we are sending to the server.
+        if(!m_FlowController.TryAcquire())
         {
-            std::unique_lock<std::mutex> lock(m_Mutex);
-            m_OutstandingMessageCount++;
-            while(m_OutstandingMessageCount >= m_MaxOutstandingMessageCount)
-            {
-                LOG_FIRST_N(WARNING, 10) << "Initiated Backoff - (Siege Rate > Server Compute "
-                                            "Rate) - Server Queues are full.";
-                m_Condition.wait(lock);
-            }
+            LOG_FIRST_N(WARNING, 10) << "Initiated Backoff - (Siege Rate > Server Compute "
+                                        "Rate) - Server Queues are full; window = "
+                                     << m_FlowController.Window();
+            m_FlowController.Acquire();
         }
 
         auto start = std::chrono::high_resolution_clock::now();
@@ -107,6 +106,7 @@ class GreeterClient
 
         // Call object to store rpc data
         AsyncClientCall* call = new AsyncClientCall;
+        call->start = std::chrono::steady_clock::now();
 
         // stub_->PrepareAsyncSayHello() creates an RPC object, returning
         // an instance to store in "call" but does not actually start the RPC
@@ -157,6 +157,8 @@ class GreeterClient
             {
                 std::cout << "RPC failed" << std::endl;
             }
+            m_FlowController.Release(std::chrono::steady_clock::now() - call->start, call->status);
+
             // Once we're complete, deallocate the call object.
             delete call;
 
@@ -166,16 +168,11 @@ class GreeterClient
             if(elapsed - last > 0.5)
             {
                 LOG(INFO) << "avg. rate: " << (float)cntr / (elapsed - last) << "( "
-                          << (float)(cntr * g_BatchSize) / (elapsed - last) << " inf/sec)";
+                          << (float)(cntr * g_BatchSize) / (elapsed - last)
+                          << " inf/sec); window: " << m_FlowController.Window();
                 last = elapsed;
                 cntr = 0;
             }
-
-            {
-                std::unique_lock<std::mutex> lock(m_Mutex);
-                m_OutstandingMessageCount--;
-            }
-            m_Condition.notify_one();
         }
     }
 
@@ -195,6 +192,9 @@ class GreeterClient
         // Storage for the status of the RPC upon completion.
         Status status;
 
+        // Time the call was sent; reported to the flow controller on completion.
+        std::chrono::steady_clock::time_point start;
+
         std::unique_ptr<ClientAsyncResponseReader<BatchPredictions>> response_reader;
     };
 
@@ -206,11 +206,8 @@ class GreeterClient
     // gRPC runtime.
     CompletionQueue cq_;
 
-    // mutex to help control rate
-    std::mutex m_Mutex;
-    std::condition_variable m_Condition;
-    int m_OutstandingMessageCount;
-    int m_MaxOutstandingMessageCount;
+    // bounds the number of outstanding requests
+    FlowController m_FlowController;
     float m_TotalRequestTime;
     size_t m_RequestCalls;
 };
@@ -224,6 +221,8 @@ static bool ValidateBytes(const char* flagname, const std::string& value)
 DEFINE_int32(count, 1000000, "number of grpc messages to send");
 DEFINE_int32(batch_size, 1, "batch_size");
 DEFINE_int32(max_outstanding, 950, "maximum outstanding requests");
+DEFINE_string(window, "fixed", "outstanding request window: fixed, aimd or gradient");
+DEFINE_int32(latency_target_us, 0, "aimd/gradient: shrink the window above this latency; 0 = off");
 DEFINE_int32(port, 50051, "server_port");
 DEFINE_double(rate, 1.0, "messages per second");
 DEFINE_double(max_rate, 100000, "maximum number of messages per second when func is applied");
@@ -280,11 +279,28 @@ int main(int argc, char** argv)
     std::ostringstream ip_port;
     ip_port << "localhost:" << FLAGS_port;
 
+    FlowControlPolicy policy;
+    policy.initial_window = FLAGS_max_outstanding;
+    policy.max_window = FLAGS_max_outstanding;
+    policy.latency_target = std::chrono::microseconds(FLAGS_latency_target_us);
+    if(FLAGS_window == "aimd")
+    {
+        policy.window = FlowControlPolicy::Window::AIMD;
+    }
+    else if(FLAGS_window == "gradient")
+    {
+        policy.window = FlowControlPolicy::Window::Gradient;
+    }
+    else if(FLAGS_window != "fixed")
+    {
+        LOG(FATAL) << "--window must be fixed, aimd or gradient; your value = " << FLAGS_window;
+    }
+
     grpc::ChannelArguments ch_args;
     ch_args.SetMaxReceiveMessageSize(-1);
     GreeterClient greeter(
         grpc::CreateCustomChannel(ip_port.str(), grpc::InsecureChannelCredentials(), ch_args),
-        FLAGS_max_outstanding);
+        policy);
 
     // Spawn reader thread that loops indefinitely
     std::thread thread_ = std::thread(&GreeterClient::AsyncCompleteRpc, &greeter);
@@ -28,6 +28,7 @@
 
 #include <future>
 #include <memory>
+#include <type_traits>
 
 namespace trtlab {
 
@@ -47,6 +48,32 @@ struct AsyncComputeWrapper<void(Args...)>
         using UserFn = ResultType(Args...);
         return std::make_shared<AsyncCompute<UserFn>>(f);
     }
+
+    /**
+     * @brief Wrap a function whose arguments are shared_ptrs that are reset after the call
+     *
+     * The arguments are released before the result is published, so the caller may release
+     * what they hold as soon as the future is ready.
+     */
+    template<typename F>
+    static auto WrapReleasing(F&& f)
+    {
+        using ResultType = typename std::result_of<F(Args...)>::type;
+        using UserFn = ResultType(Args...);
+        return std::make_shared<AsyncCompute<UserFn>>([f](Args... args) mutable -> ResultType {
+            if constexpr(std::is_void<ResultType>::value)
+            {
+                f(args...);
+                (args.reset(), ...);
+            }
+            else
+            {
+                ResultType result = f(args...);
+                (args.reset(), ...);
+                return result;
+            }
+        });
+    }
 };
 
 template<typename... Args>
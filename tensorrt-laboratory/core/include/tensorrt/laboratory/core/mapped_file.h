@@ -0,0 +1,85 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Read-only memory mapping of a file
+ *
+ * Pages are read from the page cache on first access instead of being copied into a private
+ * buffer, so mapping a file does not double its host memory footprint.  Advise passes access
+ * pattern hints to the kernel, e.g. WillNeed to start readahead of the whole file or DontNeed to
+ * drop the pages once the contents have been consumed.
+ */
+class MappedFile
+{
+  public:
+    enum class Advice
+    {
+        Normal,
+        Sequential,
+        Random,
+        WillNeed,
+        DontNeed
+    };
+
+    /**
+     * @brief Map the file; throws std::runtime_error if it can not be opened or mapped
+     */
+    MappedFile(const std::string& path, Advice advice = Advice::Sequential);
+    virtual ~MappedFile();
+
+    DELETE_COPYABILITY(MappedFile);
+    DELETE_MOVEABILITY(MappedFile);
+
+    const void* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+    const std::string& Path() const { return m_Path; }
+
+    /**
+     * @brief Apply an access pattern hint to the whole file
+     */
+    void Advise(Advice);
+
+    /**
+     * @brief Size of a file in bytes; throws std::runtime_error if it does not exist
+     */
+    static size_t FileSize(const std::string& path);
+
+  private:
+    std::string m_Path;
+    void* m_Data;
+    size_t m_Size;
+};
+
+} // namespace trtlab
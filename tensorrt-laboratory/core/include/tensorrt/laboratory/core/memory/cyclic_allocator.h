@@ -158,7 +158,9 @@ class CyclicAllocator
             m_CurrentSegment.reset(); // explicitily drop the current segment -> returns to pool
             m_CurrentSegment = InternalPopSegment(); // get the next segment from pool
         }
-        auto retval = m_CurrentSegment->Allocate(size);
+        // the descriptor holds the segment handle popped from the Pool, not the Pool's own
+        // reference, so the segment is only recycled after all its allocations are released
+        auto retval = m_CurrentSegment->Allocate(size, m_CurrentSegment);
         // TODO: proactive release should be dependent the recent allocations statistics
         if(!m_CurrentSegment->Available())
         {
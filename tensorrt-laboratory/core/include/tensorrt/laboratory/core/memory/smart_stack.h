@@ -82,12 +82,19 @@ class SmartStack : public MemoryStack<MemoryType>,
         return StackType(new SmartStack(memory));
     }
 
-    StackDescriptor Allocate(size_t size)
+    StackDescriptor Allocate(size_t size) { return Allocate(size, this->shared_from_this()); }
+
+    /**
+     * @brief Allocate on the stack; the returned descriptor holds stack instead of the
+     * shared_ptr owning the SmartStack.  Used when the stack is handed out by a Pool, so the
+     * stack is only returned to the Pool once all its descriptors are released.
+     */
+    StackDescriptor Allocate(size_t size, std::shared_ptr<const SmartStack<MemoryType>> stack)
     {
+        CHECK_EQ(stack.get(), this);
         CHECK_LE(size, this->Available());
 
         auto ptr = MemoryStack<MemoryType>::Allocate(size);
-        auto stack = this->shared_from_this();
 
         // Special Descriptor derived from MemoryType that hold a reference to the MemoryStack,
         // and who's destructor does not try to free the MemoryType memory.
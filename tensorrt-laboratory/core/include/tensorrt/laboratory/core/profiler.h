@@ -0,0 +1,97 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "tensorrt/laboratory/core/utils.h"
+
+namespace trtlab {
+
+/**
+ * @brief Process-wide collector of timed spans, exported in the Chrome trace_event format
+ *
+ * Spans are appended to a buffer owned by the recording thread, so threads never contend while
+ * recording.  Profiling is disabled by default; while disabled, a Span or a call to Now costs a
+ * single relaxed atomic load and nothing is recorded.  Load the output of ExportChromeTrace in
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Names and categories are not copied and must have static storage duration, e.g. literals.
+ */
+class Profiler
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    static void Enable(bool enabled = true);
+    static bool Enabled() { return s_Enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Current time if profiling is enabled; otherwise a default time_point, which Record
+     * ignores
+     */
+    static clock::time_point Now() { return Enabled() ? clock::now() : clock::time_point(); }
+
+    /**
+     * @brief Record a span on the calling thread, e.g. a wait that began on another thread
+     */
+    static void Record(const char* name, const char* category, clock::time_point start,
+                       clock::time_point end);
+
+    static std::string ExportChromeTrace();
+    static bool WriteChromeTrace(const std::string& path);
+    static size_t Count();
+    static void Clear();
+
+    /**
+     * @brief Records the lifetime of the object as a span
+     */
+    class Span
+    {
+      public:
+        Span(const char* name, const char* category = "trtlab")
+            : m_Name(name), m_Category(category), m_Start(Now())
+        {
+        }
+        ~Span() { Record(m_Name, m_Category, m_Start, Now()); }
+
+        DELETE_COPYABILITY(Span);
+        DELETE_MOVEABILITY(Span);
+
+      private:
+        const char* m_Name;
+        const char* m_Category;
+        clock::time_point m_Start;
+    };
+
+  private:
+    static std::atomic<bool> s_Enabled;
+};
+
+} // namespace trtlab
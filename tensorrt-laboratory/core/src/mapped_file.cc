@@ -0,0 +1,121 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+namespace {
+
+int ToMadvise(trtlab::MappedFile::Advice advice)
+{
+    using Advice = trtlab::MappedFile::Advice;
+    switch(advice)
+    {
+        case Advice::Sequential: return MADV_SEQUENTIAL;
+        case Advice::Random: return MADV_RANDOM;
+        case Advice::WillNeed: return MADV_WILLNEED;
+        case Advice::DontNeed: return MADV_DONTNEED;
+        default: return MADV_NORMAL;
+    }
+}
+
+std::runtime_error Error(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+namespace trtlab {
+
+MappedFile::MappedFile(const std::string& path, Advice advice)
+    : m_Path(path), m_Data(nullptr), m_Size(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        throw Error("Unable to open", path);
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw Error("Unable to stat", path);
+    }
+    m_Size = info.st_size;
+    // an empty file can not be mapped; it is represented by a null mapping of size 0
+    if(m_Size)
+    {
+        m_Data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // the mapping holds its own reference to the file
+    close(fd);
+    if(m_Data == MAP_FAILED)
+    {
+        m_Data = nullptr;
+        throw Error("Unable to map", path);
+    }
+    DLOG(INFO) << "Mapped " << BytesToString(m_Size) << " of " << path;
+    Advise(advice);
+}
+
+MappedFile::~MappedFile()
+{
+    if(m_Data)
+    {
+        munmap(m_Data, m_Size);
+    }
+}
+
+void MappedFile::Advise(Advice advice)
+{
+    if(m_Data && madvise(m_Data, m_Size, ToMadvise(advice)) != 0)
+    {
+        LOG(WARNING) << "madvise failed for " << m_Path << ": " << std::strerror(errno);
+    }
+}
+
+size_t MappedFile::FileSize(const std::string& path)
+{
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0)
+    {
+        throw Error("Unable to stat", path);
+    }
+    return info.st_size;
+}
+
+} // namespace trtlab
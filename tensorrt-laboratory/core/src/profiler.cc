@@ -0,0 +1,175 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/profiler.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    const char* category;
+    trtlab::Profiler::clock::time_point start;
+    trtlab::Profiler::clock::time_point end;
+};
+
+// The mutex of a ThreadBuffer is only contended while exporting or clearing
+struct ThreadBuffer
+{
+    std::mutex mutex;
+    uint64_t tid;
+    std::vector<Event> events;
+};
+
+// Buffers outlive their threads so spans of finished threads are still exported
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer& LocalBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto buffer = std::make_shared<ThreadBuffer>();
+        buffer->tid = registry.buffers.size();
+        registry.buffers.push_back(buffer);
+        return buffer;
+    }();
+    return *buffer;
+}
+
+} // namespace
+
+namespace trtlab {
+
+std::atomic<bool> Profiler::s_Enabled{false};
+
+void Profiler::Enable(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+
+void Profiler::Record(const char* name, const char* category, clock::time_point start,
+                      clock::time_point end)
+{
+    // spans started before profiling was enabled or ended after it was disabled are dropped
+    if(!Enabled() || start == clock::time_point() || end == clock::time_point())
+    {
+        return;
+    }
+    auto& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(Event{name, category, start, end});
+}
+
+/**
+ * @brief Serialize the recorded spans as a Chrome trace_event JSON object
+ *
+ * Each span is a complete ("X") event; timestamps and durations are in microseconds of the
+ * steady clock.
+ */
+std::string Profiler::ExportChromeTrace()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> registry_lock(registry.mutex);
+
+    auto us = [](clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    };
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3) << "{\"traceEvents\": [";
+    bool first = true;
+    for(const auto& buffer : registry.buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        for(const auto& e : buffer->events)
+        {
+            os << (first ? "\n" : ",\n") << "{\"name\": \"" << e.name << "\", \"cat\": \""
+               << e.category << "\", \"ph\": \"X\", \"ts\": " << us(e.start.time_since_epoch())
+               << ", \"dur\": " << us(e.end - e.start) << ", \"pid\": " << getpid()
+               << ", \"tid\": " << buffer->tid << "}";
+            first = false;
+        }
+    }
+    os << "\n], \"displayTimeUnit\": \"ms\"}";
+    return os.str();
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if(!file)
+    {
+        LOG(ERROR) << "Unable to open " << path << " for writing";
+        return false;
+    }
+    file << ExportChromeTrace() << std::endl;
+    return file.good();
+}
+
+size_t Profiler::Count()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> registry_lock(registry.mutex);
+    size_t count = 0;
+    for(const auto& buffer : registry.buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        count += buffer->events.size();
+    }
+    return count;
+}
+
+void Profiler::Clear()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> registry_lock(registry.mutex);
+    for(const auto& buffer : registry.buffers)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+} // namespace trtlab
@@ -0,0 +1,85 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/mapped_file.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace trtlab;
+
+class TestMappedFile : public ::testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        m_Path = "/tmp/trtlab_test_mapped_file." + std::to_string(getpid());
+    }
+    virtual void TearDown() { std::remove(m_Path.c_str()); }
+
+    void Write(const std::string& contents)
+    {
+        std::ofstream file(m_Path, std::ios::binary);
+        file << contents;
+    }
+
+    std::string m_Path;
+};
+
+TEST_F(TestMappedFile, MapsContents)
+{
+    std::string contents(1024 * 1024 + 7, 'x');
+    contents[12345] = 'y';
+    Write(contents);
+
+    MappedFile file(m_Path);
+    ASSERT_EQ(file.Size(), contents.size());
+    EXPECT_EQ(MappedFile::FileSize(m_Path), contents.size());
+    EXPECT_EQ(std::memcmp(file.Data(), contents.data(), contents.size()), 0);
+
+    file.Advise(MappedFile::Advice::WillNeed);
+    file.Advise(MappedFile::Advice::DontNeed);
+    // dropping the pages of a file mapping does not lose its contents
+    EXPECT_EQ(static_cast<const char*>(file.Data())[12345], 'y');
+}
+
+TEST_F(TestMappedFile, EmptyFile)
+{
+    Write("");
+    MappedFile file(m_Path, MappedFile::Advice::Random);
+    EXPECT_EQ(file.Size(), 0);
+    EXPECT_EQ(file.Data(), nullptr);
+}
+
+TEST_F(TestMappedFile, MissingFile)
+{
+    EXPECT_THROW(MappedFile file(m_Path), std::runtime_error);
+    EXPECT_THROW(MappedFile::FileSize(m_Path), std::runtime_error);
+}
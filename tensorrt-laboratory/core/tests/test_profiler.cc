@@ -0,0 +1,95 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/profiler.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+using namespace trtlab;
+
+class TestProfiler : public ::testing::Test
+{
+  protected:
+    virtual void SetUp() { Profiler::Clear(); }
+    virtual void TearDown()
+    {
+        Profiler::Enable(false);
+        Profiler::Clear();
+    }
+};
+
+TEST_F(TestProfiler, DisabledRecordsNothing)
+{
+    ASSERT_FALSE(Profiler::Enabled());
+    {
+        Profiler::Span span("disabled");
+    }
+    EXPECT_EQ(Profiler::Now(), Profiler::clock::time_point());
+    EXPECT_EQ(Profiler::Count(), 0);
+}
+
+TEST_F(TestProfiler, SpansFromManyThreads)
+{
+    Profiler::Enable();
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; i++)
+    {
+        threads.emplace_back([] {
+            for(int j = 0; j < 10; j++)
+            {
+                Profiler::Span span("work", "test");
+            }
+        });
+    }
+    for(auto& t : threads)
+    {
+        t.join();
+    }
+    // buffers of finished threads are still exported
+    EXPECT_EQ(Profiler::Count(), 40);
+
+    Profiler::Clear();
+    EXPECT_EQ(Profiler::Count(), 0);
+}
+
+TEST_F(TestProfiler, ChromeTrace)
+{
+    Profiler::Enable();
+    auto start = Profiler::Now();
+    auto end = start + std::chrono::microseconds(250);
+    Profiler::Record("wait:buffers", "wait", start, end);
+    // spans started while profiling was disabled are dropped
+    Profiler::Record("dropped", "wait", Profiler::clock::time_point(), end);
+
+    auto trace = Profiler::ExportChromeTrace();
+    EXPECT_EQ(trace.find("{\"traceEvents\": ["), 0);
+    EXPECT_NE(trace.find("\"name\": \"wait:buffers\", \"cat\": \"wait\", \"ph\": \"X\""),
+              std::string::npos);
+    EXPECT_NE(trace.find("\"dur\": 250.000"), std::string::npos);
+    EXPECT_EQ(trace.find("dropped"), std::string::npos);
+}
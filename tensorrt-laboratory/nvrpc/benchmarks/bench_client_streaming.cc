@@ -0,0 +1,121 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_streaming.h"
+
+#include "allocation_counter.h"
+#include "bench_common.h"
+
+/**
+ * Upload throughput of ClientStreaming write modes
+ *
+ * One long-lived stream to a 1 thread echo server.  Each iteration writes a burst of range(0)
+ * small requests and waits for all echoes.  range(1) selects how the burst is written:
+ *  - 0: uncorked, every Write is flushed individually
+ *  - 1: corked, the burst is released with one Flush and buffered into as few writes as gRPC
+ *       allows
+ *  - 2: uncorked with SetAutoCoalesce(range(0)), writes that queue behind the in-flight write
+ *       are buffered
+ */
+
+using namespace nvrpc::benchmarks;
+
+namespace {
+
+void UploadArgs(benchmark::internal::Benchmark* b)
+{
+    for(int burst : {1, 8, 64})
+    {
+        for(int mode : {0, 1, 2})
+        {
+            b->Args({burst, mode});
+        }
+    }
+}
+
+} // namespace
+
+static void BM_ClientStreaming_Upload(benchmark::State& state)
+{
+    auto server = BuildBenchServer<EchoStreamingContext>(
+        &TestService::AsyncService::RequestStreaming, 1, 1);
+    auto stub = BuildBenchStub();
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+    const std::size_t burst = state.range(0);
+    const auto mode = state.range(1);
+
+    auto prepare_fn = [stub](::grpc::ClientContext * context,
+                             ::grpc::CompletionQueue * cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncStreaming(context, cq));
+    };
+
+    ResponseCounter counter;
+    auto stream = std::make_unique<nvrpc::client::ClientStreaming<Input, Output>>(
+        prepare_fn, executor, [](Input&&) {}, [&counter](Output&&) { counter.Increment(); });
+    stream->SetCorked(mode == 1);
+    if(mode == 2)
+    {
+        stream->SetAutoCoalesce(burst);
+    }
+
+    std::size_t sent = 0;
+    auto upload = [&] {
+        for(std::size_t i = 0; i < burst; i++)
+        {
+            Input input;
+            input.set_batch_id(++sent);
+            stream->Write(std::move(input));
+        }
+        if(mode == 1)
+        {
+            stream->Flush();
+        }
+        counter.WaitFor(sent);
+    };
+
+    // the first burst pays for connection and stream setup
+    upload();
+
+    auto allocations = AllocationCount();
+    for(auto _ : state)
+    {
+        upload();
+    }
+    SetMessageCounters(state, state.iterations() * burst, AllocationCount() - allocations);
+
+    auto status = stream->Done().get();
+    if(!status.ok())
+    {
+        state.SkipWithError("stream did not finish with OK");
+    }
+    stream.reset();
+    server->Shutdown();
+}
+BENCHMARK(BM_ClientStreaming_Upload)
+    ->ArgNames({"burst", "mode"})
+    ->Apply(UploadArgs)
+    ->UseRealTime();
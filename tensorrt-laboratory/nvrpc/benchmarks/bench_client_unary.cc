@@ -0,0 +1,106 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_unary.h"
+
+#include "allocation_counter.h"
+#include "bench_common.h"
+
+/**
+ * Allocations per call of ClientUnary::Enqueue vs. ClientUnary::EnqueuePooled
+ *
+ * One client issues windows of range(1) unary calls to a 2 thread echo server and waits for
+ * each window to complete.  range(0) selects the client path:
+ *  - 0: Enqueue(Request&&, on_return) - a new Context and ClientContext, shared copies of the
+ *       messages and a future per call
+ *  - 1: EnqueuePooled - recycled call contexts
+ *
+ * allocs/msg counts operator new on every thread of the process, so it includes the server and
+ * gRPC's own allocations; the difference between the two paths is the client's saving.
+ */
+
+using namespace nvrpc::benchmarks;
+
+static void BM_ClientUnary_Allocations(benchmark::State& state)
+{
+    auto server = BuildBenchServer<EchoUnaryContext>(&TestService::AsyncService::RequestUnary, 2,
+                                                     64);
+    auto stub = BuildBenchStub();
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+    const bool pooled = state.range(0);
+    const std::size_t window = state.range(1);
+
+    auto prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
+                             ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(prepare_fn, executor);
+
+    ResponseCounter counter;
+    std::size_t sent = 0;
+    auto on_return = [&counter](Input&, Output&, ::grpc::Status&) { counter.Increment(); };
+
+    auto burst = [&] {
+        for(std::size_t i = 0; i < window; i++)
+        {
+            auto batch_id = ++sent;
+            if(pooled)
+            {
+                client.EnqueuePooled([batch_id](Input& input) { input.set_batch_id(batch_id); },
+                                     on_return);
+            }
+            else
+            {
+                Input input;
+                input.set_batch_id(batch_id);
+                client.Enqueue(std::move(input), on_return);
+            }
+        }
+        counter.WaitFor(sent);
+    };
+
+    // the first bursts pay for connection setup and fill the context pool
+    burst();
+    burst();
+
+    auto allocations = AllocationCount();
+    for(auto _ : state)
+    {
+        burst();
+    }
+    SetMessageCounters(state, state.iterations() * window, AllocationCount() - allocations);
+    state.counters["contexts"] = client.PooledContexts();
+
+    server->Shutdown();
+}
+BENCHMARK(BM_ClientUnary_Allocations)
+    ->ArgNames({"pooled", "window"})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 64})
+    ->Args({1, 64})
+    ->UseRealTime();
@@ -0,0 +1,167 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "tensorrt/laboratory/core/resources.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <benchmark/benchmark.h>
+
+/**
+ * Shared fixtures for the nvrpc benchmarks: an echo service for every server LifeCycle on
+ * testing.proto, builders for a loopback server/stub pair, and counter helpers.
+ */
+
+namespace nvrpc {
+namespace benchmarks {
+
+using ::nvrpc::testing::Input;
+using ::nvrpc::testing::Output;
+using ::nvrpc::testing::TestService;
+
+static const char* BenchServerAddress = "0.0.0.0:13380";
+static const char* BenchClientAddress = "localhost:13380";
+
+struct BenchResources : public ::trtlab::Resources
+{
+};
+
+class EchoUnaryContext final : public nvrpc::Context<Input, Output, BenchResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+class EchoStreamingContext final : public nvrpc::StreamingContext<Input, Output, BenchResources>
+{
+    void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override
+    {
+        Output output;
+        output.set_batch_id(input.batch_id());
+        stream->WriteResponse(std::move(output));
+    }
+};
+
+class EchoBidirectionalContext final
+    : public nvrpc::BidirectionalContext<Input, Output, BenchResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+class EchoBatchingContext final : public nvrpc::BatchingContext<Input, Output, BenchResources>
+{
+    void ExecuteRPC(std::vector<Input>& inputs, std::vector<Output>& outputs) final override
+    {
+        outputs.resize(inputs.size());
+        for(std::size_t i = 0; i < inputs.size(); i++)
+        {
+            outputs[i].set_batch_id(inputs[i].batch_id());
+        }
+        FinishResponse();
+    }
+};
+
+template<typename ContextType, typename RequestFuncType>
+std::unique_ptr<nvrpc::Server> BuildBenchServer(RequestFuncType request_fn, int threads,
+                                                int contexts_per_thread)
+{
+    auto server = std::make_unique<nvrpc::Server>(BenchServerAddress);
+    auto resources = std::make_shared<BenchResources>();
+    auto executor = server->RegisterExecutor(new nvrpc::Executor(threads));
+    auto service = server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<ContextType>(request_fn);
+    executor->RegisterContexts(rpc, resources, contexts_per_thread);
+    server->AsyncStart();
+    return server;
+}
+
+inline std::shared_ptr<TestService::Stub> BuildBenchStub()
+{
+    auto channel = grpc::CreateChannel(BenchClientAddress, grpc::InsecureChannelCredentials());
+    return TestService::NewStub(channel);
+}
+
+/**
+ * @brief Tracks the number of responses received by a ClientStreaming object
+ */
+class ResponseCounter
+{
+  public:
+    ResponseCounter() : m_Received(0) {}
+
+    void Increment()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_Received;
+        }
+        m_Condition.notify_all();
+    }
+
+    void WaitFor(std::size_t count)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this, count] { return m_Received >= count; });
+    }
+
+    std::size_t Received()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Received;
+    }
+
+  private:
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::size_t m_Received;
+};
+
+inline void SetMessageCounters(benchmark::State& state, std::size_t messages,
+                               std::size_t allocations)
+{
+    state.SetItemsProcessed(messages);
+    state.counters["allocs/msg"] = messages ? (double)allocations / (double)messages : 0.0;
+}
+
+} // namespace benchmarks
+} // namespace nvrpc
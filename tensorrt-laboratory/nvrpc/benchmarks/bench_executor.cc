@@ -0,0 +1,99 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_unary.h"
+
+#include "bench_common.h"
+
+/**
+ * Client throughput vs. nvrpc::client::Executor progress threads
+ *
+ * A 4 thread echo server is driven by one ClientUnary whose Executor has range(0) threads and
+ * uses the SelectionPolicy range(1) (0: RoundRobin, 1: LeastOutstanding).  Each iteration
+ * issues a window of range(2) unary calls and waits for all of them, so items_per_second is the
+ * closed-loop throughput the client can sustain with that many calls outstanding.
+ */
+
+using namespace nvrpc::benchmarks;
+using nvrpc::client::Executor;
+
+static void BM_ClientExecutor_UnaryWindow(benchmark::State& state)
+{
+    auto server = BuildBenchServer<EchoUnaryContext>(&TestService::AsyncService::RequestUnary, 4,
+                                                     32);
+    auto stub = BuildBenchStub();
+    auto policy = state.range(1) ? Executor::SelectionPolicy::LeastOutstanding
+                                 : Executor::SelectionPolicy::RoundRobin;
+    auto executor = std::make_shared<Executor>(state.range(0), policy);
+    const std::size_t window = state.range(2);
+
+    auto prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
+                             ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(prepare_fn, executor);
+
+    std::vector<std::shared_future<void>> futures;
+    futures.reserve(window);
+
+    auto burst = [&client, &futures, window] {
+        futures.clear();
+        for(std::size_t i = 0; i < window; i++)
+        {
+            Input input;
+            input.set_batch_id(i);
+            futures.push_back(
+                client.Enqueue(std::move(input), [](Input&, Output&, ::grpc::Status&) {}));
+        }
+        for(auto& future : futures)
+        {
+            future.get();
+        }
+    };
+
+    // the first burst pays for connection setup
+    burst();
+
+    for(auto _ : state)
+    {
+        burst();
+    }
+    state.SetItemsProcessed(state.iterations() * window);
+
+    server->Shutdown();
+}
+BENCHMARK(BM_ClientExecutor_UnaryWindow)
+    ->ArgNames({"threads", "policy", "window"})
+    ->Args({1, 0, 64})
+    ->Args({2, 0, 64})
+    ->Args({4, 0, 64})
+    ->Args({8, 0, 64})
+    ->Args({1, 1, 64})
+    ->Args({2, 1, 64})
+    ->Args({4, 1, 64})
+    ->Args({8, 1, 64})
+    ->UseRealTime();
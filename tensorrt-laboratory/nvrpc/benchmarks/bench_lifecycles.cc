@@ -0,0 +1,236 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_streaming.h"
+#include "nvrpc/client/client_unary.h"
+
+#include "allocation_counter.h"
+#include "bench_common.h"
+
+/**
+ * Per-RPC overhead of the server LifeCycles
+ *
+ * Each benchmark stands up an nvrpc::Server and an nvrpc client in the same process, connected
+ * over loopback, and echos the batch_id of testing.proto messages.  The server does no work, so
+ * the time per iteration is the round-trip latency of the state machines plus gRPC.
+ *
+ * Arguments are {server executor threads, contexts per thread}; the batching benchmark adds the
+ * number of messages sent per stream.  Counters:
+ *  - items_per_second: messages/s echoed by the server
+ *  - allocs/msg: calls to operator new, on any thread, per message echoed
+ */
+
+using namespace nvrpc::benchmarks;
+
+namespace {
+
+void ExecutorArgs(benchmark::internal::Benchmark* b)
+{
+    for(int threads : {1, 2, 4})
+    {
+        for(int contexts : {1, 10})
+        {
+            b->Args({threads, contexts});
+        }
+    }
+}
+
+void BatchingArgs(benchmark::internal::Benchmark* b)
+{
+    for(int threads : {1, 2})
+    {
+        for(int batch_size : {1, 8, 64})
+        {
+            b->Args({threads, 10, batch_size});
+        }
+    }
+}
+
+/**
+ * @brief Ping-pong one message at a time on a single long-lived bidirectional stream
+ *
+ * Used for both LifeCycleStreaming and BidirectionalLifeCycleStreaming, which share the
+ * Streaming method of TestService.
+ */
+template<typename ContextType>
+void StreamingPingPong(benchmark::State& state)
+{
+    auto server = BuildBenchServer<ContextType>(&TestService::AsyncService::RequestStreaming,
+                                                state.range(0), state.range(1));
+    auto stub = BuildBenchStub();
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+
+    auto prepare_fn = [stub](::grpc::ClientContext * context,
+                             ::grpc::CompletionQueue * cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncStreaming(context, cq));
+    };
+
+    ResponseCounter counter;
+    auto stream = std::make_unique<nvrpc::client::ClientStreaming<Input, Output>>(
+        prepare_fn, executor, [](Input&&) {}, [&counter](Output&&) { counter.Increment(); });
+
+    std::size_t sent = 0;
+    auto round_trip = [&stream, &counter, &sent] {
+        Input input;
+        input.set_batch_id(++sent);
+        stream->Write(std::move(input));
+        counter.WaitFor(sent);
+    };
+
+    // the first message pays for connection and stream setup
+    round_trip();
+
+    auto allocations = AllocationCount();
+    for(auto _ : state)
+    {
+        round_trip();
+    }
+    SetMessageCounters(state, state.iterations(), AllocationCount() - allocations);
+
+    auto status = stream->Done().get();
+    if(!status.ok())
+    {
+        state.SkipWithError("stream did not finish with OK");
+    }
+    stream.reset();
+    server->Shutdown();
+}
+
+} // namespace
+
+static void BM_LifeCycleUnary(benchmark::State& state)
+{
+    auto server = BuildBenchServer<EchoUnaryContext>(&TestService::AsyncService::RequestUnary,
+                                                     state.range(0), state.range(1));
+    auto stub = BuildBenchStub();
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+
+    auto prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
+                             ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(prepare_fn, executor);
+
+    std::size_t failed = 0;
+    std::size_t sent = 0;
+    auto round_trip = [&client, &failed, &sent] {
+        Input input;
+        input.set_batch_id(++sent);
+        client
+            .Enqueue(std::move(input),
+                     [&failed](Input& input, Output& output, ::grpc::Status& status) {
+                         if(!status.ok() || input.batch_id() != output.batch_id())
+                         {
+                             ++failed;
+                         }
+                     })
+            .get();
+    };
+
+    // the first message pays for connection setup
+    round_trip();
+
+    auto allocations = AllocationCount();
+    for(auto _ : state)
+    {
+        round_trip();
+    }
+    SetMessageCounters(state, state.iterations(), AllocationCount() - allocations);
+
+    if(failed)
+    {
+        state.SkipWithError("unary echo failed");
+    }
+    server->Shutdown();
+}
+BENCHMARK(BM_LifeCycleUnary)->Apply(ExecutorArgs)->UseRealTime();
+
+static void BM_LifeCycleStreaming(benchmark::State& state)
+{
+    StreamingPingPong<EchoStreamingContext>(state);
+}
+BENCHMARK(BM_LifeCycleStreaming)->Apply(ExecutorArgs)->UseRealTime();
+
+static void BM_BidirectionalLifeCycleStreaming(benchmark::State& state)
+{
+    StreamingPingPong<EchoBidirectionalContext>(state);
+}
+BENCHMARK(BM_BidirectionalLifeCycleStreaming)->Apply(ExecutorArgs)->UseRealTime();
+
+/**
+ * @brief All-in, then all-out: one stream per iteration carrying range(2) messages
+ */
+static void BM_LifeCycleBatching(benchmark::State& state)
+{
+    auto server = BuildBenchServer<EchoBatchingContext>(
+        &TestService::AsyncService::RequestStreaming, state.range(0), state.range(1));
+    auto stub = BuildBenchStub();
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+    const std::size_t batch_size = state.range(2);
+
+    auto prepare_fn = [stub](::grpc::ClientContext * context,
+                             ::grpc::CompletionQueue * cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncStreaming(context, cq));
+    };
+
+    std::size_t failed = 0;
+    auto batch = [&] {
+        ResponseCounter counter;
+        nvrpc::client::ClientStreaming<Input, Output> stream(
+            prepare_fn, executor, [](Input&&) {}, [&counter](Output&&) { counter.Increment(); });
+        for(std::size_t i = 1; i <= batch_size; i++)
+        {
+            Input input;
+            input.set_batch_id(i);
+            stream.Write(std::move(input));
+        }
+        auto status = stream.Done().get();
+        if(!status.ok() || counter.Received() != batch_size)
+        {
+            ++failed;
+        }
+    };
+
+    // the first batch pays for connection setup
+    batch();
+
+    auto allocations = AllocationCount();
+    for(auto _ : state)
+    {
+        batch();
+    }
+    SetMessageCounters(state, state.iterations() * batch_size, AllocationCount() - allocations);
+
+    if(failed)
+    {
+        state.SkipWithError("batching echo failed");
+    }
+    server->Shutdown();
+}
+BENCHMARK(BM_LifeCycleBatching)->Apply(BatchingArgs)->UseRealTime();
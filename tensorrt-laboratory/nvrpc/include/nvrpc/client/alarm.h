@@ -0,0 +1,88 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include <grpcpp/alarm.h>
+
+#include "nvrpc/client/base_context.h"
+#include "nvrpc/client/executor.h"
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief One-shot timer delivered through a client Executor
+ *
+ * The callback runs on the progress thread of the selected completion queue when the deadline
+ * expires.  ok is false if the alarm was cancelled, either by Cancel or because its completion
+ * queue is shutting down.  The alarm keeps itself alive until it fires; the returned handle is
+ * only needed to cancel it.
+ */
+class AlarmContext : public BaseContext, public std::enable_shared_from_this<AlarmContext>
+{
+  public:
+    using Callback = std::function<void(bool)>;
+
+    template<typename Deadline>
+    static std::shared_ptr<AlarmContext> Schedule(Executor& executor, const Deadline& deadline,
+                                                  Callback callback)
+    {
+        std::shared_ptr<AlarmContext> ctx(new AlarmContext(std::move(callback)));
+        ctx->m_Self = ctx;
+        ctx->m_Alarm.Set(executor.GetNextCQ(), deadline, ctx->Tag());
+        return ctx;
+    }
+
+    ~AlarmContext() override {}
+
+    void Cancel() { m_Alarm.Cancel(); }
+
+  private:
+    AlarmContext(Callback callback) : m_Callback(std::move(callback)) {}
+
+    bool RunNextState(bool ok) final override
+    {
+        // the callback is released once it has run, along with anything it captured; this may
+        // release the last reference, so nothing is touched afterwards
+        auto self = std::move(m_Self);
+        auto callback = std::move(m_Callback);
+        callback(ok);
+        return false;
+    }
+
+    bool ExecutorShouldDeleteContext() const override { return false; }
+
+    ::grpc::Alarm m_Alarm;
+    Callback m_Callback;
+    std::shared_ptr<AlarmContext> m_Self;
+};
+
+} // namespace client
+} // namespace nvrpc
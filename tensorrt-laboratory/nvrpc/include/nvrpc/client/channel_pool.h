@@ -0,0 +1,119 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief A fixed set of channels to one target, each backed by its own HTTP/2 connection
+ *
+ * gRPC shares subchannels between channels created with identical arguments, so N plain
+ * channels to the same target still multiplex over one connection.  ChannelPool gives each
+ * channel a local subchannel pool and a distinct channel argument, forcing one connection per
+ * channel, which spreads large messages and concurrent calls across connections.
+ *
+ * Callers Acquire a channel index for the lifetime of a call and Release it when the call
+ * completes; ClientUnary and ClientStreaming do this when constructed with a StubPool.
+ */
+class ChannelPool
+{
+  public:
+    enum class SelectionPolicy
+    {
+        RoundRobin,
+        LeastInFlight
+    };
+
+    ChannelPool(const std::string& target, std::size_t size,
+                SelectionPolicy policy = SelectionPolicy::RoundRobin,
+                std::shared_ptr<::grpc::ChannelCredentials> credentials =
+                    ::grpc::InsecureChannelCredentials(),
+                const ::grpc::ChannelArguments& args = ::grpc::ChannelArguments());
+    virtual ~ChannelPool() {}
+
+    ChannelPool(ChannelPool&&) = delete;
+    ChannelPool& operator=(ChannelPool&&) = delete;
+
+    ChannelPool(const ChannelPool&) = delete;
+    ChannelPool& operator=(const ChannelPool&) = delete;
+
+    std::size_t Acquire();
+    void Release(std::size_t index);
+
+    /**
+     * @brief Account a call on a caller-chosen channel, e.g. a hedge that must avoid the
+     * channel of the original attempt; pair with Release
+     */
+    void Acquire(std::size_t index);
+
+    const std::shared_ptr<::grpc::Channel>& Channel(std::size_t index) const;
+
+    std::size_t Size() const { return m_Channels.size(); }
+    SelectionPolicy GetSelectionPolicy() const { return m_Policy; }
+    std::int64_t InFlight(std::size_t index) const;
+
+  private:
+    const SelectionPolicy m_Policy;
+    std::atomic<std::size_t> m_Counter;
+    std::vector<std::shared_ptr<::grpc::Channel>> m_Channels;
+    std::vector<std::unique_ptr<std::atomic<std::int64_t>>> m_InFlight;
+};
+
+/**
+ * @brief ChannelPool with a generated Stub of ServiceType bound to each channel
+ */
+template<typename ServiceType>
+class StubPool : public ChannelPool
+{
+  public:
+    using StubType = typename ServiceType::Stub;
+
+    template<typename... Args>
+    StubPool(Args&&... args) : ChannelPool(std::forward<Args>(args)...)
+    {
+        for(std::size_t i = 0; i < Size(); i++)
+        {
+            m_Stubs.emplace_back(ServiceType::NewStub(Channel(i)));
+        }
+    }
+    ~StubPool() override {}
+
+    StubType* Stub(std::size_t index) const { return m_Stubs[index].get(); }
+
+  private:
+    std::vector<std::unique_ptr<StubType>> m_Stubs;
+};
+
+} // namespace client
+} // namespace nvrpc
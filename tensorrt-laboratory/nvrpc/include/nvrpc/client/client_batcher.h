@@ -0,0 +1,374 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+#include "nvrpc/client/alarm.h"
+#include "nvrpc/client/client_streaming.h"
+#include "nvrpc/client/executor.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Gathers unary requests into batches forwarded over a single stream
+ *
+ * Each call to Enqueue is appended to the open batch.  A batch is sent as one corked
+ * ClientStreaming call, i.e. one request message per member written as a single burst, when it
+ * reaches max_batch_size or max_wait after its first member was enqueued, whichever comes
+ * first.  The server is expected to return one response per request in the order the
+ * requests were received, which is the contract of nvrpc::BatchingContext.
+ *
+ * Responses are matched to members by position.  A member that is not answered before the
+ * stream finishes fails on its own: it receives the Status of the stream, or INTERNAL if the
+ * stream finished OK with too few responses; members that were answered are unaffected.
+ *
+ * Batch deadlines are delivered as alarms on the Executor; no additional threads are used.
+ */
+template<typename Request, typename Response>
+class ClientBatcher : public ::trtlab::AsyncComputeWrapper<void(Response&, ::grpc::Status&)>
+{
+  public:
+    using PrepareFn = typename ClientStreaming<Request, Response>::PrepareFn;
+
+    /**
+     * @brief Per-request timing in seconds
+     *
+     * queued is the time from Enqueue until the batch was sent; total is the time from Enqueue
+     * until the response or failure was delivered.
+     */
+    struct Latency
+    {
+        double queued;
+        double total;
+        std::size_t batch_size;
+    };
+    using LatencyFn = std::function<void(const Latency&)>;
+
+    ClientBatcher(PrepareFn prepare_fn, std::shared_ptr<Executor> executor,
+                  std::size_t max_batch_size, std::chrono::microseconds max_wait,
+                  LatencyFn on_latency = nullptr)
+        : m_Config(new Config), m_MaxWait(max_wait)
+    {
+        CHECK_GT(max_batch_size, 0);
+        m_Config->prepare_fn = prepare_fn;
+        m_Config->executor = executor;
+        m_Config->max_batch_size = max_batch_size;
+        m_Config->on_latency = on_latency;
+        m_Config->outstanding = 0;
+    }
+
+    /**
+     * @brief Sends the open batch and waits for every batch in flight to complete
+     *
+     * Must not be called from an Executor thread, e.g. from within an on_return callback.
+     */
+    ~ClientBatcher()
+    {
+        Flush();
+        std::unique_lock<std::mutex> lock(m_Config->mutex);
+        m_Config->cv.wait(lock, [this] { return m_Config->outstanding == 0; });
+    }
+
+    /**
+     * @brief Add a request to the open batch
+     *
+     * on_return(Response&, ::grpc::Status&) is called on an Executor thread when the member
+     * completes; its result is available from the returned shared_future.
+     */
+    template<typename OnReturnFn>
+    auto Enqueue(Request&& request, OnReturnFn on_return)
+    {
+        auto wrapped = this->Wrap(on_return);
+        auto future = wrapped->Future();
+
+        Item item;
+        item.request = std::move(request);
+        item.callback = [wrapped](Response& response, ::grpc::Status& status) mutable {
+            (*wrapped)(response, status);
+        };
+        item.enqueued = Clock::now();
+
+        std::shared_ptr<Batch> ready;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto state = m_Current ? m_Current->Add(item) : Batch::State::Sealed;
+            if(state == Batch::State::Sealed)
+            {
+                m_Current = std::make_shared<Batch>(m_Config.get());
+                state = m_Current->Add(item);
+                if(state == Batch::State::Open)
+                {
+                    m_Current->SetTimer(StartTimer(m_Current));
+                }
+            }
+            if(state == Batch::State::Full)
+            {
+                ready = std::move(m_Current);
+            }
+        }
+        if(ready)
+        {
+            ready->Send();
+        }
+        return future.share();
+    }
+
+    /**
+     * @brief Send the open batch without waiting for it to fill or for max_wait to expire
+     */
+    void Flush()
+    {
+        std::shared_ptr<Batch> ready;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ready = std::move(m_Current);
+        }
+        if(ready && ready->Seal())
+        {
+            ready->Send();
+        }
+    }
+
+    std::size_t MaxBatchSize() const { return m_Config->max_batch_size; }
+    std::chrono::microseconds MaxWait() const { return m_MaxWait; }
+
+  private:
+    using Clock = std::chrono::high_resolution_clock;
+    using Callback = std::function<void(Response&, ::grpc::Status&)>;
+
+    struct Config
+    {
+        PrepareFn prepare_fn;
+        std::shared_ptr<Executor> executor;
+        std::size_t max_batch_size;
+        LatencyFn on_latency;
+
+        // batches created but not yet completed; the batcher outlives all of them
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t outstanding;
+    };
+
+    struct Item
+    {
+        Request request;
+        Response response;
+        Callback callback;
+        Clock::time_point enqueued;
+    };
+
+    class Batch : public std::enable_shared_from_this<Batch>
+    {
+      public:
+        enum class State
+        {
+            Open,
+            Full,
+            Sealed
+        };
+
+        Batch(Config* config) : m_Config(config), m_Sealed(false), m_Received(0)
+        {
+            std::lock_guard<std::mutex> lock(m_Config->mutex);
+            m_Config->outstanding++;
+            m_Items.reserve(m_Config->max_batch_size);
+        }
+
+        // item is only consumed if the batch is still open
+        State Add(Item& item)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(m_Sealed)
+            {
+                return State::Sealed;
+            }
+            m_Items.push_back(std::move(item));
+            if(m_Items.size() == m_Config->max_batch_size)
+            {
+                m_Sealed = true;
+                return State::Full;
+            }
+            return State::Open;
+        }
+
+        // returns true if the caller sealed the batch and is now responsible for sending it
+        bool Seal()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(m_Sealed)
+            {
+                return false;
+            }
+            m_Sealed = true;
+            return true;
+        }
+
+        // the deadline is cancelled once the batch is sent so it does not linger on the Executor
+        void SetTimer(std::shared_ptr<AlarmContext> timer)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(m_Sealed)
+            {
+                timer->Cancel();
+                return;
+            }
+            m_Timer = std::move(timer);
+        }
+
+        void Send()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if(m_Timer)
+                {
+                    m_Timer->Cancel();
+                    m_Timer.reset();
+                }
+            }
+
+            // the batch keeps itself alive until the stream completes
+            auto self = this->shared_from_this();
+            m_Self = self;
+            m_SentAt = Clock::now();
+            DLOG(INFO) << "Sending batch of " << m_Items.size();
+
+            m_Stream = std::make_unique<ClientStreaming<Request, Response>>(
+                m_Config->prepare_fn, m_Config->executor, [](Request&&) {},
+                [this](Response&& response) { ResponseReceived(std::move(response)); });
+
+            // queue the whole batch; Done sends it as one burst ending with the half-close
+            m_Stream->SetCorked(true);
+            for(auto& item : m_Items)
+            {
+                m_Stream->Write(std::move(item.request));
+            }
+            m_Stream->Done();
+
+            // registered last, so the stream cannot be released while Send still uses it; if the
+            // stream has already completed, this completes the batch on this thread
+            m_Stream->OnComplete([this](const ::grpc::Status& status) { StreamComplete(status); });
+        }
+
+      private:
+        void ResponseReceived(Response&& response)
+        {
+            if(m_Received == m_Items.size())
+            {
+                LOG(WARNING) << "Received more responses than requests in batch; dropping";
+                return;
+            }
+            auto& item = m_Items[m_Received++];
+            item.response = std::move(response);
+            ::grpc::Status status = ::grpc::Status::OK;
+            Complete(item, status);
+        }
+
+        void StreamComplete(const ::grpc::Status& stream_status)
+        {
+            ::grpc::Status status =
+                stream_status.ok()
+                    ? ::grpc::Status(::grpc::StatusCode::INTERNAL,
+                                     "batch stream finished without a response for this request")
+                    : stream_status;
+            DLOG_IF(WARNING, m_Received < m_Items.size())
+                << "Failing " << m_Items.size() - m_Received << " of " << m_Items.size()
+                << " batch members: " << status.error_message();
+            while(m_Received < m_Items.size())
+            {
+                Complete(m_Items[m_Received++], status);
+            }
+            // release the stream, and with it a reference to the Executor, while the batcher is
+            // still guaranteed to hold another one; destroying a stream from its own completion
+            // callback is allowed
+            m_Stream.reset();
+
+            auto config = m_Config;
+            auto self = std::move(m_Self);
+            self.reset();
+
+            std::lock_guard<std::mutex> lock(config->mutex);
+            config->outstanding--;
+            config->cv.notify_all();
+        }
+
+        void Complete(Item& item, ::grpc::Status& status)
+        {
+            if(m_Config->on_latency)
+            {
+                using seconds = std::chrono::duration<double>;
+                Latency latency;
+                latency.queued = seconds(m_SentAt - item.enqueued).count();
+                latency.total = seconds(Clock::now() - item.enqueued).count();
+                latency.batch_size = m_Items.size();
+                m_Config->on_latency(latency);
+            }
+            item.callback(item.response, status);
+        }
+
+        Config* m_Config;
+        std::mutex m_Mutex;
+        bool m_Sealed;
+        std::vector<Item> m_Items;
+        std::size_t m_Received;
+        Clock::time_point m_SentAt;
+        std::unique_ptr<ClientStreaming<Request, Response>> m_Stream;
+        std::shared_ptr<AlarmContext> m_Timer;
+        std::shared_ptr<Batch> m_Self;
+    };
+
+    std::shared_ptr<AlarmContext> StartTimer(const std::shared_ptr<Batch>& batch)
+    {
+        std::weak_ptr<Batch> weak = batch;
+        auto deadline = std::chrono::system_clock::now() + m_MaxWait;
+        return AlarmContext::Schedule(*m_Config->executor, deadline, [weak](bool ok) {
+            auto batch = weak.lock();
+            if(ok && batch && batch->Seal())
+            {
+                batch->Send();
+            }
+        });
+    }
+
+    std::unique_ptr<Config> m_Config;
+    std::chrono::microseconds m_MaxWait;
+    std::mutex m_Mutex;
+    std::shared_ptr<Batch> m_Current;
+};
+
+} // namespace client
+} // namespace nvrpc
@@ -0,0 +1,453 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glog/logging.h>
+#include <grpc++/grpc++.h>
+
+#include "nvrpc/client/alarm.h"
+#include "nvrpc/client/base_context.h"
+#include "nvrpc/client/channel_pool.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/client/hedging.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Unary client that hedges and retries idempotent calls across routes
+ *
+ * A route is an endpoint, given as one PrepareFn per endpoint, or a channel of a StubPool.
+ * The first attempt of each call goes to the next route in round-robin order (or the channel
+ * chosen by the pool's SelectionPolicy); each further attempt goes to the route after the
+ * previous one.  See HedgingPolicy for when hedges and retries are sent.  Only use this client
+ * for calls that are safe to execute more than once.
+ *
+ * Hedge delays and retry backoffs are alarms on the Executor's completion queues, and losing
+ * attempts are cancelled with TryCancel; no thread blocks on a call.  on_return receives the
+ * HedgedCallCounters of the call in addition to the ClientUnary arguments.
+ */
+template<typename Request, typename Response>
+class ClientHedgedUnary
+    : public ::trtlab::AsyncComputeWrapper<void(Request&, Response&, ::grpc::Status&,
+                                                const HedgedCallCounters&)>
+{
+  public:
+    using PrepareFn = std::function<std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>(
+        ::grpc::ClientContext*, const Request&, ::grpc::CompletionQueue*)>;
+
+    using RouteFn = std::function<std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>(
+        std::size_t, ::grpc::ClientContext*, const Request&, ::grpc::CompletionQueue*)>;
+
+    /**
+     * @brief Sums of the HedgedCallCounters of all completed calls
+     */
+    struct Totals
+    {
+        std::uint64_t calls = 0;
+        std::uint64_t failed = 0;
+        std::uint64_t attempts = 0;
+        std::uint64_t hedges = 0;
+        std::uint64_t retries = 0;
+        std::uint64_t cancelled = 0;
+        std::uint64_t throttled = 0;
+        std::uint64_t hedge_wins = 0;
+    };
+
+    ClientHedgedUnary(std::vector<PrepareFn> routes, std::shared_ptr<Executor> executor,
+                      HedgingPolicy policy = HedgingPolicy())
+        : m_Shared(new Shared(policy))
+    {
+        CHECK(!routes.empty()) << "ClientHedgedUnary requires at least one route";
+        m_Shared->routes = routes.size();
+        m_Shared->route_fn = [routes](std::size_t route, ::grpc::ClientContext* context,
+                                      const Request& request, ::grpc::CompletionQueue* cq) {
+            return routes[route](context, request, cq);
+        };
+        m_Shared->executor = executor;
+    }
+
+    /**
+     * @brief Hedge and retry across the channels of a StubPool
+     *
+     * stub_prepare_fn has the PrepareFn signature with the Stub of the selected channel as an
+     * additional first argument.  Each attempt holds its channel until it completes.
+     */
+    template<typename ServiceType, typename StubPrepareFn>
+    ClientHedgedUnary(std::shared_ptr<StubPool<ServiceType>> pool, StubPrepareFn stub_prepare_fn,
+                      std::shared_ptr<Executor> executor, HedgingPolicy policy = HedgingPolicy())
+        : m_Shared(new Shared(policy))
+    {
+        auto stubs = pool.get();
+        m_Shared->routes = pool->Size();
+        m_Shared->route_fn = [stubs, stub_prepare_fn](std::size_t route,
+                                                      ::grpc::ClientContext* context,
+                                                      const Request& request,
+                                                      ::grpc::CompletionQueue* cq) {
+            return stub_prepare_fn(stubs->Stub(route), context, request, cq);
+        };
+        m_Shared->pool = pool;
+        m_Shared->executor = executor;
+    }
+
+    /**
+     * @brief Waits for every attempt in flight, including cancelled losers, to complete
+     *
+     * Must not be called from an Executor thread, e.g. from within an on_return callback.
+     */
+    ~ClientHedgedUnary()
+    {
+        std::unique_lock<std::mutex> lock(m_Shared->mutex);
+        m_Shared->cv.wait(lock, [this] { return m_Shared->outstanding == 0; });
+    }
+
+    template<typename OnReturnFn>
+    auto Enqueue(Request&& request, OnReturnFn on_return)
+    {
+        auto wrapped = this->Wrap(on_return);
+        auto future = wrapped->Future();
+
+        auto call = std::make_shared<Call>(
+            m_Shared.get(), std::move(request),
+            [wrapped](Request& request, Response& response, ::grpc::Status& status,
+                      const HedgedCallCounters& counters) mutable {
+                (*wrapped)(request, response, status, counters);
+            });
+        call->Start();
+
+        return future.share();
+    }
+
+    Totals GetTotals() const
+    {
+        std::lock_guard<std::mutex> lock(m_Shared->mutex);
+        return m_Shared->totals;
+    }
+
+    const HedgingPolicy& GetHedgingPolicy() const { return m_Shared->policy; }
+
+    std::chrono::nanoseconds CurrentHedgeDelay()
+    {
+        return HedgeDelay(m_Shared->policy, m_Shared->latencies);
+    }
+
+    double RetryBudgetTokens() const { return m_Shared->budget.Tokens(); }
+
+  private:
+    using Clock = std::chrono::high_resolution_clock;
+    using Callback =
+        std::function<void(Request&, Response&, ::grpc::Status&, const HedgedCallCounters&)>;
+
+    // state shared by all calls; owned by the client, which outlives its calls
+    struct Shared
+    {
+        Shared(const HedgingPolicy& p)
+            : policy(p), budget(p.budget_ratio, p.budget_max_tokens), next_route(0),
+              outstanding(0)
+        {
+        }
+
+        const HedgingPolicy policy;
+        RouteFn route_fn;
+        std::size_t routes;
+        std::shared_ptr<ChannelPool> pool;
+        std::shared_ptr<Executor> executor;
+
+        RetryBudget budget;
+        LatencyWindow latencies;
+        std::atomic<std::size_t> next_route;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t outstanding;
+        Totals totals;
+    };
+
+    class Call;
+
+    class Attempt : public BaseContext
+    {
+      public:
+        Attempt(std::shared_ptr<Call> call, std::uint32_t index, std::size_t route, bool hedge)
+            : m_Call(call), m_Index(index), m_Route(route), m_Hedge(hedge), m_Start(Clock::now())
+        {
+        }
+        ~Attempt() override {}
+
+      private:
+        bool RunNextState(bool ok) final override
+        {
+            m_Call->AttemptDone(this);
+            return false;
+        }
+
+        bool ExecutorShouldDeleteContext() const override { return true; }
+
+        std::shared_ptr<Call> m_Call;
+        std::uint32_t m_Index;
+        std::size_t m_Route;
+        bool m_Hedge;
+        Clock::time_point m_Start;
+        ::grpc::ClientContext m_Context;
+        Response m_Response;
+        ::grpc::Status m_Status;
+        std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>> m_Reader;
+
+        friend class Call;
+    };
+
+    class Call : public std::enable_shared_from_this<Call>
+    {
+      public:
+        Call(Shared* shared, Request&& request, Callback callback)
+            : m_Shared(shared), m_Request(std::move(request)), m_Callback(callback),
+              m_Done(false), m_HedgeWon(false), m_Primary(0)
+        {
+            std::lock_guard<std::mutex> lock(m_Shared->mutex);
+            m_Shared->outstanding++;
+        }
+
+        ~Call()
+        {
+            std::lock_guard<std::mutex> lock(m_Shared->mutex);
+            m_Shared->outstanding--;
+            m_Shared->cv.notify_all();
+        }
+
+        void Start()
+        {
+            const auto& policy = m_Shared->policy;
+            m_Shared->budget.Deposit();
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Start = Clock::now();
+            m_Primary = m_Shared->pool ? m_Shared->pool->Acquire()
+                                       : m_Shared->next_route++ % m_Shared->routes;
+            StartAttempt();
+
+            if(policy.hedge_percentile > 0.0 && policy.max_attempts > 1)
+            {
+                auto self = this->shared_from_this();
+                auto deadline = std::chrono::system_clock::now() +
+                                std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                    HedgeDelay(policy, m_Shared->latencies));
+                m_HedgeTimer = AlarmContext::Schedule(*m_Shared->executor, deadline,
+                                                      [self](bool ok) { self->HedgeTimer(ok); });
+            }
+        }
+
+        void AttemptDone(Attempt* attempt)
+        {
+            const auto& policy = m_Shared->policy;
+            bool deliver = false;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_InFlight.erase(std::find(m_InFlight.begin(), m_InFlight.end(), attempt));
+                if(m_Shared->pool)
+                {
+                    m_Shared->pool->Release(attempt->m_Route);
+                }
+
+                auto& status = attempt->m_Status;
+                DLOG(INFO) << "Attempt " << attempt->m_Index << " on route " << attempt->m_Route
+                           << " finished with " << status.error_code();
+                if(status.ok())
+                {
+                    m_Shared->latencies.Record(Clock::now() - attempt->m_Start);
+                }
+                if(m_Done)
+                {
+                    // a losing attempt
+                    return;
+                }
+
+                m_Status = status;
+                if(status.ok() || !policy.retryable_codes.count(status.error_code()))
+                {
+                    m_Response = std::move(attempt->m_Response);
+                    m_Counters.winner = attempt->m_Index;
+                    m_HedgeWon = attempt->m_Hedge;
+                    deliver = Finish();
+                }
+                else if(!m_InFlight.empty())
+                {
+                    // an outstanding hedge may still succeed
+                    return;
+                }
+                else if(m_Counters.attempts >= policy.max_attempts)
+                {
+                    deliver = Finish();
+                }
+                else if(!m_Shared->budget.TryWithdraw())
+                {
+                    m_Counters.throttled++;
+                    deliver = Finish();
+                }
+                else
+                {
+                    auto self = this->shared_from_this();
+                    auto deadline =
+                        std::chrono::system_clock::now() +
+                        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                            RetryBackoff(policy, m_Counters.retries));
+                    AlarmContext::Schedule(*m_Shared->executor, deadline,
+                                           [self](bool ok) { self->RetryTimer(ok); });
+                }
+            }
+            if(deliver)
+            {
+                Deliver();
+            }
+        }
+
+      private:
+        // must be called with m_Mutex held
+        void StartAttempt(bool hedge = false)
+        {
+            auto index = m_Counters.attempts++;
+            auto route = (m_Primary + index) % m_Shared->routes;
+            if(m_Shared->pool && index)
+            {
+                m_Shared->pool->Acquire(route);
+            }
+
+            auto attempt = new Attempt(this->shared_from_this(), index, route, hedge);
+            m_InFlight.push_back(attempt);
+            attempt->m_Reader = m_Shared->route_fn(route, &attempt->m_Context, m_Request,
+                                                   m_Shared->executor->GetNextCQ());
+            attempt->m_Reader->StartCall();
+            attempt->m_Reader->Finish(&attempt->m_Response, &attempt->m_Status, attempt->Tag());
+        }
+
+        void HedgeTimer(bool ok)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            // no hedge while a retry is waiting out its backoff
+            if(!ok || m_Done || m_InFlight.empty() ||
+               m_Counters.attempts >= m_Shared->policy.max_attempts)
+            {
+                return;
+            }
+            if(!m_Shared->budget.TryWithdraw())
+            {
+                m_Counters.throttled++;
+                return;
+            }
+            m_Counters.hedges++;
+            StartAttempt(true);
+        }
+
+        void RetryTimer(bool ok)
+        {
+            bool deliver = false;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if(m_Done)
+                {
+                    return;
+                }
+                if(!ok)
+                {
+                    deliver = Finish();
+                }
+                else
+                {
+                    m_Counters.retries++;
+                    StartAttempt();
+                }
+            }
+            if(deliver)
+            {
+                Deliver();
+            }
+        }
+
+        // must be called with m_Mutex held; the caller delivers once the lock is released
+        bool Finish()
+        {
+            m_Done = true;
+            for(auto attempt : m_InFlight)
+            {
+                attempt->m_Context.TryCancel();
+                m_Counters.cancelled++;
+            }
+            if(m_HedgeTimer)
+            {
+                m_HedgeTimer->Cancel();
+                m_HedgeTimer.reset();
+            }
+            return true;
+        }
+
+        void Deliver()
+        {
+            using seconds = std::chrono::duration<double>;
+            m_Counters.latency = seconds(Clock::now() - m_Start).count();
+            {
+                std::lock_guard<std::mutex> lock(m_Shared->mutex);
+                auto& totals = m_Shared->totals;
+                totals.calls++;
+                totals.failed += m_Status.ok() ? 0 : 1;
+                totals.attempts += m_Counters.attempts;
+                totals.hedges += m_Counters.hedges;
+                totals.retries += m_Counters.retries;
+                totals.cancelled += m_Counters.cancelled;
+                totals.throttled += m_Counters.throttled;
+                totals.hedge_wins += m_HedgeWon ? 1 : 0;
+            }
+            m_Callback(m_Request, m_Response, m_Status, m_Counters);
+        }
+
+        Shared* m_Shared;
+        Request m_Request;
+        Response m_Response;
+        ::grpc::Status m_Status;
+        Callback m_Callback;
+
+        std::mutex m_Mutex;
+        bool m_Done;
+        bool m_HedgeWon;
+        std::size_t m_Primary;
+        Clock::time_point m_Start;
+        std::vector<Attempt*> m_InFlight;
+        std::shared_ptr<AlarmContext> m_HedgeTimer;
+        HedgedCallCounters m_Counters;
+    };
+
+    std::unique_ptr<Shared> m_Shared;
+};
+
+} // namespace client
+} // namespace nvrpc
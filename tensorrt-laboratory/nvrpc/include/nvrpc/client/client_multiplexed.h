@@ -0,0 +1,226 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <grpc++/grpc++.h>
+
+#include "nvrpc/client/client_streaming.h"
+#include "nvrpc/client/executor.h"
+#include "nvrpc/correlation_id.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Independent unary-style calls multiplexed over one long-lived bidirectional stream
+ *
+ * Enqueue stamps each request with a fresh correlation id (see CorrelationId) and writes it on
+ * the shared stream; responses are matched by id and may arrive in any order, so a slow request
+ * does not block the ones behind it and no per-call RPC setup is paid.  The server side is
+ * nvrpc::MultiplexedContext.
+ *
+ * At most max_in_flight requests are outstanding; Enqueue waits for a response when the window
+ * is full.  When the stream ends, every unanswered request fails with the stream's Status, or
+ * UNAVAILABLE if the stream finished OK, as do requests enqueued afterwards.  The stream is not
+ * reopened.
+ */
+template<typename Request, typename Response>
+class ClientMultiplexed : public ::trtlab::AsyncComputeWrapper<void(Response&, ::grpc::Status&)>
+{
+  public:
+    using PrepareFn = typename ClientStreaming<Request, Response>::PrepareFn;
+
+    ClientMultiplexed(PrepareFn prepare_fn, std::shared_ptr<Executor> executor,
+                      std::size_t max_in_flight)
+        : m_Executor(executor), m_MaxInFlight(max_in_flight), m_NextID(0), m_Closed(false),
+          m_StreamDone(false), m_Finished(false)
+    {
+        CHECK_GT(max_in_flight, 0);
+        m_Stream = std::make_unique<ClientStreaming<Request, Response>>(
+            prepare_fn, executor, [](Request&&) {},
+            [this](Response&& response) { ResponseReceived(std::move(response)); });
+        m_Stream->OnComplete([this](const ::grpc::Status& status) { StreamComplete(status); });
+    }
+
+    /**
+     * @brief Closes the stream and waits for the responses to all outstanding requests
+     *
+     * Must not be called from an Executor thread, e.g. from within an on_return callback.
+     */
+    ~ClientMultiplexed()
+    {
+        Close();
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this] { return m_Finished; });
+    }
+
+    /**
+     * @brief Send a request on the shared stream
+     *
+     * on_return(Response&, ::grpc::Status&) is called on an Executor thread when the response
+     * arrives or the request fails; its result is available from the returned shared_future.
+     * Blocks while max_in_flight requests are outstanding, so it must not be called from an
+     * Executor thread when the window may be full.
+     */
+    template<typename OnReturnFn>
+    auto Enqueue(Request&& request, OnReturnFn on_return)
+    {
+        auto wrapped = this->Wrap(on_return);
+        auto future = wrapped->Future();
+        Callback callback = [wrapped](Response& response, ::grpc::Status& status) {
+            (*wrapped)(response, status);
+        };
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock,
+                         [this] { return m_Pending.size() < m_MaxInFlight || m_StreamDone; });
+        if(m_StreamDone || m_Closed)
+        {
+            auto status = m_StreamDone ? FailedStatus()
+                                     : ::grpc::Status(::grpc::StatusCode::UNAVAILABLE,
+                                                      "multiplexed stream is closed");
+            lock.unlock();
+            Response response;
+            callback(response, status);
+            return future.share();
+        }
+        auto id = ++m_NextID;
+        m_Pending.emplace(id, std::move(callback));
+        lock.unlock();
+
+        // the stream may run callbacks on this thread, so it is used without holding m_Mutex;
+        // if the write fails, the request is failed when the stream completes
+        CorrelationId<Request>::Set(request, id);
+        m_Stream->Write(std::move(request));
+        return future.share();
+    }
+
+    /**
+     * @brief Close the client side of the stream; outstanding requests are still answered
+     */
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(m_Closed)
+            {
+                return;
+            }
+            m_Closed = true;
+        }
+        m_Stream->Done();
+    }
+
+    std::size_t InFlight()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Pending.size();
+    }
+
+  private:
+    using Callback = std::function<void(Response&, ::grpc::Status&)>;
+
+    void ResponseReceived(Response&& response)
+    {
+        auto id = CorrelationId<Response>::Get(response);
+        Callback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto search = m_Pending.find(id);
+            if(search == m_Pending.end())
+            {
+                LOG(WARNING) << "dropping response with unknown correlation id " << id;
+                return;
+            }
+            callback = std::move(search->second);
+            m_Pending.erase(search);
+        }
+        m_Condition.notify_all();
+        ::grpc::Status status;
+        callback(response, status);
+    }
+
+    void StreamComplete(const ::grpc::Status& status)
+    {
+        std::unordered_map<std::uint64_t, Callback> unanswered;
+        ::grpc::Status failed;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Status = status;
+            m_StreamDone = true;
+            failed = FailedStatus();
+            unanswered.swap(m_Pending);
+        }
+        m_Condition.notify_all();
+        for(auto& pending : unanswered)
+        {
+            Response response;
+            pending.second(response, failed);
+        }
+
+        // set last: the destructor may run as soon as m_Finished is observed
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Finished = true;
+        m_Condition.notify_all();
+    }
+
+    // must be called with m_Mutex held
+    ::grpc::Status FailedStatus() const
+    {
+        if(m_Status.ok())
+        {
+            return ::grpc::Status(::grpc::StatusCode::UNAVAILABLE,
+                                  "multiplexed stream finished before the response");
+        }
+        return m_Status;
+    }
+
+    std::shared_ptr<Executor> m_Executor;
+    std::unique_ptr<ClientStreaming<Request, Response>> m_Stream;
+    const std::size_t m_MaxInFlight;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::unordered_map<std::uint64_t, Callback> m_Pending;
+    std::uint64_t m_NextID;
+    ::grpc::Status m_Status;
+    bool m_Closed;
+    bool m_StreamDone;
+    bool m_Finished;
+};
+
+} // namespace client
+} // namespace nvrpc
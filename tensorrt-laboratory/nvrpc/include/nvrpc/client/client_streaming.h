@@ -27,10 +27,13 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <queue>
 
 #include <grpc++/grpc++.h>
 
 #include "nvrpc/client/base_context.h"
+#include "nvrpc/client/channel_pool.h"
 #include "nvrpc/client/executor.h"
 #include "tensorrt/laboratory/core/async_compute.h"
 
@@ -49,9 +52,28 @@ struct ClientStreaming : public BaseContext
 
     using ReadCallback = std::function<void(Response&&)>;
     using WriteCallback = std::function<void(Request&&)>;
+    using CompleteCallback = std::function<void(const ::grpc::Status&)>;
 
     ClientStreaming(PrepareFn, std::shared_ptr<Executor>, WriteCallback, ReadCallback);
-    ~ClientStreaming() { DLOG(INFO) << "ClientStreaming dtor"; }
+
+    /**
+     * @brief Open the stream on a connection chosen from a StubPool
+     *
+     * stub_prepare_fn has the PrepareFn signature with the Stub of the selected channel as an
+     * additional first argument.  The channel is held until the stream finishes.
+     */
+    template<typename ServiceType, typename StubPrepareFn>
+    ClientStreaming(std::shared_ptr<StubPool<ServiceType>> pool, StubPrepareFn stub_prepare_fn,
+                    std::shared_ptr<Executor> executor, WriteCallback OnWrite, ReadCallback OnRead)
+        : ClientStreaming(pool, pool->Acquire(), stub_prepare_fn, executor, OnWrite, OnRead)
+    {
+    }
+
+    ~ClientStreaming()
+    {
+        DLOG(INFO) << "ClientStreaming dtor";
+        ReleaseChannel();
+    }
 
     // void Write(Request*);
     bool Write(Request&&);
@@ -59,15 +81,72 @@ struct ClientStreaming : public BaseContext
     std::shared_future<::grpc::Status> Status();
     std::shared_future<::grpc::Status> Done();
 
-    bool SetCorked(bool true_or_false) { m_Corked = true_or_false; }
+    /**
+     * @brief Invoke callback with the final Status once the stream has finished
+     *
+     * Runs on the Executor thread that completed the stream, after the futures returned by
+     * Status and Done are ready; if the stream has already completed, callback is invoked on the
+     * calling thread.  The ClientStreaming object may be destroyed from within the callback.
+     */
+    void OnComplete(CompleteCallback callback);
+
+    /**
+     * @brief Hold back writes until Flush, Done or uncork
+     *
+     * While corked, Write only queues requests.  Uncorking flushes the queue.  Returns the
+     * previous setting.
+     */
+    bool SetCorked(bool true_or_false);
 
     bool IsCorked() const { return m_Corked; }
 
+    /**
+     * @brief Send all queued requests as one burst
+     *
+     * Every request but the last is written with a buffer hint, so gRPC coalesces the burst
+     * into as few transport writes as possible instead of flushing per message.
+     */
+    void Flush();
+
+    /**
+     * @brief Coalesce writes that queue up behind an in-flight write
+     *
+     * When more requests are waiting, the next one is written with a buffer hint.  At most
+     * max_burst requests in a row are buffered before a flush is forced.  0 disables, which is
+     * the default: every uncorked Write is flushed individually.
+     */
+    void SetAutoCoalesce(std::size_t max_burst);
+
     bool ExecutorShouldDeleteContext() const override { return false; }
 
     void ExecutorShouldDeleteContext(bool true_or_false) { m_ShouldDelete = true_or_false; }
 
   private:
+    ClientStreaming(PrepareFn, std::shared_ptr<Executor>, WriteCallback, ReadCallback,
+                    std::shared_ptr<ChannelPool>, std::size_t channel);
+
+    template<typename ServiceType, typename StubPrepareFn>
+    ClientStreaming(std::shared_ptr<StubPool<ServiceType>> pool, std::size_t channel,
+                    StubPrepareFn stub_prepare_fn, std::shared_ptr<Executor> executor,
+                    WriteCallback OnWrite, ReadCallback OnRead)
+        : ClientStreaming(
+              [stub = pool->Stub(channel), stub_prepare_fn](::grpc::ClientContext* context,
+                                                            ::grpc::CompletionQueue* cq) {
+                  return stub_prepare_fn(stub, context, cq);
+              },
+              executor, OnWrite, OnRead, pool, channel)
+    {
+    }
+
+    void ReleaseChannel()
+    {
+        if(m_Pool)
+        {
+            m_Pool->Release(m_Channel);
+            m_Pool.reset();
+        }
+    }
+
     bool RunNextState(bool ok) final override { return (this->*m_NextState)(ok); }
 
     bool RunNextState(bool (ClientStreaming<Request, Response>::*state_fn)(bool), bool ok)
@@ -99,6 +178,8 @@ struct ClientStreaming : public BaseContext
     ::grpc::ClientContext m_Context;
     std::unique_ptr<::grpc::ClientAsyncReaderWriter<Request, Response>> m_Stream;
     std::promise<::grpc::Status> m_Promise;
+    std::shared_future<::grpc::Status> m_Future;
+    CompleteCallback m_CompleteCallback;
 
     PrepareFn m_PrepareFn;
 
@@ -116,12 +197,29 @@ struct ClientStreaming : public BaseContext
     std::queue<Request> m_WriteQueue;
 
     std::shared_ptr<Executor> m_Executor;
+    std::shared_ptr<ChannelPool> m_Pool;
+    std::size_t m_Channel;
 
     bool m_Corked;
     bool m_ShouldDelete;
 
+    // queued requests that may be posted, remainder of the current Flush burst, and the
+    // auto-coalesce limit with the number of buffered writes since the last flush
+    std::size_t m_Released;
+    std::size_t m_BurstRemaining;
+    std::size_t m_CoalesceLimit;
+    std::size_t m_Coalesced;
+
+    enum class WriteAction
+    {
+        None,
+        Send,
+        Buffer,
+        SendLast
+    };
+
     using ReadHandle = bool;
-    using WriteHandle = bool;
+    using WriteHandle = WriteAction;
     using ExecuteHandle = std::function<void()>;
     using CloseHandle = bool;
     using FinishHandle = bool;
@@ -130,10 +228,12 @@ struct ClientStreaming : public BaseContext
                                CompleteHandle>;
 
     bool m_Reading, m_Writing, m_Finishing, m_Closing, m_ReadsDone, m_WritesDone, m_FinishDone;
+    bool m_Complete, m_Notified;
 
     bool (ClientStreaming<Request, Response>::*m_NextState)(bool);
 
     Actions EvaluateState();
+    void ReleaseWrites();
     void ForwardProgress(Actions& actions);
 
     bool StateStreamInitialized(bool);
@@ -149,10 +249,23 @@ template<typename Request, typename Response>
 ClientStreaming<Request, Response>::ClientStreaming(PrepareFn prepare_fn,
                                                     std::shared_ptr<Executor> executor,
                                                     WriteCallback OnWrite, ReadCallback OnRead)
-    : m_Executor(executor), m_PrepareFn(prepare_fn), m_ReadState(this), m_WriteState(this),
-      m_ReadCallback(OnRead), m_WriteCallback(OnWrite), m_Reading(false), m_Writing(false),
-      m_Finishing(false), m_Closing(false), m_ReadsDone(false), m_WritesDone(false),
-      m_FinishDone(false), m_ShouldDelete(false), m_Corked(false)
+    : ClientStreaming(prepare_fn, executor, OnWrite, OnRead, nullptr, 0)
+{
+}
+
+template<typename Request, typename Response>
+ClientStreaming<Request, Response>::ClientStreaming(PrepareFn prepare_fn,
+                                                    std::shared_ptr<Executor> executor,
+                                                    WriteCallback OnWrite, ReadCallback OnRead,
+                                                    std::shared_ptr<ChannelPool> pool,
+                                                    std::size_t channel)
+    : m_Future(m_Promise.get_future().share()), m_PrepareFn(prepare_fn),
+      m_ReadCallback(OnRead), m_WriteCallback(OnWrite), m_ReadState(this), m_WriteState(this),
+      m_Executor(executor), m_Pool(pool), m_Channel(channel), m_Corked(false),
+      m_ShouldDelete(false), m_Released(0), m_BurstRemaining(0), m_CoalesceLimit(0),
+      m_Coalesced(0), m_Reading(false), m_Writing(false), m_Finishing(false), m_Closing(false),
+      m_ReadsDone(false), m_WritesDone(false), m_FinishDone(false), m_Complete(false),
+      m_Notified(false)
 {
     m_NextState = &ClientStreaming<Request, Response>::StateStreamInitialized;
     m_ReadState.m_NextState = &ClientStreaming<Request, Response>::StateInvalid;
@@ -186,7 +299,10 @@ bool ClientStreaming<Request, Response>::Write(Request&& request)
         }
 
         m_WriteQueue.push(std::move(request));
-        m_WriteState.m_NextState = &ClientStreaming<Request, Response>::StateWriteDone;
+        if(!m_Corked)
+        {
+            m_Released++;
+        }
 
         actions = EvaluateState();
     }
@@ -197,23 +313,90 @@ bool ClientStreaming<Request, Response>::Write(Request&& request)
 template<typename Request, typename Response>
 std::shared_future<::grpc::Status> ClientStreaming<Request, Response>::Done()
 {
+    // an OnComplete callback may destroy this object before ForwardProgress returns
+    auto future = m_Future;
     Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
         DLOG(INFO) << "Sending WritesDone - Closing Client -> Server side of the stream";
 
         m_WritesDone = true;
+        ReleaseWrites();
+
+        actions = EvaluateState();
+    }
+    ForwardProgress(actions);
+    return future;
+}
 
+template<typename Request, typename Response>
+bool ClientStreaming<Request, Response>::SetCorked(bool true_or_false)
+{
+    bool was_corked;
+    Actions actions;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        was_corked = m_Corked;
+        m_Corked = true_or_false;
+        if(!was_corked || m_Corked)
+        {
+            return was_corked;
+        }
+        ReleaseWrites();
+        actions = EvaluateState();
+    }
+    ForwardProgress(actions);
+    return was_corked;
+}
+
+template<typename Request, typename Response>
+void ClientStreaming<Request, Response>::Flush()
+{
+    Actions actions;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ReleaseWrites();
         actions = EvaluateState();
     }
     ForwardProgress(actions);
-    return m_Promise.get_future();
+}
+
+template<typename Request, typename Response>
+void ClientStreaming<Request, Response>::SetAutoCoalesce(std::size_t max_burst)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_CoalesceLimit = max_burst;
+}
+
+// must be called with m_Mutex held
+template<typename Request, typename Response>
+void ClientStreaming<Request, Response>::ReleaseWrites()
+{
+    // the front of the queue is the in-flight write, if any
+    m_Released = m_WriteQueue.size() - (m_Writing ? 1 : 0);
+    m_BurstRemaining = m_Released;
 }
 
 template<typename Request, typename Response>
 std::shared_future<::grpc::Status> ClientStreaming<Request, Response>::Status()
 {
-    return m_Promise.get_future();
+    return m_Future;
+}
+
+template<typename Request, typename Response>
+void ClientStreaming<Request, Response>::OnComplete(CompleteCallback callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(!m_Notified)
+        {
+            m_CompleteCallback = std::move(callback);
+            return;
+        }
+    }
+    // ForwardProgress has taken the callbacks; the stream is done once the promise is set
+    auto status = m_Future.get();
+    callback(status);
 }
 
 template<typename Request, typename Response>
@@ -221,7 +404,7 @@ typename ClientStreaming<Request, Response>::Actions
     ClientStreaming<Request, Response>::EvaluateState()
 {
     ReadHandle should_read = false;
-    WriteHandle should_write = nullptr;
+    WriteHandle should_write = WriteAction::None;
     ExecuteHandle should_execute = nullptr;
     CloseHandle should_close = false;
     FinishHandle should_finish = false;
@@ -245,9 +428,32 @@ typename ClientStreaming<Request, Response>::Actions
             };
             m_ReadQueue.pop();
         }
-        if(!m_Writing && !m_WriteQueue.empty())
+        if(!m_Writing && m_Released)
         {
-            should_write = true;
+            m_Released--;
+            if(m_WritesDone && !m_Closing && m_WriteQueue.size() == 1)
+            {
+                // half-close with the final request instead of a separate WritesDone
+                should_write = WriteAction::SendLast;
+                m_Closing = true;
+            }
+            else if(m_BurstRemaining > 1)
+            {
+                should_write = WriteAction::Buffer;
+            }
+            else if(m_CoalesceLimit && m_Released && m_Coalesced < m_CoalesceLimit)
+            {
+                should_write = WriteAction::Buffer;
+            }
+            else
+            {
+                should_write = WriteAction::Send;
+            }
+            if(m_BurstRemaining)
+            {
+                m_BurstRemaining--;
+            }
+            m_Coalesced = (should_write == WriteAction::Buffer ? m_Coalesced + 1 : 0);
             m_Writing = true;
             m_WriteState.m_NextState = &ClientStreaming<Request, Response>::StateWriteDone;
         }
@@ -263,14 +469,15 @@ typename ClientStreaming<Request, Response>::Actions
             m_Finishing = true;
             m_NextState = &ClientStreaming<Request, Response>::StateFinishDone;
         }
-        if(m_ReadsDone && m_WritesDone && m_FinishDone)
+        if(m_ReadsDone && m_WritesDone && m_FinishDone && !m_Complete)
         {
             should_complete = true;
+            m_Complete = true;
         }
     }
 
     // clang-format off
-    DLOG(INFO) << (should_read ? 1 : 0) << (should_write ? 1 : 0) << (should_execute ? 1 : 0)
+    DLOG(INFO) << (should_read ? 1 : 0) << (should_write != WriteAction::None ? 1 : 0) << (should_execute ? 1 : 0)
                << (should_finish ? 1 : 0) 
                << " -- " << m_Reading << m_Writing << m_Finishing
                << " -- " << m_ReadsDone << m_WritesDone
@@ -296,19 +503,19 @@ void ClientStreaming<Request, Response>::ForwardProgress(Actions& actions)
         DLOG(INFO) << "Posting Read/Recv";
         m_Stream->Read(&m_ReadQueue.back(), m_ReadState.Tag());
     }
-    if(should_write)
+    if(should_write != WriteAction::None)
     {
         DLOG(INFO) << "Writing/Sending Request";
-        if(m_Corked)
+        ::grpc::WriteOptions options;
+        if(should_write == WriteAction::Buffer)
         {
-            ::grpc::WriteOptions options;
-            options.set_corked();
-            m_Stream->Write(m_WriteQueue.front(), options, m_WriteState.Tag());
+            options.set_buffer_hint();
         }
-        else
+        else if(should_write == WriteAction::SendLast)
         {
-            m_Stream->Write(m_WriteQueue.front(), m_WriteState.Tag());
+            options.set_last_message();
         }
+        m_Stream->Write(m_WriteQueue.front(), options, m_WriteState.Tag());
     }
     if(should_close)
     {
@@ -328,20 +535,46 @@ void ClientStreaming<Request, Response>::ForwardProgress(Actions& actions)
     if(should_complete)
     {
         DLOG(INFO) << "Completing Promise";
-        m_Promise.set_value(std::move(m_Status));
+        // a callback registered from here on waits on the promise instead of running inline,
+        // so this object is not touched after the promise is set
+        CompleteCallback on_complete;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            on_complete = std::move(m_CompleteCallback);
+            m_Notified = true;
+        }
+        // copy the status; on_complete is allowed to destroy this object
+        auto status = m_Status;
+        m_Promise.set_value(status);
+        if(on_complete)
+        {
+            on_complete(status);
+        }
     }
 }
 
 template<typename Request, typename Response>
 bool ClientStreaming<Request, Response>::StateStreamInitialized(bool ok)
 {
+    Actions actions;
     if(!ok)
     {
         DLOG(INFO) << "Stream Failed to Initialize";
-        return false;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            // nothing was posted on the stream; collect the failed Status with Finish
+            m_NextState = &ClientStreaming<Request, Response>::StateInvalid;
+            m_ReadsDone = true;
+            m_WritesDone = true;
+            m_Closing = true;
+            m_WriteQueue = std::queue<Request>();
+            m_Released = 0;
+            actions = EvaluateState();
+        }
+        ForwardProgress(actions);
+        return true;
     }
 
-    Actions actions;
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
         DLOG(INFO) << "StreamInitialized";
@@ -405,12 +638,16 @@ bool ClientStreaming<Request, Response>::StateWriteDone(bool ok)
         {
             // Invalidate any outstanding reads on stream
             DLOG(ERROR) << "Failed to Write to Stream - shutting down";
+            // no WritesDone on a failed stream; Finish is posted once the reads have drained,
+            // which cancelling forces
             m_WritesDone = true;
+            m_Closing = true;
+            m_WriteQueue = std::queue<Request>();
+            m_Released = 0;
             if(!m_ReadsDone)
             {
                 m_Context.TryCancel();
             }
-            return false;
         }
 
         actions = EvaluateState();
@@ -456,6 +693,7 @@ bool ClientStreaming<Request, Response>::StateFinishDone(bool ok)
 
         m_Finishing = false;
         m_FinishDone = true;
+        ReleaseChannel();
 
         if(!ok)
         {
@@ -467,7 +705,8 @@ bool ClientStreaming<Request, Response>::StateFinishDone(bool ok)
         actions = EvaluateState();
     }
     ForwardProgress(actions);
-    return true;
+    // Finish is the last event of the stream; let the Executor retire it
+    return false;
 }
 /*
         DLOG(INFO) << "Read/Download portion of the stream has closed";
@@ -25,14 +25,22 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
 
 #include <glog/logging.h>
 #include <grpc++/grpc++.h>
 
 #include "nvrpc/client/base_context.h"
+#include "nvrpc/client/channel_pool.h"
 #include "nvrpc/client/executor.h"
+#include "nvrpc/client/flow_controller.h"
+#include "nvrpc/client/load_balancer.h"
 #include "tensorrt/laboratory/core/async_compute.h"
 
 namespace nvrpc {
@@ -45,19 +53,110 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
     using PrepareFn = std::function<std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>(
         ::grpc::ClientContext*, const Request&, ::grpc::CompletionQueue*)>;
 
+    using PooledPrepareFn =
+        std::function<std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>(
+            std::size_t, ::grpc::ClientContext*, const Request&, ::grpc::CompletionQueue*)>;
+
+    using BalancedPrepareFn =
+        std::function<std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>>(
+            const LoadBalancer::Endpoint&, ::grpc::ClientContext*, const Request&,
+            ::grpc::CompletionQueue*)>;
+
+    /**
+     * @brief Callback of EnqueuePooled
+     *
+     * Runs on an executor thread.  The Request and Response belong to a recycled call context
+     * and are only valid until the callback returns.
+     */
+    using PooledCallback = std::function<void(Request&, Response&, ::grpc::Status&)>;
+
     ClientUnary(PrepareFn prepare_fn, std::shared_ptr<Executor> executor)
-        : m_PrepareFn(prepare_fn), m_Executor(executor)
+        : m_PrepareFn(prepare_fn), m_Executor(executor),
+          m_ContextPool(std::make_shared<ContextPool>(executor->Size()))
+    {
+    }
+
+    /**
+     * @brief Spread calls over the connections of a StubPool
+     *
+     * stub_prepare_fn has the PrepareFn signature with the Stub of the selected channel as an
+     * additional first argument.  A channel is held from Enqueue until the call completes.
+     */
+    template<typename ServiceType, typename StubPrepareFn>
+    ClientUnary(std::shared_ptr<StubPool<ServiceType>> pool, StubPrepareFn stub_prepare_fn,
+                std::shared_ptr<Executor> executor)
+        : m_Pool(pool), m_Executor(executor),
+          m_ContextPool(std::make_shared<ContextPool>(executor->Size()))
     {
+        auto stubs = pool.get();
+        m_PooledPrepareFn = [stubs, stub_prepare_fn](std::size_t channel,
+                                                     ::grpc::ClientContext* context,
+                                                     const Request& request,
+                                                     ::grpc::CompletionQueue* cq) {
+            return stub_prepare_fn(stubs->Stub(channel), context, request, cq);
+        };
+    }
+
+    /**
+     * @brief Balance calls over the endpoints of a StubBalancer
+     *
+     * stub_prepare_fn has the PrepareFn signature with the Stub of the picked endpoint as an
+     * additional first argument.  Each call's latency and Status are reported to the balancer.
+     */
+    template<typename ServiceType, typename StubPrepareFn>
+    ClientUnary(std::shared_ptr<StubBalancer<ServiceType>> balancer, StubPrepareFn stub_prepare_fn,
+                std::shared_ptr<Executor> executor)
+        : m_Balancer(balancer), m_Executor(executor),
+          m_ContextPool(std::make_shared<ContextPool>(executor->Size()))
+    {
+        m_BalancedPrepareFn = [stub_prepare_fn](const LoadBalancer::Endpoint& endpoint,
+                                                ::grpc::ClientContext* context,
+                                                const Request& request,
+                                                ::grpc::CompletionQueue* cq) {
+            return stub_prepare_fn(StubBalancer<ServiceType>::Stub(endpoint), context, request,
+                                   cq);
+        };
     }
 
     ~ClientUnary() {}
 
+    /**
+     * @brief Admit calls through a FlowController
+     *
+     * Enqueue calls Acquire before sending; if the controller fails fast, the call is not sent
+     * and on_return receives RESOURCE_EXHAUSTED.  Each completed call is reported to the
+     * controller with its latency and Status.  Set before the first Enqueue.
+     *
+     * With FlowControlPolicy::OnLimit::Wait, Enqueue and EnqueuePooled block the calling thread
+     * until the controller admits the call.  Capacity is returned as calls complete on the
+     * Executor threads, so a waiting controller must not be used to enqueue from an on_return
+     * callback; use FailFast there.
+     */
+    void SetFlowController(std::shared_ptr<FlowController> flow_controller)
+    {
+        m_FlowController = flow_controller;
+    }
+
+    /**
+     * @brief Start a call; on_return runs on an Executor thread once it completes
+     *
+     * Returns once the call is sent, except that it blocks while a FlowController set with
+     * OnLimit::Wait has no capacity; see SetFlowController.
+     */
     template<typename OnReturnFn>
     auto Enqueue(Request* request, Response* response, OnReturnFn on_return, std::map<std::string, std::string>& headers)
     {
         auto wrapped = this->Wrap(on_return);
         auto future = wrapped->Future();
 
+        if(m_FlowController && !m_FlowController->Acquire())
+        {
+            ::grpc::Status status(::grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                  "call rejected by client flow control");
+            (*wrapped)(*request, *response, status);
+            return future.share();
+        }
+
         Context* ctx = new Context;
         ctx->m_Request = request;
         ctx->m_Response = response;
@@ -65,12 +164,33 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
             (*wrapped)(*ctx->m_Request, *ctx->m_Response, ctx->m_Status);
         };
 
+        ctx->m_Start = std::chrono::steady_clock::now();
+        ctx->m_FlowController = m_FlowController;
+
         for (auto& header : headers)
         {
             ctx->m_Context.AddMetadata(header.first, header.second);
         }
 
-        ctx->m_Reader = m_PrepareFn(&ctx->m_Context, *ctx->m_Request, m_Executor->GetNextCQ());
+        if(m_Pool)
+        {
+            ctx->m_Pool = m_Pool;
+            ctx->m_Channel = m_Pool->Acquire();
+            ctx->m_Reader = m_PooledPrepareFn(ctx->m_Channel, &ctx->m_Context, *ctx->m_Request,
+                                              m_Executor->GetNextCQ());
+        }
+        else if(m_Balancer)
+        {
+            ctx->m_Balancer = m_Balancer;
+            ctx->m_Endpoint = m_Balancer->Pick();
+            ctx->m_Reader = m_BalancedPrepareFn(*ctx->m_Endpoint, &ctx->m_Context,
+                                                *ctx->m_Request, m_Executor->GetNextCQ());
+        }
+        else
+        {
+            ctx->m_Reader =
+                m_PrepareFn(&ctx->m_Context, *ctx->m_Request, m_Executor->GetNextCQ());
+        }
         ctx->m_Reader->StartCall();
         ctx->m_Reader->Finish(ctx->m_Response, &ctx->m_Status, ctx->Tag());
 
@@ -98,9 +218,95 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
         return Enqueue(req.get(), resp.get(), extended_on_return, headers);
     }
 
+    /**
+     * @brief Pooled mode: start a call on a recycled call context
+     *
+     * Call contexts, each owning a Request, a Response and the storage for a ClientContext, are
+     * kept on a free list per CQ of the Executor and reused once their call completes.  The
+     * ClientContext is destroyed when a call completes and recreated in place for the next one,
+     * and the messages are cleared but keep their capacity.
+     *
+     * build_request(Request&) fills the cleared Request before the call is sent.  No future is
+     * created; completion is reported only through on_return, which stays allocation-free if its
+     * captures fit in a std::function's small buffer, e.g. one or two pointers.
+     *
+     * The free lists grow to the peak number of pooled calls in flight and are released with
+     * the last of the ClientUnary and its outstanding calls, so taking a call context never
+     * blocks; like Enqueue, EnqueuePooled blocks only on a waiting FlowController.
+     */
+    template<typename BuildRequestFn>
+    void EnqueuePooled(BuildRequestFn build_request, PooledCallback on_return)
+    {
+        static const std::map<std::string, std::string> empty_headers;
+        EnqueuePooled(build_request, std::move(on_return), empty_headers);
+    }
+
+    template<typename BuildRequestFn>
+    void EnqueuePooled(BuildRequestFn build_request, PooledCallback on_return,
+                       const std::map<std::string, std::string>& headers)
+    {
+        auto cq_index = m_Executor->SelectCQ();
+        auto ctx = m_ContextPool->Acquire(cq_index);
+        build_request(ctx->m_Request);
+        ctx->m_Callback = std::move(on_return);
+
+        if(m_FlowController && !m_FlowController->Acquire())
+        {
+            ctx->m_Status = ::grpc::Status(::grpc::StatusCode::RESOURCE_EXHAUSTED,
+                                           "call rejected by client flow control");
+            ctx->m_Callback(ctx->m_Request, ctx->m_Response, ctx->m_Status);
+            m_ContextPool->Release(ctx);
+            return;
+        }
+
+        ctx->m_ContextPool = m_ContextPool;
+        ctx->m_Start = std::chrono::steady_clock::now();
+        ctx->m_FlowController = m_FlowController;
+
+        auto context = ctx->CreateClientContext();
+        for(auto& header : headers)
+        {
+            context->AddMetadata(header.first, header.second);
+        }
+
+        auto cq = m_Executor->GetCQ(cq_index);
+        if(m_Pool)
+        {
+            ctx->m_Pool = m_Pool;
+            ctx->m_Channel = m_Pool->Acquire();
+            ctx->m_Reader = m_PooledPrepareFn(ctx->m_Channel, context, ctx->m_Request, cq);
+        }
+        else if(m_Balancer)
+        {
+            ctx->m_Balancer = m_Balancer;
+            ctx->m_Endpoint = m_Balancer->Pick();
+            ctx->m_Reader = m_BalancedPrepareFn(*ctx->m_Endpoint, context, ctx->m_Request, cq);
+        }
+        else
+        {
+            ctx->m_Reader = m_PrepareFn(context, ctx->m_Request, cq);
+        }
+        ctx->m_Reader->StartCall();
+        ctx->m_Reader->Finish(&ctx->m_Response, &ctx->m_Status, ctx->Tag());
+    }
+
+    /**
+     * @brief Number of call contexts created by pooled mode, free or in flight
+     */
+    std::size_t PooledContexts() const { return m_ContextPool->Allocated(); }
+
   private:
     PrepareFn m_PrepareFn;
+    PooledPrepareFn m_PooledPrepareFn;
+    BalancedPrepareFn m_BalancedPrepareFn;
+    std::shared_ptr<ChannelPool> m_Pool;
+    std::shared_ptr<LoadBalancer> m_Balancer;
     std::shared_ptr<Executor> m_Executor;
+    std::shared_ptr<FlowController> m_FlowController;
+
+    class PooledContext;
+    class ContextPool;
+    std::shared_ptr<ContextPool> m_ContextPool;
 
     class Context : public BaseContext
     {
@@ -124,6 +330,19 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
         {
             DLOG(INFO) << "ClientContext: " << Tag() << " finished with "
                        << (m_Status.ok() ? "OK" : "CANCELLED");
+            if(m_Pool)
+            {
+                m_Pool->Release(m_Channel);
+            }
+            auto latency = std::chrono::steady_clock::now() - m_Start;
+            if(m_Balancer)
+            {
+                m_Balancer->Complete(m_Endpoint, latency, m_Status);
+            }
+            if(m_FlowController)
+            {
+                m_FlowController->Release(latency, m_Status);
+            }
             m_Callback();
             DLOG(INFO) << "ClientContext: " << Tag() << " callback completed";
             return false;
@@ -136,10 +355,173 @@ struct ClientUnary : public ::trtlab::AsyncComputeWrapper<void(Request&, Respons
         ::grpc::Status m_Status;
         ::grpc::ClientContext m_Context;
         std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>> m_Reader;
+        std::shared_ptr<ChannelPool> m_Pool;
+        std::size_t m_Channel;
+        std::shared_ptr<LoadBalancer> m_Balancer;
+        LoadBalancer::EndpointPtr m_Endpoint;
+        std::shared_ptr<FlowController> m_FlowController;
+        std::chrono::steady_clock::time_point m_Start;
         bool (Context::*m_NextState)(bool);
 
         friend class ClientUnary;
     };
+
+    class PooledContext : public BaseContext
+    {
+      public:
+        PooledContext(std::size_t cq_index)
+            : m_Channel(0), m_HasClientContext(false), m_CQIndex(cq_index), m_NextFree(nullptr)
+        {
+        }
+        ~PooledContext() override { Reset(); }
+
+        bool RunNextState(bool ok) final override { return StateFinishedDone(ok); }
+
+        bool ExecutorShouldDeleteContext() const override { return false; }
+
+      private:
+        bool StateFinishedDone(bool ok)
+        {
+            if(m_Pool)
+            {
+                m_Pool->Release(m_Channel);
+            }
+            auto latency = std::chrono::steady_clock::now() - m_Start;
+            if(m_Balancer)
+            {
+                m_Balancer->Complete(m_Endpoint, latency, m_Status);
+            }
+            if(m_FlowController)
+            {
+                m_FlowController->Release(latency, m_Status);
+            }
+            m_Callback(m_Request, m_Response, m_Status);
+
+            // the last reference to the pool may be this call's; returning the context to it
+            // can then delete the pool and this context with it
+            auto pool = std::move(m_ContextPool);
+            pool->Release(this);
+            return false;
+        }
+
+        ::grpc::ClientContext* CreateClientContext()
+        {
+            DCHECK(!m_HasClientContext);
+            m_HasClientContext = true;
+            return new(&m_ClientContext)::grpc::ClientContext;
+        }
+
+        // drop all per-call state; called when the context is returned to its free list
+        void Reset()
+        {
+            // the reader lives on the call's arena, which the ClientContext owns
+            m_Reader.reset();
+            if(m_HasClientContext)
+            {
+                reinterpret_cast<::grpc::ClientContext*>(&m_ClientContext)->~ClientContext();
+                m_HasClientContext = false;
+            }
+            m_Request.Clear();
+            m_Response.Clear();
+            m_Status = ::grpc::Status::OK;
+            m_Callback = nullptr;
+            m_Pool.reset();
+            m_Balancer.reset();
+            m_Endpoint.reset();
+            m_FlowController.reset();
+            m_ContextPool.reset();
+        }
+
+        Request m_Request;
+        Response m_Response;
+        ::grpc::Status m_Status;
+        PooledCallback m_Callback;
+        typename std::aligned_storage<sizeof(::grpc::ClientContext),
+                                      alignof(::grpc::ClientContext)>::type m_ClientContext;
+        std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>> m_Reader;
+        std::shared_ptr<ChannelPool> m_Pool;
+        std::size_t m_Channel;
+        std::shared_ptr<LoadBalancer> m_Balancer;
+        LoadBalancer::EndpointPtr m_Endpoint;
+        std::shared_ptr<FlowController> m_FlowController;
+        std::chrono::steady_clock::time_point m_Start;
+        std::shared_ptr<ContextPool> m_ContextPool;
+        bool m_HasClientContext;
+        const std::size_t m_CQIndex;
+        PooledContext* m_NextFree;
+
+        friend class ClientUnary;
+    };
+
+    /**
+     * @brief Intrusive free lists of PooledContexts, one per CQ
+     *
+     * A context is always used with the CQ it was created for, so it is returned by that CQ's
+     * progress engine and reacquired by callers that selected the same CQ; the lock of a list is
+     * only shared by those.
+     */
+    class ContextPool
+    {
+      public:
+        ContextPool(std::size_t cq_count)
+            : m_FreeLists(new FreeList[cq_count]), m_Count(cq_count), m_Allocated(0)
+        {
+        }
+
+        // in-flight contexts hold a reference to the pool, so every context is free here
+        ~ContextPool()
+        {
+            for(std::size_t i = 0; i < m_Count; i++)
+            {
+                while(auto ctx = m_FreeLists[i].head)
+                {
+                    m_FreeLists[i].head = ctx->m_NextFree;
+                    delete ctx;
+                    m_Allocated--;
+                }
+            }
+            DCHECK_EQ(m_Allocated.load(), 0);
+        }
+
+        PooledContext* Acquire(std::size_t cq_index)
+        {
+            auto& list = m_FreeLists[cq_index];
+            {
+                std::lock_guard<std::mutex> lock(list.mutex);
+                if(list.head)
+                {
+                    auto ctx = list.head;
+                    list.head = ctx->m_NextFree;
+                    ctx->m_NextFree = nullptr;
+                    return ctx;
+                }
+            }
+            m_Allocated++;
+            return new PooledContext(cq_index);
+        }
+
+        void Release(PooledContext* ctx)
+        {
+            ctx->Reset();
+            auto& list = m_FreeLists[ctx->m_CQIndex];
+            std::lock_guard<std::mutex> lock(list.mutex);
+            ctx->m_NextFree = list.head;
+            list.head = ctx;
+        }
+
+        std::size_t Allocated() const { return m_Allocated; }
+
+      private:
+        struct FreeList
+        {
+            std::mutex mutex;
+            PooledContext* head = nullptr;
+        };
+
+        std::unique_ptr<FreeList[]> m_FreeLists;
+        const std::size_t m_Count;
+        std::atomic<std::size_t> m_Allocated;
+    };
 };
 
 } // namespace client
@@ -25,6 +25,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #pragma once
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -38,9 +39,23 @@ namespace client {
 class Executor : public std::enable_shared_from_this<Executor>
 {
   public:
+    /**
+     * @brief Strategy used by GetNextCQ to assign new calls to completion queues
+     *
+     * RoundRobin: cycle through the CQs using an atomic counter.
+     * LeastOutstanding: choose the CQ with the fewest in-flight calls; ties are broken in
+     * round-robin order so an idle executor still spreads work over all threads.
+     */
+    enum class SelectionPolicy
+    {
+        RoundRobin,
+        LeastOutstanding
+    };
+
     Executor();
-    Executor(int numThreads);
-    Executor(std::unique_ptr<::trtlab::ThreadPool> threadpool);
+    Executor(int numThreads, SelectionPolicy policy = SelectionPolicy::RoundRobin);
+    Executor(std::unique_ptr<::trtlab::ThreadPool> threadpool,
+             SelectionPolicy policy = SelectionPolicy::RoundRobin);
 
     Executor(Executor&& other) noexcept = delete;
     Executor& operator=(Executor&& other) noexcept = delete;
@@ -51,15 +66,55 @@ class Executor : public std::enable_shared_from_this<Executor>
     virtual ~Executor();
 
     void ShutdownAndJoin();
-    ::grpc::CompletionQueue* GetNextCQ() const;
+
+    /**
+     * @brief Select the CQ on which the caller will start a new call
+     *
+     * Each call to GetNextCQ counts as one in-flight call on the returned CQ until a context
+     * driven by that CQ completes its lifecycle, i.e. RunNextState returns false.
+     */
+    ::grpc::CompletionQueue* GetNextCQ();
+
+    /**
+     * @brief Split form of GetNextCQ: SelectCQ picks a CQ index per the policy without counting
+     * it; GetCQ counts one in-flight call on CQ cq_index and returns it.
+     *
+     * Use when per-CQ state, e.g. a free list, must be chosen before the call is started.
+     */
+    std::size_t SelectCQ();
+    ::grpc::CompletionQueue* GetCQ(std::size_t cq_index);
+
+    /**
+     * @brief Route every GetNextCQ made from the calling thread to CQ cq_index
+     *
+     * Pinning keeps the calls of a thread on one progress engine, e.g. so that callbacks for a
+     * given caller are serialized.  A thread can be pinned to one Executor at a time.
+     */
+    void PinCallingThread(std::size_t cq_index);
+    void UnpinCallingThread();
+
+    SelectionPolicy GetSelectionPolicy() const { return m_Policy; }
+    std::size_t Size() const { return m_CQs.size(); }
+    std::int64_t InFlight(std::size_t cq_index) const;
 
   private:
-    void ProgressEngine(::grpc::CompletionQueue&);
+    void ProgressEngine(std::size_t cq_index);
 
-    size_t m_Counter;
+    const SelectionPolicy m_Policy;
+    std::atomic<std::size_t> m_Counter;
     std::unique_ptr<::trtlab::ThreadPool> m_ThreadPool;
     std::vector<std::unique_ptr<::grpc::CompletionQueue>> m_CQs;
+    std::vector<std::unique_ptr<std::atomic<std::int64_t>>> m_InFlight;
 };
 
+/**
+ * @brief Index of the smallest of the in_flight counters, scanning from start modulo their count
+ *
+ * Ties go to the first counter scanned, so advancing start spreads calls in round-robin order
+ * while the counters are equal.  The scan stops early at an idle counter.
+ */
+std::size_t LeastInFlightIndex(
+    const std::vector<std::unique_ptr<std::atomic<std::int64_t>>>& in_flight, std::size_t start);
+
 } // namespace client
-} // namespace nvrpc
\ No newline at end of file
+} // namespace nvrpc
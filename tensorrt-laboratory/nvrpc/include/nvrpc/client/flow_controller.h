@@ -0,0 +1,150 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include <grpc++/grpc++.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief Limits for a FlowController
+ *
+ * rate caps calls per second with a token bucket holding up to burst tokens; 0 disables it.
+ *
+ * The concurrency window caps calls in flight:
+ *  - Fixed keeps initial_window.
+ *  - AIMD grows by additive_increase per window of successful calls, and is multiplied by
+ *    multiplicative_decrease, at most once per window of calls, on a congestion signal: a call
+ *    failing with RESOURCE_EXHAUSTED, UNAVAILABLE or DEADLINE_EXCEEDED, or, if latency_target is
+ *    non-zero, a call slower than latency_target.
+ *  - Gradient scales the window by min_latency / latency, clamped to [0.5, 1], plus sqrt(window)
+ *    of headroom, blended in with weight smoothing.  min_latency is the smallest latency seen,
+ *    forgotten every min_latency_reset calls so it tracks a changing server.  Congestion
+ *    signals are applied as in AIMD.
+ *
+ * The window is kept within [min_window, max_window].  When a limit is hit, Acquire either
+ * waits for capacity or fails fast, per on_limit.
+ */
+struct FlowControlPolicy
+{
+    enum class Window
+    {
+        Fixed,
+        AIMD,
+        Gradient
+    };
+
+    enum class OnLimit
+    {
+        Wait,
+        FailFast
+    };
+
+    double rate = 0.0;
+    double burst = 1.0;
+
+    Window window = Window::Fixed;
+    std::size_t initial_window = 64;
+    std::size_t min_window = 1;
+    std::size_t max_window = 1024;
+
+    double additive_increase = 1.0;
+    double multiplicative_decrease = 0.5;
+    std::chrono::microseconds latency_target = std::chrono::microseconds(0);
+
+    double smoothing = 0.2;
+    std::size_t min_latency_reset = 1000;
+
+    OnLimit on_limit = OnLimit::Wait;
+};
+
+/**
+ * @brief Client-side admission control: a token bucket and an adaptive concurrency window
+ *
+ * Every call admitted by Acquire must be reported with Release once it completes.  A single
+ * FlowController may be shared by any number of clients to bound their combined load.
+ */
+class FlowController
+{
+  public:
+    FlowController(const FlowControlPolicy& policy = FlowControlPolicy());
+
+    /**
+     * @brief Admit one call, waiting or failing fast per the policy
+     */
+    bool Acquire();
+
+    /**
+     * @brief Admit one call if possible without waiting
+     */
+    bool TryAcquire();
+
+    /**
+     * @brief Report the completion of an admitted call
+     */
+    void Release(std::chrono::nanoseconds latency, const ::grpc::Status& status);
+
+    /**
+     * @brief Change the token bucket rate; 0 disables it
+     */
+    void SetRate(double rate);
+
+    std::size_t Window() const;
+    std::size_t InFlight() const;
+    const FlowControlPolicy& GetPolicy() const { return m_Policy; }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    // must be called with m_Mutex held; on false, *wake_at is when a token is next available,
+    // or Clock::time_point::max() if the call must wait for a Release
+    bool TryAdmit(Clock::time_point* wake_at);
+    void Refill(Clock::time_point now);
+    void UpdateGradient(std::chrono::nanoseconds latency);
+
+    const FlowControlPolicy m_Policy;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+
+    double m_Rate;
+    double m_Tokens;
+    Clock::time_point m_LastRefill;
+
+    double m_Window;
+    std::size_t m_InFlight;
+    std::size_t m_SinceDecrease;
+    std::int64_t m_MinLatency;
+    std::size_t m_SinceMinLatencyReset;
+};
+
+} // namespace client
+} // namespace nvrpc
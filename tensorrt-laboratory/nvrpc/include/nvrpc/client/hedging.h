@@ -0,0 +1,145 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief When to hedge and retry an idempotent unary call
+ *
+ * A call starts with one attempt.  If it has not completed after the hedge delay, a second
+ * attempt is sent on another route and whichever finishes first wins; the other is cancelled.
+ * The hedge delay is hedge_percentile of recently observed attempt latencies, clamped to
+ * [min_hedge_delay, max_hedge_delay]; initial_hedge_delay is used until min_samples have been
+ * observed.  A hedge_percentile of 0 disables hedging.
+ *
+ * An attempt that fails with one of retryable_codes, when no other attempt is in flight, is
+ * retried on the next route after an exponential backoff with full jitter.
+ *
+ * Hedges and retries together are limited to max_attempts per call and draw from a retry
+ * budget shared by all calls of a client: each call deposits budget_ratio tokens, up to
+ * budget_max_tokens, and each extra attempt spends one.
+ */
+struct HedgingPolicy
+{
+    double hedge_percentile = 0.95;
+    std::chrono::microseconds initial_hedge_delay = std::chrono::milliseconds(10);
+    std::chrono::microseconds min_hedge_delay = std::chrono::milliseconds(1);
+    std::chrono::microseconds max_hedge_delay = std::chrono::seconds(1);
+    std::size_t min_samples = 32;
+
+    std::size_t max_attempts = 3;
+    std::set<::grpc::StatusCode> retryable_codes = {::grpc::StatusCode::UNAVAILABLE};
+    std::chrono::microseconds initial_backoff = std::chrono::milliseconds(10);
+    std::chrono::microseconds max_backoff = std::chrono::seconds(1);
+    double backoff_multiplier = 2.0;
+
+    double budget_ratio = 0.1;
+    double budget_max_tokens = 10.0;
+};
+
+/**
+ * @brief Counters for one hedged call, passed to its completion callback
+ */
+struct HedgedCallCounters
+{
+    std::uint32_t attempts = 0;  // attempts started, including the first
+    std::uint32_t hedges = 0;    // attempts started by the hedge delay
+    std::uint32_t retries = 0;   // attempts started after a retryable failure
+    std::uint32_t cancelled = 0; // attempts cancelled because another attempt won
+    std::uint32_t throttled = 0; // hedges or retries denied by the retry budget
+    std::int32_t winner = -1;    // index of the attempt whose result was returned
+    double latency = 0.0;        // seconds from Enqueue to completion
+};
+
+/**
+ * @brief Token bucket bounding hedges and retries to a fraction of calls
+ */
+class RetryBudget
+{
+  public:
+    RetryBudget(double ratio, double max_tokens);
+
+    void Deposit();
+    bool TryWithdraw();
+    double Tokens() const;
+
+  private:
+    const double m_Ratio;
+    const double m_MaxTokens;
+    mutable std::mutex m_Mutex;
+    double m_Tokens;
+};
+
+/**
+ * @brief Percentiles over a sliding window of the most recent latency samples
+ *
+ * Percentiles are recomputed at most once every refresh_interval samples.
+ */
+class LatencyWindow
+{
+  public:
+    LatencyWindow(std::size_t capacity = 1024, std::size_t refresh_interval = 32);
+
+    void Record(std::chrono::nanoseconds latency);
+    std::size_t Count() const;
+
+    // returns zero if no samples have been recorded
+    std::chrono::nanoseconds Percentile(double p);
+
+  private:
+    mutable std::mutex m_Mutex;
+    std::vector<std::int64_t> m_Samples;
+    std::size_t m_Next;
+    std::size_t m_Count;
+    std::size_t m_RefreshInterval;
+    std::size_t m_SinceRefresh;
+    double m_CachedPercentile;
+    std::int64_t m_Cached;
+    std::vector<std::int64_t> m_Scratch;
+};
+
+/**
+ * @brief Hedge delay for the next call under policy given the observed latencies
+ */
+std::chrono::nanoseconds HedgeDelay(const HedgingPolicy& policy, LatencyWindow& latencies);
+
+/**
+ * @brief Full-jitter exponential backoff before retry number retry (0-based)
+ */
+std::chrono::nanoseconds RetryBackoff(const HedgingPolicy& policy, std::uint32_t retry);
+
+} // namespace client
+} // namespace nvrpc
@@ -0,0 +1,204 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <grpc++/grpc++.h>
+
+namespace nvrpc {
+namespace client {
+
+/**
+ * @brief How a LoadBalancer scores, ejects and probes its endpoints
+ *
+ * Each endpoint keeps an exponentially weighted moving average of its call latency, where a
+ * new sample has weight ewma_weight; calls that complete with CANCELLED, unless it is one of
+ * failure_codes, are not sampled and neither succeed nor fail.  An endpoint is ejected after eject_after_failures
+ * consecutive calls fail with one of failure_codes.  It stays out of rotation for
+ * base_ejection, doubling with each further ejection up to max_ejection; when that expires, a
+ * single probe call is sent to it, which returns it to rotation on success or ejects it again
+ * on failure.
+ */
+struct LoadBalancerPolicy
+{
+    double ewma_weight = 0.2;
+    std::size_t eject_after_failures = 3;
+    std::set<::grpc::StatusCode> failure_codes = {::grpc::StatusCode::UNAVAILABLE,
+                                                  ::grpc::StatusCode::DEADLINE_EXCEEDED,
+                                                  ::grpc::StatusCode::INTERNAL};
+    std::chrono::milliseconds base_ejection = std::chrono::seconds(1);
+    std::chrono::milliseconds max_ejection = std::chrono::seconds(30);
+};
+
+/**
+ * @brief Client-side, latency-aware balancing of calls over a set of server endpoints
+ *
+ * Pick chooses two endpoints at random among those in rotation and returns the one with the
+ * lower cost, EWMA latency x (outstanding calls + 1); endpoints without samples are costed at
+ * the mean latency of the others.  Callers report every picked call back with Complete.
+ *
+ * Ejected endpoints whose ejection has expired are probed before any choice is made, one probe
+ * at a time.  If every endpoint is ejected, the one whose ejection ends first is used.
+ *
+ * SetEndpoints replaces the endpoint list at runtime; endpoints present in both lists keep
+ * their channel and statistics, and calls in flight to removed endpoints complete normally.
+ */
+class LoadBalancer
+{
+  public:
+    class Endpoint
+    {
+      public:
+        const std::string& Target() const { return m_Target; }
+        const std::shared_ptr<::grpc::Channel>& Channel() const { return m_Channel; }
+
+      private:
+        Endpoint(const std::string& target, std::shared_ptr<::grpc::Channel> channel)
+            : m_Target(target), m_Channel(channel), m_EWMA(0.0), m_Outstanding(0), m_Calls(0),
+              m_Failures(0), m_ConsecutiveFailures(0), m_Ejections(0), m_Ejected(false),
+              m_Probing(false)
+        {
+        }
+
+        const std::string m_Target;
+        const std::shared_ptr<::grpc::Channel> m_Channel;
+        std::shared_ptr<void> m_Stub;
+
+        // guarded by the LoadBalancer's mutex
+        double m_EWMA;
+        std::int64_t m_Outstanding;
+        std::uint64_t m_Calls;
+        std::uint64_t m_Failures;
+        std::size_t m_ConsecutiveFailures;
+        std::size_t m_Ejections;
+        bool m_Ejected;
+        bool m_Probing;
+        std::chrono::steady_clock::time_point m_EjectedUntil;
+
+        friend class LoadBalancer;
+    };
+
+    using EndpointPtr = std::shared_ptr<Endpoint>;
+
+    struct EndpointStats
+    {
+        std::string target;
+        std::chrono::nanoseconds ewma_latency;
+        std::int64_t outstanding;
+        std::uint64_t calls;
+        std::uint64_t failures;
+        bool ejected;
+    };
+
+    LoadBalancer(const std::vector<std::string>& targets,
+                 const LoadBalancerPolicy& policy = LoadBalancerPolicy(),
+                 std::shared_ptr<::grpc::ChannelCredentials> credentials =
+                     ::grpc::InsecureChannelCredentials(),
+                 const ::grpc::ChannelArguments& args = ::grpc::ChannelArguments());
+    virtual ~LoadBalancer() {}
+
+    LoadBalancer(LoadBalancer&&) = delete;
+    LoadBalancer& operator=(LoadBalancer&&) = delete;
+
+    LoadBalancer(const LoadBalancer&) = delete;
+    LoadBalancer& operator=(const LoadBalancer&) = delete;
+
+    void SetEndpoints(const std::vector<std::string>& targets);
+
+    /**
+     * @brief Choose the endpoint for a new call; pair with Complete
+     */
+    EndpointPtr Pick();
+
+    void Complete(const EndpointPtr& endpoint, std::chrono::nanoseconds latency,
+                  const ::grpc::Status& status);
+
+    std::vector<EndpointStats> Stats() const;
+    std::size_t Size() const;
+
+  protected:
+    using StubFactory = std::function<std::shared_ptr<void>(const std::shared_ptr<::grpc::Channel>&)>;
+
+    LoadBalancer(const std::vector<std::string>& targets, const LoadBalancerPolicy& policy,
+                 std::shared_ptr<::grpc::ChannelCredentials> credentials,
+                 const ::grpc::ChannelArguments& args, StubFactory stub_factory);
+
+    static void* Stub(const Endpoint& endpoint) { return endpoint.m_Stub.get(); }
+
+  private:
+    // must be called with m_Mutex held
+    double Cost(const Endpoint& endpoint, double default_latency) const;
+    void Eject(Endpoint& endpoint, std::chrono::steady_clock::time_point now);
+
+    const LoadBalancerPolicy m_Policy;
+    const std::shared_ptr<::grpc::ChannelCredentials> m_Credentials;
+    const ::grpc::ChannelArguments m_Args;
+    const StubFactory m_StubFactory;
+
+    mutable std::mutex m_Mutex;
+    std::vector<EndpointPtr> m_Endpoints;
+    std::minstd_rand m_Random;
+};
+
+/**
+ * @brief LoadBalancer with a generated Stub of ServiceType bound to each endpoint
+ */
+template<typename ServiceType>
+class StubBalancer : public LoadBalancer
+{
+  public:
+    using StubType = typename ServiceType::Stub;
+
+    StubBalancer(const std::vector<std::string>& targets,
+                 const LoadBalancerPolicy& policy = LoadBalancerPolicy(),
+                 std::shared_ptr<::grpc::ChannelCredentials> credentials =
+                     ::grpc::InsecureChannelCredentials(),
+                 const ::grpc::ChannelArguments& args = ::grpc::ChannelArguments())
+        : LoadBalancer(targets, policy, credentials, args,
+                       [](const std::shared_ptr<::grpc::Channel>& channel) {
+                           return std::shared_ptr<void>(ServiceType::NewStub(channel));
+                       })
+    {
+    }
+    ~StubBalancer() override {}
+
+    static StubType* Stub(const Endpoint& endpoint)
+    {
+        return static_cast<StubType*>(LoadBalancer::Stub(endpoint));
+    }
+};
+
+} // namespace client
+} // namespace nvrpc
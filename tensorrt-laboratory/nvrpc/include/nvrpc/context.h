@@ -29,6 +29,7 @@
 #include "nvrpc/interfaces.h"
 #include "nvrpc/life_cycle_batching.h"
 #include "nvrpc/life_cycle_bidirectional.h"
+#include "nvrpc/life_cycle_multiplexed.h"
 #include "nvrpc/life_cycle_streaming.h"
 #include "nvrpc/life_cycle_unary.h"
 
@@ -54,6 +55,9 @@ using BidirectionalContext =
 template<class Request, class Response, class Resources>
 using StreamingContext = BaseContext<LifeCycleStreaming<Request, Response>, Resources>;
 
+template<class Request, class Response, class Resources>
+using MultiplexedContext = BaseContext<LifeCycleMultiplexed<Request, Response>, Resources>;
+
 template<class LifeCycle, class Resources>
 class BaseContext : public LifeCycle
 {
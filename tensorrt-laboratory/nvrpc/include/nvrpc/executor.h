@@ -34,6 +34,7 @@
 #include "YAIS/Metrics.h"
 #endif
 
+#include <mutex>
 #include <thread>
 
 #include <glog/logging.h>
@@ -53,6 +54,7 @@ class Executor : public IExecutor
         for(int i = 0; i < m_ThreadPool->Size(); i++)
         {
             m_ServerCompletionQueues.emplace_back(builder.AddCompletionQueue());
+            m_ShutdownMutexes.emplace_back(new std::mutex);
         }
     }
 
@@ -75,11 +77,14 @@ class Executor : public IExecutor
 
     void Shutdown() final override
     {
-        for(auto& cq : m_ServerCompletionQueues)
+        // Stop recycling contexts before the CQs drain; a context reset on a shutdown CQ
+        // would fail to queue its request and abort inside gRPC
+        m_Running = false;
+        for(std::size_t i = 0; i < m_ServerCompletionQueues.size(); i++)
         {
-            LOG(INFO) << "Telling CQ to Shutdown: " << cq.get();
-            cq->Shutdown();
-            m_Running = false;
+            std::lock_guard<std::mutex> lock(*m_ShutdownMutexes[i]);
+            LOG(INFO) << "Telling CQ to Shutdown: " << m_ServerCompletionQueues[i].get();
+            m_ServerCompletionQueues[i]->Shutdown();
         }
         // exit(911);
         LOG(INFO) << "Joining Executor Threads";
@@ -88,6 +93,7 @@ class Executor : public IExecutor
 
     void Run() final override
     {
+        m_Running = true;
         // Launch the threads polling on their CQs
         for(int i = 0; i < m_ThreadPool->Size(); i++)
         {
@@ -116,7 +122,7 @@ class Executor : public IExecutor
     std::function<void()> m_TimeoutCallback;
     std::vector<std::unique_ptr<IContext>> m_Contexts;
     std::vector<std::unique_ptr<::grpc::ServerCompletionQueue>> m_ServerCompletionQueues;
-    // std::vector<std::unique_ptr<PerThreadState>> m_ShutdownState;
+    std::vector<std::unique_ptr<std::mutex>> m_ShutdownMutexes;
     std::unique_ptr<::trtlab::ThreadPool> m_ThreadPool;
 };
 
@@ -0,0 +1,113 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <memory>
+
+#include "nvrpc/correlation_id.h"
+#include "nvrpc/life_cycle_streaming.h"
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+
+/**
+ * @brief Streaming Life Cycle for independent requests multiplexed over one stream
+ *
+ * Each Request carries a correlation id (see CorrelationId).  For every request received,
+ * `ExecuteRequest` is called with a `Responder` bound to the stream and the request's id.  The
+ * Responder can be handed off to another thread and answered at any time, so responses go back
+ * in completion order: a slow request does not hold back the responses of those received
+ * after it.  The Response is stamped with the id of its request before it is written.
+ *
+ * The stream closes once the client has closed its side and every Responder has answered or
+ * been destroyed.  A request whose Responder is destroyed without answering is only failed on
+ * the client when the stream ends.
+ *
+ * @tparam Request
+ * @tparam Response
+ */
+template<class Request, class Response>
+class LifeCycleMultiplexed : public LifeCycleStreaming<Request, Response>
+{
+  public:
+    using ServerStream = typename LifeCycleStreaming<Request, Response>::ServerStream;
+
+    ~LifeCycleMultiplexed() override {}
+
+    class Responder
+    {
+      public:
+        Responder(std::shared_ptr<ServerStream> stream, std::uint64_t correlation_id)
+            : m_Stream(stream), m_CorrelationID(correlation_id)
+        {
+        }
+
+        Responder(Responder&&) = default;
+        Responder& operator=(Responder&&) = default;
+
+        Responder(const Responder&) = delete;
+        Responder& operator=(const Responder&) = delete;
+
+        ~Responder()
+        {
+            DLOG_IF(WARNING, m_Stream) << "request " << m_CorrelationID << " was not answered";
+        }
+
+        /**
+         * @brief Write the response to the request; may be called once
+         *
+         * Returns false if the stream is no longer connected.
+         */
+        bool Respond(Response&& response)
+        {
+            CHECK(m_Stream) << "request " << m_CorrelationID << " was already answered";
+            CorrelationId<Response>::Set(response, m_CorrelationID);
+            auto ok = m_Stream->WriteResponse(std::move(response));
+            m_Stream.reset();
+            return ok;
+        }
+
+        std::uint64_t CorrelationID() const { return m_CorrelationID; }
+
+      private:
+        std::shared_ptr<ServerStream> m_Stream;
+        std::uint64_t m_CorrelationID;
+    };
+
+  protected:
+    virtual void ExecuteRequest(Request&&, Responder) = 0;
+
+  private:
+    void RequestReceived(Request&& request, std::shared_ptr<ServerStream> stream) final override
+    {
+        Responder responder(stream, CorrelationId<Request>::Get(request));
+        ExecuteRequest(std::move(request), std::move(responder));
+    }
+};
+
+} // namespace nvrpc
@@ -46,6 +46,14 @@ class Server
     template<class ServiceType>
     AsyncService<typename ServiceType::AsyncService>* RegisterAsyncService();
 
+    /**
+     * @brief Register a generated async service class directly, e.g. a
+     * ServiceType::WithRawMethod_X<ServiceType::AsyncService> whose method X exchanges
+     * grpc::ByteBuffers instead of parsed messages.
+     */
+    template<class AsyncServiceType>
+    AsyncService<AsyncServiceType>* RegisterAsyncServiceType();
+
     IExecutor* RegisterExecutor(IExecutor* executor)
     {
         m_Executors.emplace_back(executor);
@@ -75,12 +83,18 @@ class Server
 
 template<class ServiceType>
 AsyncService<typename ServiceType::AsyncService>* Server::RegisterAsyncService()
+{
+    return RegisterAsyncServiceType<typename ServiceType::AsyncService>();
+}
+
+template<class AsyncServiceType>
+AsyncService<AsyncServiceType>* Server::RegisterAsyncServiceType()
 {
     if(m_Running)
     {
         throw std::runtime_error("Error: cannot register service on a running server");
     }
-    auto service = new AsyncService<typename ServiceType::AsyncService>;
+    auto service = new AsyncService<AsyncServiceType>;
     auto base = static_cast<IService*>(service);
     m_Services.emplace_back(base);
     service->Initialize(m_Builder);
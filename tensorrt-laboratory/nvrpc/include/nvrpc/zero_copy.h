@@ -0,0 +1,100 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/message_lite.h>
+#include <grpcpp/support/byte_buffer.h>
+#include <grpcpp/support/slice.h>
+
+namespace nvrpc {
+
+/**
+ * @brief ZeroCopyInputStream over the slices of a grpc::ByteBuffer
+ *
+ * Used with a google::protobuf::io::CodedInputStream, a message can be read field by field
+ * straight from the received slices; e.g. a bytes field can be read with ReadRaw into memory the
+ * caller already owns instead of being parsed into a std::string first.
+ */
+class ByteBufferInputStream final : public ::google::protobuf::io::ZeroCopyInputStream
+{
+  public:
+    ByteBufferInputStream(const ::grpc::ByteBuffer& buffer);
+    ~ByteBufferInputStream() override {}
+
+    bool Next(const void** data, int* size) final override;
+    void BackUp(int count) final override;
+    bool Skip(int count) final override;
+    int64_t ByteCount() const final override;
+
+    bool Ok() const { return m_Ok; }
+
+  private:
+    std::vector<::grpc::Slice> m_Slices;
+    size_t m_Index;
+    size_t m_Offset;
+    int64_t m_ByteCount;
+    bool m_Ok;
+};
+
+/**
+ * @brief Builds a serialized message as a grpc::ByteBuffer from slices
+ *
+ * Serialized protobuf messages can be concatenated: the result parses as the merge of the parts.
+ * Messages appended with Append are serialized (copied) into their own slice, while bytes fields
+ * appended with AppendBytes reference the caller's memory.  The owner of that memory is held by
+ * the slice and released once gRPC is done sending it, so e.g. a response can be sent directly
+ * from the host memory of a request's bindings.
+ */
+class ByteBufferWriter
+{
+  public:
+    ByteBufferWriter() : m_CopiedBytes(0), m_ReferencedBytes(0) {}
+
+    void Append(const ::google::protobuf::MessageLite& message);
+    void AppendBytes(int field_number, const void* data, size_t size,
+                     std::shared_ptr<const void> owner);
+
+    /**
+     * @brief Move the slices into buffer; the writer is empty afterwards
+     */
+    void Finish(::grpc::ByteBuffer* buffer);
+
+    size_t CopiedBytes() const { return m_CopiedBytes; }
+    size_t ReferencedBytes() const { return m_ReferencedBytes; }
+
+  private:
+    std::vector<::grpc::Slice> m_Slices;
+    size_t m_CopiedBytes;
+    size_t m_ReferencedBytes;
+};
+
+} // namespace nvrpc
@@ -0,0 +1,92 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel_pool.h"
+#include "nvrpc/client/executor.h"
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+ChannelPool::ChannelPool(const std::string& target, std::size_t size, SelectionPolicy policy,
+                         std::shared_ptr<::grpc::ChannelCredentials> credentials,
+                         const ::grpc::ChannelArguments& args)
+    : m_Policy(policy), m_Counter(0)
+{
+    CHECK_GT(size, 0) << "ChannelPool requires at least one channel";
+    for(std::size_t i = 0; i < size; i++)
+    {
+        ::grpc::ChannelArguments channel_args(args);
+        channel_args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        channel_args.SetInt("nvrpc.channel_pool_index", i);
+        m_Channels.push_back(::grpc::CreateCustomChannel(target, credentials, channel_args));
+        m_InFlight.emplace_back(new std::atomic<std::int64_t>(0));
+    }
+    DLOG(INFO) << "ChannelPool to " << target << " with " << size << " connections";
+}
+
+std::size_t ChannelPool::Acquire()
+{
+    std::size_t idx;
+    if(m_Policy == SelectionPolicy::LeastInFlight)
+    {
+        idx = LeastInFlightIndex(m_InFlight, m_Counter.fetch_add(1, std::memory_order_relaxed));
+    }
+    else
+    {
+        idx = m_Counter.fetch_add(1, std::memory_order_relaxed) % m_Channels.size();
+    }
+    m_InFlight[idx]->fetch_add(1, std::memory_order_relaxed);
+    return idx;
+}
+
+void ChannelPool::Acquire(std::size_t index)
+{
+    CHECK_LT(index, m_InFlight.size()) << "Channel index out of range";
+    m_InFlight[index]->fetch_add(1, std::memory_order_relaxed);
+}
+
+void ChannelPool::Release(std::size_t index)
+{
+    DCHECK_LT(index, m_InFlight.size());
+    m_InFlight[index]->fetch_sub(1, std::memory_order_relaxed);
+}
+
+const std::shared_ptr<::grpc::Channel>& ChannelPool::Channel(std::size_t index) const
+{
+    CHECK_LT(index, m_Channels.size()) << "Channel index out of range";
+    return m_Channels[index];
+}
+
+std::int64_t ChannelPool::InFlight(std::size_t index) const
+{
+    CHECK_LT(index, m_InFlight.size()) << "Channel index out of range";
+    return m_InFlight[index]->load(std::memory_order_relaxed);
+}
+
+} // namespace client
+} // namespace nvrpc
@@ -31,22 +31,36 @@
 
 using trtlab::ThreadPool;
 
+namespace {
+// The Executor, if any, the current thread is pinned to, and the index of its CQ
+thread_local const nvrpc::client::Executor* t_PinnedExecutor = nullptr;
+thread_local std::size_t t_PinnedIndex = 0;
+} // namespace
+
 namespace nvrpc {
 namespace client {
 
 Executor::Executor() : Executor(1) {}
 
-Executor::Executor(int numThreads) : Executor(std::make_unique<ThreadPool>(numThreads)) {}
+Executor::Executor(int numThreads, SelectionPolicy policy)
+    : Executor(std::make_unique<ThreadPool>(numThreads), policy)
+{
+}
 
-Executor::Executor(std::unique_ptr<ThreadPool> threadpool) : m_ThreadPool(std::move(threadpool))
+Executor::Executor(std::unique_ptr<ThreadPool> threadpool, SelectionPolicy policy)
+    : m_Policy(policy), m_Counter(0), m_ThreadPool(std::move(threadpool))
 {
-    // for(decltype(m_ThreadPool->Size()) i = 0; i < m_ThreadPool->Size(); i++)
+    // Create all CQs before starting any progress engine so that the vectors are not
+    // reallocated out from under a running thread
     for(auto i = 0; i < m_ThreadPool->Size(); i++)
     {
-        DLOG(INFO) << "Starting Client Progress Engine #" << i;
         m_CQs.emplace_back(new ::grpc::CompletionQueue);
-        auto cq = m_CQs.back().get();
-        m_ThreadPool->enqueue([this, cq] { ProgressEngine(*cq); });
+        m_InFlight.emplace_back(new std::atomic<std::int64_t>(0));
+    }
+    for(std::size_t i = 0; i < m_CQs.size(); i++)
+    {
+        DLOG(INFO) << "Starting Client Progress Engine #" << i;
+        m_ThreadPool->enqueue([this, i] { ProgressEngine(i); });
     }
 }
 
@@ -61,31 +75,92 @@ void Executor::ShutdownAndJoin()
     m_ThreadPool.reset();
 }
 
-void Executor::ProgressEngine(::grpc::CompletionQueue& cq)
+void Executor::ProgressEngine(std::size_t cq_index)
 {
     void* tag;
     bool ok = false;
+    auto& cq = *m_CQs[cq_index];
+    auto& in_flight = *m_InFlight[cq_index];
 
     while(cq.Next(&tag, &ok))
     {
         // CHECK(ok);
         BaseContext* ctx = BaseContext::Detag(tag);
+        // ask before running: a context the executor does not own may be destroyed by its
+        // owner as soon as its final state completes
+        auto should_delete = ctx->ExecutorShouldDeleteContext();
         if(!ctx->RunNextState(ok))
         {
-            if(ctx->ExecutorShouldDeleteContext())
+            in_flight.fetch_sub(1, std::memory_order_relaxed);
+            if(should_delete)
             {
                 DLOG(INFO) << "Deleting ClientContext: " << tag;
                 delete ctx;
             }
         }
     }
-    m_ThreadPool.reset();
 }
 
-::grpc::CompletionQueue* Executor::GetNextCQ() const
+::grpc::CompletionQueue* Executor::GetNextCQ() { return GetCQ(SelectCQ()); }
+
+std::size_t Executor::SelectCQ()
+{
+    if(t_PinnedExecutor == this)
+    {
+        return t_PinnedIndex;
+    }
+    if(m_Policy == SelectionPolicy::LeastOutstanding)
+    {
+        return LeastInFlightIndex(m_InFlight, m_Counter.fetch_add(1, std::memory_order_relaxed));
+    }
+    return m_Counter.fetch_add(1, std::memory_order_relaxed) % m_CQs.size();
+}
+
+::grpc::CompletionQueue* Executor::GetCQ(std::size_t cq_index)
+{
+    DCHECK_LT(cq_index, m_CQs.size()) << "CQ index out of range";
+    m_InFlight[cq_index]->fetch_add(1, std::memory_order_relaxed);
+    return m_CQs[cq_index].get();
+}
+
+std::size_t LeastInFlightIndex(
+    const std::vector<std::unique_ptr<std::atomic<std::int64_t>>>& in_flight, std::size_t start)
+{
+    const auto count = in_flight.size();
+    auto best = start % count;
+    auto best_in_flight = in_flight[best]->load(std::memory_order_relaxed);
+    for(std::size_t i = 1; i < count && best_in_flight > 0; i++)
+    {
+        auto idx = (start + i) % count;
+        auto in_flight_idx = in_flight[idx]->load(std::memory_order_relaxed);
+        if(in_flight_idx < best_in_flight)
+        {
+            best = idx;
+            best_in_flight = in_flight_idx;
+        }
+    }
+    return best;
+}
+
+void Executor::PinCallingThread(std::size_t cq_index)
+{
+    CHECK_LT(cq_index, m_CQs.size()) << "CQ index out of range";
+    t_PinnedExecutor = this;
+    t_PinnedIndex = cq_index;
+}
+
+void Executor::UnpinCallingThread()
+{
+    if(t_PinnedExecutor == this)
+    {
+        t_PinnedExecutor = nullptr;
+    }
+}
+
+std::int64_t Executor::InFlight(std::size_t cq_index) const
 {
-    auto idx = m_Counter % m_ThreadPool->Size();
-    return m_CQs[idx].get();
+    CHECK_LT(cq_index, m_InFlight.size()) << "CQ index out of range";
+    return m_InFlight[cq_index]->load(std::memory_order_relaxed);
 }
 
 } // namespace client
@@ -0,0 +1,196 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/flow_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+FlowController::FlowController(const FlowControlPolicy& policy)
+    : m_Policy(policy), m_Rate(policy.rate), m_Tokens(policy.burst), m_LastRefill(Clock::now()),
+      m_Window(policy.initial_window), m_InFlight(0), m_SinceDecrease(0), m_MinLatency(0),
+      m_SinceMinLatencyReset(0)
+{
+    CHECK_GE(policy.rate, 0.0);
+    CHECK_GE(policy.burst, 1.0) << "the token bucket must hold at least one token";
+    CHECK_GE(policy.min_window, 1);
+    CHECK_LE(policy.min_window, policy.max_window);
+    m_Window = std::min<double>(std::max<double>(m_Window, policy.min_window), policy.max_window);
+    // the first congestion signal backs off immediately
+    m_SinceDecrease = static_cast<std::size_t>(m_Window);
+}
+
+bool FlowController::Acquire()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    Clock::time_point wake_at;
+    while(!TryAdmit(&wake_at))
+    {
+        if(m_Policy.on_limit == FlowControlPolicy::OnLimit::FailFast)
+        {
+            return false;
+        }
+        if(wake_at == Clock::time_point::max())
+        {
+            m_Condition.wait(lock);
+        }
+        else
+        {
+            m_Condition.wait_until(lock, wake_at);
+        }
+    }
+    return true;
+}
+
+bool FlowController::TryAcquire()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Clock::time_point wake_at;
+    return TryAdmit(&wake_at);
+}
+
+bool FlowController::TryAdmit(Clock::time_point* wake_at)
+{
+    if(m_InFlight >= static_cast<std::size_t>(m_Window))
+    {
+        *wake_at = Clock::time_point::max();
+        return false;
+    }
+    if(m_Rate > 0.0)
+    {
+        auto now = Clock::now();
+        Refill(now);
+        if(m_Tokens < 1.0)
+        {
+            auto wait = std::chrono::duration<double>((1.0 - m_Tokens) / m_Rate);
+            *wake_at = now + std::chrono::duration_cast<Clock::duration>(wait);
+            return false;
+        }
+        m_Tokens -= 1.0;
+    }
+    m_InFlight++;
+    return true;
+}
+
+void FlowController::Refill(Clock::time_point now)
+{
+    auto elapsed = std::chrono::duration<double>(now - m_LastRefill).count();
+    m_Tokens = std::min(m_Policy.burst, m_Tokens + elapsed * m_Rate);
+    m_LastRefill = now;
+}
+
+void FlowController::Release(std::chrono::nanoseconds latency, const ::grpc::Status& status)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        DCHECK_GT(m_InFlight, 0);
+        m_InFlight--;
+
+        auto code = status.error_code();
+        bool congested = code == ::grpc::StatusCode::RESOURCE_EXHAUSTED ||
+                         code == ::grpc::StatusCode::UNAVAILABLE ||
+                         code == ::grpc::StatusCode::DEADLINE_EXCEEDED;
+        if(m_Policy.latency_target.count() && latency > m_Policy.latency_target)
+        {
+            congested = true;
+        }
+
+        if(m_Policy.window != FlowControlPolicy::Window::Fixed)
+        {
+            m_SinceDecrease++;
+            if(congested)
+            {
+                // back off at most once per window of completions, so a burst of failures
+                // from one overload episode does not collapse the window
+                if(m_SinceDecrease >= m_Window)
+                {
+                    m_Window *= m_Policy.multiplicative_decrease;
+                    m_SinceDecrease = 0;
+                }
+            }
+            else if(m_Policy.window == FlowControlPolicy::Window::AIMD)
+            {
+                m_Window += m_Policy.additive_increase / m_Window;
+            }
+            else if(status.ok())
+            {
+                UpdateGradient(latency);
+            }
+            m_Window = std::min<double>(std::max<double>(m_Window, m_Policy.min_window),
+                                        m_Policy.max_window);
+        }
+    }
+    m_Condition.notify_all();
+}
+
+// must be called with m_Mutex held
+void FlowController::UpdateGradient(std::chrono::nanoseconds latency)
+{
+    if(++m_SinceMinLatencyReset > m_Policy.min_latency_reset)
+    {
+        m_MinLatency = 0;
+        m_SinceMinLatencyReset = 0;
+    }
+    auto sample = std::max<std::int64_t>(latency.count(), 1);
+    if(m_MinLatency == 0 || sample < m_MinLatency)
+    {
+        m_MinLatency = sample;
+    }
+    auto gradient = std::max(0.5, std::min(1.0, (double)m_MinLatency / (double)sample));
+    auto target = m_Window * gradient + std::sqrt(m_Window);
+    m_Window = m_Window * (1.0 - m_Policy.smoothing) + target * m_Policy.smoothing;
+}
+
+void FlowController::SetRate(double rate)
+{
+    CHECK_GE(rate, 0.0);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Refill(Clock::now());
+        m_Rate = rate;
+    }
+    m_Condition.notify_all();
+}
+
+std::size_t FlowController::Window() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<std::size_t>(m_Window);
+}
+
+std::size_t FlowController::InFlight() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_InFlight;
+}
+
+} // namespace client
+} // namespace nvrpc
@@ -0,0 +1,134 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/hedging.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+RetryBudget::RetryBudget(double ratio, double max_tokens)
+    : m_Ratio(ratio), m_MaxTokens(max_tokens), m_Tokens(max_tokens)
+{
+    CHECK_GE(ratio, 0.0);
+    CHECK_GE(max_tokens, 0.0);
+}
+
+void RetryBudget::Deposit()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Tokens = std::min(m_MaxTokens, m_Tokens + m_Ratio);
+}
+
+bool RetryBudget::TryWithdraw()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if(m_Tokens < 1.0)
+    {
+        return false;
+    }
+    m_Tokens -= 1.0;
+    return true;
+}
+
+double RetryBudget::Tokens() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Tokens;
+}
+
+LatencyWindow::LatencyWindow(std::size_t capacity, std::size_t refresh_interval)
+    : m_Samples(capacity, 0), m_Next(0), m_Count(0), m_RefreshInterval(refresh_interval),
+      m_SinceRefresh(0), m_CachedPercentile(-1.0), m_Cached(0)
+{
+    CHECK_GT(capacity, 0);
+    m_Scratch.reserve(capacity);
+}
+
+void LatencyWindow::Record(std::chrono::nanoseconds latency)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Samples[m_Next] = latency.count();
+    m_Next = (m_Next + 1) % m_Samples.size();
+    m_Count = std::min(m_Count + 1, m_Samples.size());
+    m_SinceRefresh++;
+}
+
+std::size_t LatencyWindow::Count() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Count;
+}
+
+std::chrono::nanoseconds LatencyWindow::Percentile(double p)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if(m_Count == 0)
+    {
+        return std::chrono::nanoseconds(0);
+    }
+    if(p != m_CachedPercentile || m_SinceRefresh >= m_RefreshInterval)
+    {
+        m_Scratch.assign(m_Samples.begin(), m_Samples.begin() + m_Count);
+        auto position = std::ceil(p * m_Count);
+        auto rank = position < 1.0 ? 0 : std::min(m_Count, static_cast<std::size_t>(position)) - 1;
+        std::nth_element(m_Scratch.begin(), m_Scratch.begin() + rank, m_Scratch.end());
+        m_Cached = m_Scratch[rank];
+        m_CachedPercentile = p;
+        m_SinceRefresh = 0;
+    }
+    return std::chrono::nanoseconds(m_Cached);
+}
+
+std::chrono::nanoseconds HedgeDelay(const HedgingPolicy& policy, LatencyWindow& latencies)
+{
+    std::chrono::nanoseconds delay = policy.initial_hedge_delay;
+    if(latencies.Count() >= policy.min_samples)
+    {
+        delay = latencies.Percentile(policy.hedge_percentile);
+    }
+    delay = std::max<std::chrono::nanoseconds>(delay, policy.min_hedge_delay);
+    return std::min<std::chrono::nanoseconds>(delay, policy.max_hedge_delay);
+}
+
+std::chrono::nanoseconds RetryBackoff(const HedgingPolicy& policy, std::uint32_t retry)
+{
+    thread_local std::minstd_rand generator(std::random_device{}());
+    using nanoseconds = std::chrono::duration<double, std::nano>;
+    auto ceiling = nanoseconds(policy.initial_backoff).count() *
+                   std::pow(policy.backoff_multiplier, static_cast<double>(retry));
+    ceiling = std::min(ceiling, nanoseconds(policy.max_backoff).count());
+    std::uniform_real_distribution<double> jitter(0.0, ceiling);
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(jitter(generator)));
+}
+
+} // namespace client
+} // namespace nvrpc
@@ -0,0 +1,266 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/load_balancer.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <glog/logging.h>
+
+namespace nvrpc {
+namespace client {
+
+LoadBalancer::LoadBalancer(const std::vector<std::string>& targets,
+                           const LoadBalancerPolicy& policy,
+                           std::shared_ptr<::grpc::ChannelCredentials> credentials,
+                           const ::grpc::ChannelArguments& args)
+    : LoadBalancer(targets, policy, credentials, args, nullptr)
+{
+}
+
+LoadBalancer::LoadBalancer(const std::vector<std::string>& targets,
+                           const LoadBalancerPolicy& policy,
+                           std::shared_ptr<::grpc::ChannelCredentials> credentials,
+                           const ::grpc::ChannelArguments& args, StubFactory stub_factory)
+    : m_Policy(policy), m_Credentials(credentials), m_Args(args), m_StubFactory(stub_factory),
+      m_Random(std::random_device()())
+{
+    CHECK_GT(policy.ewma_weight, 0.0);
+    CHECK_LE(policy.ewma_weight, 1.0);
+    CHECK_GT(policy.eject_after_failures, 0);
+    SetEndpoints(targets);
+}
+
+void LoadBalancer::SetEndpoints(const std::vector<std::string>& targets)
+{
+    CHECK(!targets.empty()) << "LoadBalancer requires at least one endpoint";
+    std::vector<EndpointPtr> endpoints;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for(const auto& target : targets)
+        {
+            auto search = std::find_if(m_Endpoints.begin(), m_Endpoints.end(),
+                                       [&target](const EndpointPtr& endpoint) {
+                                           return endpoint->Target() == target;
+                                       });
+            if(search != m_Endpoints.end())
+            {
+                endpoints.push_back(*search);
+            }
+            else
+            {
+                endpoints.push_back(nullptr);
+            }
+        }
+    }
+
+    // create channels outside of the lock
+    for(std::size_t i = 0; i < targets.size(); i++)
+    {
+        if(!endpoints[i])
+        {
+            auto channel = ::grpc::CreateCustomChannel(targets[i], m_Credentials, m_Args);
+            endpoints[i].reset(new Endpoint(targets[i], channel));
+            if(m_StubFactory)
+            {
+                endpoints[i]->m_Stub = m_StubFactory(channel);
+            }
+            DLOG(INFO) << "LoadBalancer: adding endpoint " << targets[i];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Endpoints.swap(endpoints);
+}
+
+LoadBalancer::EndpointPtr LoadBalancer::Pick()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::size_t in_rotation = 0;
+    double latency_sum = 0.0;
+    std::size_t latency_count = 0;
+    for(auto& endpoint : m_Endpoints)
+    {
+        if(endpoint->m_Ejected)
+        {
+            if(!endpoint->m_Probing && now >= endpoint->m_EjectedUntil)
+            {
+                DLOG(INFO) << "LoadBalancer: probing " << endpoint->Target();
+                endpoint->m_Probing = true;
+                endpoint->m_Outstanding++;
+                return endpoint;
+            }
+            continue;
+        }
+        in_rotation++;
+        if(endpoint->m_EWMA > 0.0)
+        {
+            latency_sum += endpoint->m_EWMA;
+            latency_count++;
+        }
+    }
+
+    if(in_rotation == 0)
+    {
+        auto soonest = std::min_element(m_Endpoints.begin(), m_Endpoints.end(),
+                                        [](const EndpointPtr& a, const EndpointPtr& b) {
+                                            return a->m_EjectedUntil < b->m_EjectedUntil;
+                                        });
+        (*soonest)->m_Outstanding++;
+        return *soonest;
+    }
+
+    // the i-th and j-th endpoints in rotation, i != j when there are two or more
+    auto i = m_Random() % in_rotation;
+    auto j = i;
+    if(in_rotation > 1)
+    {
+        j = m_Random() % (in_rotation - 1);
+        j += (j >= i ? 1 : 0);
+    }
+
+    EndpointPtr first, second;
+    std::size_t k = 0;
+    for(auto& endpoint : m_Endpoints)
+    {
+        if(endpoint->m_Ejected)
+        {
+            continue;
+        }
+        if(k == i)
+        {
+            first = endpoint;
+        }
+        if(k == j)
+        {
+            second = endpoint;
+        }
+        k++;
+    }
+
+    auto default_latency = latency_count ? latency_sum / latency_count : 0.0;
+    auto& choice =
+        Cost(*second, default_latency) < Cost(*first, default_latency) ? second : first;
+    choice->m_Outstanding++;
+    return choice;
+}
+
+double LoadBalancer::Cost(const Endpoint& endpoint, double default_latency) const
+{
+    auto latency = endpoint.m_EWMA > 0.0 ? endpoint.m_EWMA : default_latency;
+    return (latency + 1.0) * (endpoint.m_Outstanding + 1);
+}
+
+void LoadBalancer::Complete(const EndpointPtr& endpoint, std::chrono::nanoseconds latency,
+                            const ::grpc::Status& status)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& e = *endpoint;
+    DCHECK_GT(e.m_Outstanding, 0);
+    e.m_Outstanding--;
+    e.m_Calls++;
+
+    // the first call to complete after a probe was sent decides the probe; a straggler that
+    // was started before the ejection is as good a health signal as the probe itself
+    auto probe = e.m_Probing;
+    e.m_Probing = false;
+
+    if(m_Policy.failure_codes.count(status.error_code()))
+    {
+        e.m_Failures++;
+        e.m_ConsecutiveFailures++;
+        if(probe || (!e.m_Ejected && e.m_ConsecutiveFailures >= m_Policy.eject_after_failures))
+        {
+            Eject(e, now);
+        }
+        return;
+    }
+
+    // a cancelled call, e.g. the losing attempt of a hedge, says nothing about the endpoint and
+    // its latency only measures the time until it was cancelled; a cancelled probe is resent
+    if(status.error_code() == ::grpc::StatusCode::CANCELLED)
+    {
+        return;
+    }
+
+    e.m_ConsecutiveFailures = 0;
+    auto sample = static_cast<double>(latency.count());
+    e.m_EWMA = e.m_EWMA > 0.0 ? e.m_EWMA * (1.0 - m_Policy.ewma_weight) +
+                                    sample * m_Policy.ewma_weight
+                              : sample;
+    if(probe)
+    {
+        DLOG(INFO) << "LoadBalancer: " << e.Target() << " returned to rotation";
+        e.m_Ejected = false;
+        e.m_Ejections = 0;
+    }
+}
+
+void LoadBalancer::Eject(Endpoint& endpoint, std::chrono::steady_clock::time_point now)
+{
+    auto duration = m_Policy.base_ejection;
+    for(std::size_t i = 0; i < endpoint.m_Ejections && duration < m_Policy.max_ejection; i++)
+    {
+        duration *= 2;
+    }
+    duration = std::min(duration, m_Policy.max_ejection);
+    endpoint.m_Ejections++;
+    endpoint.m_Ejected = true;
+    endpoint.m_EjectedUntil = now + duration;
+    LOG(WARNING) << "LoadBalancer: ejecting " << endpoint.Target() << " for "
+                 << duration.count() << "ms";
+}
+
+std::vector<LoadBalancer::EndpointStats> LoadBalancer::Stats() const
+{
+    std::vector<EndpointStats> stats;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for(const auto& endpoint : m_Endpoints)
+    {
+        EndpointStats s;
+        s.target = endpoint->Target();
+        s.ewma_latency = std::chrono::nanoseconds(static_cast<std::int64_t>(endpoint->m_EWMA));
+        s.outstanding = endpoint->m_Outstanding;
+        s.calls = endpoint->m_Calls;
+        s.failures = endpoint->m_Failures;
+        s.ejected = endpoint->m_Ejected;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+std::size_t LoadBalancer::Size() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Endpoints.size();
+}
+
+} // namespace client
+} // namespace nvrpc
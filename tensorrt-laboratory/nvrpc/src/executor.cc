@@ -50,14 +50,16 @@ void Executor::ProgressEngine(int thread_id)
     bool ok;
     void* tag;
     auto myCQ = m_ServerCompletionQueues[thread_id].get();
+    auto& shutdown_mutex = *m_ShutdownMutexes[thread_id];
     using NextStatus = ::grpc::ServerCompletionQueue::NextStatus;
-    m_Running = true;
 
     while(myCQ->Next(&tag, &ok))
     {
         auto ctx = IContext::Detag(tag);
         if(!RunContext(ctx, ok))
         {
+            // Shutdown holds this lock while closing our CQ
+            std::lock_guard<std::mutex> lock(shutdown_mutex);
             if(m_Running)
             {
                 ResetContext(ctx);
@@ -0,0 +1,134 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/zero_copy.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <glog/logging.h>
+
+using ::google::protobuf::internal::WireFormatLite;
+using ::google::protobuf::io::CodedOutputStream;
+
+namespace nvrpc {
+
+// ByteBufferInputStream
+
+ByteBufferInputStream::ByteBufferInputStream(const ::grpc::ByteBuffer& buffer)
+    : m_Index(0), m_Offset(0), m_ByteCount(0)
+{
+    // Dump takes references to the slices; no payload is copied
+    m_Ok = buffer.Dump(&m_Slices).ok();
+}
+
+bool ByteBufferInputStream::Next(const void** data, int* size)
+{
+    while(m_Index < m_Slices.size() && m_Offset == m_Slices[m_Index].size())
+    {
+        m_Index++;
+        m_Offset = 0;
+    }
+    if(m_Index == m_Slices.size())
+    {
+        return false;
+    }
+    const auto& slice = m_Slices[m_Index];
+    *data = slice.begin() + m_Offset;
+    *size = static_cast<int>(slice.size() - m_Offset);
+    m_ByteCount += *size;
+    m_Offset = slice.size();
+    return true;
+}
+
+void ByteBufferInputStream::BackUp(int count)
+{
+    // only the bytes of the last call to Next can be backed up
+    CHECK_LE(static_cast<size_t>(count), m_Offset);
+    m_Offset -= count;
+    m_ByteCount -= count;
+}
+
+bool ByteBufferInputStream::Skip(int count)
+{
+    const void* data;
+    int size;
+    while(count > 0 && Next(&data, &size))
+    {
+        if(size > count)
+        {
+            BackUp(size - count);
+            size = count;
+        }
+        count -= size;
+    }
+    return count == 0;
+}
+
+int64_t ByteBufferInputStream::ByteCount() const { return m_ByteCount; }
+
+// ByteBufferWriter
+
+void ByteBufferWriter::Append(const ::google::protobuf::MessageLite& message)
+{
+    auto size = message.ByteSizeLong();
+    ::grpc::Slice slice(size);
+    message.SerializeWithCachedSizesToArray(const_cast<uint8_t*>(slice.begin()));
+    m_CopiedBytes += size;
+    m_Slices.push_back(std::move(slice));
+}
+
+void ByteBufferWriter::AppendBytes(int field_number, const void* data, size_t size,
+                                   std::shared_ptr<const void> owner)
+{
+    // the tag and length prefix of the field are the only bytes copied
+    uint8_t header[16];
+    auto end = WireFormatLite::WriteTagToArray(
+        field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, header);
+    end = CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(size), end);
+    m_Slices.emplace_back(header, end - header);
+    m_CopiedBytes += end - header;
+
+    if(size)
+    {
+        auto holder = new std::shared_ptr<const void>(std::move(owner));
+        m_Slices.emplace_back(const_cast<void*>(data), size,
+                              [](void* holder) {
+                                  delete static_cast<std::shared_ptr<const void>*>(holder);
+                              },
+                              holder);
+        m_ReferencedBytes += size;
+    }
+}
+
+void ByteBufferWriter::Finish(::grpc::ByteBuffer* buffer)
+{
+    ::grpc::ByteBuffer tmp(m_Slices.data(), m_Slices.size());
+    buffer->Swap(&tmp);
+    m_Slices.clear();
+}
+
+} // namespace nvrpc
@@ -0,0 +1,142 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/channel_pool.h"
+#include "nvrpc/client/client_unary.h"
+
+#include "test_build_server.h"
+#include "test_pingpong.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace nvrpc::testing;
+using nvrpc::client::ChannelPool;
+using nvrpc::client::StubPool;
+
+class ChannelPoolTest : public ::testing::Test
+{
+  protected:
+    static std::int64_t TotalInFlight(const ChannelPool& pool)
+    {
+        std::int64_t total = 0;
+        for(std::size_t i = 0; i < pool.Size(); i++)
+        {
+            total += pool.InFlight(i);
+        }
+        return total;
+    }
+};
+
+TEST_F(ChannelPoolTest, DistinctChannels)
+{
+    ChannelPool pool("localhost:13377", 3);
+    ASSERT_EQ(pool.Size(), 3);
+    EXPECT_NE(pool.Channel(0), pool.Channel(1));
+    EXPECT_NE(pool.Channel(1), pool.Channel(2));
+    EXPECT_NE(pool.Channel(0), pool.Channel(2));
+}
+
+TEST_F(ChannelPoolTest, RoundRobin)
+{
+    ChannelPool pool("localhost:13377", 3);
+    EXPECT_EQ(pool.Acquire(), 0);
+    EXPECT_EQ(pool.Acquire(), 1);
+    EXPECT_EQ(pool.Acquire(), 2);
+    EXPECT_EQ(pool.Acquire(), 0);
+    EXPECT_EQ(pool.InFlight(0), 2);
+    EXPECT_EQ(pool.InFlight(1), 1);
+    pool.Release(0);
+    pool.Release(0);
+    EXPECT_EQ(pool.InFlight(0), 0);
+}
+
+TEST_F(ChannelPoolTest, LeastInFlight)
+{
+    ChannelPool pool("localhost:13377", 3, ChannelPool::SelectionPolicy::LeastInFlight);
+    auto busy = pool.Acquire();
+    pool.Acquire();
+    pool.Acquire();
+    pool.Acquire();
+    // every channel is in use once, plus one more on some channel
+    EXPECT_EQ(TotalInFlight(pool), 4);
+    for(std::size_t i = 0; i < pool.Size(); i++)
+    {
+        EXPECT_GE(pool.InFlight(i), 1);
+    }
+
+    // free up everything but the busy channel; it must not be chosen again until others fill
+    for(std::size_t i = 0; i < pool.Size(); i++)
+    {
+        while(pool.InFlight(i) > (i == busy ? 2 : 0))
+        {
+            pool.Release(i);
+        }
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        EXPECT_NE(pool.Acquire(), busy);
+    }
+    EXPECT_EQ(pool.InFlight(busy), 2);
+}
+
+TEST_F(ChannelPoolTest, ClientUnaryOverPool)
+{
+    auto server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
+    server->AsyncStart();
+
+    auto pool = std::make_shared<StubPool<TestService>>("localhost:13377", 4);
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+    auto prepare_fn = [](TestService::Stub * stub, ::grpc::ClientContext * context,
+                         const Input& request, ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(pool, prepare_fn, executor);
+
+    std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 1; i <= 16; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        futures.push_back(client.Enqueue(std::move(input),
+                                         [i](Input&, Output& output, ::grpc::Status& status) {
+                                             EXPECT_TRUE(status.ok());
+                                             EXPECT_EQ(output.batch_id(), i);
+                                         },
+                                         headers));
+    }
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+    // channels are released before the callback completes the future
+    EXPECT_EQ(TotalInFlight(*pool), 0);
+
+    server->Shutdown();
+}
@@ -0,0 +1,223 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_batcher.h"
+#include "nvrpc/context.h"
+
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+
+using namespace nvrpc::testing;
+using nvrpc::client::ClientBatcher;
+
+namespace {
+
+class EchoBatchingContext final : public nvrpc::BatchingContext<Input, Output, TestResources>
+{
+    void ExecuteRPC(std::vector<Input>& inputs, std::vector<Output>& outputs) final override
+    {
+        outputs.resize(inputs.size());
+        for(std::size_t i = 0; i < inputs.size(); i++)
+        {
+            outputs[i].set_batch_id(inputs[i].batch_id());
+        }
+        FinishResponse();
+    }
+};
+
+// answers only the first half of each batch, then finishes OK
+class TruncatingBatchingContext final
+    : public nvrpc::BatchingContext<Input, Output, TestResources>
+{
+    void ExecuteRPC(std::vector<Input>& inputs, std::vector<Output>& outputs) final override
+    {
+        outputs.resize(inputs.size() / 2);
+        for(std::size_t i = 0; i < outputs.size(); i++)
+        {
+            outputs[i].set_batch_id(inputs[i].batch_id());
+        }
+        FinishResponse();
+    }
+};
+
+class CancellingBatchingContext final
+    : public nvrpc::BatchingContext<Input, Output, TestResources>
+{
+    void ExecuteRPC(std::vector<Input>& inputs, std::vector<Output>& outputs) final override
+    {
+        CancelResponse();
+    }
+};
+
+} // namespace
+
+class ClientBatcherTest : public ::testing::Test
+{
+  protected:
+    using Batcher = ClientBatcher<Input, Output>;
+
+    static std::unique_ptr<Batcher> BuildBatcher(std::size_t max_batch_size,
+                                                 std::chrono::microseconds max_wait,
+                                                 Batcher::LatencyFn on_latency = nullptr)
+    {
+        auto executor = std::make_shared<nvrpc::client::Executor>(1);
+        auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+        std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+        auto prepare_fn = [stub](::grpc::ClientContext * context,
+                                 ::grpc::CompletionQueue * cq) -> auto
+        {
+            return std::move(stub->PrepareAsyncStreaming(context, cq));
+        };
+        return std::make_unique<Batcher>(prepare_fn, executor, max_batch_size, max_wait,
+                                         on_latency);
+    }
+
+    static Input MakeInput(int batch_id)
+    {
+        Input input;
+        input.set_batch_id(batch_id);
+        return input;
+    }
+};
+
+TEST_F(ClientBatcherTest, OrderedCorrelation)
+{
+    auto server = BuildStreamingServer<EchoBatchingContext>();
+    server->AsyncStart();
+
+    std::atomic<int> reports(0);
+    auto batcher = BuildBatcher(4, std::chrono::seconds(10), [&reports](const Batcher::Latency& l) {
+        EXPECT_EQ(l.batch_size, 4);
+        EXPECT_GE(l.queued, 0.0);
+        EXPECT_GE(l.total, l.queued);
+        reports++;
+    });
+
+    std::vector<std::shared_future<bool>> futures;
+    for(int i = 1; i <= 12; i++)
+    {
+        futures.push_back(batcher->Enqueue(MakeInput(i), [i](Output& output, ::grpc::Status& status) {
+            EXPECT_TRUE(status.ok());
+            EXPECT_EQ(output.batch_id(), i);
+            return status.ok();
+        }));
+    }
+    // 12 requests fill three batches; none depend on the 10s deadline
+    for(auto& future : futures)
+    {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_TRUE(future.get());
+    }
+    EXPECT_EQ(reports, 12);
+
+    batcher.reset();
+    server->Shutdown();
+}
+
+TEST_F(ClientBatcherTest, MaxWaitSendsPartialBatch)
+{
+    auto server = BuildStreamingServer<EchoBatchingContext>();
+    server->AsyncStart();
+
+    std::atomic<int> reports(0);
+    auto batcher = BuildBatcher(100, std::chrono::milliseconds(5),
+                                [&reports](const Batcher::Latency& l) {
+                                    EXPECT_EQ(l.batch_size, 3);
+                                    EXPECT_GE(l.queued, 0.004);
+                                    reports++;
+                                });
+
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 1; i <= 3; i++)
+    {
+        futures.push_back(batcher->Enqueue(MakeInput(i), [i](Output& output, ::grpc::Status& status) {
+            EXPECT_TRUE(status.ok());
+            EXPECT_EQ(output.batch_id(), i);
+        }));
+    }
+    for(auto& future : futures)
+    {
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    }
+    EXPECT_EQ(reports, 3);
+
+    batcher.reset();
+    server->Shutdown();
+}
+
+TEST_F(ClientBatcherTest, UnansweredMembersFailIndividually)
+{
+    auto server = BuildStreamingServer<TruncatingBatchingContext>();
+    server->AsyncStart();
+
+    auto batcher = BuildBatcher(4, std::chrono::seconds(10));
+
+    std::vector<std::shared_future<::grpc::StatusCode>> futures;
+    for(int i = 1; i <= 4; i++)
+    {
+        futures.push_back(batcher->Enqueue(MakeInput(i), [i](Output& output, ::grpc::Status& status) {
+            if(status.ok())
+            {
+                EXPECT_EQ(output.batch_id(), i);
+            }
+            return status.error_code();
+        }));
+    }
+    EXPECT_EQ(futures[0].get(), ::grpc::StatusCode::OK);
+    EXPECT_EQ(futures[1].get(), ::grpc::StatusCode::OK);
+    EXPECT_EQ(futures[2].get(), ::grpc::StatusCode::INTERNAL);
+    EXPECT_EQ(futures[3].get(), ::grpc::StatusCode::INTERNAL);
+
+    batcher.reset();
+    server->Shutdown();
+}
+
+TEST_F(ClientBatcherTest, StreamStatusPropagatesToMembers)
+{
+    auto server = BuildStreamingServer<CancellingBatchingContext>();
+    server->AsyncStart();
+
+    auto batcher = BuildBatcher(8, std::chrono::seconds(10));
+
+    std::vector<std::shared_future<::grpc::StatusCode>> futures;
+    for(int i = 1; i <= 3; i++)
+    {
+        futures.push_back(batcher->Enqueue(
+            MakeInput(i), [](Output&, ::grpc::Status& status) { return status.error_code(); }));
+    }
+    batcher->Flush();
+    for(auto& future : futures)
+    {
+        EXPECT_EQ(future.get(), ::grpc::StatusCode::CANCELLED);
+    }
+
+    batcher.reset();
+    server->Shutdown();
+}
@@ -0,0 +1,239 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/executor.h"
+
+#include "test_build_server.h"
+#include "test_pingpong.h"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace nvrpc::testing;
+using nvrpc::client::Executor;
+
+class ClientExecutorTest : public ::testing::Test
+{
+  protected:
+    static std::int64_t TotalInFlight(const Executor& executor)
+    {
+        std::int64_t total = 0;
+        for(std::size_t i = 0; i < executor.Size(); i++)
+        {
+            total += executor.InFlight(i);
+        }
+        return total;
+    }
+};
+
+TEST_F(ClientExecutorTest, RoundRobin)
+{
+    Executor executor(3);
+    ASSERT_EQ(executor.Size(), 3);
+    EXPECT_EQ(executor.GetSelectionPolicy(), Executor::SelectionPolicy::RoundRobin);
+
+    auto cq0 = executor.GetNextCQ();
+    auto cq1 = executor.GetNextCQ();
+    auto cq2 = executor.GetNextCQ();
+    EXPECT_NE(cq0, cq1);
+    EXPECT_NE(cq1, cq2);
+    EXPECT_NE(cq0, cq2);
+    EXPECT_EQ(executor.GetNextCQ(), cq0);
+    EXPECT_EQ(executor.GetNextCQ(), cq1);
+    EXPECT_EQ(executor.GetNextCQ(), cq2);
+
+    for(std::size_t i = 0; i < executor.Size(); i++)
+    {
+        EXPECT_EQ(executor.InFlight(i), 2);
+    }
+}
+
+TEST_F(ClientExecutorTest, LeastOutstanding)
+{
+    Executor executor(4, Executor::SelectionPolicy::LeastOutstanding);
+
+    std::set<::grpc::CompletionQueue*> cqs;
+    for(int i = 0; i < 4; i++)
+    {
+        cqs.insert(executor.GetNextCQ());
+    }
+    EXPECT_EQ(cqs.size(), 4);
+
+    // a pinned thread loads CQ 1; the policy must route around it
+    executor.PinCallingThread(1);
+    for(int i = 0; i < 10; i++)
+    {
+        executor.GetNextCQ();
+    }
+    executor.UnpinCallingThread();
+    EXPECT_EQ(executor.InFlight(1), 11);
+
+    for(int i = 0; i < 30; i++)
+    {
+        executor.GetNextCQ();
+    }
+    EXPECT_EQ(executor.InFlight(0), 11);
+    EXPECT_EQ(executor.InFlight(1), 11);
+    EXPECT_EQ(executor.InFlight(2), 11);
+    EXPECT_EQ(executor.InFlight(3), 11);
+}
+
+TEST_F(ClientExecutorTest, PinCallingThread)
+{
+    Executor executor(2);
+    executor.PinCallingThread(1);
+    auto pinned = executor.GetNextCQ();
+    for(int i = 0; i < 5; i++)
+    {
+        EXPECT_EQ(executor.GetNextCQ(), pinned);
+    }
+    EXPECT_EQ(executor.InFlight(0), 0);
+    EXPECT_EQ(executor.InFlight(1), 6);
+
+    // pinning is per-thread
+    std::thread([&executor] {
+        EXPECT_NE(executor.GetNextCQ(), executor.GetNextCQ());
+    }).join();
+
+    executor.UnpinCallingThread();
+    EXPECT_NE(executor.GetNextCQ(), executor.GetNextCQ());
+}
+
+TEST_F(ClientExecutorTest, CompletedCallsAreRetired)
+{
+    auto server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
+    server->AsyncStart();
+
+    auto executor = std::make_shared<Executor>(2, Executor::SelectionPolicy::LeastOutstanding);
+    auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+    std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+    auto prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
+                             ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(prepare_fn, executor);
+
+    std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 1; i <= 20; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        futures.push_back(client.Enqueue(
+            std::move(input),
+            [](Input&, Output&, ::grpc::Status& status) { EXPECT_TRUE(status.ok()); }, headers));
+    }
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+
+    // the callback completes the future before the executor retires the context
+    for(int i = 0; i < 1000 && TotalInFlight(*executor); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(TotalInFlight(*executor), 0);
+
+    server->Shutdown();
+}
+
+TEST_F(ClientExecutorTest, PooledCallsReuseContexts)
+{
+    auto server = BuildServer<PingPongUnaryContext, PingPongStreamingContext>();
+    server->AsyncStart();
+
+    auto executor = std::make_shared<Executor>(2);
+    auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+    std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+    auto prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
+                             ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    auto client = std::make_unique<nvrpc::client::ClientUnary<Input, Output>>(prepare_fn, executor);
+
+    const std::map<std::string, std::string> headers = {{"x-content-model", "flowers-152"}};
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::size_t completed = 0;
+    std::size_t failed = 0;
+
+    auto round = [&](int count) {
+        for(int i = 1; i <= count; i++)
+        {
+            client->EnqueuePooled(
+                [i](Input& input) {
+                    EXPECT_EQ(input.batch_id(), 0); // recycled requests are cleared
+                    input.set_batch_id(i);
+                },
+                [&](Input& input, Output& output, ::grpc::Status& status) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if(!status.ok() || output.batch_id() != input.batch_id())
+                    {
+                        failed++;
+                    }
+                    completed++;
+                    condition.notify_all();
+                },
+                headers);
+        }
+    };
+    auto wait_for = [&](std::size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return completed >= count; });
+        lock.unlock();
+        // contexts return to their free list just after the callback
+        for(int i = 0; i < 1000 && TotalInFlight(*executor); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    for(int i = 1; i <= 5; i++)
+    {
+        round(20);
+        wait_for(20 * i);
+        EXPECT_EQ(client->PooledContexts(), 20);
+    }
+    EXPECT_EQ(failed, 0);
+
+    // in-flight calls keep the pool alive past the client
+    round(20);
+    client.reset();
+    wait_for(120);
+    EXPECT_EQ(failed, 0);
+    EXPECT_EQ(TotalInFlight(*executor), 0);
+
+    server->Shutdown();
+}
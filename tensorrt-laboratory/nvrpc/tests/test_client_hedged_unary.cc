@@ -0,0 +1,247 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_hedged_unary.h"
+#include "nvrpc/client/hedging.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "test_resources.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace nvrpc::testing;
+using nvrpc::client::ClientHedgedUnary;
+using nvrpc::client::HedgedCallCounters;
+using nvrpc::client::HedgingPolicy;
+using nvrpc::client::LatencyWindow;
+using nvrpc::client::RetryBudget;
+
+namespace {
+
+class EchoUnaryContext final : public nvrpc::Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+class SlowEchoUnaryContext final : public nvrpc::Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+template<typename ContextType>
+std::unique_ptr<nvrpc::Server> BuildUnaryServer(const std::string& address)
+{
+    auto server = std::make_unique<nvrpc::Server>(address);
+    auto resources = std::make_shared<TestResources>(1);
+    auto executor = server->RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<ContextType>(&TestService::AsyncService::RequestUnary);
+    executor->RegisterContexts(rpc, resources, 4);
+    server->AsyncStart();
+    return server;
+}
+
+// nothing listens here; calls fail with UNAVAILABLE
+const char* UnreachableAddress = "localhost:13399";
+
+} // namespace
+
+class ClientHedgedUnaryTest : public ::testing::Test
+{
+  protected:
+    using Client = ClientHedgedUnary<Input, Output>;
+
+    static Client::PrepareFn Route(const std::string& address)
+    {
+        auto channel = grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+        std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+        return [stub](::grpc::ClientContext * context, const Input& request,
+                      ::grpc::CompletionQueue* cq) -> auto
+        {
+            return std::move(stub->PrepareAsyncUnary(context, request, cq));
+        };
+    }
+
+    static std::unique_ptr<Client> BuildClient(std::vector<std::string> addresses,
+                                               HedgingPolicy policy)
+    {
+        std::vector<Client::PrepareFn> routes;
+        for(const auto& address : addresses)
+        {
+            routes.push_back(Route(address));
+        }
+        auto executor = std::make_shared<nvrpc::client::Executor>(1);
+        return std::make_unique<Client>(routes, executor, policy);
+    }
+
+    static HedgedCallCounters Call(Client& client, int batch_id, ::grpc::StatusCode expected)
+    {
+        Input input;
+        input.set_batch_id(batch_id);
+        return client
+            .Enqueue(std::move(input),
+                     [batch_id, expected](Input&, Output& output, ::grpc::Status& status,
+                                          const HedgedCallCounters& counters) {
+                         EXPECT_EQ(status.error_code(), expected);
+                         if(status.ok())
+                         {
+                             EXPECT_EQ(output.batch_id(), batch_id);
+                         }
+                         return counters;
+                     })
+            .get();
+    }
+};
+
+TEST_F(ClientHedgedUnaryTest, LatencyWindowPercentiles)
+{
+    LatencyWindow window(100, 1);
+    EXPECT_EQ(window.Percentile(0.5).count(), 0);
+    for(int i = 1; i <= 100; i++)
+    {
+        window.Record(std::chrono::nanoseconds(i));
+    }
+    EXPECT_EQ(window.Count(), 100);
+    EXPECT_EQ(window.Percentile(0.5).count(), 50);
+    EXPECT_EQ(window.Percentile(0.95).count(), 95);
+    EXPECT_EQ(window.Percentile(1.0).count(), 100);
+
+    // the oldest samples are replaced
+    for(int i = 0; i < 100; i++)
+    {
+        window.Record(std::chrono::nanoseconds(1000));
+    }
+    EXPECT_EQ(window.Percentile(0.5).count(), 1000);
+}
+
+TEST_F(ClientHedgedUnaryTest, RetryBudget)
+{
+    RetryBudget budget(0.5, 2.0);
+    EXPECT_TRUE(budget.TryWithdraw());
+    EXPECT_TRUE(budget.TryWithdraw());
+    EXPECT_FALSE(budget.TryWithdraw());
+    budget.Deposit();
+    EXPECT_FALSE(budget.TryWithdraw());
+    budget.Deposit();
+    EXPECT_TRUE(budget.TryWithdraw());
+    for(int i = 0; i < 10; i++)
+    {
+        budget.Deposit();
+    }
+    EXPECT_DOUBLE_EQ(budget.Tokens(), 2.0);
+}
+
+TEST_F(ClientHedgedUnaryTest, HedgeWinsOverSlowRoute)
+{
+    auto fast = BuildUnaryServer<EchoUnaryContext>("0.0.0.0:13377");
+    auto slow = BuildUnaryServer<SlowEchoUnaryContext>("0.0.0.0:13378");
+
+    HedgingPolicy policy;
+    policy.initial_hedge_delay = std::chrono::milliseconds(20);
+    policy.min_samples = 1000;
+    policy.max_attempts = 2;
+
+    // the first call starts on route 0, the slow server
+    auto client = BuildClient({"localhost:13378", "localhost:13377"}, policy);
+    auto counters = Call(*client, 1, ::grpc::StatusCode::OK);
+    EXPECT_EQ(counters.attempts, 2);
+    EXPECT_EQ(counters.hedges, 1);
+    EXPECT_EQ(counters.winner, 1);
+    EXPECT_EQ(counters.cancelled, 1);
+    EXPECT_LT(counters.latency, 0.25);
+
+    auto totals = client->GetTotals();
+    EXPECT_EQ(totals.calls, 1);
+    EXPECT_EQ(totals.hedge_wins, 1);
+
+    // waits for the cancelled attempt on the slow server
+    client.reset();
+    slow->Shutdown();
+    fast->Shutdown();
+}
+
+TEST_F(ClientHedgedUnaryTest, RetryAfterUnavailable)
+{
+    auto server = BuildUnaryServer<EchoUnaryContext>("0.0.0.0:13377");
+
+    HedgingPolicy policy;
+    policy.hedge_percentile = 0.0;
+    policy.initial_backoff = std::chrono::milliseconds(1);
+
+    auto client = BuildClient({UnreachableAddress, "localhost:13377"}, policy);
+    auto counters = Call(*client, 7, ::grpc::StatusCode::OK);
+    EXPECT_EQ(counters.attempts, 2);
+    EXPECT_EQ(counters.retries, 1);
+    EXPECT_EQ(counters.hedges, 0);
+    EXPECT_EQ(counters.winner, 1);
+
+    client.reset();
+    server->Shutdown();
+}
+
+TEST_F(ClientHedgedUnaryTest, RetryBudgetThrottles)
+{
+    HedgingPolicy policy;
+    policy.hedge_percentile = 0.0;
+    policy.initial_backoff = std::chrono::milliseconds(1);
+    policy.budget_ratio = 0.0;
+    policy.budget_max_tokens = 1.0;
+
+    auto client = BuildClient({UnreachableAddress, UnreachableAddress}, policy);
+
+    // one token: the first retry is allowed, the second is throttled
+    auto counters = Call(*client, 1, ::grpc::StatusCode::UNAVAILABLE);
+    EXPECT_EQ(counters.attempts, 2);
+    EXPECT_EQ(counters.retries, 1);
+    EXPECT_EQ(counters.throttled, 1);
+    EXPECT_EQ(counters.winner, -1);
+
+    counters = Call(*client, 2, ::grpc::StatusCode::UNAVAILABLE);
+    EXPECT_EQ(counters.attempts, 1);
+    EXPECT_EQ(counters.retries, 0);
+    EXPECT_EQ(counters.throttled, 1);
+
+    auto totals = client->GetTotals();
+    EXPECT_EQ(totals.calls, 2);
+    EXPECT_EQ(totals.failed, 2);
+}
@@ -0,0 +1,205 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_multiplexed.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "test_resources.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace nvrpc::testing;
+using nvrpc::client::ClientMultiplexed;
+
+namespace {
+
+// echoes batch_id; requests with batch_id >= SlowBatchID are answered from the resource thread
+// pool after (batch_id - SlowBatchID) milliseconds
+const std::uint64_t SlowBatchID = 1000;
+
+class EchoMultiplexedContext final : public nvrpc::MultiplexedContext<Input, Output, TestResources>
+{
+    void ExecuteRequest(Input&& input, Responder responder) final override
+    {
+        Output output;
+        output.set_batch_id(input.batch_id());
+        if(input.batch_id() < SlowBatchID)
+        {
+            responder.Respond(std::move(output));
+            return;
+        }
+        auto delay = std::chrono::milliseconds(input.batch_id() - SlowBatchID);
+        GetResources()->AcquireThreadPool().enqueue(
+            [delay, output, responder = std::move(responder)]() mutable {
+                std::this_thread::sleep_for(delay);
+                responder.Respond(std::move(output));
+            });
+    }
+};
+
+} // namespace
+
+class ClientMultiplexedTest : public ::testing::Test
+{
+  protected:
+    using Client = ClientMultiplexed<Input, Output>;
+
+    void SetUp() override
+    {
+        m_Server = std::make_unique<nvrpc::Server>("localhost:13377");
+        auto resources = std::make_shared<TestResources>(4);
+        auto executor = m_Server->RegisterExecutor(new nvrpc::Executor(1));
+        auto service = m_Server->RegisterAsyncService<TestService>();
+        auto rpc = service->RegisterRPC<EchoMultiplexedContext>(
+            &TestService::AsyncService::RequestStreaming);
+        executor->RegisterContexts(rpc, resources, 2);
+        m_Server->AsyncStart();
+    }
+
+    void TearDown() override { m_Server->Shutdown(); }
+
+    static std::unique_ptr<Client> BuildClient(const std::string& address,
+                                               std::size_t max_in_flight)
+    {
+        auto channel = grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+        std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+        auto prepare_fn = [stub](::grpc::ClientContext * context,
+                                 ::grpc::CompletionQueue * cq) -> auto
+        {
+            return std::move(stub->PrepareAsyncStreaming(context, cq));
+        };
+        auto executor = std::make_shared<nvrpc::client::Executor>(1);
+        return std::make_unique<Client>(prepare_fn, executor, max_in_flight);
+    }
+
+    std::unique_ptr<nvrpc::Server> m_Server;
+};
+
+TEST_F(ClientMultiplexedTest, ResponsesCompleteOutOfOrder)
+{
+    auto client = BuildClient("localhost:13377", 16);
+
+    std::mutex mutex;
+    std::vector<std::uint64_t> completed;
+    std::vector<std::shared_future<void>> futures;
+    auto enqueue = [&](std::uint64_t batch_id) {
+        Input input;
+        input.set_batch_id(batch_id);
+        futures.push_back(client->Enqueue(
+            std::move(input), [&, batch_id](Output& output, ::grpc::Status& status) {
+                EXPECT_TRUE(status.ok());
+                EXPECT_EQ(output.batch_id(), batch_id);
+                std::lock_guard<std::mutex> lock(mutex);
+                completed.push_back(batch_id);
+            }));
+    };
+
+    // a slow request first; the fast ones behind it are not held up
+    enqueue(SlowBatchID + 200);
+    for(std::uint64_t i = 1; i <= 10; i++)
+    {
+        enqueue(i);
+    }
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+
+    ASSERT_EQ(completed.size(), 11);
+    EXPECT_EQ(completed.back(), SlowBatchID + 200);
+    EXPECT_EQ(client->InFlight(), 0);
+}
+
+TEST_F(ClientMultiplexedTest, InFlightIsCapped)
+{
+    auto client = BuildClient("localhost:13377", 2);
+
+    // four 100ms requests, at most two at a time
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::shared_future<void>> futures;
+    for(int i = 0; i < 4; i++)
+    {
+        Input input;
+        input.set_batch_id(SlowBatchID + 100);
+        futures.push_back(client->Enqueue(std::move(input), [](Output&, ::grpc::Status& status) {
+            EXPECT_TRUE(status.ok());
+        }));
+        EXPECT_LE(client->InFlight(), 2);
+    }
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(190));
+}
+
+TEST_F(ClientMultiplexedTest, RequestsFailWhenTheStreamFails)
+{
+    // nothing listens here
+    auto client = BuildClient("localhost:13399", 4);
+
+    for(int i = 0; i < 3; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        client
+            ->Enqueue(std::move(input),
+                      [](Output&, ::grpc::Status& status) {
+                          EXPECT_EQ(status.error_code(), ::grpc::StatusCode::UNAVAILABLE);
+                      })
+            .get();
+    }
+    EXPECT_EQ(client->InFlight(), 0);
+}
+
+TEST_F(ClientMultiplexedTest, DestructorWaitsForOutstandingResponses)
+{
+    auto client = BuildClient("localhost:13377", 4);
+
+    std::size_t answered = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        Input input;
+        input.set_batch_id(SlowBatchID + 50);
+        client->Enqueue(std::move(input), [&answered](Output&, ::grpc::Status& status) {
+            EXPECT_TRUE(status.ok());
+            answered++;
+        });
+    }
+    client.reset();
+    EXPECT_EQ(answered, 4);
+}
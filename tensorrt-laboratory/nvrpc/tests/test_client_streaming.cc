@@ -0,0 +1,204 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_streaming.h"
+#include "nvrpc/context.h"
+
+#include "test_build_server.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace nvrpc::testing;
+
+namespace {
+
+class EchoStreamingContext final : public nvrpc::StreamingContext<Input, Output, TestResources>
+{
+    void RequestReceived(Input&& input, std::shared_ptr<ServerStream> stream) final override
+    {
+        Output output;
+        output.set_batch_id(input.batch_id());
+        stream->WriteResponse(std::move(output));
+    }
+};
+
+} // namespace
+
+class ClientStreamingTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Server = BuildStreamingServer<EchoStreamingContext>();
+        m_Server->AsyncStart();
+        m_Executor = std::make_shared<nvrpc::client::Executor>(1);
+        auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+        std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+        auto prepare_fn = [stub](::grpc::ClientContext * context,
+                                 ::grpc::CompletionQueue * cq) -> auto
+        {
+            return std::move(stub->PrepareAsyncStreaming(context, cq));
+        };
+        m_Stream = std::make_unique<nvrpc::client::ClientStreaming<Input, Output>>(
+            prepare_fn, m_Executor, [](Input&&) {}, [this](Output&& output) {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Received.push_back(output.batch_id());
+            });
+    }
+
+    void TearDown() override
+    {
+        m_Stream.reset();
+        m_Executor.reset();
+        m_Server->Shutdown();
+    }
+
+    void Write(std::size_t count)
+    {
+        for(std::size_t i = 0; i < count; i++)
+        {
+            Input input;
+            input.set_batch_id(++m_Sent);
+            m_Stream->Write(std::move(input));
+        }
+    }
+
+    std::size_t Received()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Received.size();
+    }
+
+    bool WaitForReceived(std::size_t count)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(Received() < count && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return Received() == count;
+    }
+
+    void ExpectInOrder()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for(std::size_t i = 0; i < m_Received.size(); i++)
+        {
+            EXPECT_EQ(m_Received[i], i + 1);
+        }
+    }
+
+    std::unique_ptr<nvrpc::Server> m_Server;
+    // released after the stream, so a stream may be destroyed on an Executor thread
+    std::shared_ptr<nvrpc::client::Executor> m_Executor;
+    std::unique_ptr<nvrpc::client::ClientStreaming<Input, Output>> m_Stream;
+    std::mutex m_Mutex;
+    std::vector<std::uint64_t> m_Received;
+    std::uint64_t m_Sent = 0;
+};
+
+TEST_F(ClientStreamingTest, CorkedWritesWaitForFlush)
+{
+    EXPECT_FALSE(m_Stream->SetCorked(true));
+    EXPECT_TRUE(m_Stream->IsCorked());
+    Write(5);
+
+    // nothing leaves the client while corked
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(Received(), 0);
+
+    m_Stream->Flush();
+    EXPECT_TRUE(WaitForReceived(5));
+
+    // still corked after a Flush
+    Write(3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(Received(), 5);
+    m_Stream->Flush();
+    EXPECT_TRUE(WaitForReceived(8));
+
+    EXPECT_TRUE(m_Stream->Done().get().ok());
+    ExpectInOrder();
+}
+
+TEST_F(ClientStreamingTest, UncorkFlushes)
+{
+    m_Stream->SetCorked(true);
+    Write(4);
+    EXPECT_TRUE(m_Stream->SetCorked(false));
+    EXPECT_TRUE(WaitForReceived(4));
+
+    // uncorked writes are sent immediately
+    Write(2);
+    EXPECT_TRUE(WaitForReceived(6));
+
+    EXPECT_TRUE(m_Stream->Done().get().ok());
+    ExpectInOrder();
+}
+
+TEST_F(ClientStreamingTest, DoneFlushesCorkedWrites)
+{
+    m_Stream->SetCorked(true);
+    Write(16);
+    EXPECT_TRUE(m_Stream->Done().get().ok());
+    EXPECT_EQ(Received(), 16);
+    ExpectInOrder();
+}
+
+TEST_F(ClientStreamingTest, AutoCoalesce)
+{
+    m_Stream->SetAutoCoalesce(8);
+    Write(100);
+    EXPECT_TRUE(WaitForReceived(100));
+    EXPECT_TRUE(m_Stream->Done().get().ok());
+    ExpectInOrder();
+}
+
+TEST_F(ClientStreamingTest, OnCompleteMayReleaseStream)
+{
+    std::promise<bool> released;
+    m_Stream->OnComplete([this, &released](const ::grpc::Status& status) {
+        m_Stream.reset();
+        released.set_value(status.ok());
+    });
+    Write(4);
+    m_Stream->Done();
+    EXPECT_TRUE(released.get_future().get());
+    EXPECT_EQ(Received(), 4);
+}
+
+TEST_F(ClientStreamingTest, OnCompleteAfterCompletionRunsInline)
+{
+    EXPECT_TRUE(m_Stream->Done().get().ok());
+    bool called = false;
+    m_Stream->OnComplete([&called](const ::grpc::Status& status) { called = status.ok(); });
+    EXPECT_TRUE(called);
+}
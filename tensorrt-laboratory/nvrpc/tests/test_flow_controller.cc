@@ -0,0 +1,235 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/flow_controller.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "test_resources.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace nvrpc::testing;
+using nvrpc::client::FlowControlPolicy;
+using nvrpc::client::FlowController;
+
+namespace {
+
+class EchoUnaryContext final : public nvrpc::Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+const ::grpc::Status Congested(::grpc::StatusCode::RESOURCE_EXHAUSTED, "server busy");
+
+} // namespace
+
+class FlowControllerTest : public ::testing::Test
+{
+  protected:
+    static FlowControlPolicy Policy(FlowControlPolicy::Window window, std::size_t initial_window)
+    {
+        FlowControlPolicy policy;
+        policy.window = window;
+        policy.initial_window = initial_window;
+        return policy;
+    }
+
+    // admit and complete n calls with the given latency and status
+    static void Complete(FlowController& flow, int n, std::chrono::microseconds latency,
+                         const ::grpc::Status& status = ::grpc::Status::OK)
+    {
+        for(int i = 0; i < n; i++)
+        {
+            ASSERT_TRUE(flow.TryAcquire());
+            flow.Release(latency, status);
+        }
+    }
+};
+
+TEST_F(FlowControllerTest, FixedWindowFailsFast)
+{
+    auto policy = Policy(FlowControlPolicy::Window::Fixed, 2);
+    policy.on_limit = FlowControlPolicy::OnLimit::FailFast;
+    FlowController flow(policy);
+
+    EXPECT_TRUE(flow.Acquire());
+    EXPECT_TRUE(flow.Acquire());
+    EXPECT_FALSE(flow.Acquire());
+    EXPECT_EQ(flow.InFlight(), 2);
+
+    // a fixed window ignores congestion
+    flow.Release(std::chrono::microseconds(10), Congested);
+    EXPECT_EQ(flow.Window(), 2);
+    EXPECT_TRUE(flow.Acquire());
+}
+
+TEST_F(FlowControllerTest, FixedWindowWaits)
+{
+    FlowController flow(Policy(FlowControlPolicy::Window::Fixed, 1));
+    ASSERT_TRUE(flow.Acquire());
+
+    std::atomic<bool> admitted(false);
+    std::thread waiter([&flow, &admitted] {
+        EXPECT_TRUE(flow.Acquire());
+        admitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(admitted);
+
+    flow.Release(std::chrono::microseconds(10), ::grpc::Status::OK);
+    waiter.join();
+    EXPECT_TRUE(admitted);
+    EXPECT_EQ(flow.InFlight(), 1);
+}
+
+TEST_F(FlowControllerTest, TokenBucketLimitsRate)
+{
+    auto policy = Policy(FlowControlPolicy::Window::Fixed, 1000);
+    policy.rate = 100.0;
+    policy.burst = 10.0;
+    FlowController flow(policy);
+
+    // the burst is admitted at once, then calls are paced at the rate
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < 30; i++)
+    {
+        ASSERT_TRUE(flow.Acquire());
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(elapsed, 20.0 / 100.0 * 0.9);
+    EXPECT_FALSE(flow.TryAcquire());
+
+    flow.SetRate(0.0);
+    EXPECT_TRUE(flow.TryAcquire());
+}
+
+TEST_F(FlowControllerTest, AIMD)
+{
+    auto policy = Policy(FlowControlPolicy::Window::AIMD, 8);
+    policy.max_window = 64;
+    policy.latency_target = std::chrono::milliseconds(10);
+    FlowController flow(policy);
+
+    // about one window of successes grows the window by additive_increase
+    Complete(flow, 9, std::chrono::milliseconds(1));
+    EXPECT_EQ(flow.Window(), 9);
+
+    // congestion halves the window, at most once per window of completions
+    Complete(flow, 4, std::chrono::milliseconds(1), Congested);
+    EXPECT_EQ(flow.Window(), 4);
+    Complete(flow, 1, std::chrono::milliseconds(1), Congested);
+    EXPECT_EQ(flow.Window(), 4);
+
+    // exceeding the latency target is congestion too
+    Complete(flow, 1, std::chrono::milliseconds(20));
+    EXPECT_EQ(flow.Window(), 2);
+
+    Complete(flow, 10000, std::chrono::milliseconds(1));
+    EXPECT_EQ(flow.Window(), 64);
+}
+
+TEST_F(FlowControllerTest, GradientTracksLatency)
+{
+    auto policy = Policy(FlowControlPolicy::Window::Gradient, 16);
+    policy.max_window = 256;
+    FlowController flow(policy);
+
+    // steady latency: the window grows
+    Complete(flow, 200, std::chrono::milliseconds(1));
+    auto grown = flow.Window();
+    EXPECT_GT(grown, 64);
+
+    // queueing delay: latency quadruples and the window shrinks
+    Complete(flow, 50, std::chrono::milliseconds(4));
+    EXPECT_LT(flow.Window(), grown / 2);
+}
+
+TEST_F(FlowControllerTest, ClientUnaryRejectsWhenFull)
+{
+    auto server = std::make_unique<nvrpc::Server>("localhost:13377");
+    auto resources = std::make_shared<TestResources>(1);
+    auto executor = server->RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<EchoUnaryContext>(&TestService::AsyncService::RequestUnary);
+    executor->RegisterContexts(rpc, resources, 4);
+    server->AsyncStart();
+
+    auto channel = grpc::CreateChannel("localhost:13377", grpc::InsecureChannelCredentials());
+    std::shared_ptr<TestService::Stub> stub = TestService::NewStub(channel);
+    auto prepare_fn = [stub](::grpc::ClientContext * context, const Input& request,
+                             ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    nvrpc::client::ClientUnary<Input, Output> client(
+        prepare_fn, std::make_shared<nvrpc::client::Executor>(1));
+
+    auto policy = Policy(FlowControlPolicy::Window::Fixed, 1);
+    policy.on_limit = FlowControlPolicy::OnLimit::FailFast;
+    auto flow = std::make_shared<FlowController>(policy);
+    client.SetFlowController(flow);
+
+    auto call = [&client](int batch_id, ::grpc::StatusCode expected) {
+        Input input;
+        input.set_batch_id(batch_id);
+        client
+            .Enqueue(std::move(input),
+                     [batch_id, expected](Input&, Output& output, ::grpc::Status& status) {
+                         EXPECT_EQ(status.error_code(), expected);
+                         if(status.ok())
+                         {
+                             EXPECT_EQ(output.batch_id(), batch_id);
+                         }
+                     })
+            .get();
+    };
+
+    // the window is released once the call completes
+    call(1, ::grpc::StatusCode::OK);
+    EXPECT_EQ(flow->InFlight(), 0);
+
+    // occupy the only slot; the next call is rejected without being sent
+    ASSERT_TRUE(flow->Acquire());
+    call(2, ::grpc::StatusCode::RESOURCE_EXHAUSTED);
+    flow->Release(std::chrono::microseconds(10), ::grpc::Status::OK);
+    call(3, ::grpc::StatusCode::OK);
+
+    server->Shutdown();
+}
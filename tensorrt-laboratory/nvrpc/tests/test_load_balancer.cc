@@ -0,0 +1,302 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/load_balancer.h"
+#include "nvrpc/context.h"
+#include "nvrpc/executor.h"
+#include "nvrpc/server.h"
+
+#include "test_resources.h"
+
+#include "testing.grpc.pb.h"
+#include "testing.pb.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+using namespace nvrpc::testing;
+using nvrpc::client::LoadBalancer;
+using nvrpc::client::LoadBalancerPolicy;
+using nvrpc::client::StubBalancer;
+
+namespace {
+
+class EchoUnaryContext final : public nvrpc::Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+class SlowEchoUnaryContext final : public nvrpc::Context<Input, Output, TestResources>
+{
+    void ExecuteRPC(Input& input, Output& output) final override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        output.set_batch_id(input.batch_id());
+        FinishResponse();
+    }
+};
+
+template<typename ContextType>
+std::unique_ptr<nvrpc::Server> BuildUnaryServer(const std::string& address)
+{
+    auto server = std::make_unique<nvrpc::Server>(address);
+    auto resources = std::make_shared<TestResources>(1);
+    auto executor = server->RegisterExecutor(new nvrpc::Executor(1));
+    auto service = server->RegisterAsyncService<TestService>();
+    auto rpc = service->RegisterRPC<ContextType>(&TestService::AsyncService::RequestUnary);
+    executor->RegisterContexts(rpc, resources, 4);
+    server->AsyncStart();
+    return server;
+}
+
+// nothing listens here; calls fail with UNAVAILABLE
+const char* UnreachableAddress = "localhost:13399";
+
+const ::grpc::Status Unavailable(::grpc::StatusCode::UNAVAILABLE, "endpoint down");
+
+} // namespace
+
+class LoadBalancerTest : public ::testing::Test
+{
+  protected:
+    static std::map<std::string, LoadBalancer::EndpointStats> StatsByTarget(LoadBalancer& lb)
+    {
+        std::map<std::string, LoadBalancer::EndpointStats> stats;
+        for(const auto& s : lb.Stats())
+        {
+            stats[s.target] = s;
+        }
+        return stats;
+    }
+
+    // pick and immediately complete n calls; returns the number of calls per target
+    static std::map<std::string, int> Run(LoadBalancer& lb, int n,
+                                          std::map<std::string, std::chrono::microseconds> latency)
+    {
+        std::map<std::string, int> picks;
+        for(int i = 0; i < n; i++)
+        {
+            auto endpoint = lb.Pick();
+            picks[endpoint->Target()]++;
+            lb.Complete(endpoint, latency[endpoint->Target()], ::grpc::Status::OK);
+        }
+        return picks;
+    }
+};
+
+TEST_F(LoadBalancerTest, PrefersLowLatency)
+{
+    LoadBalancer lb({"localhost:13381", "localhost:13382", "localhost:13383"});
+    ASSERT_EQ(lb.Size(), 3);
+
+    std::map<std::string, std::chrono::microseconds> latency = {
+        {"localhost:13381", std::chrono::microseconds(1000)},
+        {"localhost:13382", std::chrono::microseconds(1000)},
+        {"localhost:13383", std::chrono::microseconds(10000)}};
+
+    Run(lb, 30, latency);
+    auto picks = Run(lb, 900, latency);
+
+    // the two choices are always distinct, and the slow endpoint is the costlier of any pair
+    EXPECT_EQ(picks["localhost:13383"], 0);
+    EXPECT_GT(picks["localhost:13381"], 300);
+    EXPECT_GT(picks["localhost:13382"], 300);
+}
+
+TEST_F(LoadBalancerTest, SpreadsOutstandingCalls)
+{
+    LoadBalancer lb({"localhost:13381", "localhost:13382"});
+
+    // without latency samples the cost is the number of outstanding calls
+    std::vector<LoadBalancer::EndpointPtr> held;
+    for(int i = 0; i < 10; i++)
+    {
+        held.push_back(lb.Pick());
+    }
+    for(const auto& s : lb.Stats())
+    {
+        EXPECT_EQ(s.outstanding, 5);
+    }
+    for(auto& endpoint : held)
+    {
+        lb.Complete(endpoint, std::chrono::microseconds(100), ::grpc::Status::OK);
+    }
+    for(const auto& s : lb.Stats())
+    {
+        EXPECT_EQ(s.outstanding, 0);
+        EXPECT_EQ(s.calls, 5);
+    }
+}
+
+TEST_F(LoadBalancerTest, EjectsAndProbes)
+{
+    LoadBalancerPolicy policy;
+    policy.eject_after_failures = 2;
+    policy.base_ejection = std::chrono::milliseconds(100);
+    LoadBalancer lb({"localhost:13381", "localhost:13382"}, policy);
+    std::map<std::string, std::chrono::microseconds> latency = {
+        {"localhost:13381", std::chrono::microseconds(100)},
+        {"localhost:13382", std::chrono::microseconds(100)}};
+
+    auto fail_next = [&lb](const std::string& target) {
+        for(int i = 0; i < 100; i++)
+        {
+            auto endpoint = lb.Pick();
+            if(endpoint->Target() == target)
+            {
+                lb.Complete(endpoint, std::chrono::microseconds(100), Unavailable);
+                return true;
+            }
+            lb.Complete(endpoint, std::chrono::microseconds(100), ::grpc::Status::OK);
+        }
+        return false;
+    };
+
+    ASSERT_TRUE(fail_next("localhost:13382"));
+    EXPECT_FALSE(StatsByTarget(lb)["localhost:13382"].ejected);
+    ASSERT_TRUE(fail_next("localhost:13382"));
+    EXPECT_TRUE(StatsByTarget(lb)["localhost:13382"].ejected);
+
+    auto picks = Run(lb, 50, latency);
+    EXPECT_EQ(picks["localhost:13381"], 50);
+
+    // once the ejection expires, a single probe is sent
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    auto probe = lb.Pick();
+    EXPECT_EQ(probe->Target(), "localhost:13382");
+    EXPECT_EQ(lb.Pick()->Target(), "localhost:13381");
+
+    // a failed probe ejects it again, for twice as long
+    lb.Complete(probe, std::chrono::microseconds(100), Unavailable);
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+    EXPECT_EQ(lb.Pick()->Target(), "localhost:13381");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    probe = lb.Pick();
+    ASSERT_EQ(probe->Target(), "localhost:13382");
+
+    // a successful probe returns it to rotation
+    lb.Complete(probe, std::chrono::microseconds(100), ::grpc::Status::OK);
+    EXPECT_FALSE(StatsByTarget(lb)["localhost:13382"].ejected);
+    picks = Run(lb, 200, latency);
+    EXPECT_GT(picks["localhost:13382"], 0);
+}
+
+TEST_F(LoadBalancerTest, CancelledCallsAreNotSampled)
+{
+    LoadBalancer lb({"localhost:13381"});
+    Run(lb, 1, {{"localhost:13381", std::chrono::microseconds(100)}});
+    auto ewma = lb.Stats()[0].ewma_latency;
+    EXPECT_EQ(ewma, std::chrono::microseconds(100));
+
+    // e.g. the cancelled loser of a hedged call
+    auto endpoint = lb.Pick();
+    lb.Complete(endpoint, std::chrono::seconds(1),
+                ::grpc::Status(::grpc::StatusCode::CANCELLED, "hedge lost"));
+    auto stats = lb.Stats()[0];
+    EXPECT_EQ(stats.ewma_latency, ewma);
+    EXPECT_EQ(stats.outstanding, 0);
+    EXPECT_EQ(stats.calls, 2);
+}
+
+TEST_F(LoadBalancerTest, EndpointsChangeAtRuntime)
+{
+    LoadBalancer lb({"localhost:13381", "localhost:13382"});
+    Run(lb, 20, {{"localhost:13381", std::chrono::microseconds(100)},
+                 {"localhost:13382", std::chrono::microseconds(100)}});
+
+    auto in_flight = lb.Pick();
+    auto removed = in_flight->Target() == "localhost:13381" ? "localhost:13382" : "localhost:13381";
+    auto kept = in_flight->Target();
+
+    lb.SetEndpoints({kept, "localhost:13383"});
+    auto stats = StatsByTarget(lb);
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats.count(removed), 0);
+    EXPECT_GT(stats[kept].calls, 0); // statistics are kept
+    EXPECT_EQ(stats[kept].outstanding, 1);
+    EXPECT_EQ(stats["localhost:13383"].calls, 0);
+
+    // the new endpoint is costed at the mean latency and gets traffic at once
+    lb.Complete(in_flight, std::chrono::microseconds(100), ::grpc::Status::OK);
+    auto picks = Run(lb, 100, {{kept, std::chrono::microseconds(100)},
+                               {"localhost:13383", std::chrono::microseconds(100)}});
+    EXPECT_GT(picks["localhost:13383"], 0);
+    EXPECT_EQ(picks.count(removed), 0);
+}
+
+TEST_F(LoadBalancerTest, ClientUnaryBalancesAcrossServers)
+{
+    auto fast = BuildUnaryServer<EchoUnaryContext>("localhost:13381");
+    auto slow = BuildUnaryServer<SlowEchoUnaryContext>("localhost:13382");
+
+    LoadBalancerPolicy policy;
+    policy.base_ejection = std::chrono::seconds(10);
+    auto balancer = std::make_shared<StubBalancer<TestService>>(
+        std::vector<std::string>{"localhost:13381", "localhost:13382", UnreachableAddress},
+        policy);
+    auto prepare_fn = [](TestService::Stub * stub, ::grpc::ClientContext * context,
+                         const Input& request, ::grpc::CompletionQueue* cq) -> auto
+    {
+        return std::move(stub->PrepareAsyncUnary(context, request, cq));
+    };
+    auto executor = std::make_shared<nvrpc::client::Executor>(1);
+    nvrpc::client::ClientUnary<Input, Output> client(balancer, prepare_fn, executor);
+
+    int failed = 0;
+    for(int i = 1; i <= 100; i++)
+    {
+        Input input;
+        input.set_batch_id(i);
+        client
+            .Enqueue(std::move(input),
+                     [i, &failed](Input&, Output& output, ::grpc::Status& status) {
+                         if(!status.ok())
+                         {
+                             failed++;
+                             return;
+                         }
+                         EXPECT_EQ(output.batch_id(), i);
+                     })
+            .get();
+    }
+
+    auto stats = StatsByTarget(*balancer);
+    EXPECT_TRUE(stats[UnreachableAddress].ejected);
+    EXPECT_EQ(failed, policy.eject_after_failures);
+    EXPECT_GT(stats["localhost:13381"].calls, 3 * stats["localhost:13382"].calls);
+    EXPECT_GT(stats["localhost:13382"].ewma_latency, stats["localhost:13381"].ewma_latency);
+
+    fast->Shutdown();
+    slow->Shutdown();
+}
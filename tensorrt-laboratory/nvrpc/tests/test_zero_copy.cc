@@ -0,0 +1,174 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "nvrpc/zero_copy.h"
+#include "testing.pb.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <gtest/gtest.h>
+
+using namespace nvrpc;
+using namespace nvrpc::testing;
+
+using ::google::protobuf::internal::WireFormatLite;
+using ::google::protobuf::io::CodedInputStream;
+
+namespace {
+
+// splits the serialized message into slices of `chunk` bytes, like a message received in pieces
+::grpc::ByteBuffer Slices(const std::string& bytes, size_t chunk)
+{
+    std::vector<::grpc::Slice> slices;
+    for(size_t offset = 0; offset < bytes.size(); offset += chunk)
+    {
+        slices.emplace_back(bytes.data() + offset, std::min(chunk, bytes.size() - offset));
+    }
+    return ::grpc::ByteBuffer(slices.data(), slices.size());
+}
+
+std::string Flatten(const ::grpc::ByteBuffer& buffer)
+{
+    std::vector<::grpc::Slice> slices;
+    EXPECT_TRUE(buffer.Dump(&slices).ok());
+    std::string bytes;
+    for(const auto& slice : slices)
+    {
+        bytes.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+    }
+    return bytes;
+}
+
+std::string Payload(size_t size)
+{
+    std::string payload(size, 0);
+    for(size_t i = 0; i < size; i++)
+    {
+        payload[i] = static_cast<char>(i * 7);
+    }
+    return payload;
+}
+
+} // namespace
+
+class ZeroCopyTest : public ::testing::Test
+{
+};
+
+TEST_F(ZeroCopyTest, ReadBytesFieldIntoMemory)
+{
+    Input input;
+    input.set_batch_id(7);
+    input.set_raw_bytes(Payload(1000));
+    input.set_correlation_id(9);
+
+    for(size_t chunk : {1, 3, 64, 4096})
+    {
+        auto buffer = Slices(input.SerializeAsString(), chunk);
+        ByteBufferInputStream stream(buffer);
+        ASSERT_TRUE(stream.Ok());
+        CodedInputStream coded(&stream);
+
+        // the bytes field is read straight into memory owned by the caller
+        std::vector<char> memory(1000);
+        uint64_t batch_id = 0, correlation_id = 0;
+        while(auto tag = coded.ReadTag())
+        {
+            auto field = WireFormatLite::GetTagFieldNumber(tag);
+            if(field == Input::kRawBytesFieldNumber)
+            {
+                uint32_t size;
+                ASSERT_TRUE(coded.ReadVarint32(&size));
+                ASSERT_EQ(size, memory.size());
+                ASSERT_TRUE(coded.ReadRaw(memory.data(), size));
+            }
+            else if(field == Input::kBatchIdFieldNumber)
+            {
+                ASSERT_TRUE(coded.ReadVarint64(&batch_id));
+            }
+            else if(field == Input::kCorrelationIdFieldNumber)
+            {
+                ASSERT_TRUE(coded.ReadVarint64(&correlation_id));
+            }
+            else
+            {
+                ASSERT_TRUE(WireFormatLite::SkipField(&coded, tag));
+            }
+        }
+        EXPECT_EQ(batch_id, 7);
+        EXPECT_EQ(correlation_id, 9);
+        EXPECT_EQ(std::string(memory.begin(), memory.end()), input.raw_bytes());
+        EXPECT_EQ(stream.ByteCount(), input.ByteSizeLong());
+    }
+}
+
+TEST_F(ZeroCopyTest, SkipAcrossSlices)
+{
+    auto buffer = Slices(Payload(100), 7);
+    ByteBufferInputStream stream(buffer);
+    EXPECT_TRUE(stream.Skip(50));
+    const void* data;
+    int size;
+    ASSERT_TRUE(stream.Next(&data, &size));
+    EXPECT_EQ(*static_cast<const char*>(data), static_cast<char>(50 * 7));
+    EXPECT_EQ(stream.ByteCount(), 50 + size);
+    stream.BackUp(size);
+    EXPECT_EQ(stream.ByteCount(), 50);
+    EXPECT_FALSE(stream.Skip(51));
+}
+
+TEST_F(ZeroCopyTest, WriteBytesFieldFromMemory)
+{
+    auto payload = std::make_shared<std::string>(Payload(1 << 20));
+    Input header;
+    header.set_batch_id(7);
+    header.set_correlation_id(9);
+
+    ::grpc::ByteBuffer buffer;
+    {
+        ByteBufferWriter writer;
+        writer.Append(header);
+        writer.AppendBytes(Input::kRawBytesFieldNumber, payload->data(), payload->size(),
+                           payload);
+        writer.Finish(&buffer);
+
+        // only the header message and the tag and length of the field are copied
+        EXPECT_EQ(writer.ReferencedBytes(), payload->size());
+        EXPECT_LT(writer.CopiedBytes(), 16);
+    }
+    // the slice holds the owner of the memory
+    EXPECT_EQ(payload.use_count(), 2);
+
+    Input input;
+    ASSERT_TRUE(input.ParseFromString(Flatten(buffer)));
+    EXPECT_EQ(input.batch_id(), 7);
+    EXPECT_EQ(input.correlation_id(), 9);
+    EXPECT_EQ(input.raw_bytes(), *payload);
+
+    buffer.Clear();
+    EXPECT_EQ(payload.use_count(), 1);
+}
@@ -32,9 +32,13 @@
 namespace py = pybind11;
 
 #include <future>
+#include <limits>
 #include <memory>
 #include <string>
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
@@ -58,8 +62,10 @@ using namespace trtlab::TensorRT;
 #include "nvrpc/executor.h"
 #include "nvrpc/server.h"
 #include "nvrpc/service.h"
+#include "nvrpc/zero_copy.h"
 
 #include "nvrpc/client/client_unary.h"
+#include "nvrpc/client/channel_pool.h"
 #include "nvrpc/client/executor.h"
 
 using nvrpc::AsyncService;
@@ -116,7 +122,8 @@ class PyInferenceManager final : public InferenceManager
     std::vector<std::string> Models()
     {
         std::vector<std::string> model_names;
-        ForEachModel([&model_names](const Model& model) { model_names.push_back(model.Name()); });
+        ForEachModel(
+            [&model_names](const BaseModel& model) { model_names.push_back(model.Name()); });
         return model_names;
     }
 };
@@ -128,6 +135,7 @@ class PyRemoteInferenceManager
     {
         m_Hostname = "localhost:50052";
         int client_threads = 1;
+        int channels = 1;
         for(const auto& item : kwargs)
         {
             auto key = py::cast<std::string>(item.first);
@@ -135,13 +143,21 @@ class PyRemoteInferenceManager
             {
                 m_Hostname = py::cast<std::string>(item.second);
             }
+            else if(key == "client_threads")
+            {
+                client_threads = py::cast<int>(item.second);
+            }
+            else if(key == "channels")
+            {
+                channels = py::cast<int>(item.second);
+            }
         }
 
         ::grpc::ChannelArguments ch_args;
         ch_args.SetMaxReceiveMessageSize(-1);
-        m_Channel =
-            grpc::CreateCustomChannel(m_Hostname, grpc::InsecureChannelCredentials(), ch_args);
-        m_Stub = ::trtis::GRPCService::NewStub(m_Channel);
+        m_Stubs = std::make_shared<::nvrpc::client::StubPool<::trtis::GRPCService>>(
+            m_Hostname, channels, ::nvrpc::client::ChannelPool::SelectionPolicy::LeastInFlight,
+            grpc::InsecureChannelCredentials(), ch_args);
         m_Executor = std::make_shared<::nvrpc::client::Executor>(client_threads);
     }
 
@@ -171,16 +187,17 @@ class PyRemoteInferenceManager
 
     std::shared_ptr<PyInferRemoteRunner> InferRunner(const std::string& model_name)
     {
-        auto infer_prepare_fn = [this](::grpc::ClientContext * context,
-                                       const ::trtis::InferRequest& request,
-                                       ::grpc::CompletionQueue* cq) -> auto
+        auto infer_prepare_fn = [](::trtis::GRPCService::Stub * stub,
+                                   ::grpc::ClientContext * context,
+                                   const ::trtis::InferRequest& request,
+                                   ::grpc::CompletionQueue* cq) -> auto
         {
-            return std::move(m_Stub->PrepareAsyncInfer(context, request, cq));
+            return std::move(stub->PrepareAsyncInfer(context, request, cq));
         };
 
         auto runner = std::make_unique<
             ::nvrpc::client::ClientUnary<::trtis::InferRequest, ::trtis::InferResponse>>(
-            infer_prepare_fn, m_Executor);
+            m_Stubs, infer_prepare_fn, m_Executor);
 
         return std::make_shared<PyInferRemoteRunner>(GetModel(model_name), std::move(runner));
     }
@@ -198,7 +215,7 @@ class PyRemoteInferenceManager
         ::grpc::ClientContext context;
         ::trtis::StatusRequest request;
         ::trtis::StatusResponse response;
-        auto status = m_Stub->Status(&context, request, &response);
+        auto status = m_Stubs->Stub(0)->Status(&context, request, &response);
         CHECK(status.ok());
         return response;
     }
@@ -206,8 +223,7 @@ class PyRemoteInferenceManager
   private:
     std::string m_Hostname;
     std::map<std::string, std::shared_ptr<TrtisModel>> m_Models;
-    std::shared_ptr<::grpc::Channel> m_Channel;
-    std::unique_ptr<::trtis::GRPCService::Stub> m_Stub;
+    std::shared_ptr<::nvrpc::client::StubPool<::trtis::GRPCService>> m_Stubs;
     std::shared_ptr<::nvrpc::client::Executor> m_Executor;
 };
 
@@ -557,7 +573,7 @@ class StatusContext final
             auto model_status = server_status->mutable_model_status();
 
             // populate each model
-            GetResources()->ForEachModel([model_status](const Model& model) {
+            GetResources()->ForEachModel([model_status](const BaseModel& model) {
                 auto config = (*model_status)[model.Name()].mutable_config();
                 config->set_name(model.Name());
                 config->set_max_batch_size(model.GetMaxBatchSize());
@@ -593,52 +609,175 @@ class StatusContext final
     }
 };
 
-class InferContext final
-    : public Context<::trtis::InferRequest, ::trtis::InferResponse, InferenceManager>
+/**
+ * @brief Infer RPC on raw grpc::ByteBuffers
+ *
+ * The InferRequest is read field by field from the received slices, and each raw_input is read
+ * directly into the host memory of the request's Bindings.  The raw_output fields of the
+ * InferResponse reference the host memory of the Bindings, which are held until gRPC has sent
+ * the response.  Per request, input tensors are copied once (slices to bindings) and output
+ * tensors are not copied; parsing and serializing full messages copied each tensor twice.
+ */
+class InferContext final : public Context<::grpc::ByteBuffer, ::grpc::ByteBuffer, InferenceManager>
 {
     void ExecuteRPC(RequestType& input, ResponseType& output) final override
     {
         // Executing on a Executor threads - we don't want to block message handling, so we offload
         GetResources()->AcquireThreadPool("pre").enqueue([this, &input, &output]() {
             // Executed on a thread from CudaThreadPool
-            auto model = GetResources()->GetModel(input.model_name());
-            auto buffers = GetResources()->GetBuffers(); // <=== Limited Resource; May Block !!!
-            auto bindings = buffers->CreateBindings(model);
-
-            // prepare input bindings - copy data from input
-            const auto& meta_data = input.meta_data();
-            bindings->SetBatchSize(meta_data.batch_size());
-            for(int input_idx = 0; input_idx < input.raw_input_size(); input_idx++)
+            auto meta_data = std::make_shared<::trtis::InferRequestHeader>();
+            size_t copied = 0;
+            auto bindings = ReadRequest(input, *meta_data, copied);
+            if(!bindings)
             {
-                const auto& in = meta_data.input(input_idx);
-                auto binding_idx = model->BindingId(in.name());
-                const std::string& raw = input.raw_input(input_idx);
-                CHECK_EQ(raw.size(), bindings->BindingSize(binding_idx));
-                DLOG(INFO) << "Copying binding " << in.name() << " from raw_input " << input_idx
-                           << " to binding " << binding_idx;
-                std::memcpy(bindings->HostAddress(binding_idx), raw.c_str(), raw.size());
+                this->CancelResponse();
+                return;
             }
-            InferRunner runner(model, GetResources());
-            runner.Infer(bindings, [this, &input, &output](std::shared_ptr<Bindings>& bindings) {
+
+            // the stages of the request use the runner; the post function holds it until the end
+            auto runner = std::make_shared<InferRunner>(bindings->GetModel(), GetResources());
+            runner->Infer(bindings, [this, runner, &output, meta_data,
+                                     copied](std::shared_ptr<Bindings>& bindings) {
                 // post processing function - write response
-                // for each output binding - write populate the response from data in bindings
-                const auto& input_meta_data = input.meta_data();
-                auto output_meta_data = output.mutable_meta_data();
+                // the response header is serialized; the outputs reference the bindings
+                ::trtis::InferResponse response;
+                auto output_meta_data = response.mutable_meta_data();
                 output_meta_data->set_model_name(bindings->GetModel()->Name());
                 output_meta_data->set_batch_size(bindings->BatchSize());
-                for(int idx = 0; idx < input_meta_data.output_size(); idx++)
+
+                nvrpc::ByteBufferWriter writer;
+                std::vector<uint32_t> binding_ids;
+                for(int idx = 0; idx < meta_data->output_size(); idx++)
+                {
+                    const auto& out = meta_data->output(idx);
+                    binding_ids.push_back(bindings->GetModel()->BindingId(out.name()));
+                    output_meta_data->add_output()->set_name(out.name());
+                }
+                writer.Append(response);
+                for(auto binding_idx : binding_ids)
                 {
-                    const auto& out = input_meta_data.output(idx);
-                    auto binding_idx = bindings->GetModel()->BindingId(out.name());
-                    auto meta = output_meta_data->add_output();
-                    meta->set_name(out.name());
-                    output.add_raw_output(bindings->HostAddress(binding_idx),
-                                          bindings->BindingSize(binding_idx));
+                    writer.AppendBytes(::trtis::InferResponse::kRawOutputFieldNumber,
+                                       bindings->HostAddress(binding_idx),
+                                       bindings->BindingSize(binding_idx), bindings);
                 }
+                writer.Finish(&output);
+                DLOG(INFO) << "Infer request copied " << copied + writer.CopiedBytes()
+                           << " bytes; response references " << writer.ReferencedBytes()
+                           << " bytes of bindings";
                 this->FinishResponse();
             });
         });
     }
+
+    /**
+     * @brief Read an InferRequest into the host memory of new Bindings (May Block!)
+     *
+     * Returns nullptr if the request is malformed, e.g. if it names a model that is not
+     * registered, tensors the model does not have or a batch size the model does not support.
+     */
+    std::shared_ptr<Bindings> ReadRequest(const ::grpc::ByteBuffer& request,
+                                          ::trtis::InferRequestHeader& meta_data, size_t& copied)
+    {
+        using ::google::protobuf::internal::WireFormatLite;
+
+        nvrpc::ByteBufferInputStream stream(request);
+        ::google::protobuf::io::CodedInputStream coded(&stream);
+        coded.SetTotalBytesLimit(std::numeric_limits<int>::max());
+
+        std::string model_name;
+        std::shared_ptr<BaseModel> model;
+        std::shared_ptr<Bindings> bindings;
+        int input_idx = 0;
+        bool ok = stream.Ok();
+
+        // fields are serialized in order; model_name and meta_data precede raw_input
+        while(ok)
+        {
+            auto tag = coded.ReadTag();
+            if(tag == 0)
+            {
+                break;
+            }
+            auto field = WireFormatLite::GetTagFieldNumber(tag);
+            if(field == ::trtis::InferRequest::kModelNameFieldNumber)
+            {
+                ok = WireFormatLite::ReadString(&coded, &model_name);
+            }
+            else if(field == ::trtis::InferRequest::kMetaDataFieldNumber)
+            {
+                uint32_t size;
+                ok = coded.ReadVarint32(&size);
+                auto limit = coded.PushLimit(size);
+                ok = ok && meta_data.MergePartialFromCodedStream(&coded) &&
+                     coded.ConsumedEntireMessage();
+                coded.PopLimit(limit);
+            }
+            else if(field == ::trtis::InferRequest::kRawInputFieldNumber)
+            {
+                if(!bindings)
+                {
+                    model = GetResources()->FindModel(model_name);
+                    if(!model || !Matches(*model, meta_data))
+                    {
+                        ok = false;
+                        break;
+                    }
+                    auto buffers = GetResources()->GetBuffers(model); // <=== Limited Resource
+                    bindings = buffers->CreateBindings(model);
+                    bindings->SetBatchSize(meta_data.batch_size());
+                }
+                uint32_t size;
+                ok = input_idx < meta_data.input_size() && coded.ReadVarint32(&size);
+                if(ok)
+                {
+                    const auto& in = meta_data.input(input_idx++);
+                    auto binding_idx = model->BindingId(in.name());
+                    DLOG(INFO) << "Reading raw_input " << input_idx - 1 << " into binding "
+                               << binding_idx;
+                    ok = size == bindings->BindingSize(binding_idx) &&
+                         coded.ReadRaw(bindings->HostAddress(binding_idx), size);
+                    copied += size;
+                }
+            }
+            else
+            {
+                ok = WireFormatLite::SkipField(&coded, tag);
+            }
+        }
+
+        if(!ok || !bindings || input_idx != meta_data.input_size())
+        {
+            LOG(ERROR) << "Malformed InferRequest for model " << model_name;
+            return nullptr;
+        }
+        return bindings;
+    }
+
+    /**
+     * @brief Whether the tensors and batch size of the request header are valid for the model
+     */
+    static bool Matches(const BaseModel& model, const ::trtis::InferRequestHeader& meta_data)
+    {
+        if(meta_data.batch_size() > static_cast<uint32_t>(model.GetMaxBatchSize()))
+        {
+            return false;
+        }
+        for(const auto& in : meta_data.input())
+        {
+            if(model.GetBindingType(in.name()) != BaseModel::BindingType::Input)
+            {
+                return false;
+            }
+        }
+        for(const auto& out : meta_data.output())
+        {
+            if(model.GetBindingType(out.name()) != BaseModel::BindingType::Output)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
 };
 
 void BasicInferService(std::shared_ptr<InferenceManager> resources, int port,
@@ -657,10 +796,12 @@ void BasicInferService(std::shared_ptr<InferenceManager> resources, int port,
     LOG(INFO) << "gRPC MaxReceiveMessageSize = " << trtlab::BytesToString(bytes);
 
     // A server can host multiple services
-    auto inferenceService = server.RegisterAsyncService<::trtis::GRPCService>();
+    // Infer exchanges raw ByteBuffers so tensors are not copied through parsed messages
+    using InferService =
+        ::trtis::GRPCService::WithRawMethod_Infer<::trtis::GRPCService::AsyncService>;
+    auto inferenceService = server.RegisterAsyncServiceType<InferService>();
 
-    auto rpcCompute = inferenceService->RegisterRPC<InferContext>(
-        &::trtis::GRPCService::AsyncService::RequestInfer);
+    auto rpcCompute = inferenceService->RegisterRPC<InferContext>(&InferService::RequestInfer);
 
     auto rpcStatus = inferenceService->RegisterRPC<StatusContext>(
         &::trtis::GRPCService::AsyncService::RequestStatus);
@@ -0,0 +1,113 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/infer_runner.h"
+#include "tensorrt/laboratory/inference_manager.h"
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+static constexpr uint32_t kMaxBatchSize = 64;
+static constexpr size_t kItemFloats = 1024;
+
+// Mostly small requests with an occasional full batch
+std::vector<uint32_t> MixedBatchTrace()
+{
+    std::vector<uint32_t> trace;
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        trace.push_back((i % 16 == 0) ? kMaxBatchSize : 1 + (i * 7) % 8);
+    }
+    return trace;
+}
+
+void MixedBatchTrace(benchmark::State& state, const BuffersPolicy& policy)
+{
+    auto resources = std::make_shared<InferenceManager>(4, 8);
+    resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(2));
+    resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+    resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(2));
+    resources->SetBuffersPolicy(policy);
+    resources->RegisterModel("echo", std::make_shared<EchoModel>(
+                                         kMaxBatchSize, std::vector<size_t>{kItemFloats}));
+    resources->AllocateResources();
+
+    auto trace = MixedBatchTrace();
+    size_t items = 0;
+    InferRunner runner(resources->GetModel("echo"), resources);
+    for(auto _ : state)
+    {
+        std::vector<std::shared_future<void>> futures;
+        for(auto batch_size : trace)
+        {
+            futures.push_back(runner.Infer(
+                batch_size,
+                [](Bindings& bindings) {
+                    std::memset(bindings.HostAddress(0), 1, bindings.BindingSize(0));
+                },
+                [](std::shared_ptr<Bindings>& bindings) {
+                    benchmark::DoNotOptimize(bindings->HostAddress(1));
+                }));
+            items += batch_size;
+        }
+        for(auto& future : futures)
+        {
+            future.wait();
+        }
+    }
+    state.SetItemsProcessed(items);
+    state.counters["requests/s"] =
+        benchmark::Counter(state.iterations() * trace.size(), benchmark::Counter::kIsRate);
+    state.counters["footprint_bytes"] = resources->BuffersFootprint();
+
+    resources->JoinAllThreads();
+}
+
+} // namespace
+
+static void BM_FixedBuffers_MixedBatchTrace(benchmark::State& state)
+{
+    MixedBatchTrace(state, BuffersPolicy{});
+}
+
+static void BM_CyclicBuffers_MixedBatchTrace(benchmark::State& state)
+{
+    BuffersPolicy policy;
+    policy.strategy = BuffersPolicy::Strategy::kCyclic;
+    MixedBatchTrace(state, policy);
+}
+
+BENCHMARK(BM_FixedBuffers_MixedBatchTrace)->UseRealTime();
+BENCHMARK(BM_CyclicBuffers_MixedBatchTrace)->UseRealTime();
@@ -0,0 +1,139 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorrt/laboratory/bindings.h"
+#include "tensorrt/laboratory/infer_bench.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Values searched by an AutoTuner
+ *
+ * buffers of 0 use twice the number of executions.  An empty list of batch_sizes searches the
+ * powers of 2 up to, and including, the model's GetMaxBatchSize().
+ */
+struct TuningSpace
+{
+    std::vector<int> executions = {1, 2, 4};
+    std::vector<int> buffers = {0};
+    std::vector<uint32_t> batch_sizes;
+    std::vector<uint32_t> pre_threads = {1, 2, 4};
+    std::vector<uint32_t> post_threads = {1, 2};
+};
+
+/**
+ * @brief Latency SLO and load of every trial of an AutoTuner
+ *
+ * A trial meets the SLO when its latency_percentile, in seconds, is at most latency_slo.  Of the
+ * trials meeting the SLO, those within throughput_tolerance of the best throughput are considered
+ * equally fast; the one with the smallest memory footprint, then the fewest threads, is chosen.
+ */
+struct TuningOptions
+{
+    double latency_slo = 0.010;
+    InferBenchKey latency_percentile = kLatencyP99;
+    uint32_t concurrency = 16;
+    double seconds = 1.0;
+    double warmup = 0.1;
+    double throughput_tolerance = 0.05;
+};
+
+/**
+ * @brief Offline search for the InferenceManager and ThreadPool sizes of a model
+ *
+ * Every configuration of the TuningSpace is benchmarked with InferBench on a fresh
+ * InferenceManager holding only a model created by the factory; a model that ExecutesOnHost can be
+ * tuned without a GPU.  Batch sizes are tried in increasing order and larger batch sizes are
+ * skipped once a batch size misses the SLO.  The "cuda" ThreadPool has one thread per execution.
+ */
+class AutoTuner
+{
+  public:
+    using ModelFactory = std::function<std::shared_ptr<BaseModel>()>;
+
+    struct Configuration
+    {
+        int max_executions;
+        int max_buffers;
+        uint32_t batch_size;
+        uint32_t pre_threads;
+        uint32_t post_threads;
+        uint32_t cuda_threads;
+    };
+
+    struct Trial
+    {
+        Configuration config;
+        InferBench::Results results;
+        size_t memory;
+        bool meets_slo;
+    };
+
+    AutoTuner(ModelFactory, TuningSpace space = TuningSpace(),
+              TuningOptions options = TuningOptions());
+    virtual ~AutoTuner();
+
+    /**
+     * @brief Request pre- and post-processing of the benchmark; see InferBench::SetRequestWork
+     */
+    void SetRequestWork(std::function<void(Bindings&)> pre, std::function<void(Bindings&)> post);
+
+    /**
+     * @brief Run every trial; returns the best trial, or nullptr if no trial meets the SLO
+     *
+     * The returned trial is owned by the AutoTuner and valid until the next call to Run.
+     */
+    const Trial* Run();
+
+    const std::vector<Trial>& Trials() const { return m_Trials; }
+
+    static std::string ToJSON(const Trial&);
+
+  private:
+    Trial Measure(const Configuration&);
+    const Trial* Best() const;
+
+    ModelFactory m_ModelFactory;
+    TuningSpace m_Space;
+    TuningOptions m_Options;
+    std::function<void(Bindings&)> m_PreWork;
+    std::function<void(Bindings&)> m_PostWork;
+    std::vector<Trial> m_Trials;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
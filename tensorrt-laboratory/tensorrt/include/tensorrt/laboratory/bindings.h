@@ -41,7 +41,7 @@
 namespace trtlab {
 namespace TensorRT {
 
-class Model;
+class BaseModel;
 class Buffers;
 
 /**
@@ -73,6 +73,14 @@ class Bindings
     void SetHostAddress(int binding_id, HostDescriptor);
     void SetDeviceAddress(int binding_id, DeviceDescriptor);
 
+    /**
+     * @brief Use the host buffer of binding_id as its device address.
+     *
+     * Used by host-resident Buffers, i.e. for models that execute on the CPU.  Transfers
+     * between aliased host and device addresses are skipped.
+     */
+    void SetDeviceAddressToHost(int binding_id);
+
     HostDescriptor& HostMemoryDescriptor(int binding_id);
     // const HostMemory& HostMemory(int binding_id) const;
 
@@ -90,21 +98,30 @@ class Bindings
     auto InputBindings() const { return m_Model->GetInputBindingIds(); }
     auto OutputBindings() const { return m_Model->GetOutputBindingIds(); }
 
-    auto GetModel() -> const std::shared_ptr<Model>& { return m_Model; }
+    auto GetModel() -> const std::shared_ptr<BaseModel>& { return m_Model; }
     auto BatchSize() const { return m_BatchSize; }
     void SetBatchSize(uint32_t);
 
+    /**
+     * @brief Number of batch items the binding memory was allocated for; SetBatchSize can not
+     * exceed this value.
+     */
+    auto AllocatedBatchSize() const { return m_AllocatedBatchSize; }
+
     inline cudaStream_t Stream() const { return m_Buffers->Stream(); }
     void Synchronize() const { m_Buffers->Synchronize(); }
 
     size_t BindingSize(uint32_t binding_id) const;
+    size_t BindingCapacity(uint32_t binding_id) const;
 
   private:
-    Bindings(const std::shared_ptr<Model>, const std::shared_ptr<Buffers>);
+    Bindings(const std::shared_ptr<BaseModel>, const std::shared_ptr<Buffers>,
+             uint32_t allocated_batch_size);
 
-    const std::shared_ptr<Model> m_Model;
+    const std::shared_ptr<BaseModel> m_Model;
     const std::shared_ptr<Buffers> m_Buffers;
     uint32_t m_BatchSize;
+    uint32_t m_AllocatedBatchSize;
 
     std::vector<void*> m_HostAddresses;
     std::vector<void*> m_DeviceAddresses;
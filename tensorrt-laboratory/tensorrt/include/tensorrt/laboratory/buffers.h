@@ -27,6 +27,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <cuda.h>
 #include <cuda_runtime.h>
@@ -53,20 +54,73 @@ class Buffers : public std::enable_shared_from_this<Buffers>
     Buffers();
     virtual ~Buffers();
 
-    auto CreateBindings(const std::shared_ptr<Model>&) -> std::shared_ptr<Bindings>;
+    auto CreateBindings(const std::shared_ptr<BaseModel>&) -> std::shared_ptr<Bindings>;
+
+    /**
+     * @brief Create Bindings whose memory is sized for batch_size items rather than the model's
+     * maximum batch size, so several small requests can share the stacks of one Buffers object.
+     * The batch size of the returned Bindings is set to batch_size.
+     */
+    auto CreateBindings(const std::shared_ptr<BaseModel>&, uint32_t batch_size)
+        -> std::shared_ptr<Bindings>;
+
+    /**
+     * @brief True if Bindings for batch_size items of the model fit in the remaining stack space
+     */
+    bool Fits(const BaseModel&, uint32_t batch_size) const;
 
     inline cudaStream_t Stream() { return m_Stream; }
     void Synchronize();
 
   protected:
+    /**
+     * @brief Construct a Buffers object without a cudaStream_t; Stream() returns nullptr and
+     * Synchronize() is a no-op.  Used by host-resident Buffers.
+     */
+    explicit Buffers(bool create_stream);
+
     virtual void Reset(bool writeZeros = false){};
-    void ConfigureBindings(const std::shared_ptr<Model>& model, std::shared_ptr<Bindings>);
+    virtual void ConfigureBindings(const std::shared_ptr<BaseModel>& model,
+                                   std::shared_ptr<Bindings>);
+    void ConfigureHostBindings(const std::shared_ptr<BaseModel>& model, std::shared_ptr<Bindings>);
 
     virtual std::unique_ptr<HostMemory> AllocateHost(size_t size) = 0;
     virtual std::unique_ptr<DeviceMemory> AllocateDevice(size_t size) = 0;
 
+    virtual bool StacksFit(const std::vector<size_t>&) const { return true; }
+
+    template<typename MemoryType>
+    static bool StackFits(const MemoryStack<MemoryType>& stack, const std::vector<size_t>& sizes)
+    {
+        return AlignedSize(sizes, stack.Alignment()) <= stack.Available();
+    }
+
+    static size_t AlignedSize(const std::vector<size_t>& sizes, size_t alignment);
+
+    /**
+     * @brief Bytes needed to place all bindings back to back, each aligned to alignment
+     */
+    static size_t BindingsSize(const Bindings&, size_t alignment);
+
+    /**
+     * @brief Point each binding to its range of a single host and a single device allocation,
+     * laid out as by BindingsSize.  Without a device allocation, the device addresses alias the
+     * host addresses.
+     */
+    void ConfigureBindingsFromAllocations(std::shared_ptr<Bindings>,
+                                          std::shared_ptr<HostMemory> host, size_t host_alignment,
+                                          std::shared_ptr<DeviceMemory> device,
+                                          size_t device_alignment);
+
   private:
+    auto MakeBindings(const std::shared_ptr<BaseModel>&, uint32_t) -> std::shared_ptr<Bindings>;
+
     cudaStream_t m_Stream;
+
+    // Handle issued by the InferenceManager's Pool; Bindings keep it alive so the Buffers are
+    // not reset and returned to the Pool while any Bindings created from them are in use.
+    std::weak_ptr<Buffers> m_PoolHandle;
+
     friend class InferenceManager;
 };
 
@@ -112,17 +166,34 @@ class FixedBuffers : public Buffers
         m_DeviceStack->Reset(writeZeros);
     }
 
+    bool StacksFit(const std::vector<size_t>& binding_sizes) const final override
+    {
+        return StackFits(*m_HostStack, binding_sizes) && StackFits(*m_DeviceStack, binding_sizes);
+    }
+
   private:
     std::unique_ptr<MemoryStack<HostMemoryType>> m_HostStack;
     std::unique_ptr<MemoryStack<DeviceMemoryType>> m_DeviceStack;
 };
 
+/**
+ * @brief Buffers that take the memory of each request from rings of rotating segments
+ *
+ * FixedBuffers reserve stacks sized for the largest model at its maximum batch size.  The memory
+ * of CyclicBuffers is only sized for the batch size the Bindings are created for and is taken
+ * from CyclicAllocators, which are usually shared by all the CyclicBuffers of a Pool.  All
+ * bindings of a request are placed in one allocation per memory space, so a request never holds
+ * part of its memory while waiting on a segment.  Creating Bindings blocks while every segment
+ * of a ring holds allocations of requests in flight.
+ *
+ * @see CyclicAllocator for sizing the segments of the rings
+ */
 template<typename HostMemoryType, typename DeviceMemoryType>
 class CyclicBuffers : public Buffers
 {
   public:
-    using HostAllocatorType = std::unique_ptr<CyclicAllocator<HostMemoryType>>;
-    using DeviceAllocatorType = std::unique_ptr<CyclicAllocator<DeviceMemoryType>>;
+    using HostAllocatorType = std::shared_ptr<CyclicAllocator<HostMemoryType>>;
+    using DeviceAllocatorType = std::shared_ptr<CyclicAllocator<DeviceMemoryType>>;
 
     using HostDescriptor = typename CyclicAllocator<HostMemoryType>::Descriptor;
     using DeviceDescriptor = typename CyclicAllocator<DeviceMemoryType>::Descriptor;
@@ -133,22 +204,150 @@ class CyclicBuffers : public Buffers
     }
     ~CyclicBuffers() override {}
 
-    std::unique_ptr<HostMemory> AllocateHost(size_t size)
+    std::unique_ptr<HostMemory> AllocateHost(size_t size) final override
     {
         return m_HostAllocator->Allocate(size);
     }
 
-    std::unique_ptr<DeviceMemory> AllocateDevice(size_t size)
+    std::unique_ptr<DeviceMemory> AllocateDevice(size_t size) final override
     {
         return m_DeviceAllocator->Allocate(size);
     }
 
+  protected:
+    void ConfigureBindings(const std::shared_ptr<BaseModel>& model,
+                           std::shared_ptr<Bindings> bindings) final override
+    {
+        auto host_alignment = m_HostAllocator->Alignment();
+        auto device_alignment = m_DeviceAllocator->Alignment();
+        std::shared_ptr<HostMemory> host = AllocateHost(BindingsSize(*bindings, host_alignment));
+        std::shared_ptr<DeviceMemory> device =
+            AllocateDevice(BindingsSize(*bindings, device_alignment));
+        ConfigureBindingsFromAllocations(bindings, std::move(host), host_alignment,
+                                         std::move(device), device_alignment);
+    }
+
     void Reset(bool writeZeros = false) final override {}
 
+    bool StacksFit(const std::vector<size_t>& binding_sizes) const final override
+    {
+        return AlignedSize(binding_sizes, m_HostAllocator->Alignment()) <=
+                   m_HostAllocator->MaxAllocationSize() &&
+               AlignedSize(binding_sizes, m_DeviceAllocator->Alignment()) <=
+                   m_DeviceAllocator->MaxAllocationSize();
+    }
+
   private:
     HostAllocatorType m_HostAllocator;
     DeviceAllocatorType m_DeviceAllocator;
 };
 
+/**
+ * @brief Host-resident CyclicBuffers for models that execute on the CPU
+ *
+ * The bindings of each request are taken from a ring of host memory and their device addresses
+ * alias the host addresses, as for HostBuffers.  No CUDA resources are created.
+ */
+template<typename HostMemoryType>
+class CyclicHostBuffers : public Buffers
+{
+  public:
+    using HostAllocatorType = std::shared_ptr<CyclicAllocator<HostMemoryType>>;
+
+    CyclicHostBuffers(HostAllocatorType host) : Buffers(false), m_HostAllocator{std::move(host)}
+    {
+    }
+    ~CyclicHostBuffers() override {}
+
+  protected:
+    void ConfigureBindings(const std::shared_ptr<BaseModel>& model,
+                           std::shared_ptr<Bindings> bindings) final override
+    {
+        auto alignment = m_HostAllocator->Alignment();
+        std::shared_ptr<HostMemory> host = AllocateHost(BindingsSize(*bindings, alignment));
+        ConfigureBindingsFromAllocations(bindings, std::move(host), alignment, nullptr, 0);
+    }
+
+    std::unique_ptr<HostMemory> AllocateHost(size_t size) final override
+    {
+        return m_HostAllocator->Allocate(size);
+    }
+
+    std::unique_ptr<DeviceMemory> AllocateDevice(size_t size) final override
+    {
+        LOG(FATAL) << "CyclicHostBuffers do not provide device memory";
+        return nullptr;
+    }
+
+    void Reset(bool writeZeros = false) final override {}
+
+    bool StacksFit(const std::vector<size_t>& binding_sizes) const final override
+    {
+        return AlignedSize(binding_sizes, m_HostAllocator->Alignment()) <=
+               m_HostAllocator->MaxAllocationSize();
+    }
+
+  private:
+    HostAllocatorType m_HostAllocator;
+};
+
+/**
+ * @brief Host-resident Buffers for models that execute on the CPU
+ *
+ * Each binding is pushed once to a host memory stack and its device address aliases the host
+ * address, so the CopyToDevice/CopyFromDevice calls of the common execution paths are no-ops.
+ * No CUDA resources are created; these Buffers can be used on machines without a GPU.
+ */
+template<typename HostMemoryType>
+class HostBuffers : public Buffers
+{
+  public:
+    HostBuffers(size_t host_size)
+        : Buffers(false), m_HostStack(std::make_unique<MemoryStack<HostMemoryType>>(host_size))
+    {
+    }
+
+    ~HostBuffers() override {}
+
+  protected:
+    class BufferStackDescriptor final : public Descriptor<HostMemoryType>
+    {
+      public:
+        BufferStackDescriptor(void* ptr, size_t size)
+            : Descriptor<HostMemoryType>(ptr, size, HostMemoryType::Type() + "Desc")
+        {
+        }
+        ~BufferStackDescriptor() final override {}
+    };
+
+    void ConfigureBindings(const std::shared_ptr<BaseModel>& model,
+                           std::shared_ptr<Bindings> bindings) final override
+    {
+        ConfigureHostBindings(model, bindings);
+    }
+
+    std::unique_ptr<HostMemory> AllocateHost(size_t size) final override
+    {
+        return std::move(
+            std::make_unique<BufferStackDescriptor>(m_HostStack->Allocate(size), size));
+    }
+
+    std::unique_ptr<DeviceMemory> AllocateDevice(size_t size) final override
+    {
+        LOG(FATAL) << "HostBuffers do not provide device memory";
+        return nullptr;
+    }
+
+    void Reset(bool writeZeros = false) final override { m_HostStack->Reset(writeZeros); }
+
+    bool StacksFit(const std::vector<size_t>& binding_sizes) const final override
+    {
+        return StackFits(*m_HostStack, binding_sizes);
+    }
+
+  private:
+    std::unique_ptr<MemoryStack<HostMemoryType>> m_HostStack;
+};
+
 } // namespace TensorRT
 } // namespace trtlab
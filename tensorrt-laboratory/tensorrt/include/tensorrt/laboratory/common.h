@@ -34,6 +34,7 @@ namespace trtlab {
 namespace TensorRT {
 
 class Runtime;
+class BaseModel;
 class Model;
 class Buffers;
 class Bindings;
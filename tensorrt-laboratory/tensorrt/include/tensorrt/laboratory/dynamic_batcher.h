@@ -0,0 +1,165 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tensorrt/laboratory/bindings.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/infer_runner.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Limits for a DynamicBatcher
+ *
+ * max_batch_size caps the size of a batch; 0 or values larger than the model's
+ * GetMaxBatchSize() use the model's maximum.
+ *
+ * A batch is dispatched as soon as the largest preferred batch size (or max_batch_size if none
+ * are given) is queued.  Otherwise the batcher waits up to max_queue_delay, measured from the
+ * oldest queued request, then dispatches the largest preferred batch size not exceeding the
+ * queue depth, or the whole queue if no preferred size fits.
+ *
+ * While max_batches_in_flight batches are being computed, requests keep accumulating so the
+ * next batch can grow; 0 uses the InferenceManager's MaxCopyConcurrency().
+ */
+struct DynamicBatchingPolicy
+{
+    uint32_t max_batch_size = 0;
+    std::chrono::microseconds max_queue_delay = std::chrono::microseconds(1000);
+    std::vector<uint32_t> preferred_batch_sizes;
+    uint32_t max_batches_in_flight = 0;
+};
+
+/**
+ * @brief View of a single request's batch item within the batched Bindings.
+ */
+class BatchItem
+{
+  public:
+    BatchItem(Bindings& bindings, uint32_t index) : m_Bindings(bindings), m_Index(index) {}
+
+    void* HostAddress(uint32_t binding_id);
+    void* HostAddress(const std::string& binding_name);
+    size_t BindingSize(uint32_t binding_id) const;
+
+    uint32_t Index() const { return m_Index; }
+    Bindings& GetBindings() { return m_Bindings; }
+
+  private:
+    Bindings& m_Bindings;
+    uint32_t m_Index;
+};
+
+/**
+ * @brief Server-side dynamic batcher for a single model
+ *
+ * Individual requests, each a single batch item, are queued and coalesced into batches
+ * according to the DynamicBatchingPolicy.  Each batch is executed as one Bindings by an
+ * InferRunner: the pre functions of the requests write their inputs directly into their slice of
+ * the batched input bindings, and after the compute, the post functions read their slice of the
+ * output bindings and fulfill the per-request futures.
+ *
+ * The destructor flushes queued requests and waits on all batches in flight.
+ */
+class DynamicBatcher
+{
+  public:
+    using PreFn = std::function<void(BatchItem&)>;
+
+    DynamicBatcher(std::shared_ptr<BaseModel>, std::shared_ptr<InferenceManager>,
+                   DynamicBatchingPolicy policy = DynamicBatchingPolicy());
+    virtual ~DynamicBatcher();
+
+    DELETE_COPYABILITY(DynamicBatcher);
+    DELETE_MOVEABILITY(DynamicBatcher);
+
+    template<typename Post>
+    auto Infer(PreFn pre, Post post)
+    {
+        auto compute = AsyncComputeWrapper<void(BatchItem&)>::Wrap(post);
+        auto future = compute->Future();
+        Enqueue(std::move(pre), [compute](BatchItem& item) mutable { (*compute)(item); });
+        return future.share();
+    }
+
+    struct Stats
+    {
+        uint64_t requests;
+        uint64_t batches;
+        std::map<uint32_t, uint64_t> batch_sizes;
+    };
+
+    Stats GetStats() const;
+    uint32_t MaxBatchSize() const { return m_MaxBatchSize; }
+
+  private:
+    struct Request
+    {
+        PreFn pre;
+        std::function<void(BatchItem&)> post;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void Enqueue(PreFn pre, std::function<void(BatchItem&)> post);
+    void BatchingLoop();
+    uint32_t NextBatchSize(bool expired) const;
+    void Dispatch(std::vector<Request>&& batch);
+
+    const std::shared_ptr<BaseModel> m_Model;
+    const std::shared_ptr<InferenceManager> m_Resources;
+    DynamicBatchingPolicy m_Policy;
+    uint32_t m_MaxBatchSize;
+    uint32_t m_DispatchSize;
+    uint32_t m_MaxInFlight;
+
+    InferRunner m_Runner;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<Request> m_Queue;
+    uint32_t m_InFlight;
+    bool m_Shutdown;
+    Stats m_Stats;
+
+    std::thread m_Thread;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,198 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tensorrt/laboratory/bindings.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/utils.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+class Ensemble;
+
+/**
+ * @brief Bindings of all steps of one Ensemble request
+ *
+ * Tensors are addressed by their ensemble input/output names.  The inputs are written by the
+ * pre function and the outputs read by the post function of Ensemble::Infer.
+ */
+class EnsembleBindings
+{
+  public:
+    virtual ~EnsembleBindings();
+
+    uint32_t BatchSize() const { return m_BatchSize; }
+
+    void* HostAddress(const std::string& tensor);
+    size_t BindingSize(const std::string& tensor) const;
+
+    Bindings& StepBindings(const std::string& step);
+
+  private:
+    EnsembleBindings(const Ensemble&, uint32_t batch_size);
+
+    const Ensemble& m_Ensemble;
+    uint32_t m_BatchSize;
+    std::vector<std::shared_ptr<Bindings>> m_Steps;
+
+    // number of producers of each step that have not completed
+    std::mutex m_Mutex;
+    std::vector<uint32_t> m_Pending;
+
+    friend class Ensemble;
+};
+
+/**
+ * @brief DAG of registered models executed in-process as a single request
+ *
+ * Each step executes a model registered with the InferenceManager.  Connect feeds an output
+ * binding of one step to an input binding of a later step: the input binding of the consumer
+ * aliases the host memory of the producer's output, so no data is copied between the steps.
+ * Host models also alias the device address; device models copy the tensor from the aliased host
+ * memory to the device as usual.  Inputs of the ensemble may feed several steps.
+ *
+ * Steps are executed on the "cuda" ThreadPool of the InferenceManager as soon as their producers
+ * completed, so independent branches execute concurrently; execution slots are acquired through
+ * the ExecutionScheduler of each step's model.  The Bindings of all steps are created from the
+ * Buffers Pools of the step models before the pre function runs and are held until the post
+ * function returns.  Requests create their Bindings one at a time, so concurrent requests can not
+ * deadlock on partially acquired Buffers; each Buffers Pool must hold at least as many Buffers as
+ * there are steps whose models it serves.
+ *
+ * Steps, connections and tensors are declared before Finalize, which validates the graph and
+ * throws std::runtime_error if it has cycles, unbound or doubly bound inputs, connected tensors of
+ * different types or sizes, or a Buffers Pool too small for one request.  If the resources of the
+ * InferenceManager are allocated after Finalize, the Buffers Pools are checked by the first
+ * Infer instead.  The Ensemble must outlive its requests.
+ */
+class Ensemble : public AsyncComputeWrapper<void(std::shared_ptr<EnsembleBindings>&)>
+{
+  public:
+    using PreFn = std::function<void(EnsembleBindings&)>;
+    using PostFn = std::function<void(std::shared_ptr<EnsembleBindings>&)>;
+
+    Ensemble(std::shared_ptr<InferenceManager> resources);
+    virtual ~Ensemble();
+
+    DELETE_COPYABILITY(Ensemble);
+    DELETE_MOVEABILITY(Ensemble);
+
+    void AddStep(const std::string& step, const std::string& model_name);
+    void Connect(const std::string& producer, const std::string& output,
+                 const std::string& consumer, const std::string& input);
+    void AddInput(const std::string& tensor, const std::string& step, const std::string& input);
+    void AddOutput(const std::string& tensor, const std::string& step, const std::string& output);
+
+    void Finalize();
+
+    /**
+     * @brief Smallest maximum batch size of the step models
+     */
+    uint32_t GetMaxBatchSize() const { return m_MaxBatchSize; }
+
+    /**
+     * @brief Names of the steps in execution order
+     */
+    auto Steps() const -> std::vector<std::string>;
+
+    template<typename Post>
+    auto Infer(PreFn pre, Post post)
+    {
+        return Infer(GetMaxBatchSize(), pre, post);
+    }
+
+    template<typename Post>
+    auto Infer(uint32_t batch_size, PreFn pre, Post post)
+    {
+        auto compute = WrapReleasing(post);
+        auto future = compute->Future();
+        Enqueue(batch_size, pre,
+                [compute](std::shared_ptr<EnsembleBindings>& bindings) { (*compute)(bindings); });
+        return future.share();
+    }
+
+  private:
+    struct Port
+    {
+        uint32_t step;
+        uint32_t binding;
+    };
+
+    struct Step
+    {
+        std::string name;
+        std::shared_ptr<BaseModel> model;
+        std::vector<uint32_t> consumers;
+        uint32_t producers;
+    };
+
+    Port FindPort(const std::string& step, const std::string& binding, bool is_input) const;
+    void Bind(const Port& input, const Port& source);
+
+    void Enqueue(uint32_t batch_size, PreFn pre, PostFn post);
+    void Launch(std::shared_ptr<EnsembleBindings>, uint32_t step);
+    void Execute(const std::shared_ptr<Bindings>&, const BaseModel&);
+    auto CreateBindings(uint32_t batch_size) -> std::shared_ptr<EnsembleBindings>;
+    bool CheckBuffers() const;
+
+    inline ThreadPool& Workers(std::string name) { return m_Resources->AcquireThreadPool(name); }
+
+    std::shared_ptr<InferenceManager> m_Resources;
+    std::vector<Step> m_Steps;
+    std::map<std::string, uint32_t> m_StepIds;
+
+    // input binding of a step -> output binding or ensemble input it aliases
+    std::map<std::pair<uint32_t, uint32_t>, Port> m_Sources;
+    std::map<std::string, Port> m_Tensors;
+
+    std::vector<uint32_t> m_Order;
+    uint32_t m_MaxBatchSize;
+    bool m_Finalized;
+
+    // set once the Buffers Pools were found large enough for one request
+    std::atomic<bool> m_BuffersChecked;
+
+    // serializes the creation of the Bindings of concurrent requests
+    std::mutex m_CreateMutex;
+
+    friend class EnsembleBindings;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -43,8 +43,8 @@ namespace TensorRT {
  * The ExecutionContext is a limited quanity resource used to control the number
  * of simultaneous calculations allowed on the device at any given time.
  *
- * A properly configured Bindings object is required to initiate the TensorRT
- * inference calculation.
+ * A properly configured Bindings object is required to initiate the inference
+ * calculation of the model's IExecutor.
  */
 class ExecutionContext
 {
@@ -54,7 +54,7 @@ class ExecutionContext
     DELETE_COPYABILITY(ExecutionContext);
     DELETE_MOVEABILITY(ExecutionContext);
 
-    void SetContext(std::shared_ptr<::nvinfer1::IExecutionContext> context);
+    void SetContext(std::shared_ptr<IExecutor> context);
     void Infer(const std::shared_ptr<Bindings>&);
     auto Synchronize() -> double;
 
@@ -64,7 +64,8 @@ class ExecutionContext
 
     std::function<double()> m_ElapsedTimer;
     cudaEvent_t m_ExecutionContextFinished;
-    std::shared_ptr<::nvinfer1::IExecutionContext> m_Context;
+    bool m_EventRecorded;
+    std::shared_ptr<IExecutor> m_Context;
 
     std::unique_ptr<CudaDeviceMemory> m_Workspace;
 
@@ -0,0 +1,129 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "tensorrt/laboratory/core/utils.h"
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Per-model share of the ExecutionScheduler
+ *
+ * weight is the model's relative share of the execution slots while models compete for them.
+ * max_concurrency caps the slots the model may hold; 0 uses the concurrency the model was
+ * registered with.  min_reserved slots are held back for the model: other models can not use
+ * them, even while the model is idle.
+ */
+struct SchedulingPolicy
+{
+    double weight = 1.0;
+    uint32_t max_concurrency = 0;
+    uint32_t min_reserved = 0;
+};
+
+/**
+ * @brief Weighted fair scheduler for the shared execution slots of an InferenceManager
+ *
+ * Acquire blocks until the calling model is granted a slot.  Whenever a slot is free, it is
+ * granted to the first waiter of the eligible model with the smallest virtual time; each grant
+ * advances the model's virtual time by 1 / weight (start-time fair queuing).  A model becoming
+ * active starts at the smallest virtual time of the active models, so idle models do not bank
+ * credit.  A model is eligible while it holds fewer than its max_concurrency slots and granting
+ * the slot leaves the unused reservations of the other models intact.  Models below their
+ * reservation are served first.
+ */
+class ExecutionScheduler
+{
+  public:
+    ExecutionScheduler(uint32_t capacity);
+    virtual ~ExecutionScheduler();
+
+    DELETE_COPYABILITY(ExecutionScheduler);
+    DELETE_MOVEABILITY(ExecutionScheduler);
+
+    void AddModel(const BaseModel*, uint32_t max_concurrency);
+    void RemoveModel(const BaseModel*);
+    void SetPolicy(const BaseModel*, const SchedulingPolicy&);
+
+    void Acquire(const BaseModel*);
+    void Release(const BaseModel*);
+
+    struct Stats
+    {
+        uint32_t queue_depth;
+        uint32_t in_flight;
+        uint64_t granted;
+        std::chrono::nanoseconds total_wait;
+        std::chrono::nanoseconds max_wait;
+    };
+
+    Stats GetStats(const BaseModel*) const;
+    uint32_t Capacity() const { return m_Capacity; }
+
+  private:
+    struct Waiter
+    {
+        std::chrono::steady_clock::time_point enqueued;
+        bool granted;
+    };
+
+    struct ModelState
+    {
+        SchedulingPolicy policy;
+        uint32_t registered_concurrency;
+        uint32_t max_concurrency;
+        double virtual_time;
+        std::deque<Waiter*> waiters;
+        Stats stats;
+    };
+
+    ModelState& State(const BaseModel*);
+    const ModelState& State(const BaseModel*) const;
+    bool Schedule();
+    uint32_t UnusedReservations(const ModelState* except) const;
+
+    const uint32_t m_Capacity;
+    uint32_t m_Free;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::vector<const BaseModel*> m_Order;
+    std::map<const BaseModel*, ModelState> m_Models;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,109 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Base class for reference models that execute on the CPU.
+ *
+ * HostModels conform to IModel so they can be registered with an InferenceManager and driven by
+ * the same Buffers, Bindings, InferRunner and RPC paths as TensorRT models.  An InferenceManager
+ * with only HostModels registered allocates no GPU resources, which makes it possible to measure
+ * the scheduling and I/O overheads in isolation on machines without a GPU.
+ */
+class HostModel : public BaseModel
+{
+  public:
+    HostModel(int max_batch_size);
+    ~HostModel() override;
+
+    int GetMaxBatchSize() const final override { return m_MaxBatchSize; }
+    bool ExecutesOnHost() const final override { return true; }
+    auto CreateExecutor() const -> std::shared_ptr<IExecutor> final override;
+
+    /**
+     * @brief Compute a batch; tensors are read from and written to Bindings::HostAddress.
+     */
+    virtual void Execute(Bindings&) const = 0;
+
+  protected:
+    void AddHostBinding(const std::string& name, bool is_input, const std::vector<size_t>& dims,
+                        ::nvinfer1::DataType dtype = ::nvinfer1::DataType::kFLOAT);
+
+    uint32_t BatchSize(const Bindings&) const;
+
+  private:
+    int m_MaxBatchSize;
+};
+
+/**
+ * @brief Identity model; copies binding "input" to binding "output".
+ */
+class EchoModel final : public HostModel
+{
+  public:
+    EchoModel(int max_batch_size, const std::vector<size_t>& dims);
+    ~EchoModel() final override;
+
+    void Execute(Bindings&) const final override;
+};
+
+/**
+ * @brief Single fully connected layer; output = relu(weights * input + bias).
+ *
+ * Bindings "input" and "output" are float vectors of size `inputs` and `outputs`.  The weights
+ * are generated from `seed` so results are reproducible.
+ */
+class DenseModel final : public HostModel
+{
+  public:
+    DenseModel(int max_batch_size, size_t inputs, size_t outputs, uint32_t seed = 0);
+    ~DenseModel() final override;
+
+    auto GetWeightsMemorySize() const -> size_t final override;
+    void Execute(Bindings&) const final override;
+
+    const std::vector<float>& Weights() const { return m_Weights; }
+    const std::vector<float>& Bias() const { return m_Bias; }
+
+  private:
+    size_t m_Inputs;
+    size_t m_Outputs;
+    std::vector<float> m_Weights;
+    std::vector<float> m_Bias;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
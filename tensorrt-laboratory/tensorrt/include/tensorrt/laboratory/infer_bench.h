@@ -26,6 +26,12 @@
  */
 #pragma once
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "tensorrt/laboratory/inference_manager.h"
 #include "tensorrt/laboratory/model.h"
 
@@ -42,28 +48,75 @@ enum InferBenchKey
     kBatchesPerSecond,
     kInferencesPerSecond,
     kSecondsPerBatch,
-    kExecutionTimePerBatch
+    kExecutionTimePerBatch,
+    kConcurrency,
+    kWarmupTime,
+    kLatencyMean,
+    kLatencyP50,
+    kLatencyP90,
+    kLatencyP99,
+    kLatencyP999,
+    kLatencyMax
 };
 
+/**
+ * @brief Throughput and latency benchmark over the registered models of an InferenceManager
+ *
+ * Requests are issued round-robin over the models for the given number of seconds, after an
+ * optional warmup period whose requests are not measured.  concurrency limits the number of
+ * requests in flight; 0 issues requests as fast as Buffers are available.  Latencies, in
+ * seconds, are measured from issuing a request, including the wait for Buffers, until its
+ * results are available.
+ */
 class InferBench
 {
   public:
     InferBench(std::shared_ptr<InferenceManager>);
     virtual ~InferBench();
 
-    using ModelsList = std::vector<std::shared_ptr<Model>>;
+    using ModelsList = std::vector<std::shared_ptr<BaseModel>>;
     using Results = std::map<InferBenchKey, double>;
+    using ResultsList = std::vector<std::unique_ptr<Results>>;
 
-    std::unique_ptr<Results> Run(const std::shared_ptr<Model> model, uint32_t batch_size,
+    std::unique_ptr<Results> Run(const std::shared_ptr<BaseModel> model, uint32_t batch_size,
                                  double seconds = 5.0);
     std::unique_ptr<Results> Run(const ModelsList& models, uint32_t batch_size,
                                  double seconds = 5.0);
+    std::unique_ptr<Results> Run(const ModelsList& models, uint32_t batch_size, double seconds,
+                                 double warmup, uint32_t concurrency);
+
+    /**
+     * @brief Issue requests through the "pre" ThreadPool, calling pre on the input Bindings and
+     * post on the output Bindings of every request; either may be empty
+     *
+     * By default Buffers are acquired on the calling thread and requests start on the "cuda"
+     * ThreadPool, so the "pre" ThreadPool is idle.  Once request work is set, the latency of a
+     * request includes waiting for pre and post workers; a concurrency limit should be used, as
+     * requests are queued on the "pre" ThreadPool without waiting for Buffers.
+     */
+    void SetRequestWork(std::function<void(Bindings&)> pre, std::function<void(Bindings&)> post);
+
+    /**
+     * @brief Run the benchmark for every combination of batch size and concurrency
+     */
+    ResultsList Sweep(const ModelsList& models, const std::vector<uint32_t>& batch_sizes,
+                      const std::vector<uint32_t>& concurrencies, double seconds = 5.0,
+                      double warmup = 0.5);
+
+    static std::string KeyName(InferBenchKey);
+    static std::string ToJSON(const Results&);
+    static std::string ToJSON(const ResultsList&);
 
   protected:
     InferenceManager& InferResources() { return *m_Resources; }
 
   private:
+    std::unique_ptr<Results> Measure(const ModelsList& models, uint32_t batch_size,
+                                     double seconds, uint32_t concurrency);
+
     std::shared_ptr<InferenceManager> m_Resources;
+    std::function<void(Bindings&)> m_PreWork;
+    std::function<void(Bindings&)> m_PostWork;
 };
 
 } // namespace TensorRT
@@ -28,6 +28,7 @@
 
 #include "tensorrt/laboratory/bindings.h"
 #include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/core/profiler.h"
 #include "tensorrt/laboratory/inference_manager.h"
 #include "tensorrt/laboratory/model.h"
 
@@ -36,7 +37,7 @@ namespace TensorRT {
 
 struct InferRunner : public AsyncComputeWrapper<void(std::shared_ptr<Bindings>&)>
 {
-    InferRunner(std::shared_ptr<Model> model, std::shared_ptr<InferenceManager> resources)
+    InferRunner(std::shared_ptr<BaseModel> model, std::shared_ptr<InferenceManager> resources)
         : m_Model{model}, m_Resources{resources}
     {
     }
@@ -55,63 +56,133 @@ struct InferRunner : public AsyncComputeWrapper<void(std::shared_ptr<Bindings>&)
     template<typename Post>
     auto Infer(PreFn pre, Post post)
     {
-        auto compute = Wrap(post);
+        auto compute = WrapReleasing(post);
         auto future = compute->Future();
         Enqueue(pre, compute);
         return future.share();
     }
 
+    /**
+     * @brief Run inference on Bindings sized for batch_size items rather than the max batch size
+     */
+    template<typename Post>
+    auto Infer(uint32_t batch_size, PreFn pre, Post post)
+    {
+        auto compute = WrapReleasing(post);
+        auto future = compute->Future();
+        Enqueue(batch_size, pre, compute);
+        return future.share();
+    }
+
     template<typename Post>
     auto Infer(std::shared_ptr<Bindings> bindings, Post post)
     {
-        auto compute = Wrap(post);
+        auto compute = WrapReleasing(post);
         auto future = compute->Future();
         Enqueue(bindings, compute);
         return future.share();
     }
 
   protected:
+    // Each stage and resource wait of a request is recorded as a Profiler span: queue:* spans
+    // cover the time a task waits for a worker, wait:* spans the time blocked on a resource Pool.
+    // Copies and compute are asynchronous; their spans cover issuing the work, while the sync
+    // span covers waiting for it to complete.
+    //
+    // The Bindings of a request hold the InferenceManager.  They are moved from stage to stage and
+    // released before the future is ready, so no worker holds the InferenceManager afterwards.
+
     template<typename T>
     void Enqueue(PreFn Pre, std::shared_ptr<AsyncCompute<T>> Post)
     {
-        Workers("pre").enqueue([this, Pre, Post]() mutable {
+        auto queued = Profiler::Now();
+        Workers("pre").enqueue([this, Pre, Post, queued]() mutable {
+            Profiler::Record("queue:pre", "queue", queued, Profiler::Now());
             auto bindings = InitializeBindings();
-            Pre(*bindings);
-            Enqueue(bindings, Post);
+            Preprocess(Pre, *bindings);
+            Enqueue(std::move(bindings), std::move(Post));
+        });
+    }
+
+    template<typename T>
+    void Enqueue(uint32_t batch_size, PreFn Pre, std::shared_ptr<AsyncCompute<T>> Post)
+    {
+        auto queued = Profiler::Now();
+        Workers("pre").enqueue([this, batch_size, Pre, Post, queued]() mutable {
+            Profiler::Record("queue:pre", "queue", queued, Profiler::Now());
+            auto bindings = InitializeBindings(batch_size);
+            Preprocess(Pre, *bindings);
+            Enqueue(std::move(bindings), std::move(Post));
         });
     }
 
     template<typename T>
     void Enqueue(std::shared_ptr<Bindings> bindings, std::shared_ptr<AsyncCompute<T>> Post)
     {
-        Workers("cuda").enqueue([this, bindings, Post]() mutable {
+        auto queued = Profiler::Now();
+        Workers("cuda").enqueue([this, bindings = std::move(bindings), Post, queued]() mutable {
+            Profiler::Record("queue:cuda", "queue", queued, Profiler::Now());
             DLOG(INFO) << "H2D";
-            bindings->CopyToDevice(bindings->InputBindings());
+            {
+                Profiler::Span span("copy:h2d", "copy");
+                bindings->CopyToDevice(bindings->InputBindings());
+            }
             DLOG(INFO) << "Compute";
             auto trt_ctx = Compute(bindings);
-            bindings->CopyFromDevice(bindings->OutputBindings());
-            Workers("post").enqueue([this, bindings, trt_ctx, Post]() mutable {
-                trt_ctx->Synchronize();
-                trt_ctx.reset();
-                DLOG(INFO) << "Sync TRT";
-                bindings->Synchronize();
-                DLOG(INFO) << "Sync D2H";
-                (*Post)(bindings);
+            {
+                Profiler::Span span("copy:d2h", "copy");
+                bindings->CopyFromDevice(bindings->OutputBindings());
+            }
+            auto posted = Profiler::Now();
+            Workers("post").enqueue([bindings = std::move(bindings), trt_ctx = std::move(trt_ctx),
+                                     Post = std::move(Post), posted]() mutable {
+                Profiler::Record("queue:post", "queue", posted, Profiler::Now());
+                {
+                    Profiler::Span span("sync", "compute");
+                    trt_ctx->Synchronize();
+                    trt_ctx.reset();
+                    DLOG(INFO) << "Sync TRT";
+                    bindings->Synchronize();
+                    DLOG(INFO) << "Sync D2H";
+                }
+                {
+                    Profiler::Span span("post", "stage");
+                    (*Post)(bindings);
+                }
                 bindings.reset();
                 DLOG(INFO) << "Execute Finished";
             });
         });
     }
 
+    void Preprocess(PreFn& Pre, Bindings& bindings)
+    {
+        Profiler::Span span("pre", "stage");
+        Pre(bindings);
+    }
+
     BindingsHandle InitializeBindings()
     {
-        auto buffers = m_Resources->GetBuffers();
+        Profiler::Span span("wait:buffers", "wait");
+        auto buffers = m_Resources->GetBuffers(m_Model);
         return buffers->CreateBindings(m_Model);
     }
 
+    BindingsHandle InitializeBindings(uint32_t batch_size)
+    {
+        Profiler::Span span("wait:buffers", "wait");
+        auto buffers = m_Resources->GetBuffers(m_Model);
+        return buffers->CreateBindings(m_Model, batch_size);
+    }
+
     auto Compute(BindingsHandle& bindings) -> std::shared_ptr<ExecutionContext>
     {
-        auto trt_ctx = m_Resources->GetExecutionContext(bindings->GetModel());
+        std::shared_ptr<ExecutionContext> trt_ctx;
+        {
+            Profiler::Span span("wait:execution_context", "wait");
+            trt_ctx = m_Resources->GetExecutionContext(bindings->GetModel());
+        }
+        Profiler::Span span("compute", "compute");
         trt_ctx->Infer(bindings);
         return trt_ctx;
     }
@@ -145,14 +216,14 @@ struct InferRunner : public AsyncComputeWrapper<void(std::shared_ptr<Bindings>&)
   public:
     const int MaxBatchSize() const { return m_Model->GetMaxBatchSize(); }
 
-    const Model& GetModel() const { return *m_Model; }
+    const BaseModel& GetModel() const { return *m_Model; }
 
-    const std::shared_ptr<Model> GetModelSmartPtr() const { return m_Model; }
+    const std::shared_ptr<BaseModel> GetModelSmartPtr() const { return m_Model; }
 
     InferenceManager& Resources() { return *m_Resources; }
 
   private:
-    std::shared_ptr<Model> m_Model;
+    std::shared_ptr<BaseModel> m_Model;
     std::shared_ptr<InferenceManager> m_Resources;
 };
 
@@ -29,6 +29,9 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 // #include <shared_mutex> /* C++17 - not found in g++ 5.4 */
 
 #include <NvInfer.h>
@@ -39,34 +42,79 @@
 #include "tensorrt/laboratory/core/resources.h"
 #include "tensorrt/laboratory/core/thread_pool.h"
 #include "tensorrt/laboratory/execution_context.h"
+#include "tensorrt/laboratory/execution_scheduler.h"
+#include "tensorrt/laboratory/memory_planner.h"
 #include "tensorrt/laboratory/model.h"
 #include "tensorrt/laboratory/runtime.h"
 
 namespace trtlab {
 namespace TensorRT {
 
+/**
+ * @brief How an InferenceManager allocates the Buffers of its Pools
+ *
+ * kFixed gives every Buffers object its own stacks, sized for the largest model of its Pool at
+ * the maximum batch size.  With kCyclic, the Buffers of a Pool share rings of rotating segments
+ * from which each request only takes the memory of its batch size.  segment_factor sets the size
+ * of a segment as a multiple of the largest request of the Pool and must be at least 1; segments
+ * is the number of segments per ring.  If segments is 0, the ring is sized to memory_fraction of
+ * the footprint of the fixed strategy, with at least 2 segments.
+ */
+struct BuffersPolicy
+{
+    enum class Strategy
+    {
+        kFixed,
+        kCyclic
+    };
+
+    Strategy strategy = Strategy::kFixed;
+    double segment_factor = 2.0;
+    uint32_t segments = 0;
+    double memory_fraction = 0.5;
+};
+
 class InferenceManager : public ::trtlab::Resources
 {
   public:
     InferenceManager(int max_executions, int max_buffers);
     virtual ~InferenceManager();
 
-    void RegisterModel(const std::string& name, std::shared_ptr<Model> model);
-    void RegisterModel(const std::string& name, std::shared_ptr<Model> model,
+    void RegisterModel(const std::string& name, std::shared_ptr<BaseModel> model);
+    void RegisterModel(const std::string& name, std::shared_ptr<BaseModel> model,
                        uint32_t max_concurrency);
+    void UnregisterModel(const std::string& name);
 
     // void RegisterModel(const std::string& name, const std::string& model_path, uint32_t
     // max_concurrency); void RegisterModel(const std::string& name, const std::string& model_path,
     // uint32_t max_concurrency);
 
+    void SetExclusiveGroup(const std::string& model_name, const std::string& group);
+    void SetBuffersPolicy(const BuffersPolicy&);
+    const BuffersPolicy& GetBuffersPolicy() const { return m_BuffersPolicy; }
     void AllocateResources();
 
     auto GetBuffers() -> std::shared_ptr<Buffers>;
-    auto GetModel(std::string model_name) -> std::shared_ptr<Model>;
-    auto GetExecutionContext(const Model* model) -> std::shared_ptr<ExecutionContext>;
-    auto GetExecutionContext(const std::shared_ptr<Model>& model)
+    auto GetBuffers(const BaseModel* model) -> std::shared_ptr<Buffers>;
+    auto GetBuffers(const std::shared_ptr<BaseModel>& model) -> std::shared_ptr<Buffers>;
+    auto GetBuffersPool(const BaseModel* model) const -> std::pair<size_t, uint32_t>;
+    auto GetModel(std::string model_name) -> std::shared_ptr<BaseModel>;
+    auto FindModel(const std::string& model_name) -> std::shared_ptr<BaseModel>;
+    auto GetExecutionContext(const BaseModel* model) -> std::shared_ptr<ExecutionContext>;
+    auto GetExecutionContext(const std::shared_ptr<BaseModel>& model)
         -> std::shared_ptr<ExecutionContext>;
 
+    void SetSchedulingPolicy(const std::string& model_name, const SchedulingPolicy&);
+    auto GetSchedulingStats(const std::string& model_name) const -> ExecutionScheduler::Stats;
+
+    const MemoryPlan& GetBuffersPlan() const { return m_BuffersPlan; }
+    const MemoryPlan& GetWorkspacePlan() const { return m_WorkspacePlan; }
+
+    /**
+     * @brief Host and device bytes allocated for the Buffers by AllocateResources
+     */
+    size_t BuffersFootprint() const { return m_BuffersFootprint; }
+
     auto AcquireThreadPool(const std::string&) -> ThreadPool&;
     void RegisterThreadPool(const std::string&, std::unique_ptr<ThreadPool> threads);
     bool HasThreadPool(const std::string&) const;
@@ -80,7 +128,7 @@ class InferenceManager : public ::trtlab::Resources
     int MaxExecConcurrency() const;
     int MaxCopyConcurrency() const;
 
-    void ForEachModel(std::function<void(const Model&)>);
+    void ForEachModel(std::function<void(const BaseModel&)>);
 
   private:
     int m_MaxExecutions;
@@ -89,15 +137,41 @@ class InferenceManager : public ::trtlab::Resources
     size_t m_DeviceStackSize;
     size_t m_ActivationsSize;
     Runtime* m_ActiveRuntime;
+    int m_HostModels;
+    int m_DeviceModels;
+    bool m_HostBuffers;
 
     std::map<std::string, std::unique_ptr<ThreadPool>> m_ThreadPools;
+
+    // guards the models and their per-model resources, which may change while serving
+    mutable std::mutex m_ModelsMutex;
     std::map<std::string, std::shared_ptr<Runtime>> m_Runtimes;
-    std::map<std::string, std::shared_ptr<Model>> m_Models;
-    std::map<const Model*, std::shared_ptr<Pool<::nvinfer1::IExecutionContext>>>
-        m_ModelExecutionContexts;
+    std::map<std::string, std::shared_ptr<BaseModel>> m_Models;
+    std::map<const BaseModel*, std::shared_ptr<Pool<IExecutor>>> m_ModelExecutionContexts;
 
-    std::shared_ptr<Pool<Buffers>> m_Buffers;
-    std::shared_ptr<Pool<ExecutionContext>> m_ExecutionContexts;
+    struct ModelMemory
+    {
+        size_t host;
+        size_t device;
+        size_t activations;
+        uint32_t concurrency;
+        std::string group;
+    };
+    std::map<std::string, ModelMemory> m_ModelMemory;
+
+    // One Pool per class of the MemoryPlans; models are mapped to the index of their Pool
+    MemoryPlan m_BuffersPlan;
+    MemoryPlan m_WorkspacePlan;
+    BuffersPolicy m_BuffersPolicy;
+    size_t m_BuffersFootprint;
+    std::vector<std::shared_ptr<Pool<Buffers>>> m_Buffers;
+    std::vector<std::shared_ptr<Pool<ExecutionContext>>> m_ExecutionContexts;
+    std::map<const BaseModel*, size_t> m_ModelBuffers;
+    std::map<const BaseModel*, size_t> m_ModelExecutionSlots;
+    std::shared_ptr<ExecutionScheduler> m_Scheduler;
+
+    auto PopBuffers(size_t pool) -> std::shared_ptr<Buffers>;
+    size_t PushCyclicBuffers(Pool<Buffers>&, uint32_t count, size_t host, size_t device);
 
     std::size_t Align(std::size_t size, std::size_t alignment)
     {
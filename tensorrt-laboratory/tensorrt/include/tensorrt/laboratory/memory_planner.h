@@ -0,0 +1,110 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Layout of a set of equally sized memory slots shared by one or more models
+ *
+ * slots are sorted from largest to smallest; assignment maps each model name to the index of the
+ * slots its requests are served from.
+ */
+struct MemoryPlan
+{
+    struct Slots
+    {
+        size_t bytes;
+        uint32_t count;
+        std::vector<std::string> models;
+    };
+
+    std::vector<Slots> slots;
+    std::map<std::string, size_t> assignment;
+    uint32_t max_slots = 0;
+
+    /**
+     * @brief Bytes allocated by the plan
+     */
+    size_t Footprint() const;
+
+    /**
+     * @brief Bytes allocated by max_slots slots each sized for the largest model
+     */
+    size_t UniformFootprint() const;
+
+    uint32_t SlotCount() const;
+};
+
+/**
+ * @brief Computes how many slots of which size to allocate for the registered models
+ *
+ * Every request of a model needs one slot of at least the model's size, e.g. an activation
+ * workspace or a Buffers stack.  Without a plan, max_slots slots are allocated, each sized for
+ * the largest model.  Models may be placed in an exclusive group: members of a group are never
+ * run at the same time, so a group needs as many slots as its most concurrent member, sized for
+ * its largest member.  Groups are then either given slots of their own or merged with groups of
+ * similar size; a merged class of slots never needs more than max_slots entries, because no more
+ * than max_slots requests are in flight.  The partition with the smallest total footprint is
+ * chosen; the uniform layout is one of the candidates, so the plan is never larger.
+ */
+class MemoryPlanner
+{
+  public:
+    MemoryPlanner(uint32_t max_slots);
+
+    /**
+     * @brief Add a model requiring bytes per slot and at most concurrency slots at a time
+     *
+     * concurrency 0 or larger than max_slots is treated as max_slots.  An empty group places the
+     * model in a group of its own.
+     */
+    void AddModel(const std::string& name, size_t bytes, uint32_t concurrency,
+                  const std::string& group = "");
+
+    MemoryPlan Compute() const;
+
+  private:
+    struct Requirement
+    {
+        size_t bytes;
+        uint32_t concurrency;
+        std::string group;
+    };
+
+    uint32_t m_MaxSlots;
+    std::map<std::string, Requirement> m_Models;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -37,13 +37,64 @@
 namespace trtlab {
 namespace TensorRT {
 
+class Bindings;
+
 /**
- * @brief Wrapper class for nvinfer1::ICudaEngine.
+ * @brief Backend-neutral handle used to launch the computation of a model.
  *
- * A Model object holds an instance of ICudaEngine and extracts some basic meta data
- * from the engine to simplify pushing the input/output bindings to a memory stack.
+ * An IExecutor is the per-model limited resource pooled by the InferenceManager.  The TensorRT
+ * backend wraps an IExecutionContext; host backends compute directly on the host addresses
+ * of the Bindings.
+ */
+class IExecutor
+{
+  public:
+    virtual ~IExecutor() {}
+
+    /**
+     * @brief Attach (or detach with nullptr) the activation scratch memory owned by the
+     * global ExecutionContext concurrency limiter.
+     */
+    virtual void SetWorkspace(void*) {}
+
+    /**
+     * @brief Launch the computation on the Bindings.  Device backends enqueue the work on
+     * Bindings::Stream(); host backends complete the work before returning.
+     */
+    virtual void Enqueue(Bindings&) = 0;
+};
+
+/**
+ * @brief Backend-neutral model interface.
+ *
+ * Everything the InferenceManager needs to size its resources and to create the pooled
+ * IExecutors for a model.
  */
-class BaseModel // TODO: inherit from IModel so we can have non-TensorRT models that conform
+class IModel
+{
+  public:
+    virtual ~IModel() {}
+
+    virtual int GetMaxBatchSize() const = 0;
+    virtual auto GetActivationsMemorySize() const -> size_t = 0;
+    virtual auto GetWeightsMemorySize() const -> size_t = 0;
+
+    /**
+     * @brief True if the model computes on host memory and needs no GPU resources.
+     */
+    virtual bool ExecutesOnHost() const = 0;
+
+    virtual auto CreateExecutor() const -> std::shared_ptr<IExecutor> = 0;
+};
+
+/**
+ * @brief Input/output tensor meta data shared by all model backends.
+ *
+ * A BaseModel holds the description of the input/output bindings used to push the tensors
+ * to a memory stack.  Backends that only describe a model, but cannot execute it, may rely on
+ * the default CreateExecutor which returns nullptr.
+ */
+class BaseModel : public IModel
 {
   public:
     enum BindingType
@@ -67,7 +118,11 @@ class BaseModel // TODO: inherit from IModel so we can have non-TensorRT models
 
     void SetName(const std::string& name) { m_Name = name; }
 
-    virtual int GetMaxBatchSize() const = 0;
+    virtual int GetMaxBatchSize() const override = 0;
+    auto GetActivationsMemorySize() const -> size_t override { return 0; }
+    auto GetWeightsMemorySize() const -> size_t override { return 0; }
+    bool ExecutesOnHost() const override { return false; }
+    auto CreateExecutor() const -> std::shared_ptr<IExecutor> override { return nullptr; }
 
     auto GetBindingMemorySize() const -> const size_t;
 
@@ -119,6 +174,12 @@ class BaseModel // TODO: inherit from IModel so we can have non-TensorRT models
     std::string m_Name;
 };
 
+/**
+ * @brief Wrapper class for nvinfer1::ICudaEngine.
+ *
+ * A Model object holds an instance of ICudaEngine and extracts some basic meta data
+ * from the engine to simplify pushing the input/output bindings to a memory stack.
+ */
 class Model final : public BaseModel
 {
   public:
@@ -140,12 +201,16 @@ class Model final : public BaseModel
     void AddWeights(void*, size_t); // TODO: Move to protected/private
     void PrefetchWeights(cudaStream_t) const;
     auto CreateExecutionContext() const -> std::shared_ptr<::nvinfer1::IExecutionContext>;
+    auto CreateExecutor() const -> std::shared_ptr<IExecutor> final override;
 
     int GetMaxBatchSize() const final override { return m_Engine->getMaxBatchSize(); }
 
-    auto GetActivationsMemorySize() const { return m_Engine->getDeviceMemorySize(); }
+    auto GetActivationsMemorySize() const -> size_t final override
+    {
+        return m_Engine->getDeviceMemorySize();
+    }
 
-    auto GetWeightsMemorySize() const -> const size_t;
+    auto GetWeightsMemorySize() const -> size_t final override;
 
   protected:
     TensorBindingInfo ConfigureBinding(uint32_t);
@@ -0,0 +1,90 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "tensorrt/laboratory/core/thread_pool.h"
+#include "tensorrt/laboratory/core/utils.h"
+#include "tensorrt/laboratory/model.h"
+#include "tensorrt/laboratory/runtime.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Deserializes a set of engine files concurrently on a ThreadPool
+ *
+ * Each file is memory mapped and handed to a DeserializeFn.  At most max_mapped_bytes of engine
+ * files are mapped at any time; a file larger than the limit is loaded while no other file is
+ * mapped.  Files are started in the order given, so the limit never starves a large file.
+ *
+ * The DeserializeFn is called concurrently from the worker threads.
+ */
+class ModelLoader
+{
+  public:
+    using DeserializeFn = std::function<std::shared_ptr<BaseModel>(const void*, size_t)>;
+    using FileMap = std::map<std::string, std::string>;
+    using ModelMap = std::map<std::string, std::shared_ptr<BaseModel>>;
+
+    ModelLoader(int threads, size_t max_mapped_bytes);
+    virtual ~ModelLoader();
+
+    DELETE_COPYABILITY(ModelLoader);
+    DELETE_MOVEABILITY(ModelLoader);
+
+    /**
+     * @brief Load the files, given as model name to path; rethrows the first failure once all
+     * files were attempted
+     */
+    ModelMap Load(const FileMap& files, DeserializeFn deserialize);
+    ModelMap Load(const FileMap& files, std::shared_ptr<Runtime> runtime);
+
+    /**
+     * @brief Files of a directory with the given extension, keyed by file name without extension
+     */
+    static FileMap Directory(const std::string& path, const std::string& extension = ".engine");
+
+  private:
+    void AcquireBytes(size_t bytes);
+    void ReleaseBytes(size_t bytes);
+
+    const size_t m_MaxMappedBytes;
+    size_t m_MappedBytes;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    ThreadPool m_Workers;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,144 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "tensorrt/laboratory/core/utils.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Loads models on first use and evicts idle models to stay within a memory budget
+ *
+ * Models are added with a Loader, e.g. a lambda calling Runtime::DeserializeEngine, and the
+ * number of bytes the model keeps resident.  Acquire loads the model if necessary and returns a
+ * handle; while any handle of a model is alive, the model is in use and can not be evicted.  To
+ * make room for a model, idle models that are not pinned are evicted in least-recently-used
+ * order; if the models in use do not leave enough room, Acquire blocks until they are released.
+ * Acquire throws if the model does not fit next to the pinned models.  Handles do not keep the
+ * registry alive; a handle released after the registry only releases its model.
+ *
+ * If an InferenceManager is given, loaded models are registered with it and unregistered when
+ * evicted, so the handles can be used with InferRunner directly.  The InferenceManager must have
+ * allocated resources that fit the largest model, e.g. by registering the largest model, calling
+ * AllocateResources and unregistering it again.
+ */
+class ModelRegistry : public std::enable_shared_from_this<ModelRegistry>
+{
+  public:
+    using Loader = std::function<std::shared_ptr<BaseModel>()>;
+    using ModelHandle = std::shared_ptr<BaseModel>;
+
+    static std::shared_ptr<ModelRegistry>
+        Create(size_t budget, std::shared_ptr<InferenceManager> resources = nullptr);
+    virtual ~ModelRegistry();
+
+    DELETE_COPYABILITY(ModelRegistry);
+    DELETE_MOVEABILITY(ModelRegistry);
+
+    /**
+     * @brief Add a model that is loaded on first use
+     *
+     * bytes is the memory the model keeps resident once loaded; 0 measures the weights of the
+     * model after loading it, in which case the budget is enforced after the load.
+     */
+    void Add(const std::string& name, Loader loader, size_t bytes = 0,
+             uint32_t max_concurrency = 0);
+
+    /**
+     * @brief Pinned models are never evicted once loaded
+     */
+    void Pin(const std::string& name, bool pinned = true);
+
+    /**
+     * @brief Get a handle to a model, loading it if necessary (May Block!)
+     *
+     * Blocks while another thread loads the same model or while models in use occupy the budget.
+     */
+    ModelHandle Acquire(const std::string& name);
+
+    bool IsLoaded(const std::string& name) const;
+    size_t Budget() const { return m_Budget; }
+    size_t Resident() const;
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t loads;
+        uint64_t evictions;
+    };
+    Stats GetStats() const;
+
+  protected:
+    ModelRegistry(size_t budget, std::shared_ptr<InferenceManager> resources);
+
+  private:
+    struct Entry
+    {
+        Loader loader;
+        size_t bytes;
+        uint32_t max_concurrency;
+        std::shared_ptr<BaseModel> model;
+        uint32_t in_flight;
+        bool pinned;
+        bool loading;
+        std::list<std::string>::iterator lru;
+    };
+
+    Entry& GetEntry(const std::string& name);
+    ModelHandle MakeHandle(const std::string& name, Entry&);
+    void Release(const std::string& name);
+    void Touch(Entry&);
+    void MakeRoom(size_t bytes, const std::string& except, std::unique_lock<std::mutex>& lock);
+    void Evict(const std::string& name, Entry&);
+
+    const size_t m_Budget;
+    size_t m_Resident;
+    Stats m_Stats;
+    std::shared_ptr<InferenceManager> m_Resources;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::map<std::string, Entry> m_Entries;
+
+    // loaded models; most recently used first
+    std::list<std::string> m_LRU;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,197 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensorrt/laboratory/core/utils.h"
+#include "tensorrt/laboratory/dynamic_batcher.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/model.h"
+#include "tensorrt/laboratory/runtime.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Settings of a model in a ModelRepository
+ *
+ * Mirrors the fields of nvidia.inferenceserver.ModelConfig (examples/11_Protos/inference/
+ * model_config.proto) used by the repository.  Parse reads the protobuf text format of a
+ * config.pbtxt; other fields of model_config.proto are ignored, and like protobuf's TextFormat,
+ * Parse throws on fields the proto does not declare.
+ */
+struct ModelConfig
+{
+    struct Tensor
+    {
+        std::string name;
+        std::string data_type;
+        std::vector<int64_t> dims;
+    };
+
+    enum class VersionPolicy
+    {
+        kLatest,
+        kAll,
+        kSpecific
+    };
+
+    std::string name;
+    std::string platform;
+    int max_batch_size = 0;
+    std::vector<Tensor> inputs;
+    std::vector<Tensor> outputs;
+    // sum of the counts of the instance groups; 0 uses the InferenceManager's max executions
+    uint32_t instance_count = 0;
+    std::string default_model_filename;
+
+    VersionPolicy version_policy = VersionPolicy::kLatest;
+    uint32_t num_versions = 1;
+    std::vector<int64_t> versions;
+
+    bool dynamic_batching = false;
+    DynamicBatchingPolicy batching;
+
+    static ModelConfig Parse(const std::string& text);
+    static ModelConfig ParseFile(const std::string& path);
+
+    /**
+     * @brief Throws if the inputs, outputs or max_batch_size do not match the model's bindings
+     */
+    void Validate(const BaseModel& model) const;
+};
+
+/**
+ * @brief Serves the models of a directory laid out like a TensorRT Inference Server model store
+ *
+ *     <path>/<model>/config.pbtxt
+ *     <path>/<model>/<version>/model.plan
+ *
+ * Poll scans the directory and loads the versions selected by each model's version policy that
+ * are not yet loaded, and unloads versions that were removed or are no longer selected.  Each
+ * version is validated against its config and registered with the InferenceManager as
+ * "<model>/<version>" with the config's instance count as its max concurrency.  Models and
+ * versions that fail to load are logged and retried once their files change.  Changes to the
+ * config.pbtxt of a loaded model take effect for the versions loaded after the change.
+ *
+ * An unloaded version stays registered until its in-flight requests and the models and batchers
+ * returned by GetModel and GetBatcher are released; its batcher is flushed when the last of them
+ * is released.  A removed version that is added back loads once its previous instance is gone.
+ * Destroying the repository unloads its versions the same way.
+ *
+ * Watch polls on a background thread.  Versions added after AllocateResources must fit the
+ * allocated Buffers, see InferenceManager::RegisterModel.
+ */
+class ModelRepository
+{
+  public:
+    using ModelFactory = std::function<std::shared_ptr<BaseModel>(const std::string& path)>;
+    static constexpr int64_t kLatest = -1;
+
+    ModelRepository(const std::string& path, std::shared_ptr<InferenceManager> resources,
+                    ModelFactory factory);
+    ModelRepository(const std::string& path, std::shared_ptr<InferenceManager> resources,
+                    std::shared_ptr<Runtime> runtime);
+    virtual ~ModelRepository();
+
+    DELETE_COPYABILITY(ModelRepository);
+    DELETE_MOVEABILITY(ModelRepository);
+
+    void Poll();
+    void Watch(std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    void StopWatching();
+
+    std::vector<std::string> Models() const;
+    std::vector<int64_t> Versions(const std::string& model) const;
+    ModelConfig GetConfig(const std::string& model) const;
+    std::shared_ptr<BaseModel> GetModel(const std::string& model, int64_t version = kLatest) const;
+
+    /**
+     * @brief DynamicBatcher using the config's batching settings; created on first use
+     *
+     * Returns nullptr if the config does not enable dynamic_batching.  Resources must be
+     * allocated.
+     */
+    std::shared_ptr<DynamicBatcher> GetBatcher(const std::string& model,
+                                               int64_t version = kLatest);
+
+    static std::string RegisteredName(const std::string& model, int64_t version);
+
+  private:
+    struct Version
+    {
+        ModelConfig config;
+        // aliases the registration of the version, which is unregistered when it is released
+        std::shared_ptr<BaseModel> model;
+        std::shared_ptr<DynamicBatcher> batcher;
+    };
+
+    // config of the last scan and the loaded versions
+    struct Entry
+    {
+        ModelConfig config;
+        std::map<int64_t, Version> versions;
+    };
+
+    void Load(const std::string& model, const ModelConfig& config, int64_t version,
+              const std::string& path);
+    void Unload(const std::string& model, int64_t version);
+    Version& GetVersion(const std::string& model, int64_t version);
+    const Version& GetVersion(const std::string& model, int64_t version) const;
+    bool Failed(const std::string& path, int64_t mtime);
+    bool Unloading(const std::string& name);
+
+    const std::string m_Path;
+    std::shared_ptr<InferenceManager> m_Resources;
+    ModelFactory m_Factory;
+
+    mutable std::mutex m_Mutex;
+    std::map<std::string, Entry> m_Models;
+    // files that failed to load, with their modification time (ns) at the failure
+    std::map<std::string, int64_t> m_Failures;
+    // unloaded versions by registered name; they are registered until their models are released
+    std::map<std::string, std::weak_ptr<BaseModel>> m_Unloaded;
+
+    std::mutex m_PollMutex;
+    std::thread m_Watcher;
+    std::mutex m_WatchMutex;
+    std::condition_variable m_WatchCondition;
+    bool m_Watching;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
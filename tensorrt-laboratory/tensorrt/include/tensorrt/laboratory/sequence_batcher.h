@@ -0,0 +1,204 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensorrt/laboratory/bindings.h"
+#include "tensorrt/laboratory/core/async_compute.h"
+#include "tensorrt/laboratory/dynamic_batcher.h"
+#include "tensorrt/laboratory/infer_runner.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/model.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+/**
+ * @brief Limits and control inputs of a SequenceBatcher
+ *
+ * max_sequences is the number of slots, i.e. sequences that are served concurrently; 0 or values
+ * larger than the model's GetMaxBatchSize() use the model's maximum.  A step is dispatched as soon
+ * as every active sequence has a queued request, or max_queue_delay after the oldest queued
+ * request.  Sequences without a request for idle_timeout are ended and their slot is reclaimed.
+ *
+ * The control inputs are written for every batch item of a step when the model has an input
+ * binding of that name: start is 1 for the first request of a sequence, end for the last one,
+ * ready for slots with a request in this step, and correlation_id holds the correlation id of the
+ * slot.  Control inputs may be of type kFLOAT, kINT32 or kINT8.
+ */
+struct SequenceBatchingPolicy
+{
+    uint32_t max_sequences = 0;
+    std::chrono::microseconds max_queue_delay = std::chrono::microseconds(1000);
+    std::chrono::microseconds idle_timeout = std::chrono::microseconds(1000000);
+
+    std::string start_input = "START";
+    std::string end_input = "END";
+    std::string ready_input = "READY";
+    std::string correlation_id_input = "CORRID";
+};
+
+/**
+ * @brief Server-side batcher for stateful models serving sequences of requests
+ *
+ * Each request belongs to the sequence of its correlation id.  A sequence starts with a request
+ * flagged start, is assigned a slot while one is free (or waits in FIFO order for one) and keeps
+ * that slot until a request flagged end or its idle timeout.  The slot is the batch item of the
+ * sequence in every step, so a model may keep the state of a sequence per batch item.  Each step
+ * batches the next request of every sequence that has one; steps are executed one at a time, so
+ * the requests of a sequence are computed in order.
+ *
+ * Infer throws std::runtime_error for a request that does not continue a sequence: a request
+ * without start for an unknown or ended correlation id, or a start for a sequence that is still
+ * active.  A correlation id can be reused by a start queued after the end of its sequence.
+ *
+ * The destructor executes the requests queued by sequences holding a slot and waits on the step in
+ * flight; requests of sequences waiting for a slot are dropped.
+ */
+class SequenceBatcher
+{
+  public:
+    using PreFn = std::function<void(BatchItem&)>;
+
+    enum Flags : uint32_t
+    {
+        kNone = 0,
+        kStart = 1,
+        kEnd = 2
+    };
+
+    SequenceBatcher(std::shared_ptr<BaseModel>, std::shared_ptr<InferenceManager>,
+                    SequenceBatchingPolicy policy = SequenceBatchingPolicy());
+    virtual ~SequenceBatcher();
+
+    DELETE_COPYABILITY(SequenceBatcher);
+    DELETE_MOVEABILITY(SequenceBatcher);
+
+    template<typename Post>
+    auto Infer(uint64_t correlation_id, uint32_t flags, PreFn pre, Post post)
+    {
+        auto compute = AsyncComputeWrapper<void(BatchItem&)>::Wrap(post);
+        auto future = compute->Future();
+        Enqueue(correlation_id, flags, std::move(pre),
+                [compute](BatchItem& item) mutable { (*compute)(item); });
+        return future.share();
+    }
+
+    struct Stats
+    {
+        uint64_t requests;
+        uint64_t steps;
+        uint64_t sequences_started;
+        uint64_t sequences_ended;
+        uint64_t sequences_timed_out;
+        uint32_t active_sequences;
+        uint32_t waiting_sequences;
+    };
+
+    Stats GetStats() const;
+    uint32_t MaxSequences() const { return m_MaxSequences; }
+
+    /**
+     * @brief Slot held by the sequence of correlation_id; -1 if it is not assigned a slot
+     */
+    int Slot(uint64_t correlation_id) const;
+
+  private:
+    struct Request
+    {
+        uint32_t flags;
+        PreFn pre;
+        std::function<void(BatchItem&)> post;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct Sequence
+    {
+        int slot;
+        std::deque<Request> queue;
+        std::chrono::steady_clock::time_point last_active;
+        bool ending;
+    };
+
+    struct StepItem
+    {
+        uint64_t correlation_id;
+        uint32_t slot;
+        Request request;
+    };
+
+    void Enqueue(uint64_t correlation_id, uint32_t flags, PreFn pre,
+                 std::function<void(BatchItem&)> post);
+    void BatchingLoop();
+    void AssignSlots();
+    void ReleaseSlot(uint64_t correlation_id);
+    auto ReclaimIdle(std::chrono::steady_clock::time_point now)
+        -> std::chrono::steady_clock::time_point;
+    bool AllActiveQueued() const;
+    bool AnyQueued() const;
+    void Dispatch(std::vector<StepItem>&& items);
+    void WriteControl(Bindings&, int binding_id, uint32_t slot, int64_t value) const;
+
+    const std::shared_ptr<BaseModel> m_Model;
+    const std::shared_ptr<InferenceManager> m_Resources;
+    SequenceBatchingPolicy m_Policy;
+    uint32_t m_MaxSequences;
+
+    // binding ids of the control inputs; -1 if the model does not have them
+    int m_StartInput;
+    int m_EndInput;
+    int m_ReadyInput;
+    int m_CorrelationIdInput;
+
+    InferRunner m_Runner;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::map<uint64_t, Sequence> m_Sequences;
+    std::deque<uint64_t> m_Waiting;
+    std::vector<uint64_t> m_Slots;
+    std::vector<bool> m_SlotUsed;
+    bool m_InFlight;
+    bool m_Shutdown;
+    Stats m_Stats;
+
+    std::thread m_Thread;
+};
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,239 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/auto_tuner.h"
+#include "tensorrt/laboratory/core/thread_pool.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+namespace TensorRT {
+
+namespace {
+
+uint32_t Threads(const AutoTuner::Configuration& config)
+{
+    return config.pre_threads + config.cuda_threads + config.post_threads;
+}
+
+} // namespace
+
+AutoTuner::AutoTuner(ModelFactory factory, TuningSpace space, TuningOptions options)
+    : m_ModelFactory(factory), m_Space(space), m_Options(options)
+{
+    if(!m_ModelFactory)
+    {
+        throw std::runtime_error("AutoTuner requires a model factory");
+    }
+    if(m_Space.executions.empty() || m_Space.buffers.empty() || m_Space.pre_threads.empty() ||
+       m_Space.post_threads.empty())
+    {
+        throw std::runtime_error("AutoTuner requires at least one value per dimension");
+    }
+    for(auto executions : m_Space.executions)
+    {
+        if(executions < 1)
+        {
+            throw std::runtime_error("AutoTuner executions must be at least 1");
+        }
+    }
+    for(auto buffers : m_Space.buffers)
+    {
+        if(buffers < 0)
+        {
+            throw std::runtime_error("AutoTuner buffers must not be negative");
+        }
+    }
+    if(std::count(m_Space.pre_threads.begin(), m_Space.pre_threads.end(), 0) ||
+       std::count(m_Space.post_threads.begin(), m_Space.post_threads.end(), 0))
+    {
+        throw std::runtime_error("AutoTuner thread counts must be at least 1");
+    }
+    if(!m_Options.concurrency)
+    {
+        throw std::runtime_error("AutoTuner requires a concurrency limit");
+    }
+}
+
+AutoTuner::~AutoTuner() {}
+
+void AutoTuner::SetRequestWork(std::function<void(Bindings&)> pre,
+                               std::function<void(Bindings&)> post)
+{
+    m_PreWork = pre;
+    m_PostWork = post;
+}
+
+const AutoTuner::Trial* AutoTuner::Run()
+{
+    auto max_batch_size = static_cast<uint32_t>(m_ModelFactory()->GetMaxBatchSize());
+    auto batch_sizes = m_Space.batch_sizes;
+    if(batch_sizes.empty())
+    {
+        for(uint32_t batch_size = 1; batch_size <= max_batch_size; batch_size *= 2)
+        {
+            batch_sizes.push_back(batch_size);
+        }
+    }
+    std::sort(batch_sizes.begin(), batch_sizes.end());
+    batch_sizes.erase(std::remove_if(batch_sizes.begin(), batch_sizes.end(),
+                                     [max_batch_size](uint32_t batch_size) {
+                                         return !batch_size || batch_size > max_batch_size;
+                                     }),
+                      batch_sizes.end());
+    batch_sizes.erase(std::unique(batch_sizes.begin(), batch_sizes.end()), batch_sizes.end());
+    if(batch_sizes.empty())
+    {
+        throw std::runtime_error("AutoTuner has no batch size within the model's max batch size");
+    }
+
+    m_Trials.clear();
+    for(auto executions : m_Space.executions)
+    {
+        for(auto buffers : m_Space.buffers)
+        {
+            for(auto pre_threads : m_Space.pre_threads)
+            {
+                for(auto post_threads : m_Space.post_threads)
+                {
+                    for(auto batch_size : batch_sizes)
+                    {
+                        Configuration config;
+                        config.max_executions = executions;
+                        config.max_buffers = buffers ? buffers : 2 * executions;
+                        config.batch_size = batch_size;
+                        config.pre_threads = pre_threads;
+                        config.post_threads = post_threads;
+                        config.cuda_threads = executions;
+                        m_Trials.push_back(Measure(config));
+                        if(!m_Trials.back().meets_slo)
+                        {
+                            // larger batches only add latency
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    auto best = Best();
+    if(best)
+    {
+        LOG(INFO) << "AutoTuner best of " << m_Trials.size() << " trials: " << ToJSON(*best);
+    }
+    else
+    {
+        LOG(WARNING) << "AutoTuner: none of " << m_Trials.size() << " trials meets the "
+                     << InferBench::KeyName(m_Options.latency_percentile) << " SLO of "
+                     << m_Options.latency_slo << " seconds";
+    }
+    return best;
+}
+
+auto AutoTuner::Measure(const Configuration& config) -> Trial
+{
+    auto resources =
+        std::make_shared<InferenceManager>(config.max_executions, config.max_buffers);
+    resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(config.pre_threads));
+    resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(config.cuda_threads));
+    resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(config.post_threads));
+    auto model = m_ModelFactory();
+    resources->RegisterModel("model", model);
+    resources->AllocateResources();
+
+    Trial trial;
+    trial.config = config;
+    {
+        InferBench bench(resources);
+        bench.SetRequestWork(m_PreWork, m_PostWork);
+        trial.results = *bench.Run({model}, config.batch_size, m_Options.seconds,
+                                   m_Options.warmup, m_Options.concurrency);
+    }
+    trial.memory = resources->BuffersFootprint() + resources->GetWorkspacePlan().Footprint();
+    trial.meets_slo = trial.results[m_Options.latency_percentile] <= m_Options.latency_slo;
+    DLOG(INFO) << "AutoTuner trial: " << ToJSON(trial);
+    return trial;
+}
+
+auto AutoTuner::Best() const -> const Trial*
+{
+    const Trial* fastest = nullptr;
+    for(const auto& trial : m_Trials)
+    {
+        if(trial.meets_slo && (!fastest || trial.results.at(kInferencesPerSecond) >
+                                               fastest->results.at(kInferencesPerSecond)))
+        {
+            fastest = &trial;
+        }
+    }
+    if(!fastest)
+    {
+        return nullptr;
+    }
+
+    auto threshold =
+        (1.0 - m_Options.throughput_tolerance) * fastest->results.at(kInferencesPerSecond);
+    const Trial* best = nullptr;
+    for(const auto& trial : m_Trials)
+    {
+        if(!trial.meets_slo || trial.results.at(kInferencesPerSecond) < threshold)
+        {
+            continue;
+        }
+        auto key = [](const Trial& t) {
+            return std::make_tuple(t.memory, Threads(t.config),
+                                   -t.results.at(kInferencesPerSecond));
+        };
+        if(!best || key(trial) < key(*best))
+        {
+            best = &trial;
+        }
+    }
+    return best;
+}
+
+std::string AutoTuner::ToJSON(const Trial& trial)
+{
+    const auto& config = trial.config;
+    std::ostringstream os;
+    os << "{\"max_executions\": " << config.max_executions
+       << ", \"max_buffers\": " << config.max_buffers << ", \"batch_size\": " << config.batch_size
+       << ", \"pre_threads\": " << config.pre_threads
+       << ", \"cuda_threads\": " << config.cuda_threads
+       << ", \"post_threads\": " << config.post_threads << ", \"memory\": " << trial.memory
+       << ", \"meets_slo\": " << (trial.meets_slo ? "true" : "false")
+       << ", \"results\": " << InferBench::ToJSON(trial.results) << "}";
+    return os.str();
+}
+
+} // namespace TensorRT
+} // namespace trtlab
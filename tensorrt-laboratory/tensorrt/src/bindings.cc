@@ -26,6 +26,8 @@
  */
 #include "tensorrt/laboratory/bindings.h"
 
+#include <cstring>
+
 #include <glog/logging.h>
 
 #include "tensorrt/laboratory/core/memory/descriptor.h"
@@ -50,9 +52,11 @@ class RawHostMemoryDescriptor final : public Descriptor<HostMemory>
 namespace trtlab {
 namespace TensorRT {
 
-Bindings::Bindings(const std::shared_ptr<Model> model, const std::shared_ptr<Buffers> buffers)
-    : m_Model(model), m_Buffers(buffers), m_BatchSize(0)
+Bindings::Bindings(const std::shared_ptr<BaseModel> model, const std::shared_ptr<Buffers> buffers,
+                   uint32_t allocated_batch_size)
+    : m_Model(model), m_Buffers(buffers), m_BatchSize(0), m_AllocatedBatchSize(allocated_batch_size)
 {
+    CHECK_LE(m_AllocatedBatchSize, m_Model->GetMaxBatchSize());
     auto count = model->GetBindingsCount();
     m_HostAddresses.resize(count);
     m_DeviceAddresses.resize(count);
@@ -99,6 +103,15 @@ void Bindings::SetDeviceAddress(int binding_id, DescriptorHandle<DeviceMemory> m
     m_DeviceDescriptors[binding_id] = std::move(mdesc);
 }
 
+void Bindings::SetDeviceAddressToHost(int binding_id)
+{
+    CHECK_LT(binding_id, m_DeviceAddresses.size());
+    CHECK(m_HostAddresses[binding_id]) << "Host address for binding " << binding_id
+                                       << " must be set before it can be aliased";
+    m_DeviceDescriptors.erase(binding_id);
+    m_DeviceAddresses[binding_id] = m_HostAddresses[binding_id];
+}
+
 void* Bindings::HostAddress(uint32_t binding_id)
 {
     CHECK_LT(binding_id, m_HostAddresses.size());
@@ -131,6 +144,17 @@ void Bindings::CopyToDevice(const std::vector<uint32_t>& ids)
 void Bindings::CopyToDevice(uint32_t device_binding_id, void* src, size_t bytes)
 {
     auto dst = DeviceAddress(device_binding_id);
+    CHECK_LE(bytes, BindingCapacity(device_binding_id));
+    if(dst == src)
+    {
+        return;
+    }
+    if(!Stream())
+    {
+        // host-resident Buffers; the host address was replaced after it was aliased
+        std::memcpy(dst, src, bytes);
+        return;
+    }
     DLOG(INFO) << "CopyToDevice binding_id: " << device_binding_id << "; size: " << bytes;
     CHECK_EQ(cudaMemcpyAsync(dst, src, bytes, cudaMemcpyHostToDevice, Stream()), CUDA_SUCCESS)
         << "CopyToDevice for Binding " << device_binding_id << " failed - (dst, src, bytes) = "
@@ -155,6 +179,17 @@ void Bindings::CopyFromDevice(const std::vector<uint32_t>& ids)
 void Bindings::CopyFromDevice(uint32_t device_binding_id, void* dst, size_t bytes)
 {
     auto src = DeviceAddress(device_binding_id);
+    CHECK_LE(bytes, BindingCapacity(device_binding_id));
+    if(dst == src)
+    {
+        return;
+    }
+    if(!Stream())
+    {
+        // host-resident Buffers; the host address was replaced after it was aliased
+        std::memcpy(dst, src, bytes);
+        return;
+    }
     DLOG(INFO) << "CopyFromDevice binding_id: " << device_binding_id << "; size: " << bytes;
     CHECK_EQ(cudaMemcpyAsync(dst, src, bytes, cudaMemcpyDeviceToHost, Stream()), CUDA_SUCCESS)
         << "CopyFromDevice for Binding " << device_binding_id << " failed - (dst, src, bytes) = "
@@ -163,14 +198,20 @@ void Bindings::CopyFromDevice(uint32_t device_binding_id, void* dst, size_t byte
 
 void Bindings::SetBatchSize(uint32_t batch_size)
 {
-    CHECK_LE(batch_size, m_Model->GetMaxBatchSize());
+    CHECK_LE(batch_size, m_AllocatedBatchSize)
+        << "Bindings were allocated for a batch size of " << m_AllocatedBatchSize;
     m_BatchSize = batch_size;
 }
 
 size_t Bindings::BindingSize(uint32_t binding_id) const
 {
     return m_Model->GetBinding(binding_id).bytesPerBatchItem *
-           (m_BatchSize ? m_BatchSize : m_Model->GetMaxBatchSize());
+           (m_BatchSize ? m_BatchSize : m_AllocatedBatchSize);
+}
+
+size_t Bindings::BindingCapacity(uint32_t binding_id) const
+{
+    return m_Model->GetBinding(binding_id).bytesPerBatchItem * m_AllocatedBatchSize;
 }
 
 } // namespace TensorRT
@@ -36,35 +36,93 @@ using trtlab::CudaDeviceMemory;
 using trtlab::CudaPinnedHostMemory;
 using trtlab::MemoryStack;
 
+namespace {
+// Range of a larger allocation; keeps the allocation alive while the binding uses it
+template<typename MemoryType>
+class SubDescriptor final : public trtlab::Descriptor<MemoryType>
+{
+  public:
+    SubDescriptor(std::shared_ptr<MemoryType> allocation, size_t offset, size_t size)
+        : trtlab::Descriptor<MemoryType>(static_cast<char*>(allocation->Data()) + offset, size,
+                                         "BuffersSubDesc"),
+          m_Allocation(std::move(allocation))
+    {
+    }
+    ~SubDescriptor() final override {}
+
+  private:
+    std::shared_ptr<MemoryType> m_Allocation;
+};
+} // namespace
+
 namespace trtlab {
 namespace TensorRT {
 
-Buffers::Buffers()
+Buffers::Buffers() : Buffers(true) {}
+
+Buffers::Buffers(bool create_stream) : m_Stream(nullptr)
 {
-    // CHECK(cudaStreamCreateWithFlags(&m_Stream, cudaStreamNonBlocking) == cudaSuccess); <-- breaks
-    CHECK_EQ(cudaStreamCreate(&m_Stream), cudaSuccess);
+    if(create_stream)
+    {
+        // CHECK(cudaStreamCreateWithFlags(&m_Stream, cudaStreamNonBlocking) == cudaSuccess);
+        // <-- breaks
+        CHECK_EQ(cudaStreamCreate(&m_Stream), cudaSuccess);
+    }
 }
 
 Buffers::~Buffers()
 {
     DLOG(INFO) << "Buffers Deconstructor";
-    CHECK_EQ(cudaStreamSynchronize(m_Stream), CUDA_SUCCESS);
-    CHECK_EQ(cudaStreamDestroy(m_Stream), CUDA_SUCCESS);
+    if(m_Stream)
+    {
+        CHECK_EQ(cudaStreamSynchronize(m_Stream), CUDA_SUCCESS);
+        CHECK_EQ(cudaStreamDestroy(m_Stream), CUDA_SUCCESS);
+    }
+}
+
+auto Buffers::CreateBindings(const std::shared_ptr<BaseModel>& model) -> std::shared_ptr<Bindings>
+{
+    return MakeBindings(model, model->GetMaxBatchSize());
 }
 
-auto Buffers::CreateBindings(const std::shared_ptr<Model>& model) -> std::shared_ptr<Bindings>
+auto Buffers::CreateBindings(const std::shared_ptr<BaseModel>& model, uint32_t batch_size)
+    -> std::shared_ptr<Bindings>
 {
-    auto bindings = std::shared_ptr<Bindings>(new Bindings(model, shared_from_this()));
+    CHECK_GT(batch_size, 0);
+    auto bindings = MakeBindings(model, batch_size);
+    bindings->SetBatchSize(batch_size);
+    return bindings;
+}
+
+auto Buffers::MakeBindings(const std::shared_ptr<BaseModel>& model, uint32_t batch_size)
+    -> std::shared_ptr<Bindings>
+{
+    auto handle = m_PoolHandle.lock();
+    if(!handle)
+    {
+        handle = shared_from_this();
+    }
+    auto bindings = std::shared_ptr<Bindings>(new Bindings(model, handle, batch_size));
     ConfigureBindings(model, bindings);
     return bindings;
 }
 
-void Buffers::ConfigureBindings(const std::shared_ptr<Model>& model,
+bool Buffers::Fits(const BaseModel& model, uint32_t batch_size) const
+{
+    std::vector<size_t> sizes;
+    for(uint32_t i = 0; i < model.GetBindingsCount(); i++)
+    {
+        sizes.push_back(model.GetBinding(i).bytesPerBatchItem * batch_size);
+    }
+    return StacksFit(sizes);
+}
+
+void Buffers::ConfigureBindings(const std::shared_ptr<BaseModel>& model,
                                 std::shared_ptr<Bindings> bindings)
 {
     for(uint32_t i = 0; i < model->GetBindingsCount(); i++)
     {
-        auto binding_size = model->GetBinding(i).bytesPerBatchItem * model->GetMaxBatchSize();
+        auto binding_size = bindings->BindingCapacity(i);
         DLOG(INFO) << "Configuring Binding " << i << ": pushing " << binding_size
                    << " to host/device stacks";
         bindings->SetHostAddress(i, AllocateHost(binding_size));
@@ -72,8 +130,74 @@ void Buffers::ConfigureBindings(const std::shared_ptr<Model>& model,
     }
 }
 
+void Buffers::ConfigureHostBindings(const std::shared_ptr<BaseModel>& model,
+                                    std::shared_ptr<Bindings> bindings)
+{
+    for(uint32_t i = 0; i < model->GetBindingsCount(); i++)
+    {
+        auto binding_size = bindings->BindingCapacity(i);
+        DLOG(INFO) << "Configuring Binding " << i << ": pushing " << binding_size
+                   << " to host stack";
+        bindings->SetHostAddress(i, AllocateHost(binding_size));
+        bindings->SetDeviceAddressToHost(i);
+    }
+}
+
+size_t Buffers::AlignedSize(const std::vector<size_t>& sizes, size_t alignment)
+{
+    size_t total = 0;
+    for(auto size : sizes)
+    {
+        auto remainder = size % alignment;
+        total += (remainder == 0) ? size : size + alignment - remainder;
+    }
+    return total;
+}
+
+size_t Buffers::BindingsSize(const Bindings& bindings, size_t alignment)
+{
+    std::vector<size_t> sizes;
+    for(uint32_t i = 0; i < bindings.m_Model->GetBindingsCount(); i++)
+    {
+        sizes.push_back(bindings.BindingCapacity(i));
+    }
+    return AlignedSize(sizes, alignment);
+}
+
+void Buffers::ConfigureBindingsFromAllocations(std::shared_ptr<Bindings> bindings,
+                                               std::shared_ptr<HostMemory> host,
+                                               size_t host_alignment,
+                                               std::shared_ptr<DeviceMemory> device,
+                                               size_t device_alignment)
+{
+    size_t host_offset = 0, device_offset = 0;
+    for(uint32_t i = 0; i < bindings->m_Model->GetBindingsCount(); i++)
+    {
+        auto binding_size = bindings->BindingCapacity(i);
+        DLOG(INFO) << "Configuring Binding " << i << ": " << binding_size << " bytes at offset "
+                   << host_offset << " of the host allocation";
+        CHECK_LE(host_offset + binding_size, host->Size());
+        bindings->SetHostAddress(
+            i, std::make_unique<SubDescriptor<HostMemory>>(host, host_offset, binding_size));
+        host_offset += AlignedSize({binding_size}, host_alignment);
+        if(!device)
+        {
+            bindings->SetDeviceAddressToHost(i);
+            continue;
+        }
+        CHECK_LE(device_offset + binding_size, device->Size());
+        bindings->SetDeviceAddress(
+            i, std::make_unique<SubDescriptor<DeviceMemory>>(device, device_offset, binding_size));
+        device_offset += AlignedSize({binding_size}, device_alignment);
+    }
+}
+
 void Buffers::Synchronize()
 {
+    if(!m_Stream)
+    {
+        return;
+    }
     CHECK_EQ(cudaStreamSynchronize(m_Stream), CUDA_SUCCESS) << "Stream Sync failed";
 }
 
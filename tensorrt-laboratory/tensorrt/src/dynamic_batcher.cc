@@ -0,0 +1,222 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/dynamic_batcher.h"
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/profiler.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+// BatchItem
+
+void* BatchItem::HostAddress(uint32_t binding_id)
+{
+    auto base = static_cast<char*>(m_Bindings.HostAddress(binding_id));
+    return base + m_Index * BindingSize(binding_id);
+}
+
+void* BatchItem::HostAddress(const std::string& binding_name)
+{
+    return HostAddress(m_Bindings.GetModel()->BindingId(binding_name));
+}
+
+size_t BatchItem::BindingSize(uint32_t binding_id) const
+{
+    return m_Bindings.GetModel()->GetBinding(binding_id).bytesPerBatchItem;
+}
+
+// DynamicBatcher
+
+DynamicBatcher::DynamicBatcher(std::shared_ptr<BaseModel> model,
+                               std::shared_ptr<InferenceManager> resources,
+                               DynamicBatchingPolicy policy)
+    : m_Model(model), m_Resources(resources), m_Policy(policy), m_Runner(model, resources),
+      m_InFlight(0), m_Shutdown(false), m_Stats{0, 0, {}}
+{
+    uint32_t model_max = m_Model->GetMaxBatchSize();
+    m_MaxBatchSize = m_Policy.max_batch_size ? std::min(m_Policy.max_batch_size, model_max)
+                                             : model_max;
+    CHECK_GT(m_MaxBatchSize, 0);
+
+    auto& preferred = m_Policy.preferred_batch_sizes;
+    preferred.erase(std::remove_if(preferred.begin(), preferred.end(),
+                                   [this](uint32_t size) {
+                                       return size == 0 || size > m_MaxBatchSize;
+                                   }),
+                    preferred.end());
+    std::sort(preferred.begin(), preferred.end());
+    preferred.erase(std::unique(preferred.begin(), preferred.end()), preferred.end());
+    m_DispatchSize = preferred.empty() ? m_MaxBatchSize : preferred.back();
+
+    m_MaxInFlight = m_Policy.max_batches_in_flight ? m_Policy.max_batches_in_flight
+                                                   : m_Resources->MaxCopyConcurrency();
+    CHECK_GT(m_MaxInFlight, 0);
+
+    LOG(INFO) << "DynamicBatcher for model " << m_Model->Name()
+              << "; max batch size: " << m_MaxBatchSize
+              << "; dispatch size: " << m_DispatchSize
+              << "; max queue delay: " << m_Policy.max_queue_delay.count() << "us";
+
+    m_Thread = std::thread([this] { BatchingLoop(); });
+}
+
+DynamicBatcher::~DynamicBatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Shutdown = true;
+    }
+    m_Condition.notify_all();
+    m_Thread.join();
+
+    // batches in flight hold a pointer to this object and to m_Runner
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock, [this] { return m_InFlight == 0; });
+}
+
+void DynamicBatcher::Enqueue(PreFn pre, std::function<void(BatchItem&)> post)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        CHECK(!m_Shutdown) << "DynamicBatcher is shutting down";
+        m_Queue.push_back(Request{std::move(pre), std::move(post), std::chrono::steady_clock::now()});
+        m_Stats.requests++;
+    }
+    m_Condition.notify_all();
+}
+
+auto DynamicBatcher::GetStats() const -> Stats
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+uint32_t DynamicBatcher::NextBatchSize(bool expired) const
+{
+    uint32_t queued = m_Queue.size();
+    if(queued >= m_DispatchSize)
+    {
+        return m_DispatchSize;
+    }
+    if(!expired)
+    {
+        return 0;
+    }
+    const auto& preferred = m_Policy.preferred_batch_sizes;
+    for(auto it = preferred.rbegin(); it != preferred.rend(); it++)
+    {
+        if(*it <= queued)
+        {
+            return *it;
+        }
+    }
+    return std::min(queued, m_MaxBatchSize);
+}
+
+void DynamicBatcher::BatchingLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while(true)
+    {
+        m_Condition.wait(lock, [this] { return m_Shutdown || !m_Queue.empty(); });
+        if(m_Queue.empty())
+        {
+            DLOG(INFO) << "DynamicBatcher drained; exiting batching loop";
+            return;
+        }
+
+        // grow the batch until it reaches the dispatch size or the oldest request expires
+        auto deadline = m_Queue.front().enqueued + m_Policy.max_queue_delay;
+        m_Condition.wait_until(
+            lock, deadline, [this] { return m_Shutdown || m_Queue.size() >= m_DispatchSize; });
+
+        // backpressure: while the backend is saturated, keep growing the batch
+        m_Condition.wait(lock, [this] { return m_InFlight < m_MaxInFlight; });
+
+        auto expired = m_Shutdown || std::chrono::steady_clock::now() >= deadline;
+        auto count = NextBatchSize(expired);
+        if(!count)
+        {
+            continue;
+        }
+
+        std::vector<Request> batch;
+        batch.reserve(count);
+        for(uint32_t i = 0; i < count; i++)
+        {
+            batch.push_back(std::move(m_Queue.front()));
+            m_Queue.pop_front();
+        }
+        m_InFlight++;
+        m_Stats.batches++;
+        m_Stats.batch_sizes[count]++;
+
+        lock.unlock();
+        Dispatch(std::move(batch));
+        lock.lock();
+    }
+}
+
+void DynamicBatcher::Dispatch(std::vector<Request>&& requests)
+{
+    auto batch = std::make_shared<std::vector<Request>>(std::move(requests));
+    auto dispatched = Profiler::Now();
+    for(const auto& request : *batch)
+    {
+        Profiler::Record("queue:batcher", "queue", request.enqueued, dispatched);
+    }
+    DLOG(INFO) << "DynamicBatcher dispatching batch of " << batch->size();
+
+    m_Runner.Infer(
+        batch->size(),
+        [batch](Bindings& bindings) {
+            for(uint32_t i = 0; i < batch->size(); i++)
+            {
+                BatchItem item(bindings, i);
+                (*batch)[i].pre(item);
+            }
+        },
+        [this, batch](std::shared_ptr<Bindings>& bindings) {
+            for(uint32_t i = 0; i < batch->size(); i++)
+            {
+                BatchItem item(*bindings, i);
+                (*batch)[i].post(item);
+            }
+            bindings.reset();
+            // notify under the lock; the destructor may return as soon as it is released
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_InFlight--;
+            m_Condition.notify_all();
+        });
+}
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,434 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/ensemble.h"
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/profiler.h"
+
+namespace {
+// Host address of an output binding of another step; keeps the producer's Bindings alive
+class AliasDescriptor final : public trtlab::Descriptor<trtlab::HostMemory>
+{
+  public:
+    AliasDescriptor(std::shared_ptr<trtlab::TensorRT::Bindings> source, uint32_t binding_id)
+        : trtlab::Descriptor<trtlab::HostMemory>(source->HostAddress(binding_id),
+                                                 source->BindingCapacity(binding_id),
+                                                 "EnsembleAlias"),
+          m_Source(std::move(source))
+    {
+    }
+    ~AliasDescriptor() final override {}
+
+  private:
+    std::shared_ptr<trtlab::TensorRT::Bindings> m_Source;
+};
+} // namespace
+
+namespace trtlab {
+namespace TensorRT {
+
+EnsembleBindings::EnsembleBindings(const Ensemble& ensemble, uint32_t batch_size)
+    : m_Ensemble(ensemble), m_BatchSize(batch_size)
+{
+    for(const auto& step : ensemble.m_Steps)
+    {
+        m_Pending.push_back(step.producers);
+    }
+}
+
+EnsembleBindings::~EnsembleBindings() {}
+
+void* EnsembleBindings::HostAddress(const std::string& tensor)
+{
+    auto search = m_Ensemble.m_Tensors.find(tensor);
+    CHECK(search != m_Ensemble.m_Tensors.end()) << "Unknown ensemble tensor: " << tensor;
+    return m_Steps[search->second.step]->HostAddress(search->second.binding);
+}
+
+size_t EnsembleBindings::BindingSize(const std::string& tensor) const
+{
+    auto search = m_Ensemble.m_Tensors.find(tensor);
+    CHECK(search != m_Ensemble.m_Tensors.end()) << "Unknown ensemble tensor: " << tensor;
+    return m_Steps[search->second.step]->BindingSize(search->second.binding);
+}
+
+Bindings& EnsembleBindings::StepBindings(const std::string& step)
+{
+    auto search = m_Ensemble.m_StepIds.find(step);
+    CHECK(search != m_Ensemble.m_StepIds.end()) << "Unknown ensemble step: " << step;
+    return *m_Steps[search->second];
+}
+
+Ensemble::Ensemble(std::shared_ptr<InferenceManager> resources)
+    : m_Resources(resources), m_MaxBatchSize(0), m_Finalized(false), m_BuffersChecked(false)
+{
+}
+
+Ensemble::~Ensemble() {}
+
+/**
+ * @brief Add a step executing the model registered under model_name
+ */
+void Ensemble::AddStep(const std::string& step, const std::string& model_name)
+{
+    CHECK(!m_Finalized) << "Steps must be added before Finalize()";
+    if(m_StepIds.count(step))
+    {
+        throw std::runtime_error("Ensemble step " + step + " is already defined");
+    }
+    m_StepIds[step] = m_Steps.size();
+    m_Steps.push_back(Step{step, m_Resources->GetModel(model_name), {}, 0});
+}
+
+/**
+ * @brief Feed the output binding of producer to the input binding of consumer
+ */
+void Ensemble::Connect(const std::string& producer, const std::string& output,
+                       const std::string& consumer, const std::string& input)
+{
+    auto source = FindPort(producer, output, false);
+    auto target = FindPort(consumer, input, true);
+    if(source.step == target.step)
+    {
+        throw std::runtime_error("Ensemble step " + producer + " can not feed itself");
+    }
+    Bind(target, source);
+    m_Steps[source.step].consumers.push_back(target.step);
+    m_Steps[target.step].producers++;
+}
+
+/**
+ * @brief Declare an ensemble input written by the pre function to the input binding of a step
+ *
+ * Adding the same tensor to several steps feeds all of them from the same memory.
+ */
+void Ensemble::AddInput(const std::string& tensor, const std::string& step,
+                        const std::string& input)
+{
+    auto target = FindPort(step, input, true);
+    auto search = m_Tensors.find(tensor);
+    if(search == m_Tensors.end())
+    {
+        m_Tensors[tensor] = target;
+        Bind(target, target);
+        return;
+    }
+    const auto& source = search->second;
+    if(!m_Steps[source.step].model->GetBinding(source.binding).isInput)
+    {
+        throw std::runtime_error("Ensemble tensor " + tensor + " is already an output");
+    }
+    Bind(target, source);
+}
+
+/**
+ * @brief Declare an ensemble output read by the post function from the output binding of a step
+ */
+void Ensemble::AddOutput(const std::string& tensor, const std::string& step,
+                         const std::string& output)
+{
+    auto source = FindPort(step, output, false);
+    if(m_Tensors.count(tensor))
+    {
+        throw std::runtime_error("Ensemble tensor " + tensor + " is already defined");
+    }
+    m_Tensors[tensor] = source;
+}
+
+/**
+ * @brief Validate the graph and compute the execution order of the steps
+ */
+void Ensemble::Finalize()
+{
+    CHECK(!m_Finalized) << "Ensemble is already finalized";
+    if(m_Steps.empty())
+    {
+        throw std::runtime_error("Ensemble has no steps");
+    }
+
+    m_MaxBatchSize = m_Steps[0].model->GetMaxBatchSize();
+    for(uint32_t i = 0; i < m_Steps.size(); i++)
+    {
+        const auto& model = *m_Steps[i].model;
+        m_MaxBatchSize = std::min<uint32_t>(m_MaxBatchSize, model.GetMaxBatchSize());
+        for(auto id : model.GetInputBindingIds())
+        {
+            if(!m_Sources.count(std::make_pair(i, id)))
+            {
+                throw std::runtime_error("Input " + model.GetBinding(id).name +
+                                         " of ensemble step " + m_Steps[i].name + " is not bound");
+            }
+        }
+    }
+
+    // Kahn's algorithm; steps left over are part of a cycle
+    std::vector<uint32_t> producers;
+    std::deque<uint32_t> ready;
+    for(uint32_t i = 0; i < m_Steps.size(); i++)
+    {
+        producers.push_back(m_Steps[i].producers);
+        if(!m_Steps[i].producers)
+        {
+            ready.push_back(i);
+        }
+    }
+    m_Order.clear();
+    while(!ready.empty())
+    {
+        auto step = ready.front();
+        ready.pop_front();
+        m_Order.push_back(step);
+        for(auto consumer : m_Steps[step].consumers)
+        {
+            if(--producers[consumer] == 0)
+            {
+                ready.push_back(consumer);
+            }
+        }
+    }
+    if(m_Order.size() != m_Steps.size())
+    {
+        m_Order.clear();
+        throw std::runtime_error("Ensemble steps form a cycle");
+    }
+    m_BuffersChecked = CheckBuffers();
+    m_Finalized = true;
+}
+
+/**
+ * @brief Throw if a Buffers Pool holds fewer Buffers than the steps mapped to it
+ *
+ * Each request takes one Buffers per step while holding m_CreateMutex, so such a request would
+ * wait forever.  Returns false if the resources are not allocated yet.
+ */
+bool Ensemble::CheckBuffers() const
+{
+    std::map<size_t, uint32_t> steps;
+    std::map<size_t, uint32_t> counts;
+    for(const auto& step : m_Steps)
+    {
+        auto pool = m_Resources->GetBuffersPool(step.model.get());
+        if(!pool.second)
+        {
+            return false;
+        }
+        steps[pool.first]++;
+        counts[pool.first] = pool.second;
+    }
+    for(const auto& item : steps)
+    {
+        if(item.second > counts[item.first])
+        {
+            throw std::runtime_error("Buffers Pool " + std::to_string(item.first) + " holds " +
+                                     std::to_string(counts[item.first]) + " Buffers, but " +
+                                     std::to_string(item.second) +
+                                     " ensemble steps take their Buffers from it");
+        }
+    }
+    return true;
+}
+
+auto Ensemble::Steps() const -> std::vector<std::string>
+{
+    std::vector<std::string> steps;
+    for(auto step : m_Order)
+    {
+        steps.push_back(m_Steps[step].name);
+    }
+    return steps;
+}
+
+auto Ensemble::FindPort(const std::string& step, const std::string& binding, bool is_input) const
+    -> Port
+{
+    CHECK(!m_Finalized) << "The ensemble graph must be defined before Finalize()";
+    auto search = m_StepIds.find(step);
+    if(search == m_StepIds.end())
+    {
+        throw std::runtime_error("Unknown ensemble step " + step);
+    }
+    const auto& model = *m_Steps[search->second].model;
+    auto type = model.GetBindingType(binding);
+    if(type != (is_input ? BaseModel::BindingType::Input : BaseModel::BindingType::Output))
+    {
+        throw std::runtime_error("Model " + model.Name() + " of ensemble step " + step +
+                                 " has no " + (is_input ? "input " : "output ") + binding);
+    }
+    return Port{search->second, model.BindingId(binding)};
+}
+
+void Ensemble::Bind(const Port& input, const Port& source)
+{
+    auto key = std::make_pair(input.step, input.binding);
+    const auto& info = m_Steps[input.step].model->GetBinding(input.binding);
+    if(m_Sources.count(key))
+    {
+        throw std::runtime_error("Input " + info.name + " of ensemble step " +
+                                 m_Steps[input.step].name + " is already bound");
+    }
+    const auto& source_info = m_Steps[source.step].model->GetBinding(source.binding);
+    if(info.dtype != source_info.dtype || info.bytesPerBatchItem != source_info.bytesPerBatchItem)
+    {
+        throw std::runtime_error("Input " + info.name + " of ensemble step " +
+                                 m_Steps[input.step].name + " does not match the type or size of " +
+                                 source_info.name + " of step " + m_Steps[source.step].name);
+    }
+    m_Sources[key] = source;
+}
+
+auto Ensemble::CreateBindings(uint32_t batch_size) -> std::shared_ptr<EnsembleBindings>
+{
+    auto request = std::shared_ptr<EnsembleBindings>(new EnsembleBindings(*this, batch_size));
+    request->m_Steps.resize(m_Steps.size());
+    {
+        Profiler::Span span("wait:buffers", "wait");
+        std::lock_guard<std::mutex> lock(m_CreateMutex);
+        for(auto step : m_Order)
+        {
+            const auto& model = m_Steps[step].model;
+            auto buffers = m_Resources->GetBuffers(model);
+            request->m_Steps[step] = buffers->CreateBindings(model, batch_size);
+        }
+    }
+    for(const auto& item : m_Sources)
+    {
+        const auto& source = item.second;
+        auto step = item.first.first;
+        auto binding = item.first.second;
+        if(source.step == step && source.binding == binding)
+        {
+            continue;
+        }
+        auto& bindings = request->m_Steps[step];
+        bindings->SetHostAddress(binding, std::make_unique<AliasDescriptor>(
+                                              request->m_Steps[source.step], source.binding));
+        if(m_Steps[step].model->ExecutesOnHost())
+        {
+            bindings->SetDeviceAddressToHost(binding);
+        }
+    }
+    return request;
+}
+
+void Ensemble::Enqueue(uint32_t batch_size, PreFn pre, PostFn post)
+{
+    CHECK(m_Finalized) << "Ensemble must be finalized before inference";
+    CHECK_GT(batch_size, 0);
+    CHECK_LE(batch_size, m_MaxBatchSize);
+    if(!m_BuffersChecked)
+    {
+        m_BuffersChecked = CheckBuffers();
+    }
+    auto queued = Profiler::Now();
+    Workers("pre").enqueue([this, batch_size, pre, post, queued]() mutable {
+        Profiler::Record("queue:pre", "queue", queued, Profiler::Now());
+        auto request = CreateBindings(batch_size);
+        {
+            Profiler::Span span("pre", "stage");
+            pre(*request);
+        }
+        // every task of the request holds a reference to it; the post function is queued when the
+        // last task released it, so no worker holds the request once its future is ready
+        std::shared_ptr<EnsembleBindings> steps(request.get(), [this, request,
+                                                                post](EnsembleBindings*) mutable {
+            auto posted = Profiler::Now();
+            Workers("post").enqueue([request = std::move(request), post = std::move(post),
+                                     posted]() mutable {
+                Profiler::Record("queue:post", "queue", posted, Profiler::Now());
+                Profiler::Span span("post", "stage");
+                post(request);
+            });
+        });
+        for(auto step : m_Order)
+        {
+            if(!m_Steps[step].producers)
+            {
+                Launch(steps, step);
+            }
+        }
+    });
+}
+
+void Ensemble::Launch(std::shared_ptr<EnsembleBindings> request, uint32_t step)
+{
+    auto queued = Profiler::Now();
+    Workers("cuda").enqueue([this, request, step, queued]() mutable {
+        Profiler::Record("queue:cuda", "queue", queued, Profiler::Now());
+        Execute(request->m_Steps[step], *m_Steps[step].model);
+
+        std::vector<uint32_t> ready;
+        {
+            std::lock_guard<std::mutex> lock(request->m_Mutex);
+            for(auto consumer : m_Steps[step].consumers)
+            {
+                if(--request->m_Pending[consumer] == 0)
+                {
+                    ready.push_back(consumer);
+                }
+            }
+        }
+        for(auto consumer : ready)
+        {
+            Launch(request, consumer);
+        }
+    });
+}
+
+void Ensemble::Execute(const std::shared_ptr<Bindings>& bindings, const BaseModel& model)
+{
+    DLOG(INFO) << "Executing ensemble step with model " << model.Name();
+    {
+        Profiler::Span span("copy:h2d", "copy");
+        bindings->CopyToDevice(bindings->InputBindings());
+    }
+    std::shared_ptr<ExecutionContext> ctx;
+    {
+        Profiler::Span span("wait:execution_context", "wait");
+        ctx = m_Resources->GetExecutionContext(&model);
+    }
+    {
+        Profiler::Span span("compute", "compute");
+        ctx->Infer(bindings);
+    }
+    {
+        Profiler::Span span("copy:d2h", "copy");
+        bindings->CopyFromDevice(bindings->OutputBindings());
+    }
+    // consumers read the outputs from host memory
+    Profiler::Span span("sync", "compute");
+    ctx->Synchronize();
+    ctx.reset();
+    bindings->Synchronize();
+}
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -57,34 +57,42 @@ namespace TensorRT {
  * timings, they are simply a nice-to-have, so a reasonable approximation on the host is sufficient.
  */
 ExecutionContext::ExecutionContext(size_t workspace_size)
-    : m_Context{nullptr}, m_Workspace{std::make_unique<Allocator<CudaDeviceMemory>>(workspace_size)}
+    : m_ExecutionContextFinished{nullptr}, m_EventRecorded{false}, m_Context{nullptr}
 {
-    CHECK_EQ(cudaEventCreateWithFlags(&m_ExecutionContextFinished, cudaEventDisableTiming),
-             CUDA_SUCCESS)
-        << "Failed to Create Execution Context Finished Event";
+    // Host-only models require no activation workspace; avoid touching the CUDA runtime so the
+    // ExecutionContext can be used on machines without a GPU.
+    if(workspace_size)
+    {
+        m_Workspace = std::make_unique<Allocator<CudaDeviceMemory>>(workspace_size);
+    }
 }
 
 ExecutionContext::~ExecutionContext()
 {
-    CHECK_EQ(cudaEventDestroy(m_ExecutionContextFinished), CUDA_SUCCESS);
+    if(m_ExecutionContextFinished)
+    {
+        CHECK_EQ(cudaEventDestroy(m_ExecutionContextFinished), CUDA_SUCCESS);
+    }
 }
 
 /**
  * @brief Set the ExectionContext
  * @param context
  */
-void ExecutionContext::SetContext(std::shared_ptr<::nvinfer1::IExecutionContext> context)
+void ExecutionContext::SetContext(std::shared_ptr<IExecutor> context)
 {
     m_Context = context;
-    m_Context->setDeviceMemory(m_Workspace->Data());
+    m_Context->SetWorkspace(m_Workspace ? m_Workspace->Data() : nullptr);
 }
 
 /**
  * @brief Enqueue an Inference calculation
  *
- * Initiates a forward pass through a TensorRT optimized graph and registers an event on the stream
- * which is trigged when the compute has finished and the ExecutionContext can be reused by
- * competing threads. Use the Synchronize method to sync on this event.
+ * Initiates a forward pass through the model's IExecutor.  For device backends, an event is
+ * registered on the stream which is trigged when the compute has finished and the
+ * ExecutionContext can be reused by competing threads. Use the Synchronize method to sync on
+ * this event.  Host backends, i.e. Bindings without a stream, complete the compute before
+ * Infer returns.
  *
  * @param bindings
  */
@@ -95,9 +103,18 @@ void ExecutionContext::Infer(const std::shared_ptr<Bindings>& bindings)
     m_ElapsedTimer = [start] {
         return std::chrono::duration<double>(std::chrono::system_clock::now() - start).count();
     };
-    m_Context->enqueue(bindings->BatchSize(), bindings->DeviceAddresses(), bindings->Stream(),
-                       nullptr);
-    CHECK_EQ(cudaEventRecord(m_ExecutionContextFinished, bindings->Stream()), CUDA_SUCCESS);
+    m_Context->Enqueue(*bindings);
+    if(bindings->Stream())
+    {
+        if(!m_ExecutionContextFinished)
+        {
+            CHECK_EQ(cudaEventCreateWithFlags(&m_ExecutionContextFinished, cudaEventDisableTiming),
+                     CUDA_SUCCESS)
+                << "Failed to Create Execution Context Finished Event";
+        }
+        CHECK_EQ(cudaEventRecord(m_ExecutionContextFinished, bindings->Stream()), CUDA_SUCCESS);
+        m_EventRecorded = true;
+    }
 }
 
 /**
@@ -105,7 +122,10 @@ void ExecutionContext::Infer(const std::shared_ptr<Bindings>& bindings)
  */
 auto ExecutionContext::Synchronize() -> double
 {
-    CHECK_EQ(cudaEventSynchronize(m_ExecutionContextFinished), CUDA_SUCCESS);
+    if(m_EventRecorded)
+    {
+        CHECK_EQ(cudaEventSynchronize(m_ExecutionContextFinished), CUDA_SUCCESS);
+    }
     return m_ElapsedTimer();
 }
 
@@ -122,8 +142,9 @@ auto ExecutionContext::Synchronize() -> double
  */
 void ExecutionContext::Reset()
 {
-    m_Context->setDeviceMemory(nullptr);
+    m_Context->SetWorkspace(nullptr);
     m_Context.reset();
+    m_EventRecorded = false;
     m_ElapsedTimer = [] { return 0.0; };
 }
 
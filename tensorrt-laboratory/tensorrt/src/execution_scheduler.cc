@@ -0,0 +1,240 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/execution_scheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+namespace TensorRT {
+
+ExecutionScheduler::ExecutionScheduler(uint32_t capacity) : m_Capacity(capacity), m_Free(capacity)
+{
+    CHECK_GT(m_Capacity, 0);
+}
+
+ExecutionScheduler::~ExecutionScheduler()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for(const auto& item : m_Models)
+    {
+        CHECK(item.second.waiters.empty()) << "ExecutionScheduler destroyed with waiters";
+    }
+}
+
+void ExecutionScheduler::AddModel(const BaseModel* model, uint32_t max_concurrency)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    CHECK(m_Models.find(model) == m_Models.end()) << "Model already added to scheduler";
+    auto& state = m_Models[model];
+    state.registered_concurrency = max_concurrency;
+    state.max_concurrency = max_concurrency;
+    state.virtual_time = 0.0;
+    state.stats = Stats{0, 0, 0, std::chrono::nanoseconds(0), std::chrono::nanoseconds(0)};
+    m_Order.push_back(model);
+}
+
+/**
+ * @brief Remove an idle model; its reservation is released to the other models
+ */
+void ExecutionScheduler::RemoveModel(const BaseModel* model)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const auto& state = State(model);
+    CHECK(state.waiters.empty() && state.stats.in_flight == 0)
+        << "Unable to remove model " << model->Name() << " while it is in use";
+    m_Models.erase(model);
+    m_Order.erase(std::remove(m_Order.begin(), m_Order.end(), model), m_Order.end());
+    if(Schedule())
+    {
+        m_Condition.notify_all();
+    }
+}
+
+void ExecutionScheduler::SetPolicy(const BaseModel* model, const SchedulingPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& state = State(model);
+    CHECK_GT(policy.weight, 0.0);
+    uint32_t reserved = 0;
+    for(const auto& item : m_Models)
+    {
+        reserved += (&item.second == &state ? 0 : item.second.policy.min_reserved);
+    }
+    CHECK_LE(reserved + policy.min_reserved, m_Capacity)
+        << "Reservations exceed the scheduler capacity of " << m_Capacity;
+
+    state.policy = policy;
+    state.max_concurrency = policy.max_concurrency
+                                ? std::min(policy.max_concurrency, state.registered_concurrency)
+                                : state.registered_concurrency;
+    // a model can not be guaranteed more slots than it is allowed to hold
+    state.policy.min_reserved = std::min(state.policy.min_reserved, state.max_concurrency);
+    if(Schedule())
+    {
+        m_Condition.notify_all();
+    }
+}
+
+void ExecutionScheduler::Acquire(const BaseModel* model)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    auto& state = State(model);
+
+    if(state.waiters.empty() && state.stats.in_flight == 0)
+    {
+        // becoming active; catch up to the active models so idle time is not banked
+        auto min_vt = std::numeric_limits<double>::max();
+        for(const auto& item : m_Models)
+        {
+            const auto& other = item.second;
+            if(&other != &state && (other.waiters.size() || other.stats.in_flight))
+            {
+                min_vt = std::min(min_vt, other.virtual_time);
+            }
+        }
+        if(min_vt != std::numeric_limits<double>::max())
+        {
+            state.virtual_time = std::max(state.virtual_time, min_vt);
+        }
+    }
+
+    Waiter waiter{std::chrono::steady_clock::now(), false};
+    state.waiters.push_back(&waiter);
+    state.stats.queue_depth++;
+    if(Schedule())
+    {
+        m_Condition.notify_all();
+    }
+
+    if(!waiter.granted)
+    {
+        DLOG(INFO) << "Waiting on an execution slot for model " << model->Name();
+        m_Condition.wait(lock, [&waiter] { return waiter.granted; });
+    }
+
+    auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - waiter.enqueued);
+    state.stats.total_wait += wait;
+    state.stats.max_wait = std::max(state.stats.max_wait, wait);
+}
+
+void ExecutionScheduler::Release(const BaseModel* model)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& state = State(model);
+    CHECK_GT(state.stats.in_flight, 0);
+    state.stats.in_flight--;
+    m_Free++;
+    if(Schedule())
+    {
+        m_Condition.notify_all();
+    }
+}
+
+auto ExecutionScheduler::GetStats(const BaseModel* model) const -> Stats
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return State(model).stats;
+}
+
+auto ExecutionScheduler::State(const BaseModel* model) -> ModelState&
+{
+    auto search = m_Models.find(model);
+    CHECK(search != m_Models.end()) << "Model not registered with the scheduler";
+    return search->second;
+}
+
+auto ExecutionScheduler::State(const BaseModel* model) const -> const ModelState&
+{
+    auto search = m_Models.find(model);
+    CHECK(search != m_Models.end()) << "Model not registered with the scheduler";
+    return search->second;
+}
+
+uint32_t ExecutionScheduler::UnusedReservations(const ModelState* except) const
+{
+    uint32_t reserved = 0;
+    for(const auto& item : m_Models)
+    {
+        const auto& state = item.second;
+        if(&state != except && state.stats.in_flight < state.policy.min_reserved)
+        {
+            reserved += state.policy.min_reserved - state.stats.in_flight;
+        }
+    }
+    return reserved;
+}
+
+bool ExecutionScheduler::Schedule()
+{
+    bool granted = false;
+    while(m_Free)
+    {
+        ModelState* next = nullptr;
+        bool next_reserved = false;
+        for(auto model : m_Order)
+        {
+            auto& state = m_Models[model];
+            if(state.waiters.empty() || state.stats.in_flight >= state.max_concurrency)
+            {
+                continue;
+            }
+            bool reserved = state.stats.in_flight < state.policy.min_reserved;
+            if(!reserved && UnusedReservations(&state) >= m_Free)
+            {
+                continue;
+            }
+            if(!next || (reserved && !next_reserved) ||
+               (reserved == next_reserved && state.virtual_time < next->virtual_time))
+            {
+                next = &state;
+                next_reserved = reserved;
+            }
+        }
+        if(!next)
+        {
+            break;
+        }
+
+        auto waiter = next->waiters.front();
+        next->waiters.pop_front();
+        waiter->granted = true;
+        next->virtual_time += 1.0 / next->policy.weight;
+        next->stats.queue_depth--;
+        next->stats.in_flight++;
+        next->stats.granted++;
+        m_Free--;
+        granted = true;
+    }
+    return granted;
+}
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,168 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/host_model.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/bindings.h"
+#include "tensorrt/laboratory/utils.h"
+
+namespace trtlab {
+namespace TensorRT {
+namespace {
+
+class HostExecutor final : public IExecutor
+{
+  public:
+    HostExecutor(const HostModel* model) : m_Model(model) {}
+    ~HostExecutor() final override {}
+
+    void Enqueue(Bindings& bindings) final override { m_Model->Execute(bindings); }
+
+  private:
+    const HostModel* m_Model;
+};
+
+} // namespace
+
+// HostModel
+
+HostModel::HostModel(int max_batch_size) : BaseModel(), m_MaxBatchSize(max_batch_size)
+{
+    CHECK_GT(m_MaxBatchSize, 0);
+}
+
+HostModel::~HostModel() {}
+
+auto HostModel::CreateExecutor() const -> std::shared_ptr<IExecutor>
+{
+    // The InferenceManager owns the registered model for at least as long as its executors.
+    return std::make_shared<HostExecutor>(this);
+}
+
+void HostModel::AddHostBinding(const std::string& name, bool is_input,
+                               const std::vector<size_t>& dims, ::nvinfer1::DataType dtype)
+{
+    TensorBindingInfo binding;
+    size_t elements = 1;
+    for(auto d : dims)
+    {
+        elements *= d;
+    }
+    binding.name = name;
+    binding.dtype = dtype;
+    binding.isInput = is_input;
+    binding.dtypeSize = SizeofDataType(dtype);
+    binding.elementsPerBatchItem = elements;
+    binding.bytesPerBatchItem = elements * binding.dtypeSize;
+    binding.dims = dims;
+    AddBinding(std::move(binding));
+}
+
+uint32_t HostModel::BatchSize(const Bindings& bindings) const
+{
+    auto batch_size = bindings.BatchSize();
+    return batch_size ? batch_size : GetMaxBatchSize();
+}
+
+// EchoModel
+
+EchoModel::EchoModel(int max_batch_size, const std::vector<size_t>& dims)
+    : HostModel(max_batch_size)
+{
+    AddHostBinding("input", true, dims);
+    AddHostBinding("output", false, dims);
+}
+
+EchoModel::~EchoModel() {}
+
+void EchoModel::Execute(Bindings& bindings) const
+{
+    auto input = BindingId("input");
+    auto output = BindingId("output");
+    auto bytes = GetBinding(input).bytesPerBatchItem * BatchSize(bindings);
+    std::memcpy(bindings.HostAddress(output), bindings.HostAddress(input), bytes);
+}
+
+// DenseModel
+
+DenseModel::DenseModel(int max_batch_size, size_t inputs, size_t outputs, uint32_t seed)
+    : HostModel(max_batch_size), m_Inputs(inputs), m_Outputs(outputs),
+      m_Weights(inputs * outputs), m_Bias(outputs)
+{
+    AddHostBinding("input", true, {inputs});
+    AddHostBinding("output", false, {outputs});
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    auto scale = 1.0f / static_cast<float>(std::max<size_t>(inputs, 1));
+    for(auto& w : m_Weights)
+    {
+        w = distribution(generator) * scale;
+    }
+    for(auto& b : m_Bias)
+    {
+        b = distribution(generator) * scale;
+    }
+}
+
+DenseModel::~DenseModel() {}
+
+auto DenseModel::GetWeightsMemorySize() const -> size_t
+{
+    return (m_Weights.size() + m_Bias.size()) * sizeof(float);
+}
+
+void DenseModel::Execute(Bindings& bindings) const
+{
+    auto input = static_cast<const float*>(bindings.HostAddress(BindingId("input")));
+    auto output = static_cast<float*>(bindings.HostAddress(BindingId("output")));
+    auto batch_size = BatchSize(bindings);
+
+    for(uint32_t n = 0; n < batch_size; n++)
+    {
+        const float* x = input + n * m_Inputs;
+        float* y = output + n * m_Outputs;
+        for(size_t o = 0; o < m_Outputs; o++)
+        {
+            const float* w = m_Weights.data() + o * m_Inputs;
+            float sum = m_Bias[o];
+            for(size_t i = 0; i < m_Inputs; i++)
+            {
+                sum += w[i] * x[i];
+            }
+            y[o] = std::max(sum, 0.0f);
+        }
+    }
+}
+
+} // namespace TensorRT
+} // namespace trtlab
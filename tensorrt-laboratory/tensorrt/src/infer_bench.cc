@@ -28,6 +28,16 @@
 #include "tensorrt/laboratory/bindings.h"
 #include "tensorrt/laboratory/infer_runner.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+
 #include <glog/logging.h>
 
 namespace trtlab {
@@ -36,53 +46,142 @@ namespace TensorRT {
 InferBench::InferBench(std::shared_ptr<InferenceManager> resources) : m_Resources(resources) {}
 InferBench::~InferBench() {}
 
-std::unique_ptr<InferBench::Results> InferBench::Run(std::shared_ptr<Model> model,
+std::unique_ptr<InferBench::Results> InferBench::Run(std::shared_ptr<BaseModel> model,
                                                      uint32_t batch_size, double seconds)
 {
-    std::vector<std::shared_ptr<Model>> models = {model};
-    return std::move(Run(models, batch_size, seconds));
+    ModelsList models = {model};
+    return Run(models, batch_size, seconds);
 }
 
 std::unique_ptr<InferBench::Results> InferBench::Run(const ModelsList& models, uint32_t batch_size,
                                                      double seconds)
 {
-    size_t batch_count = 0;
-    std::vector<std::shared_future<void>> futures;
-    futures.reserve(1024 * 1024);
+    return Run(models, batch_size, seconds, 0.0, 0);
+}
 
+std::unique_ptr<InferBench::Results> InferBench::Run(const ModelsList& models, uint32_t batch_size,
+                                                     double seconds, double warmup,
+                                                     uint32_t concurrency)
+{
     // Check ModelsList to ensure the requested batch_size is appropriate
+    CHECK(!models.empty());
     for(const auto& model : models)
     {
         CHECK_LE(batch_size, model->GetMaxBatchSize());
     }
 
+    if(warmup > 0.0)
+    {
+        DLOG(INFO) << "Warming up for " << warmup << " seconds";
+        Measure(models, batch_size, warmup, concurrency);
+    }
+
+    auto results = Measure(models, batch_size, seconds, concurrency);
+    (*results)[kWarmupTime] = warmup;
+
+    DLOG(INFO) << "Benchmark Run Complete";
+    DLOG(INFO) << "Inference Results: " << (*results)[kBatchesComputed] << " batches computed in "
+               << (*results)[kWalltime] << " seconds on " << (*results)[kMaxExecConcurrency]
+               << " compute streams using batch_size: " << (*results)[kBatchSize]
+               << "; inf/sec: " << (*results)[kInferencesPerSecond]
+               << "; batches/sec: " << (*results)[kBatchesPerSecond]
+               << "; execution time per batch: " << (*results)[kExecutionTimePerBatch]
+               << "; latency p50/p99: " << (*results)[kLatencyP50] << "/"
+               << (*results)[kLatencyP99];
+
+    return results;
+}
+
+void InferBench::SetRequestWork(std::function<void(Bindings&)> pre,
+                                std::function<void(Bindings&)> post)
+{
+    m_PreWork = pre ? pre : [](Bindings&) {};
+    m_PostWork = post;
+}
+
+auto InferBench::Sweep(const ModelsList& models, const std::vector<uint32_t>& batch_sizes,
+                       const std::vector<uint32_t>& concurrencies, double seconds, double warmup)
+    -> ResultsList
+{
+    ResultsList results;
+    for(auto batch_size : batch_sizes)
+    {
+        for(auto concurrency : concurrencies)
+        {
+            results.push_back(Run(models, batch_size, seconds, warmup, concurrency));
+        }
+    }
+    return results;
+}
+
+std::unique_ptr<InferBench::Results> InferBench::Measure(const ModelsList& models,
+                                                         uint32_t batch_size, double seconds,
+                                                         uint32_t concurrency)
+{
+    using clock = std::chrono::high_resolution_clock;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t in_flight = 0;
+    std::vector<double> latencies;
+
+    // The runners must outlive the requests issued through them
+    std::vector<std::unique_ptr<InferRunner>> runners;
+    for(const auto& model : models)
+    {
+        runners.push_back(std::make_unique<InferRunner>(model, m_Resources));
+    }
+
     // Setup std::chrono deadline - no more elapsed lambda
-    auto start = std::chrono::high_resolution_clock::now();
+    size_t batch_count = 0;
+    auto start = clock::now();
     auto last = start + std::chrono::milliseconds(static_cast<long>(seconds * 1000));
 
     // Benchmark loop over Models modulo size of ModelsList
-    while(std::chrono::high_resolution_clock::now() < last && ++batch_count)
+    while(clock::now() < last && ++batch_count)
     {
         size_t model_idx = batch_count % models.size();
         const auto& model = models[model_idx];
 
-        auto buffers = InferResources().GetBuffers(); // <=== Limited Resource; May Block !!!
-        auto bindings = buffers->CreateBindings(model);
-        bindings->SetBatchSize(batch_size);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&] { return !concurrency || in_flight < concurrency; });
+            in_flight++;
+        }
 
-        InferRunner runner(model, m_Resources);
-        futures.push_back(runner.Infer(
-            bindings, [](std::shared_ptr<Bindings>& bindings) mutable { bindings.reset(); }));
+        auto issued = clock::now();
+        auto complete = [&, issued](std::shared_ptr<Bindings>& bindings) mutable {
+            if(m_PostWork)
+            {
+                m_PostWork(*bindings);
+            }
+            bindings.reset();
+            auto latency = std::chrono::duration<double>(clock::now() - issued).count();
+            // notify under the lock; Measure returns as soon as in_flight reaches 0
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.push_back(latency);
+            in_flight--;
+            condition.notify_all();
+        };
+
+        if(m_PreWork)
+        {
+            runners[model_idx]->Infer(batch_size, m_PreWork, complete);
+            continue;
+        }
+
+        auto buffers = InferResources().GetBuffers(model); // <=== Limited Resource; May Block !!!
+        auto bindings = buffers->CreateBindings(model, batch_size);
+        runners[model_idx]->Infer(bindings, complete);
     }
 
-    // Join worker threads
-    for(const auto& f : futures)
+    // Wait for the outstanding requests
     {
-        f.wait();
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return in_flight == 0; });
     }
 
-    auto total_time =
-        std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    auto total_time = std::chrono::duration<double>(clock::now() - start).count();
     auto inferences = batch_count * batch_size;
 
     auto results_ptr = std::make_unique<InferBench::Results>();
@@ -90,6 +189,7 @@ std::unique_ptr<InferBench::Results> InferBench::Run(const ModelsList& models, u
     results[kBatchSize] = batch_size;
     results[kMaxExecConcurrency] = m_Resources->MaxExecConcurrency();
     results[kMaxCopyConcurrency] = m_Resources->MaxCopyConcurrency();
+    results[kConcurrency] = concurrency;
     results[kBatchesComputed] = batch_count;
     results[kWalltime] = total_time;
     results[kBatchesPerSecond] = batch_count / total_time;
@@ -97,16 +197,82 @@ std::unique_ptr<InferBench::Results> InferBench::Run(const ModelsList& models, u
     results[kExecutionTimePerBatch] =
         total_time / (batch_count / m_Resources->MaxExecConcurrency());
 
-    DLOG(INFO) << "Benchmark Run Complete";
+    // Nearest-rank percentiles of the per-request latencies
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        if(latencies.empty())
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        auto rank = static_cast<size_t>(std::ceil(p * latencies.size()));
+        return latencies[std::max<size_t>(rank, 1) - 1];
+    };
+    results[kLatencyMean] =
+        std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+    results[kLatencyP50] = percentile(0.50);
+    results[kLatencyP90] = percentile(0.90);
+    results[kLatencyP99] = percentile(0.99);
+    results[kLatencyP999] = percentile(0.999);
+    results[kLatencyMax] = percentile(1.0);
 
-    DLOG(INFO) << "Inference Results: " << results[kBatchesComputed] << " batches computed in "
-               << results[kWalltime] << " seconds on " << results[kMaxExecConcurrency]
-               << " compute streams using batch_size: " << results[kBatchSize]
-               << "; inf/sec: " << results[kInferencesPerSecond]
-               << "; batches/sec: " << results[kBatchesPerSecond]
-               << "; execution time per batch: " << results[kExecutionTimePerBatch];
+    return results_ptr;
+}
 
-    return std::move(results_ptr);
+std::string InferBench::KeyName(InferBenchKey key)
+{
+    switch(key)
+    {
+        case kMaxExecConcurrency: return "max_exec_concurrency";
+        case kMaxCopyConcurrency: return "max_copy_concurrency";
+        case kBatchSize: return "batch_size";
+        case kWalltime: return "walltime";
+        case kBatchesComputed: return "batches_computed";
+        case kBatchesPerSecond: return "batches_per_second";
+        case kInferencesPerSecond: return "inferences_per_second";
+        case kSecondsPerBatch: return "seconds_per_batch";
+        case kExecutionTimePerBatch: return "execution_time_per_batch";
+        case kConcurrency: return "concurrency";
+        case kWarmupTime: return "warmup_time";
+        case kLatencyMean: return "latency_mean";
+        case kLatencyP50: return "latency_p50";
+        case kLatencyP90: return "latency_p90";
+        case kLatencyP99: return "latency_p99";
+        case kLatencyP999: return "latency_p99.9";
+        case kLatencyMax: return "latency_max";
+    }
+    return "unknown";
+}
+
+std::string InferBench::ToJSON(const Results& results)
+{
+    std::ostringstream os;
+    os << std::setprecision(9) << "{";
+    for(auto it = results.begin(); it != results.end(); it++)
+    {
+        os << (it == results.begin() ? "" : ", ") << "\"" << KeyName(it->first) << "\": ";
+        if(std::isfinite(it->second))
+        {
+            os << it->second;
+        }
+        else
+        {
+            os << "null";
+        }
+    }
+    os << "}";
+    return os.str();
+}
+
+std::string InferBench::ToJSON(const ResultsList& results)
+{
+    std::ostringstream os;
+    os << "[";
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        os << (i ? ",\n " : "") << ToJSON(*results[i]);
+    }
+    os << "]";
+    return os.str();
 }
 
 } // namespace TensorRT
@@ -26,14 +26,19 @@
  */
 #include "tensorrt/laboratory/inference_manager.h"
 
+#include <cmath>
+
 #include <glog/logging.h>
 
+#include "tensorrt/laboratory/core/memory/malloc.h"
 #include "tensorrt/laboratory/cuda/device_info.h"
 #include "tensorrt/laboratory/cuda/memory/cuda_device.h"
 #include "tensorrt/laboratory/cuda/memory/cuda_pinned_host.h"
 
 using trtlab::CudaDeviceMemory;
 using trtlab::CudaPinnedHostMemory;
+using trtlab::HostMemory;
+using trtlab::Malloc;
 
 namespace trtlab {
 namespace TensorRT {
@@ -58,8 +63,9 @@ namespace TensorRT {
  */
 InferenceManager::InferenceManager(int max_executions, int max_buffers)
     : m_MaxExecutions(max_executions), m_MaxBuffers(max_buffers ? max_buffers : max_executions * 2),
-      m_HostStackSize(0), m_DeviceStackSize(0),
-      m_ActivationsSize(0), m_Buffers{nullptr}, m_ActiveRuntime{nullptr}
+      m_HostStackSize(0), m_DeviceStackSize(0), m_ActivationsSize(0), m_ActiveRuntime{nullptr},
+      m_HostModels(0), m_DeviceModels(0), m_HostBuffers(false), m_BuffersFootprint(0),
+      m_Scheduler{std::make_shared<ExecutionScheduler>(max_executions)}
 {
     // RegisterRuntime("default", std::make_unique<CustomRuntime<StandardAllocator>>());
     // SetActiveRuntime("default");
@@ -77,7 +83,7 @@ int InferenceManager::MaxCopyConcurrency() const { return m_MaxBuffers; }
 /**
  * @brief Register a Model with the InferenceManager object
  */
-void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Model> model)
+void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<BaseModel> model)
 {
     RegisterModel(name, model, m_MaxExecutions);
 }
@@ -88,10 +94,20 @@ void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Mo
  * This variant allows you to specify an alternate maximum concurrency for this model.  The value
  * must be 1 <= concurrency <= MaxConcurrency.  Larger values will be capped to the maximum
  * concurrency allowed by the InferenceManager object.
+ *
+ * Any model implementing IModel::CreateExecutor can be registered; however, host models (see
+ * IModel::ExecutesOnHost) and device models can not be mixed in a single InferenceManager.  If
+ * only host models are registered, AllocateResources creates host-resident Buffers and no GPU
+ * resources.
+ *
+ * A model registered after AllocateResources executes on the class of activation workspaces
+ * with the most ExecutionContexts that fits it; its concurrency is capped to the size of that
+ * class.
  */
-void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Model> model,
+void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<BaseModel> model,
                                      uint32_t max_concurrency)
 {
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
     auto item = m_Models.find(name);
     if(item != m_Models.end())
     {
@@ -100,6 +116,16 @@ void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Mo
         return;
     }
 
+    if(model->ExecutesOnHost() ? m_DeviceModels : m_HostModels)
+    {
+        throw std::runtime_error("Host and device models can not be registered with the same "
+                                 "InferenceManager");
+    }
+    if(!m_Buffers.empty() && model->ExecutesOnHost() != m_HostBuffers)
+    {
+        throw std::runtime_error("Model backend does not match the allocated Buffers");
+    }
+
     if(max_concurrency > m_MaxExecutions)
     {
         LOG(WARNING) << "Requested concurrency (" << max_concurrency
@@ -109,16 +135,16 @@ void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Mo
     }
 
     // Size according to largest padding - device alignment
-    size_t bindings =
-        model->GetBindingMemorySize() + model->GetBindingsCount() * DeviceInfo::Alignment();
+    auto alignment =
+        model->ExecutesOnHost() ? HostMemory::DefaultAlignment() : DeviceInfo::Alignment();
+    size_t bindings = model->GetBindingMemorySize() + model->GetBindingsCount() * alignment;
     size_t activations = Align(model->GetActivationsMemorySize(), 128 * 1024); // add a cacheline
 
     size_t host = Align(bindings, 32 * 1024);
-    size_t device = Align(bindings, 128 * 1024);
+    size_t device = model->ExecutesOnHost() ? 0 : Align(bindings, 128 * 1024);
 
-    // TODO: Check to see if m_Buffers has been allocated.  If so, we should thown an exception
-    // if the registered model requirements are larger than our allocated buffers.
-    if(m_Buffers)
+    // Models registered after AllocateResources are served from the largest Pools
+    if(!m_Buffers.empty())
     {
         if(host > m_HostStackSize || device > m_DeviceStackSize)
         {
@@ -126,13 +152,33 @@ void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Mo
                 "Required binding resources are greater than allocated capacity");
         }
     }
-    if(m_ExecutionContexts)
+    size_t execution_slots = 0;
+    if(!m_ExecutionContexts.empty())
     {
-        if(activations > m_ActivationsSize)
+        bool fits = false;
+        for(size_t i = 0; i < m_WorkspacePlan.slots.size(); i++)
+        {
+            const auto& slots = m_WorkspacePlan.slots[i];
+            if(slots.bytes >= activations &&
+               (!fits || slots.count > m_WorkspacePlan.slots[execution_slots].count))
+            {
+                execution_slots = i;
+                fits = true;
+            }
+        }
+        if(activations > m_ActivationsSize || !fits)
         {
             throw std::runtime_error(
                 "Required activation workspace is greater than allocated capacity");
         }
+        // the scheduler must not grant more executions than the class holds ExecutionContexts
+        auto count = m_WorkspacePlan.slots[execution_slots].count;
+        if(max_concurrency > count)
+        {
+            LOG(WARNING) << "Concurrency of model " << name << " is capped to the " << count
+                         << " ExecutionContexts of its class of activation workspaces";
+            max_concurrency = count;
+        }
     }
 
     m_HostStackSize = std::max(m_HostStackSize, host);
@@ -147,12 +193,51 @@ void InferenceManager::RegisterModel(const std::string& name, std::shared_ptr<Mo
     if(weights) LOG(INFO) << "Weights require " << BytesToString(weights);
 
     model->SetName(name);
-    m_Models[name] = model;
-    m_ModelExecutionContexts[model.get()] = Pool<::nvinfer1::IExecutionContext>::Create();
+    auto executors = Pool<IExecutor>::Create();
     for(int i = 0; i < max_concurrency; i++)
     {
-        m_ModelExecutionContexts[model.get()]->Push(model->CreateExecutionContext());
+        auto executor = model->CreateExecutor();
+        if(!executor)
+        {
+            throw std::runtime_error("Model " + name + " does not provide an IExecutor");
+        }
+        executors->Push(executor);
+    }
+
+    m_Models[name] = model;
+    m_ModelMemory[name] = ModelMemory{host, device, activations, max_concurrency, ""};
+    if(!m_Buffers.empty())
+    {
+        m_ModelBuffers[model.get()] = 0;
+        m_ModelExecutionSlots[model.get()] = execution_slots;
     }
+    m_ModelExecutionContexts[model.get()] = executors;
+    m_Scheduler->AddModel(model.get(), max_concurrency);
+    (model->ExecutesOnHost() ? m_HostModels : m_DeviceModels)++;
+}
+
+/**
+ * @brief Remove a registered Model, releasing its IExecutors
+ *
+ * The model must be idle: no requests may be waiting on or holding one of its execution slots.
+ * The allocated Buffers and workspaces are kept; a model registered later under the same or a
+ * different name is served from the allocated Pools, see RegisterModel.
+ */
+void InferenceManager::UnregisterModel(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    auto item = m_Models.find(name);
+    CHECK(item != m_Models.end()) << "Unable to find entry for model: " << name;
+    auto model = item->second;
+    m_Scheduler->RemoveModel(model.get());
+
+    LOG(INFO) << "-- Unregistering Model: " << name << " --";
+    (model->ExecutesOnHost() ? m_HostModels : m_DeviceModels)--;
+    m_ModelExecutionContexts.erase(model.get());
+    m_ModelBuffers.erase(model.get());
+    m_ModelExecutionSlots.erase(model.get());
+    m_ModelMemory.erase(name);
+    m_Models.erase(item);
 }
 
 Runtime& InferenceManager::ActiveRuntime() { return *m_ActiveRuntime; }
@@ -171,52 +256,246 @@ void InferenceManager::SetActiveRuntime(const std::string& name)
     m_ActiveRuntime = search->second.get();
 }
 
+/**
+ * @brief Declare that the models of a group are never executed at the same time
+ *
+ * Models of the same exclusive group share their Buffers and activation workspaces, which are
+ * sized for the largest member of the group.  Requests of a model are still correct if the
+ * declaration is violated, but they will wait for the group's resources.  Must be called before
+ * AllocateResources.
+ *
+ * @see MemoryPlanner
+ */
+void InferenceManager::SetExclusiveGroup(const std::string& model_name, const std::string& group)
+{
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    CHECK(m_Buffers.empty()) << "Exclusive groups must be set before AllocateResources()";
+    auto item = m_ModelMemory.find(model_name);
+    CHECK(item != m_ModelMemory.end()) << "Unable to find entry for model: " << model_name;
+    item->second.group = group;
+}
+
+/**
+ * @brief Select the strategy and sizing of the Buffers; must be called before AllocateResources
+ *
+ * @see BuffersPolicy
+ */
+void InferenceManager::SetBuffersPolicy(const BuffersPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    CHECK(m_Buffers.empty()) << "The Buffers policy must be set before AllocateResources()";
+    CHECK_GE(policy.segment_factor, 1.0) << "A segment must hold the largest request";
+    CHECK_GT(policy.memory_fraction, 0.0);
+    m_BuffersPolicy = policy;
+}
+
 /**
  * @brief Allocates Host and Device Resources for Inference
  *
- * Buffers are sized according to the registered models.  Models registered after
- * AllocateInferenceManager has been call that require larger buffers should throw an exception
- * (TODO).
+ * Buffers and activation workspaces are laid out by a MemoryPlanner from the binding and
+ * activation sizes and the concurrency of the registered models.  Instead of sizing every
+ * Buffers object and ExecutionContext for the largest model, smaller models may be given Pools of
+ * smaller resources whenever that reduces the total footprint.  Models registered after
+ * AllocateResources are served from the allocated Pools and throw if they do not fit.
+ *
+ * The Buffers of each Pool are either fixed stacks or share rings of rotating segments, as
+ * selected by the BuffersPolicy.
  */
 void InferenceManager::AllocateResources()
 {
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    m_Buffers.clear();
+    m_BuffersFootprint = 0;
+    m_ExecutionContexts.clear();
+    m_HostBuffers = (m_HostModels > 0);
+
+    MemoryPlanner buffers_planner(m_MaxBuffers);
+    MemoryPlanner workspace_planner(m_MaxExecutions);
+    for(const auto& item : m_ModelMemory)
+    {
+        const auto& mem = item.second;
+        // Buffers are held through the copies overlapping the execution, so a model may use
+        // proportionally more Buffers than execution slots
+        uint32_t copies =
+            (mem.concurrency * m_MaxBuffers + m_MaxExecutions - 1) / m_MaxExecutions;
+        buffers_planner.AddModel(item.first, mem.host + mem.device, copies, mem.group);
+        workspace_planner.AddModel(item.first, mem.activations, mem.concurrency, mem.group);
+    }
+    m_BuffersPlan = buffers_planner.Compute();
+    m_WorkspacePlan = workspace_planner.Compute();
+    if(m_BuffersPlan.slots.empty())
+    {
+        m_BuffersPlan.slots.push_back(
+            MemoryPlan::Slots{m_HostStackSize + m_DeviceStackSize, (uint32_t)m_MaxBuffers, {}});
+        m_WorkspacePlan.slots.push_back(
+            MemoryPlan::Slots{m_ActivationsSize, (uint32_t)m_MaxExecutions, {}});
+    }
+
     LOG(INFO) << "-- Allocating TensorRT Resources --";
     LOG(INFO) << "Creating " << m_MaxExecutions << " TensorRT execution tokens.";
-    LOG(INFO) << "Creating a Pool of " << m_MaxBuffers << " Host/Device Memory Stacks";
-    LOG(INFO) << "Each Host Stack contains " << BytesToString(m_HostStackSize);
-    LOG(INFO) << "Each Device Stack contains " << BytesToString(m_DeviceStackSize);
-    LOG(INFO) << "Total GPU Memory: "
-              << BytesToString(m_MaxBuffers * m_DeviceStackSize +
-                               m_MaxExecutions * m_ActivationsSize);
-
-    m_Buffers = Pool<Buffers>::Create();
-    for(int i = 0; i < m_MaxBuffers; i++)
+    size_t device_total = 0;
+    for(const auto& slots : m_BuffersPlan.slots)
+    {
+        size_t host = 0, device = 0;
+        for(const auto& name : slots.models)
+        {
+            host = std::max(host, m_ModelMemory[name].host);
+            device = std::max(device, m_ModelMemory[name].device);
+        }
+        if(slots.models.empty())
+        {
+            host = m_HostStackSize;
+            device = m_DeviceStackSize;
+        }
+        auto pool = Pool<Buffers>::Create();
+        if(m_BuffersPolicy.strategy == BuffersPolicy::Strategy::kCyclic)
+        {
+            device_total += PushCyclicBuffers(*pool, slots.count, host, device);
+            m_Buffers.push_back(pool);
+            continue;
+        }
+        device_total += slots.count * device;
+        m_BuffersFootprint += slots.count * (host + device);
+
+        if(m_HostModels)
+        {
+            LOG(INFO) << "Creating a Pool of " << slots.count << " Host Memory Stacks";
+            LOG(INFO) << "Each Host Stack contains " << BytesToString(host);
+        }
+        else
+        {
+            LOG(INFO) << "Creating a Pool of " << slots.count << " Host/Device Memory Stacks";
+            LOG(INFO) << "Each Host Stack contains " << BytesToString(host);
+            LOG(INFO) << "Each Device Stack contains " << BytesToString(device);
+        }
+        for(uint32_t i = 0; i < slots.count; i++)
+        {
+            if(m_HostModels)
+            {
+                DLOG(INFO) << "Allocating Host Buffers #" << i;
+                pool->Push(std::make_shared<HostBuffers<Malloc>>(host));
+                continue;
+            }
+            DLOG(INFO) << "Allocating Host/Device Buffers #" << i;
+            pool->Push(std::make_shared<FixedBuffers<CudaPinnedHostMemory, CudaDeviceMemory>>(
+                host, device));
+        }
+        m_Buffers.push_back(pool);
+    }
+
+    for(const auto& slots : m_WorkspacePlan.slots)
+    {
+        LOG(INFO) << "Creating " << slots.count << " Activation Workspaces of "
+                  << BytesToString(slots.bytes);
+        auto pool = Pool<ExecutionContext>::Create();
+        for(uint32_t i = 0; i < slots.count; i++)
+        {
+            pool->EmplacePush(new ExecutionContext(slots.bytes));
+        }
+        m_ExecutionContexts.push_back(pool);
+    }
+
+    LOG(INFO) << "Buffers Memory: " << BytesToString(m_BuffersFootprint) << " (planned: "
+              << BytesToString(m_BuffersPlan.Footprint())
+              << "; unplanned: " << BytesToString(m_BuffersPlan.UniformFootprint()) << ")";
+    LOG(INFO) << "Workspace Memory: " << BytesToString(m_WorkspacePlan.Footprint())
+              << " (unplanned: " << BytesToString(m_WorkspacePlan.UniformFootprint()) << ")";
+    if(!m_HostModels)
+    {
+        LOG(INFO) << "Total GPU Memory: "
+                  << BytesToString(device_total + m_WorkspacePlan.Footprint());
+    }
+
+    for(const auto& item : m_Models)
+    {
+        m_ModelBuffers[item.second.get()] = m_BuffersPlan.assignment[item.first];
+        m_ModelExecutionSlots[item.second.get()] = m_WorkspacePlan.assignment[item.first];
+    }
+}
+
+/**
+ * @brief Push count CyclicBuffers sharing one ring per memory space to the Pool
+ *
+ * host and device are the largest requests of the Pool, i.e. the binding memory of its largest
+ * model at the maximum batch size.  Segments must hold at least one such request.  Returns the
+ * device memory of the rings.
+ */
+size_t InferenceManager::PushCyclicBuffers(Pool<Buffers>& pool, uint32_t count, size_t host,
+                                           size_t device)
+{
+    const auto& policy = m_BuffersPolicy;
+    auto segment_size = [this, &policy](size_t request, size_t alignment) {
+        auto bytes = std::ceil(request * policy.segment_factor);
+        return Align(static_cast<size_t>(bytes), alignment);
+    };
+    auto segment_count = [count, &policy](size_t request, size_t segment) -> size_t {
+        if(policy.segments)
+        {
+            return policy.segments;
+        }
+        auto ring = std::ceil(policy.memory_fraction * count * request / segment);
+        return std::max<size_t>(2, static_cast<size_t>(ring));
+    };
+
+    auto host_segment = segment_size(host, 32 * 1024);
+    auto host_segments = segment_count(host, host_segment);
+    LOG(INFO) << "Creating a Pool of " << count << " Cyclic Buffers";
+    LOG(INFO) << "Host Ring contains " << host_segments << " segments of "
+              << BytesToString(host_segment);
+    m_BuffersFootprint += host_segments * host_segment;
+
+    if(m_HostModels)
     {
-        DLOG(INFO) << "Allocating Host/Device Buffers #" << i;
-        m_Buffers->Push(std::make_shared<FixedBuffers<CudaPinnedHostMemory, CudaDeviceMemory>>(
-            m_HostStackSize, m_DeviceStackSize));
+        auto ring = std::make_shared<CyclicAllocator<Malloc>>(host_segments, host_segment);
+        for(uint32_t i = 0; i < count; i++)
+        {
+            pool.Push(std::make_shared<CyclicHostBuffers<Malloc>>(ring));
+        }
+        return 0;
     }
 
-    m_ExecutionContexts = Pool<ExecutionContext>::Create();
-    for(int i = 0; i < m_MaxExecutions; i++)
+    auto device_segment = segment_size(device, 128 * 1024);
+    auto device_segments = segment_count(device, device_segment);
+    LOG(INFO) << "Device Ring contains " << device_segments << " segments of "
+              << BytesToString(device_segment);
+    m_BuffersFootprint += device_segments * device_segment;
+
+    auto host_ring =
+        std::make_shared<CyclicAllocator<CudaPinnedHostMemory>>(host_segments, host_segment);
+    auto device_ring =
+        std::make_shared<CyclicAllocator<CudaDeviceMemory>>(device_segments, device_segment);
+    for(uint32_t i = 0; i < count; i++)
     {
-        m_ExecutionContexts->EmplacePush(new ExecutionContext(m_ActivationsSize));
+        pool.Push(std::make_shared<CyclicBuffers<CudaPinnedHostMemory, CudaDeviceMemory>>(
+            host_ring, device_ring));
     }
+    return device_segments * device_segment;
 }
 
 /**
  * @brief Get a registered Model by name
  *
  * @param model_name
- * @return std::shared_ptr<Model>
+ * @return std::shared_ptr<BaseModel>
  */
-auto InferenceManager::GetModel(std::string model_name) -> std::shared_ptr<Model>
+auto InferenceManager::GetModel(std::string model_name) -> std::shared_ptr<BaseModel>
 {
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
     auto item = m_Models.find(model_name);
     CHECK(item != m_Models.end()) << "Unable to find entry for model: " << model_name;
     return item->second;
 }
 
+/**
+ * @brief Registered model of the given name; nullptr if there is none
+ */
+auto InferenceManager::FindModel(const std::string& model_name) -> std::shared_ptr<BaseModel>
+{
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    auto item = m_Models.find(model_name);
+    return item == m_Models.end() ? nullptr : item->second;
+}
+
 /**
  * @brief Get a Buffers from the Resource Pool (May Block!)
  *
@@ -225,17 +504,72 @@ auto InferenceManager::GetModel(std::string model_name) -> std::shared_ptr<Model
  *
  * Note: The resource will be returned to the resource Pool when the reference count of the
  * shared_ptr goes to zero.  No action on the user is required, unless they want to release the
- * object earlier by using the reset() function on all instances of the shared_ptr.
+ * object earlier by using the reset() function on all instances of the shared_ptr.  Bindings
+ * created from the Buffers hold a reference, so the Buffers are only reset and returned once all
+ * of its Bindings are released as well.
  *
  * @return std::shared_ptr<Buffers>
  */
 auto InferenceManager::GetBuffers() -> std::shared_ptr<Buffers>
 {
-    CHECK(m_Buffers) << "Call AllocateResources() before trying to acquire a Buffers object.";
-    return m_Buffers->Pop([](Buffers* ptr) {
+    // the first Pool holds the largest Buffers, which fit any registered model
+    return PopBuffers(0);
+}
+
+/**
+ * @brief Get a Buffers object sized for the model from the Resource Pool (May Block!)
+ *
+ * Prefer this variant over GetBuffers() when the model is known: the Buffers are taken from the
+ * Pool the MemoryPlan assigned to the model.
+ *
+ * @see GetBuffers()
+ */
+auto InferenceManager::GetBuffers(const BaseModel* model) -> std::shared_ptr<Buffers>
+{
+    size_t pool;
+    {
+        std::lock_guard<std::mutex> lock(m_ModelsMutex);
+        auto item = m_ModelBuffers.find(model);
+        CHECK(item != m_ModelBuffers.end()) << "No Buffers for model " << model->Name();
+        pool = item->second;
+    }
+    return PopBuffers(pool);
+}
+
+auto InferenceManager::GetBuffers(const std::shared_ptr<BaseModel>& model)
+    -> std::shared_ptr<Buffers>
+{
+    return GetBuffers(model.get());
+}
+
+/**
+ * @brief Index of the Buffers Pool serving the model and the number of Buffers it holds
+ *
+ * Models sharing a Pool compete for the same Buffers.  Before AllocateResources no Pool exists
+ * and {0, 0} is returned.
+ */
+auto InferenceManager::GetBuffersPool(const BaseModel* model) const -> std::pair<size_t, uint32_t>
+{
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    if(m_Buffers.empty())
+    {
+        return std::make_pair(0, 0);
+    }
+    auto item = m_ModelBuffers.find(model);
+    CHECK(item != m_ModelBuffers.end()) << "No Buffers for model " << model->Name();
+    return std::make_pair(item->second, m_BuffersPlan.slots[item->second].count);
+}
+
+auto InferenceManager::PopBuffers(size_t pool) -> std::shared_ptr<Buffers>
+{
+    CHECK(!m_Buffers.empty())
+        << "Call AllocateResources() before trying to acquire a Buffers object.";
+    auto buffers = m_Buffers[pool]->Pop([](Buffers* ptr) {
         ptr->Reset();
         DLOG(INFO) << "Releasing Buffers";
     });
+    buffers->m_PoolHandle = buffers;
+    return buffers;
 }
 
 /**
@@ -251,41 +585,86 @@ auto InferenceManager::GetBuffers() -> std::shared_ptr<Buffers>
  *
  * @return std::shared_ptr<ExecutionContext>
  */
-auto InferenceManager::GetExecutionContext(const Model* model) -> std::shared_ptr<ExecutionContext>
+auto InferenceManager::GetExecutionContext(const BaseModel* model)
+    -> std::shared_ptr<ExecutionContext>
 {
-    CHECK(m_ExecutionContexts)
-        << "Call AllocateResources() before trying to acquire an ExeuctionContext.";
-    auto item = m_ModelExecutionContexts.find(model);
-    CHECK(item != m_ModelExecutionContexts.end())
-        << "No ExectionContext for model " << model->Name();
-    // This is the global concurrency limiter - it owns the activation scratch memory
-    auto ctx = m_ExecutionContexts->Pop([](ExecutionContext* ptr) {
+    std::shared_ptr<Pool<IExecutor>> executors;
+    std::shared_ptr<Pool<ExecutionContext>> pool;
+    {
+        std::lock_guard<std::mutex> lock(m_ModelsMutex);
+        CHECK(!m_ExecutionContexts.empty())
+            << "Call AllocateResources() before trying to acquire an ExeuctionContext.";
+        auto item = m_ModelExecutionContexts.find(model);
+        CHECK(item != m_ModelExecutionContexts.end())
+            << "No ExectionContext for model " << model->Name();
+        auto slots = m_ModelExecutionSlots.find(model);
+        CHECK(slots != m_ModelExecutionSlots.end());
+        executors = item->second;
+        pool = m_ExecutionContexts[slots->second];
+    }
+    // The scheduler decides which model is granted the next global limiter; its slot is only
+    // released once the context and IExecutor are back in their pools.  A model is never granted
+    // more executions than it has IExecutors, so once granted, the model pool below will not block
+    m_Scheduler->Acquire(model);
+    // This is the limiter of the model's class of execution slots - it owns the activation
+    // scratch memory.  The planned classes hold a context for every execution their models may
+    // be granted at once, unless the models of an exclusive group overlap; a model registered
+    // after AllocateResources shares a class with the planned models and may wait here for one
+    // of their contexts
+    auto ctx = pool->Pop([](ExecutionContext* ptr) {
         ptr->Reset();
         DLOG(INFO) << "Returning Execution Concurrency Limiter to Pool";
     });
-    // This is the model concurrency limiter - it owns the TensorRT IExecutionContext
-    // for which the pointer to the global limiter's memory buffer will be set
-    ctx->SetContext(item->second->Pop([](::nvinfer1::IExecutionContext* ptr) {
-        DLOG(INFO) << "Returning Model IExecutionContext to Pool";
-    }));
+    // This is the model concurrency limiter - it owns the backend's IExecutor (for TensorRT the
+    // IExecutionContext) for which the pointer to the global limiter's memory buffer will be set
+    ctx->SetContext(executors->Pop(
+        [](IExecutor* ptr) { DLOG(INFO) << "Returning Model IExecutor to Pool"; }));
     DLOG(INFO) << "Acquired Concurrency Limiting Execution Context";
-    return ctx;
+    auto ptr = ctx.get();
+    return std::shared_ptr<ExecutionContext>(
+        ptr, [ctx, scheduler = m_Scheduler, model](ExecutionContext*) mutable {
+            ctx.reset();
+            scheduler->Release(model);
+        });
 }
 
 /**
  * @brief Get an Exeuction Context object from the Resource Pool (May Block!)
  *
- * Convenience method for accepting a shared_ptr<Model> as input.
+ * Convenience method for accepting a shared_ptr<BaseModel> as input.
  *
  * @param model
  * @return std::shared_ptr<ExecutionContext>
  */
-auto InferenceManager::GetExecutionContext(const std::shared_ptr<Model>& model)
+auto InferenceManager::GetExecutionContext(const std::shared_ptr<BaseModel>& model)
     -> std::shared_ptr<ExecutionContext>
 {
     return GetExecutionContext(model.get());
 }
 
+/**
+ * @brief Set the share of the execution resources for a registered model
+ *
+ * @see SchedulingPolicy
+ */
+void InferenceManager::SetSchedulingPolicy(const std::string& model_name,
+                                           const SchedulingPolicy& policy)
+{
+    m_Scheduler->SetPolicy(GetModel(model_name).get(), policy);
+}
+
+/**
+ * @brief Queue depth, in-flight and wait time statistics of a registered model
+ */
+auto InferenceManager::GetSchedulingStats(const std::string& model_name) const
+    -> ExecutionScheduler::Stats
+{
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
+    auto item = m_Models.find(model_name);
+    CHECK(item != m_Models.end()) << "Unable to find entry for model: " << model_name;
+    return m_Scheduler->GetStats(item->second.get());
+}
+
 auto InferenceManager::AcquireThreadPool(const std::string& name) -> ThreadPool&
 {
     // std::shared_lock<std::shared_mutex> lock(m_ThreadPoolMutex);
@@ -318,8 +697,9 @@ void InferenceManager::JoinAllThreads()
     DLOG(INFO) << "All Threads Checked-In and Joined";
 }
 
-void InferenceManager::ForEachModel(std::function<void(const Model&)> callback)
+void InferenceManager::ForEachModel(std::function<void(const BaseModel&)> callback)
 {
+    std::lock_guard<std::mutex> lock(m_ModelsMutex);
     for(const auto& item : m_Models)
     {
         callback(*(item.second));
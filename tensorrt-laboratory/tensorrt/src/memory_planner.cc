@@ -0,0 +1,153 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/memory_planner.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+namespace TensorRT {
+
+size_t MemoryPlan::Footprint() const
+{
+    size_t total = 0;
+    for(const auto& s : slots)
+    {
+        total += s.bytes * s.count;
+    }
+    return total;
+}
+
+size_t MemoryPlan::UniformFootprint() const
+{
+    return slots.empty() ? 0 : slots[0].bytes * max_slots;
+}
+
+uint32_t MemoryPlan::SlotCount() const
+{
+    uint32_t count = 0;
+    for(const auto& s : slots)
+    {
+        count += s.count;
+    }
+    return count;
+}
+
+MemoryPlanner::MemoryPlanner(uint32_t max_slots) : m_MaxSlots(max_slots)
+{
+    CHECK_GT(m_MaxSlots, 0);
+}
+
+void MemoryPlanner::AddModel(const std::string& name, size_t bytes, uint32_t concurrency,
+                             const std::string& group)
+{
+    CHECK(m_Models.find(name) == m_Models.end()) << "Model " << name << " already added";
+    if(concurrency == 0 || concurrency > m_MaxSlots)
+    {
+        concurrency = m_MaxSlots;
+    }
+    m_Models[name] = Requirement{bytes, concurrency, group.empty() ? "model:" + name : group};
+}
+
+MemoryPlan MemoryPlanner::Compute() const
+{
+    // Collapse each exclusive group to the size of its largest member and the concurrency of its
+    // most concurrent member
+    std::map<std::string, MemoryPlan::Slots> groups;
+    for(const auto& item : m_Models)
+    {
+        auto search = groups.find(item.second.group);
+        if(search == groups.end())
+        {
+            groups[item.second.group] = MemoryPlan::Slots{0, 0, {}};
+        }
+        auto& g = groups[item.second.group];
+        g.bytes = std::max(g.bytes, item.second.bytes);
+        g.count = std::max(g.count, item.second.concurrency);
+        g.models.push_back(item.first);
+    }
+
+    std::vector<MemoryPlan::Slots> sorted;
+    for(auto& item : groups)
+    {
+        sorted.push_back(std::move(item.second));
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const MemoryPlan::Slots& a, const MemoryPlan::Slots& b) {
+                         return a.bytes > b.bytes;
+                     });
+
+    // Merging only ever pays off for groups adjacent in size: best[j] is the smallest footprint
+    // of the first j groups, where the last class merges groups split[j]..j-1 and is sized for
+    // the largest of them
+    const auto n = sorted.size();
+    std::vector<size_t> best(n + 1, std::numeric_limits<size_t>::max());
+    std::vector<size_t> split(n + 1, 0);
+    best[0] = 0;
+    for(size_t j = 1; j <= n; j++)
+    {
+        uint32_t count = 0;
+        for(size_t i = j; i > 0; i--)
+        {
+            count = std::min(m_MaxSlots, count + sorted[i - 1].count);
+            auto cost = best[i - 1] + sorted[i - 1].bytes * count;
+            if(cost <= best[j])
+            {
+                best[j] = cost;
+                split[j] = i - 1;
+            }
+        }
+    }
+
+    MemoryPlan plan;
+    plan.max_slots = m_MaxSlots;
+    for(size_t j = n; j > 0; j = split[j])
+    {
+        MemoryPlan::Slots merged{sorted[split[j]].bytes, 0, {}};
+        for(size_t i = split[j]; i < j; i++)
+        {
+            merged.count = std::min(m_MaxSlots, merged.count + sorted[i].count);
+            merged.models.insert(merged.models.end(), sorted[i].models.begin(),
+                                 sorted[i].models.end());
+        }
+        plan.slots.insert(plan.slots.begin(), std::move(merged));
+    }
+    for(size_t s = 0; s < plan.slots.size(); s++)
+    {
+        for(const auto& name : plan.slots[s].models)
+        {
+            plan.assignment[name] = s;
+        }
+    }
+    DCHECK_LE(plan.Footprint(), plan.UniformFootprint());
+    return plan;
+}
+
+} // namespace TensorRT
+} // namespace trtlab
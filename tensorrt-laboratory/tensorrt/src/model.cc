@@ -40,6 +40,27 @@ using ::nvinfer1::IExecutionContext;
 
 namespace trtlab {
 namespace TensorRT {
+namespace {
+
+class TensorRTExecutor final : public IExecutor
+{
+  public:
+    TensorRTExecutor(std::shared_ptr<IExecutionContext> context) : m_Context(context) {}
+    ~TensorRTExecutor() final override {}
+
+    void SetWorkspace(void* workspace) final override { m_Context->setDeviceMemory(workspace); }
+
+    void Enqueue(Bindings& bindings) final override
+    {
+        m_Context->enqueue(bindings.BatchSize(), bindings.DeviceAddresses(), bindings.Stream(),
+                           nullptr);
+    }
+
+  private:
+    std::shared_ptr<IExecutionContext> m_Context;
+};
+
+} // namespace
 
 void BaseModel::AddBinding(TensorBindingInfo&& binding)
 {
@@ -143,6 +164,11 @@ auto Model::CreateExecutionContext() const -> std::shared_ptr<IExecutionContext>
                                         });
 }
 
+auto Model::CreateExecutor() const -> std::shared_ptr<IExecutor>
+{
+    return std::make_shared<TensorRTExecutor>(CreateExecutionContext());
+}
+
 void Model::AddWeights(void* ptr, size_t size) { m_Weights.push_back(Weights{ptr, size}); }
 
 void Model::PrefetchWeights(cudaStream_t stream) const
@@ -154,7 +180,7 @@ void Model::PrefetchWeights(cudaStream_t stream) const
     }
 }
 
-auto Model::GetWeightsMemorySize() const -> const size_t
+auto Model::GetWeightsMemorySize() const -> size_t
 {
     size_t total = 0;
     for(auto weights : m_Weights)
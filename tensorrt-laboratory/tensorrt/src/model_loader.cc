@@ -0,0 +1,152 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/model_loader.h"
+
+#include <dirent.h>
+
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/mapped_file.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+ModelLoader::ModelLoader(int threads, size_t max_mapped_bytes)
+    : m_MaxMappedBytes(max_mapped_bytes), m_MappedBytes(0), m_Workers(threads)
+{
+}
+
+ModelLoader::~ModelLoader() {}
+
+auto ModelLoader::Load(const FileMap& files, DeserializeFn deserialize) -> ModelMap
+{
+    std::vector<std::pair<std::string, std::future<std::shared_ptr<BaseModel>>>> futures;
+    for(const auto& item : files)
+    {
+        auto path = item.second;
+        size_t bytes;
+        try
+        {
+            bytes = MappedFile::FileSize(path);
+        } catch(...)
+        {
+            // recorded as the failure of this model; the other files are still loaded
+            std::promise<std::shared_ptr<BaseModel>> failed;
+            failed.set_exception(std::current_exception());
+            futures.emplace_back(item.first, failed.get_future());
+            continue;
+        }
+        // reserve on the calling thread so files are admitted in order
+        AcquireBytes(bytes);
+        futures.emplace_back(item.first, m_Workers.enqueue([this, path, bytes, deserialize] {
+            try
+            {
+                MappedFile file(path, MappedFile::Advice::Sequential);
+                file.Advise(MappedFile::Advice::WillNeed);
+                auto model = deserialize(file.Data(), file.Size());
+                file.Advise(MappedFile::Advice::DontNeed);
+                ReleaseBytes(bytes);
+                return model;
+            } catch(...)
+            {
+                ReleaseBytes(bytes);
+                throw;
+            }
+        }));
+    }
+
+    ModelMap models;
+    std::exception_ptr error;
+    for(auto& item : futures)
+    {
+        try
+        {
+            models[item.first] = item.second.get();
+            DLOG(INFO) << "Loaded model " << item.first;
+        } catch(...)
+        {
+            LOG(ERROR) << "Failed to load model " << item.first;
+            error = error ? error : std::current_exception();
+        }
+    }
+    if(error)
+    {
+        std::rethrow_exception(error);
+    }
+    return models;
+}
+
+auto ModelLoader::Load(const FileMap& files, std::shared_ptr<Runtime> runtime) -> ModelMap
+{
+    return Load(files, [runtime](const void* data, size_t size) -> std::shared_ptr<BaseModel> {
+        return runtime->DeserializeEngine(data, size);
+    });
+}
+
+auto ModelLoader::Directory(const std::string& path, const std::string& extension) -> FileMap
+{
+    FileMap files;
+    DIR* dir = opendir(path.c_str());
+    if(!dir)
+    {
+        throw std::runtime_error("Unable to open directory " + path);
+    }
+    while(auto entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if(name.size() > extension.size() &&
+           name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+        {
+            files[name.substr(0, name.size() - extension.size())] = path + "/" + name;
+        }
+    }
+    closedir(dir);
+    return files;
+}
+
+void ModelLoader::AcquireBytes(size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock, [this, bytes] {
+        return m_MappedBytes == 0 || m_MappedBytes + bytes <= m_MaxMappedBytes;
+    });
+    m_MappedBytes += bytes;
+}
+
+void ModelLoader::ReleaseBytes(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_MappedBytes -= bytes;
+    m_Condition.notify_all();
+}
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -0,0 +1,247 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/model_registry.h"
+
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+namespace TensorRT {
+
+std::shared_ptr<ModelRegistry> ModelRegistry::Create(size_t budget,
+                                                     std::shared_ptr<InferenceManager> resources)
+{
+    return std::shared_ptr<ModelRegistry>(new ModelRegistry(budget, resources));
+}
+
+ModelRegistry::ModelRegistry(size_t budget, std::shared_ptr<InferenceManager> resources)
+    : m_Budget(budget), m_Resident(0), m_Stats{0, 0, 0}, m_Resources(resources)
+{
+}
+
+ModelRegistry::~ModelRegistry() {}
+
+void ModelRegistry::Add(const std::string& name, Loader loader, size_t bytes,
+                        uint32_t max_concurrency)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    CHECK(m_Entries.find(name) == m_Entries.end()) << "Model " << name << " already added";
+    CHECK_LE(bytes, m_Budget) << "Model " << name << " exceeds the memory budget";
+    m_Entries[name] = Entry{loader, bytes, max_concurrency, nullptr, 0, false, false, m_LRU.end()};
+}
+
+void ModelRegistry::Pin(const std::string& name, bool pinned)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    GetEntry(name).pinned = pinned;
+    m_Condition.notify_all();
+}
+
+auto ModelRegistry::Acquire(const std::string& name) -> ModelHandle
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    auto& entry = GetEntry(name);
+    m_Condition.wait(lock, [&entry] { return !entry.loading; });
+    if(entry.model)
+    {
+        m_Stats.hits++;
+        return MakeHandle(name, entry);
+    }
+
+    // reserve the budget before loading; the size of unmeasured models is enforced after loading
+    const bool measure = (entry.bytes == 0);
+    MakeRoom(entry.bytes, name, lock);
+    m_Resident += entry.bytes;
+    entry.loading = true;
+    lock.unlock();
+
+    std::shared_ptr<BaseModel> model;
+    try
+    {
+        DLOG(INFO) << "Loading model " << name;
+        model = entry.loader();
+        if(!model)
+        {
+            throw std::runtime_error("Loader of model " + name + " did not return a model");
+        }
+        if(m_Resources)
+        {
+            entry.max_concurrency ? m_Resources->RegisterModel(name, model, entry.max_concurrency)
+                                  : m_Resources->RegisterModel(name, model);
+        }
+    } catch(...)
+    {
+        lock.lock();
+        m_Resident -= entry.bytes;
+        entry.loading = false;
+        DLOG(INFO) << "Failed to load model " << name;
+        m_Condition.notify_all();
+        throw;
+    }
+
+    lock.lock();
+    entry.loading = false;
+    entry.model = model;
+    entry.lru = m_LRU.insert(m_LRU.begin(), name);
+    m_Stats.loads++;
+    m_Condition.notify_all();
+    if(measure)
+    {
+        entry.bytes = model->GetWeightsMemorySize();
+        m_Resident += entry.bytes;
+        if(entry.bytes > m_Budget)
+        {
+            Evict(name, entry);
+            throw std::runtime_error("Model " + name + " of " + BytesToString(entry.bytes) +
+                                     " exceeds the memory budget of " + BytesToString(m_Budget));
+        }
+        try
+        {
+            MakeRoom(0, name, lock);
+        } catch(...)
+        {
+            Evict(name, entry);
+            throw;
+        }
+    }
+    return MakeHandle(name, entry);
+}
+
+bool ModelRegistry::IsLoaded(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto search = m_Entries.find(name);
+    return search != m_Entries.end() && search->second.model;
+}
+
+size_t ModelRegistry::Resident() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Resident;
+}
+
+auto ModelRegistry::GetStats() const -> Stats
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+auto ModelRegistry::GetEntry(const std::string& name) -> Entry&
+{
+    auto search = m_Entries.find(name);
+    CHECK(search != m_Entries.end()) << "Unable to find entry for model: " << name;
+    return search->second;
+}
+
+auto ModelRegistry::MakeHandle(const std::string& name, Entry& entry) -> ModelHandle
+{
+    entry.in_flight++;
+    Touch(entry);
+    // the handle aliases the model; it does not keep the registry, nor the InferenceManager the
+    // registry owns, alive, so the last handle may be released on any thread
+    std::weak_ptr<ModelRegistry> weak = shared_from_this();
+    auto model = entry.model;
+    return ModelHandle(model.get(), [weak, model, name](BaseModel*) {
+        if(auto registry = weak.lock())
+        {
+            registry->Release(name);
+        }
+    });
+}
+
+void ModelRegistry::Release(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& entry = GetEntry(name);
+    CHECK_GT(entry.in_flight, 0);
+    entry.in_flight--;
+    Touch(entry);
+    m_Condition.notify_all();
+}
+
+void ModelRegistry::Touch(Entry& entry)
+{
+    if(entry.model)
+    {
+        m_LRU.splice(m_LRU.begin(), m_LRU, entry.lru);
+    }
+}
+
+void ModelRegistry::MakeRoom(size_t bytes, const std::string& except,
+                             std::unique_lock<std::mutex>& lock)
+{
+    while(true)
+    {
+        size_t pinned = 0;
+        auto it = m_LRU.end();
+        while(m_Resident + bytes > m_Budget && it != m_LRU.begin())
+        {
+            --it;
+            auto& entry = GetEntry(*it);
+            if(*it == except || entry.pinned || entry.in_flight)
+            {
+                // a measured model is resident while making room for it; it counts as pinned
+                pinned += (entry.pinned || *it == except ? entry.bytes : 0);
+                continue;
+            }
+            // erasing invalidates only the evicted element
+            auto evicted = it++;
+            Evict(*evicted, entry);
+        }
+        if(m_Resident + bytes <= m_Budget)
+        {
+            return;
+        }
+        if(pinned + bytes > m_Budget)
+        {
+            throw std::runtime_error("Unable to fit model " + except + " in the memory budget of " +
+                                     BytesToString(m_Budget) + " next to the pinned models");
+        }
+        // the remaining models are in use or loading; wait for one of them to be released
+        DLOG(INFO) << "Waiting on an idle model to make room for " << except;
+        m_Condition.wait(lock);
+    }
+}
+
+void ModelRegistry::Evict(const std::string& name, Entry& entry)
+{
+    DLOG(INFO) << "Evicting model " << name;
+    CHECK_EQ(entry.in_flight, 0);
+    if(m_Resources)
+    {
+        m_Resources->UnregisterModel(name);
+    }
+    m_LRU.erase(entry.lru);
+    entry.lru = m_LRU.end();
+    entry.model.reset();
+    m_Resident -= entry.bytes;
+    m_Stats.evictions++;
+}
+
+} // namespace TensorRT
+} // namespace trtlab
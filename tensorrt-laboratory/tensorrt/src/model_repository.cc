@@ -0,0 +1,935 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/model_repository.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+namespace trtlab {
+namespace TensorRT {
+
+namespace {
+
+/**
+ * @brief Keeps a version registered with the InferenceManager while its model is in use
+ */
+struct Registration
+{
+    ~Registration()
+    {
+        if(auto resources = this->resources.lock())
+        {
+            resources->UnregisterModel(name);
+        }
+    }
+
+    std::string name;
+    std::shared_ptr<BaseModel> model;
+    std::weak_ptr<InferenceManager> resources;
+};
+
+/**
+ * @brief Generic message of the protobuf text format: an ordered list of named fields, each a
+ * scalar or a nested message; list values ([a, b]) are expanded into repeated fields.
+ */
+struct TextMessage
+{
+    struct Field
+    {
+        std::string scalar;
+        std::shared_ptr<TextMessage> message;
+    };
+
+    std::vector<std::string> Scalars(const std::string& name) const
+    {
+        std::vector<std::string> values;
+        for(const auto& field : fields)
+        {
+            if(field.first == name && !field.second.message)
+            {
+                values.push_back(field.second.scalar);
+            }
+        }
+        return values;
+    }
+
+    std::vector<const TextMessage*> Messages(const std::string& name) const
+    {
+        std::vector<const TextMessage*> values;
+        for(const auto& field : fields)
+        {
+            if(field.first == name && field.second.message)
+            {
+                values.push_back(field.second.message.get());
+            }
+        }
+        return values;
+    }
+
+    bool Has(const std::string& name) const
+    {
+        return std::any_of(fields.begin(), fields.end(),
+                           [&name](const auto& field) { return field.first == name; });
+    }
+
+    std::vector<std::pair<std::string, Field>> fields;
+};
+
+class TextParser
+{
+  public:
+    TextParser(const std::string& text) : m_Text(text), m_Pos(0) {}
+
+    std::shared_ptr<TextMessage> Parse()
+    {
+        auto message = ParseMessage("");
+        if(!Peek().empty())
+        {
+            Error("unexpected '" + Peek() + "'");
+        }
+        return message;
+    }
+
+  private:
+    std::shared_ptr<TextMessage> ParseMessage(const std::string& end)
+    {
+        auto message = std::make_shared<TextMessage>();
+        for(auto token = Peek(); token != end; token = Peek())
+        {
+            if(token.empty())
+            {
+                Error("missing '" + end + "'");
+            }
+            auto name = Next();
+            if(!IsScalar(name))
+            {
+                Error("expected a field name; got '" + name + "'");
+            }
+            if(Peek() == ":")
+            {
+                Next();
+            }
+            if(Peek() == "[")
+            {
+                Next();
+                while(Peek() != "]")
+                {
+                    message->fields.emplace_back(name, ParseValue());
+                    if(Peek() == ",")
+                    {
+                        Next();
+                    }
+                    else if(Peek() != "]")
+                    {
+                        Error("expected ',' or ']'");
+                    }
+                }
+                Next();
+            }
+            else
+            {
+                message->fields.emplace_back(name, ParseValue());
+            }
+            if(Peek() == "," || Peek() == ";")
+            {
+                Next();
+            }
+        }
+        return message;
+    }
+
+    TextMessage::Field ParseValue()
+    {
+        TextMessage::Field field;
+        auto token = Next();
+        if(token == "{" || token == "<")
+        {
+            field.message = ParseMessage(token == "{" ? "}" : ">");
+            Next();
+        }
+        else if(!token.empty() && (token[0] == '"' || token[0] == '\''))
+        {
+            field.scalar = token.substr(1);
+        }
+        else if(IsScalar(token))
+        {
+            field.scalar = token;
+        }
+        else
+        {
+            Error("expected a value; got '" + token + "'");
+        }
+        return field;
+    }
+
+    static bool IsScalar(const std::string& token)
+    {
+        return !token.empty() && (std::isalnum(token[0]) || token[0] == '_' ||
+                                  token[0] == '-' || token[0] == '+' || token[0] == '.');
+    }
+
+    const std::string& Peek()
+    {
+        if(m_Peeked.empty() && m_Pos < m_Text.size())
+        {
+            m_Peeked = Tokenize();
+        }
+        return m_Peeked;
+    }
+
+    std::string Next()
+    {
+        auto token = Peek();
+        m_Peeked.clear();
+        return token;
+    }
+
+    // strings are returned with their opening quote and without escapes
+    std::string Tokenize()
+    {
+        while(m_Pos < m_Text.size())
+        {
+            if(std::isspace(m_Text[m_Pos]))
+            {
+                m_Pos++;
+            }
+            else if(m_Text[m_Pos] == '#')
+            {
+                m_Pos = std::min(m_Text.find('\n', m_Pos), m_Text.size());
+            }
+            else
+            {
+                break;
+            }
+        }
+        if(m_Pos == m_Text.size())
+        {
+            return "";
+        }
+
+        auto c = m_Text[m_Pos];
+        if(c == '"' || c == '\'')
+        {
+            std::string token(1, c);
+            for(m_Pos++; m_Pos < m_Text.size() && m_Text[m_Pos] != c; m_Pos++)
+            {
+                if(m_Text[m_Pos] == '\\' && m_Pos + 1 < m_Text.size())
+                {
+                    m_Pos++;
+                }
+                token += m_Text[m_Pos];
+            }
+            if(m_Pos++ == m_Text.size())
+            {
+                Error("unterminated string");
+            }
+            return token;
+        }
+        if(IsScalar(std::string(1, c)))
+        {
+            auto start = m_Pos;
+            while(m_Pos < m_Text.size() && (std::isalnum(m_Text[m_Pos]) || m_Text[m_Pos] == '_' ||
+                                            m_Text[m_Pos] == '-' || m_Text[m_Pos] == '+' ||
+                                            m_Text[m_Pos] == '.'))
+            {
+                m_Pos++;
+            }
+            return m_Text.substr(start, m_Pos - start);
+        }
+        m_Pos++;
+        return std::string(1, c);
+    }
+
+    [[noreturn]] void Error(const std::string& msg) const
+    {
+        auto line = std::count(m_Text.begin(), m_Text.begin() + m_Pos, '\n') + 1;
+        throw std::runtime_error("config line " + std::to_string(line) + ": " + msg);
+    }
+
+    const std::string& m_Text;
+    size_t m_Pos;
+    std::string m_Peeked;
+};
+
+int64_t ToInt(const std::string& value)
+{
+    try
+    {
+        size_t end;
+        auto i = std::stoll(value, &end, 0);
+        if(end == value.size())
+        {
+            return i;
+        }
+    } catch(const std::exception&)
+    {
+    }
+    throw std::runtime_error("expected an integer; got '" + value + "'");
+}
+
+/**
+ * @brief Throws on fields that model_config.proto does not declare for the message, so that
+ * misspelled settings are not silently replaced by their defaults
+ */
+void CheckFields(const TextMessage& message, const std::string& type,
+                 const std::set<std::string>& names)
+{
+    for(const auto& field : message.fields)
+    {
+        if(names.count(field.first) == 0)
+        {
+            throw std::runtime_error(type + " has no field " + field.first);
+        }
+    }
+}
+
+std::string GetString(const TextMessage& message, const std::string& name)
+{
+    auto values = message.Scalars(name);
+    return values.empty() ? "" : values.back();
+}
+
+int64_t GetInt(const TextMessage& message, const std::string& name, int64_t default_value = 0)
+{
+    auto values = message.Scalars(name);
+    return values.empty() ? default_value : ToInt(values.back());
+}
+
+uint32_t GetUnsigned(const TextMessage& message, const std::string& name, uint32_t default_value)
+{
+    auto value = GetInt(message, name, default_value);
+    if(value < 0 || value > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::runtime_error(name + " " + std::to_string(value) + " is out of range");
+    }
+    return static_cast<uint32_t>(value);
+}
+
+std::vector<int64_t> GetInts(const TextMessage& message, const std::string& name)
+{
+    std::vector<int64_t> values;
+    for(const auto& value : message.Scalars(name))
+    {
+        values.push_back(ToInt(value));
+    }
+    return values;
+}
+
+std::vector<ModelConfig::Tensor> GetTensors(const TextMessage& message, const std::string& name,
+                                            const std::string& type,
+                                            const std::set<std::string>& fields)
+{
+    std::vector<ModelConfig::Tensor> tensors;
+    for(const auto* tensor : message.Messages(name))
+    {
+        CheckFields(*tensor, type, fields);
+        tensors.push_back({GetString(*tensor, "name"), GetString(*tensor, "data_type"),
+                           GetInts(*tensor, "dims")});
+    }
+    return tensors;
+}
+
+bool DataTypeMatches(const std::string& data_type, nvinfer1::DataType dtype)
+{
+    static const std::map<std::string, nvinfer1::DataType> types = {
+        {"TYPE_FP32", nvinfer1::DataType::kFLOAT},
+        {"TYPE_FP16", nvinfer1::DataType::kHALF},
+        {"TYPE_INT8", nvinfer1::DataType::kINT8},
+        {"TYPE_INT32", nvinfer1::DataType::kINT32},
+    };
+    auto search = types.find(data_type);
+    if(search == types.end())
+    {
+        throw std::runtime_error("data_type " + data_type + " is not supported by TensorRT");
+    }
+    return search->second == dtype;
+}
+
+bool Stat(const std::string& path, struct stat* info)
+{
+    return stat(path.c_str(), info) == 0;
+}
+
+int64_t ModifiedTime(const struct stat& info)
+{
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+std::vector<std::string> Subdirectories(const std::string& path)
+{
+    auto dir = opendir(path.c_str());
+    if(dir == nullptr)
+    {
+        throw std::runtime_error("Unable to open model repository " + path);
+    }
+    std::vector<std::string> names;
+    while(auto entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        struct stat info;
+        if(name[0] != '.' && Stat(path + "/" + name, &info) && S_ISDIR(info.st_mode))
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+} // namespace
+
+// ModelConfig
+
+ModelConfig ModelConfig::Parse(const std::string& text)
+{
+    auto message = TextParser(text).Parse();
+    CheckFields(*message, "ModelConfig",
+                {"name", "platform", "version_policy", "max_batch_size", "input", "output",
+                 "instance_group", "default_model_filename", "cc_model_filenames",
+                 "dynamic_batching"});
+
+    ModelConfig config;
+    config.name = GetString(*message, "name");
+    config.platform = GetString(*message, "platform");
+    config.max_batch_size = GetInt(*message, "max_batch_size");
+    config.inputs =
+        GetTensors(*message, "input", "ModelInput", {"name", "data_type", "format", "dims"});
+    config.outputs = GetTensors(*message, "output", "ModelOutput",
+                                {"name", "data_type", "dims", "label_filename"});
+    config.default_model_filename = GetString(*message, "default_model_filename");
+
+    for(const auto* group : message->Messages("instance_group"))
+    {
+        CheckFields(*group, "ModelInstanceGroup", {"name", "kind", "count", "gpus"});
+        config.instance_count += GetUnsigned(*group, "count", 1);
+    }
+
+    for(const auto* policy : message->Messages("version_policy"))
+    {
+        CheckFields(*policy, "ModelVersionPolicy", {"latest", "all", "specific"});
+        for(const auto* latest : policy->Messages("latest"))
+        {
+            CheckFields(*latest, "ModelVersionPolicy.Latest", {"num_versions"});
+            config.version_policy = VersionPolicy::kLatest;
+            config.num_versions = GetUnsigned(*latest, "num_versions", 1);
+        }
+        for(const auto* all : policy->Messages("all"))
+        {
+            CheckFields(*all, "ModelVersionPolicy.All", {});
+        }
+        if(policy->Has("all"))
+        {
+            config.version_policy = VersionPolicy::kAll;
+        }
+        for(const auto* specific : policy->Messages("specific"))
+        {
+            CheckFields(*specific, "ModelVersionPolicy.Specific", {"versions"});
+            config.version_policy = VersionPolicy::kSpecific;
+            config.versions = GetInts(*specific, "versions");
+        }
+    }
+
+    for(const auto* batching : message->Messages("dynamic_batching"))
+    {
+        CheckFields(*batching, "ModelDynamicBatching",
+                    {"preferred_batch_size", "max_queue_delay_microseconds"});
+        config.dynamic_batching = true;
+        config.batching.max_batch_size = std::max(config.max_batch_size, 1);
+        config.batching.max_queue_delay =
+            std::chrono::microseconds(GetInt(*batching, "max_queue_delay_microseconds"));
+        for(auto size : GetInts(*batching, "preferred_batch_size"))
+        {
+            config.batching.preferred_batch_sizes.push_back(size);
+        }
+    }
+    return config;
+}
+
+ModelConfig ModelConfig::ParseFile(const std::string& path)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        throw std::runtime_error("Unable to read " + path);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    try
+    {
+        return Parse(text.str());
+    } catch(const std::exception& e)
+    {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+void ModelConfig::Validate(const BaseModel& model) const
+{
+    auto error = [this](const std::string& msg) {
+        throw std::runtime_error("model " + name + ": " + msg);
+    };
+
+    if(!platform.empty() && platform != "tensorrt_plan")
+    {
+        error("platform " + platform + " is not supported");
+    }
+    if(max_batch_size < 0 || max_batch_size > model.GetMaxBatchSize())
+    {
+        error("max_batch_size " + std::to_string(max_batch_size) +
+              " exceeds the max batch size of the engine (" +
+              std::to_string(model.GetMaxBatchSize()) + ")");
+    }
+    if(inputs.empty() && outputs.empty())
+    {
+        return;
+    }
+    if(inputs.size() != model.GetInputBindingCount() ||
+       outputs.size() != model.GetOutputBindingCount())
+    {
+        error("config has " + std::to_string(inputs.size()) + " inputs and " +
+              std::to_string(outputs.size()) + " outputs; the engine has " +
+              std::to_string(model.GetInputBindingCount()) + " and " +
+              std::to_string(model.GetOutputBindingCount()));
+    }
+
+    auto check = [&model, &error](const Tensor& tensor, BaseModel::BindingType type) {
+        if(model.GetBindingType(tensor.name) != type)
+        {
+            error("engine has no " +
+                  std::string(type == BaseModel::BindingType::Input ? "input" : "output") +
+                  " binding " + tensor.name);
+        }
+        const auto& binding = model.GetBinding(model.BindingId(tensor.name));
+        if(!DataTypeMatches(tensor.data_type, binding.dtype))
+        {
+            error("data_type of " + tensor.name + " does not match the engine");
+        }
+        bool dims = tensor.dims.size() == binding.dims.size();
+        for(size_t i = 0; dims && i < tensor.dims.size(); i++)
+        {
+            dims = tensor.dims[i] == -1 || tensor.dims[i] == static_cast<int64_t>(binding.dims[i]);
+        }
+        if(!dims)
+        {
+            error("dims of " + tensor.name + " do not match the engine");
+        }
+    };
+    for(const auto& tensor : inputs)
+    {
+        check(tensor, BaseModel::BindingType::Input);
+    }
+    for(const auto& tensor : outputs)
+    {
+        check(tensor, BaseModel::BindingType::Output);
+    }
+}
+
+// ModelRepository
+
+ModelRepository::ModelRepository(const std::string& path,
+                                 std::shared_ptr<InferenceManager> resources, ModelFactory factory)
+    : m_Path(path), m_Resources(resources), m_Factory(factory), m_Watching(false)
+{
+}
+
+ModelRepository::ModelRepository(const std::string& path,
+                                 std::shared_ptr<InferenceManager> resources,
+                                 std::shared_ptr<Runtime> runtime)
+    : ModelRepository(path, resources, [runtime](const std::string& file) {
+          return std::shared_ptr<BaseModel>(runtime->DeserializeEngine(file));
+      })
+{
+}
+
+ModelRepository::~ModelRepository() { StopWatching(); }
+
+std::string ModelRepository::RegisteredName(const std::string& model, int64_t version)
+{
+    return model + "/" + std::to_string(version);
+}
+
+void ModelRepository::Poll()
+{
+    std::lock_guard<std::mutex> poll_lock(m_PollMutex);
+
+    // selected versions of the valid models: model -> (config, version -> file)
+    std::map<std::string, std::pair<ModelConfig, std::map<int64_t, std::string>>> selected;
+    // models whose config can not be read keep their loaded versions
+    std::set<std::string> keep;
+
+    for(const auto& model : Subdirectories(m_Path))
+    {
+        auto dir = m_Path + "/" + model;
+        auto config_path = dir + "/config.pbtxt";
+        struct stat info;
+        if(!Stat(config_path, &info))
+        {
+            DLOG(INFO) << "Skipping " << dir << "; no config.pbtxt";
+            continue;
+        }
+        if(Failed(config_path, ModifiedTime(info)))
+        {
+            keep.insert(model);
+            continue;
+        }
+
+        ModelConfig config;
+        try
+        {
+            config = ModelConfig::ParseFile(config_path);
+            if(config.name.empty())
+            {
+                config.name = model;
+            }
+            if(config.name != model)
+            {
+                throw std::runtime_error(config_path + ": name " + config.name +
+                                         " does not match the directory");
+            }
+        } catch(const std::exception& e)
+        {
+            LOG(ERROR) << "Invalid model config: " << e.what();
+            m_Failures[config_path] = ModifiedTime(info);
+            keep.insert(model);
+            continue;
+        }
+        m_Failures.erase(config_path);
+
+        auto filename =
+            config.default_model_filename.empty() ? "model.plan" : config.default_model_filename;
+        std::map<int64_t, std::string> available;
+        for(const auto& version : Subdirectories(dir))
+        {
+            auto file = dir + "/" + version + "/" + filename;
+            if(std::all_of(version.begin(), version.end(), ::isdigit) && Stat(file, &info))
+            {
+                available[std::stoll(version)] = file;
+            }
+        }
+
+        auto& versions = selected[model];
+        versions.first = config;
+        if(config.version_policy == ModelConfig::VersionPolicy::kLatest)
+        {
+            auto count = std::max<uint32_t>(config.num_versions, 1);
+            for(auto it = available.rbegin(); it != available.rend() && count; it++, count--)
+            {
+                versions.second.insert(*it);
+            }
+        }
+        else
+        {
+            for(const auto& version : available)
+            {
+                if(config.version_policy == ModelConfig::VersionPolicy::kAll ||
+                   std::count(config.versions.begin(), config.versions.end(), version.first))
+                {
+                    versions.second.insert(version);
+                }
+            }
+        }
+    }
+
+    // load the new versions before unloading the versions they replace
+    for(const auto& item : selected)
+    {
+        for(const auto& version : item.second.second)
+        {
+            const auto& file = version.second;
+            bool loaded = false;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                auto search = m_Models.find(item.first);
+                loaded = search != m_Models.end() && search->second.versions.count(version.first);
+            }
+            struct stat info;
+            if(!loaded && !Unloading(RegisteredName(item.first, version.first)) &&
+               Stat(file, &info) && !Failed(file, ModifiedTime(info)))
+            {
+                try
+                {
+                    Load(item.first, item.second.first, version.first, file);
+                    m_Failures.erase(file);
+                    loaded = true;
+                } catch(const std::exception& e)
+                {
+                    LOG(ERROR) << "Unable to load version " << version.first << " of model "
+                               << item.first << ": " << e.what();
+                    m_Failures[file] = ModifiedTime(info);
+                }
+            }
+            if(!loaded)
+            {
+                // keep serving the loaded versions until all selected versions load
+                keep.insert(item.first);
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, int64_t>> unload;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for(auto& item : m_Models)
+        {
+            auto search = selected.find(item.first);
+            if(search != selected.end())
+            {
+                item.second.config = search->second.first;
+            }
+            if(keep.count(item.first))
+            {
+                continue;
+            }
+            for(const auto& version : item.second.versions)
+            {
+                if(search == selected.end() || search->second.second.count(version.first) == 0)
+                {
+                    unload.emplace_back(item.first, version.first);
+                }
+            }
+        }
+    }
+    for(const auto& version : unload)
+    {
+        Unload(version.first, version.second);
+    }
+
+    // forget failures of files that were removed
+    for(auto it = m_Failures.begin(); it != m_Failures.end();)
+    {
+        struct stat info;
+        it = Stat(it->first, &info) ? std::next(it) : m_Failures.erase(it);
+    }
+    for(auto it = m_Unloaded.begin(); it != m_Unloaded.end();)
+    {
+        it = it->second.expired() ? m_Unloaded.erase(it) : std::next(it);
+    }
+}
+
+bool ModelRepository::Failed(const std::string& path, int64_t mtime)
+{
+    auto search = m_Failures.find(path);
+    return search != m_Failures.end() && search->second == mtime;
+}
+
+bool ModelRepository::Unloading(const std::string& name)
+{
+    auto search = m_Unloaded.find(name);
+    return search != m_Unloaded.end() && !search->second.expired();
+}
+
+void ModelRepository::Load(const std::string& model, const ModelConfig& config, int64_t version,
+                           const std::string& path)
+{
+    auto instance = m_Factory(path);
+    if(!instance)
+    {
+        throw std::runtime_error("no model was deserialized from " + path);
+    }
+    config.Validate(*instance);
+
+    auto registration = std::make_shared<Registration>();
+    registration->name = RegisteredName(model, version);
+    registration->model = instance;
+    if(m_Resources)
+    {
+        if(config.instance_count)
+        {
+            m_Resources->RegisterModel(registration->name, instance, config.instance_count);
+        }
+        else
+        {
+            m_Resources->RegisterModel(registration->name, instance);
+        }
+        registration->resources = m_Resources;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& entry = m_Models[model];
+    entry.config = config;
+    entry.versions[version] =
+        Version{config, std::shared_ptr<BaseModel>(registration, instance.get()), nullptr};
+    LOG(INFO) << "Loaded version " << version << " of model " << model << " from " << path;
+}
+
+void ModelRepository::Unload(const std::string& model, int64_t version)
+{
+    Version unloaded;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto& entry = m_Models.at(model);
+        unloaded = std::move(entry.versions.at(version));
+        entry.versions.erase(version);
+        if(entry.versions.empty())
+        {
+            m_Models.erase(model);
+        }
+    }
+    m_Unloaded[RegisteredName(model, version)] = unloaded.model;
+    // the batcher holds the model; it is flushed before the model leaves the InferenceManager,
+    // which happens here unless requests or callers still hold the version
+    unloaded.batcher.reset();
+    unloaded.model.reset();
+    LOG(INFO) << "Unloaded version " << version << " of model " << model;
+}
+
+void ModelRepository::Watch(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(m_WatchMutex);
+    if(m_Watching)
+    {
+        return;
+    }
+    m_Watching = true;
+    m_Watcher = std::thread([this, interval] {
+        std::unique_lock<std::mutex> lock(m_WatchMutex);
+        while(!m_WatchCondition.wait_for(lock, interval, [this] { return !m_Watching; }))
+        {
+            lock.unlock();
+            try
+            {
+                Poll();
+            } catch(const std::exception& e)
+            {
+                LOG(ERROR) << "Model repository poll failed: " << e.what();
+            }
+            lock.lock();
+        }
+    });
+}
+
+void ModelRepository::StopWatching()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WatchMutex);
+        m_Watching = false;
+    }
+    m_WatchCondition.notify_all();
+    if(m_Watcher.joinable())
+    {
+        m_Watcher.join();
+    }
+}
+
+std::vector<std::string> ModelRepository::Models() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<std::string> models;
+    for(const auto& item : m_Models)
+    {
+        models.push_back(item.first);
+    }
+    return models;
+}
+
+std::vector<int64_t> ModelRepository::Versions(const std::string& model) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<int64_t> versions;
+    auto search = m_Models.find(model);
+    if(search != m_Models.end())
+    {
+        for(const auto& version : search->second.versions)
+        {
+            versions.push_back(version.first);
+        }
+    }
+    return versions;
+}
+
+ModelConfig ModelRepository::GetConfig(const std::string& model) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto search = m_Models.find(model);
+    if(search == m_Models.end())
+    {
+        throw std::runtime_error("Model " + model + " is not loaded");
+    }
+    return search->second.config;
+}
+
+auto ModelRepository::GetVersion(const std::string& model, int64_t version) -> Version&
+{
+    auto search = m_Models.find(model);
+    if(search == m_Models.end())
+    {
+        throw std::runtime_error("Model " + model + " is not loaded");
+    }
+    auto& versions = search->second.versions;
+    auto item = version == kLatest ? std::prev(versions.end()) : versions.find(version);
+    if(item == versions.end())
+    {
+        throw std::runtime_error("Version " + std::to_string(version) + " of model " + model +
+                                 " is not loaded");
+    }
+    return item->second;
+}
+
+auto ModelRepository::GetVersion(const std::string& model, int64_t version) const
+    -> const Version&
+{
+    return const_cast<ModelRepository*>(this)->GetVersion(model, version);
+}
+
+std::shared_ptr<BaseModel> ModelRepository::GetModel(const std::string& model,
+                                                     int64_t version) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return GetVersion(model, version).model;
+}
+
+std::shared_ptr<DynamicBatcher> ModelRepository::GetBatcher(const std::string& model,
+                                                            int64_t version)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto& entry = GetVersion(model, version);
+    if(!entry.config.dynamic_batching)
+    {
+        return nullptr;
+    }
+    if(!entry.batcher)
+    {
+        CHECK(m_Resources) << "DynamicBatcher requires an InferenceManager";
+        entry.batcher =
+            std::make_shared<DynamicBatcher>(entry.model, m_Resources, entry.config.batching);
+    }
+    return entry.batcher;
+}
+
+} // namespace TensorRT
+} // namespace trtlab
@@ -34,6 +34,8 @@
 
 #include <glog/logging.h>
 
+#include "tensorrt/laboratory/core/mapped_file.h"
+
 namespace trtlab {
 namespace TensorRT {
 
@@ -50,17 +52,24 @@ Runtime::~Runtime() { DLOG(INFO) << "Destorying Runtime " << this; }
 
 std::shared_ptr<Model> Runtime::DeserializeEngine(const std::string& plan_file)
 {
-    DLOG(INFO) << "Deserializing TensorRT ICudaEngine from file: " << plan_file;
-    const auto& buffer = ReadEngineFile(plan_file);
-    return DeserializeEngine(buffer.data(), buffer.size(), nullptr);
+    return DeserializeEngine(plan_file, nullptr);
 }
 
+/**
+ * @brief Deserialize an engine from a memory mapping of the file
+ *
+ * The plan is read through the page cache rather than copied into a private buffer, so peak host
+ * memory is not doubled; the pages are released once the engine has been deserialized.
+ */
 std::shared_ptr<Model> Runtime::DeserializeEngine(const std::string& plan_file,
                                                   ::nvinfer1::IPluginFactory* plugin_factory)
 {
     DLOG(INFO) << "Deserializing TensorRT ICudaEngine from file: " << plan_file;
-    const auto& buffer = ReadEngineFile(plan_file);
-    return DeserializeEngine(buffer.data(), buffer.size(), plugin_factory);
+    MappedFile file(plan_file, MappedFile::Advice::Sequential);
+    file.Advise(MappedFile::Advice::WillNeed);
+    auto model = DeserializeEngine(file.Data(), file.Size(), plugin_factory);
+    file.Advise(MappedFile::Advice::DontNeed);
+    return model;
 }
 
 std::shared_ptr<Model> Runtime::DeserializeEngine(const void* data, size_t size)
@@ -0,0 +1,399 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/sequence_batcher.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include "tensorrt/laboratory/core/profiler.h"
+
+namespace trtlab {
+namespace TensorRT {
+
+SequenceBatcher::SequenceBatcher(std::shared_ptr<BaseModel> model,
+                                 std::shared_ptr<InferenceManager> resources,
+                                 SequenceBatchingPolicy policy)
+    : m_Model(model), m_Resources(resources), m_Policy(policy), m_Runner(model, resources),
+      m_InFlight(false), m_Shutdown(false), m_Stats{0, 0, 0, 0, 0, 0, 0}
+{
+    uint32_t model_max = m_Model->GetMaxBatchSize();
+    m_MaxSequences = m_Policy.max_sequences ? std::min(m_Policy.max_sequences, model_max)
+                                            : model_max;
+    CHECK_GT(m_MaxSequences, 0);
+    m_Slots.resize(m_MaxSequences, 0);
+    m_SlotUsed.resize(m_MaxSequences, false);
+
+    auto control = [this](const std::string& name) -> int {
+        if(name.empty() || m_Model->GetBindingType(name) != BaseModel::BindingType::Input)
+        {
+            return -1;
+        }
+        auto id = m_Model->BindingId(name);
+        auto dtype = m_Model->GetBinding(id).dtype;
+        CHECK(dtype == nvinfer1::DataType::kFLOAT || dtype == nvinfer1::DataType::kINT32 ||
+              dtype == nvinfer1::DataType::kINT8)
+            << "Unsupported data type of control input " << name;
+        return id;
+    };
+    m_StartInput = control(m_Policy.start_input);
+    m_EndInput = control(m_Policy.end_input);
+    m_ReadyInput = control(m_Policy.ready_input);
+    m_CorrelationIdInput = control(m_Policy.correlation_id_input);
+
+    LOG(INFO) << "SequenceBatcher for model " << m_Model->Name()
+              << "; max sequences: " << m_MaxSequences
+              << "; max queue delay: " << m_Policy.max_queue_delay.count() << "us"
+              << "; idle timeout: " << m_Policy.idle_timeout.count() << "us";
+
+    m_Thread = std::thread([this] { BatchingLoop(); });
+}
+
+SequenceBatcher::~SequenceBatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Shutdown = true;
+    }
+    m_Condition.notify_all();
+    m_Thread.join();
+
+    // the step in flight holds a pointer to this object and to m_Runner
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock, [this] { return !m_InFlight; });
+    if(!m_Waiting.empty())
+    {
+        LOG(WARNING) << "SequenceBatcher dropped " << m_Waiting.size()
+                     << " sequences waiting for a slot";
+    }
+}
+
+void SequenceBatcher::Enqueue(uint64_t correlation_id, uint32_t flags, PreFn pre,
+                              std::function<void(BatchItem&)> post)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        CHECK(!m_Shutdown) << "SequenceBatcher is shutting down";
+        auto now = std::chrono::steady_clock::now();
+        bool start = flags & kStart;
+        auto search = m_Sequences.find(correlation_id);
+        if(search == m_Sequences.end())
+        {
+            if(!start)
+            {
+                throw std::runtime_error("Sequence " + std::to_string(correlation_id) +
+                                         " has not been started");
+            }
+            search = m_Sequences.emplace(correlation_id, Sequence{-1, {}, now, false}).first;
+            m_Waiting.push_back(correlation_id);
+        }
+        else if(start != search->second.ending)
+        {
+            throw std::runtime_error("Sequence " + std::to_string(correlation_id) +
+                                     (start ? " is still active" : " has ended"));
+        }
+        auto& sequence = search->second;
+        sequence.ending = flags & kEnd;
+        sequence.queue.push_back(Request{flags, std::move(pre), std::move(post), now});
+        m_Stats.requests++;
+        m_Stats.sequences_started += start;
+        AssignSlots();
+    }
+    m_Condition.notify_all();
+}
+
+auto SequenceBatcher::GetStats() const -> Stats
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto stats = m_Stats;
+    stats.waiting_sequences = m_Waiting.size();
+    stats.active_sequences = std::count(m_SlotUsed.begin(), m_SlotUsed.end(), true);
+    return stats;
+}
+
+int SequenceBatcher::Slot(uint64_t correlation_id) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto search = m_Sequences.find(correlation_id);
+    return search == m_Sequences.end() ? -1 : search->second.slot;
+}
+
+void SequenceBatcher::AssignSlots()
+{
+    auto now = std::chrono::steady_clock::now();
+    for(uint32_t slot = 0; slot < m_MaxSequences && !m_Waiting.empty(); slot++)
+    {
+        if(m_SlotUsed[slot])
+        {
+            continue;
+        }
+        auto correlation_id = m_Waiting.front();
+        m_Waiting.pop_front();
+        auto& sequence = m_Sequences.at(correlation_id);
+        sequence.slot = slot;
+        sequence.last_active = now;
+        m_Slots[slot] = correlation_id;
+        m_SlotUsed[slot] = true;
+        DLOG(INFO) << "Sequence " << correlation_id << " assigned to slot " << slot;
+    }
+}
+
+void SequenceBatcher::ReleaseSlot(uint64_t correlation_id)
+{
+    auto search = m_Sequences.find(correlation_id);
+    auto& sequence = search->second;
+    m_SlotUsed[sequence.slot] = false;
+    DLOG(INFO) << "Sequence " << correlation_id << " released slot " << sequence.slot;
+    if(sequence.queue.empty())
+    {
+        m_Sequences.erase(search);
+        return;
+    }
+    // the correlation id was reused by a new sequence queued after the end of this one
+    sequence.slot = -1;
+    m_Waiting.push_back(correlation_id);
+}
+
+auto SequenceBatcher::ReclaimIdle(std::chrono::steady_clock::time_point now)
+    -> std::chrono::steady_clock::time_point
+{
+    auto next = std::chrono::steady_clock::time_point::max();
+    bool released = false;
+    for(uint32_t slot = 0; slot < m_MaxSequences; slot++)
+    {
+        if(!m_SlotUsed[slot])
+        {
+            continue;
+        }
+        auto& sequence = m_Sequences.at(m_Slots[slot]);
+        if(!sequence.queue.empty())
+        {
+            continue;
+        }
+        auto expiry = sequence.last_active + m_Policy.idle_timeout;
+        if(expiry > now)
+        {
+            next = std::min(next, expiry);
+            continue;
+        }
+        LOG(WARNING) << "Sequence " << m_Slots[slot] << " timed out; reclaiming slot " << slot;
+        m_Stats.sequences_timed_out++;
+        ReleaseSlot(m_Slots[slot]);
+        released = true;
+    }
+    if(released)
+    {
+        AssignSlots();
+    }
+    return next;
+}
+
+bool SequenceBatcher::AnyQueued() const
+{
+    for(uint32_t slot = 0; slot < m_MaxSequences; slot++)
+    {
+        if(m_SlotUsed[slot] && !m_Sequences.at(m_Slots[slot]).queue.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SequenceBatcher::AllActiveQueued() const
+{
+    for(uint32_t slot = 0; slot < m_MaxSequences; slot++)
+    {
+        if(m_SlotUsed[slot] && m_Sequences.at(m_Slots[slot]).queue.empty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SequenceBatcher::BatchingLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    while(true)
+    {
+        auto expiry = ReclaimIdle(std::chrono::steady_clock::now());
+        if(!AnyQueued())
+        {
+            if(m_Shutdown)
+            {
+                DLOG(INFO) << "SequenceBatcher drained; exiting batching loop";
+                return;
+            }
+            auto woken = [this] { return m_Shutdown || AnyQueued(); };
+            if(expiry == std::chrono::steady_clock::time_point::max())
+            {
+                m_Condition.wait(lock, woken);
+            }
+            else
+            {
+                m_Condition.wait_until(lock, expiry, woken);
+            }
+            continue;
+        }
+
+        // wait for the other active sequences to queue their next request
+        auto oldest = std::chrono::steady_clock::time_point::max();
+        for(uint32_t slot = 0; slot < m_MaxSequences; slot++)
+        {
+            if(!m_SlotUsed[slot])
+            {
+                continue;
+            }
+            const auto& queue = m_Sequences.at(m_Slots[slot]).queue;
+            if(!queue.empty())
+            {
+                oldest = std::min(oldest, queue.front().enqueued);
+            }
+        }
+        m_Condition.wait_until(lock, oldest + m_Policy.max_queue_delay,
+                               [this] { return m_Shutdown || AllActiveQueued(); });
+
+        // steps are executed in order; the state of a sequence is updated by the previous step
+        m_Condition.wait(lock, [this] { return !m_InFlight; });
+
+        std::vector<StepItem> items;
+        auto now = std::chrono::steady_clock::now();
+        for(uint32_t slot = 0; slot < m_MaxSequences; slot++)
+        {
+            if(!m_SlotUsed[slot])
+            {
+                continue;
+            }
+            auto& sequence = m_Sequences.at(m_Slots[slot]);
+            if(sequence.queue.empty())
+            {
+                continue;
+            }
+            items.push_back(StepItem{m_Slots[slot], slot, std::move(sequence.queue.front())});
+            sequence.queue.pop_front();
+            sequence.last_active = now;
+        }
+        for(const auto& item : items)
+        {
+            if(item.request.flags & kEnd)
+            {
+                m_Stats.sequences_ended++;
+                ReleaseSlot(item.correlation_id);
+            }
+        }
+        AssignSlots();
+        if(items.empty())
+        {
+            continue;
+        }
+        m_InFlight = true;
+        m_Stats.steps++;
+
+        lock.unlock();
+        Dispatch(std::move(items));
+        lock.lock();
+    }
+}
+
+void SequenceBatcher::WriteControl(Bindings& bindings, int binding_id, uint32_t slot,
+                                   int64_t value) const
+{
+    if(binding_id < 0)
+    {
+        return;
+    }
+    const auto& binding = m_Model->GetBinding(binding_id);
+    auto address = static_cast<char*>(bindings.HostAddress(binding_id)) +
+                   slot * binding.bytesPerBatchItem;
+    switch(binding.dtype)
+    {
+        case nvinfer1::DataType::kFLOAT:
+            *reinterpret_cast<float*>(address) = static_cast<float>(value);
+            break;
+        case nvinfer1::DataType::kINT32:
+            *reinterpret_cast<int32_t*>(address) = static_cast<int32_t>(value);
+            break;
+        case nvinfer1::DataType::kINT8:
+            *reinterpret_cast<int8_t*>(address) = static_cast<int8_t>(value);
+            break;
+        default:
+            LOG(FATAL) << "Unsupported data type of control input " << binding.name;
+    }
+}
+
+void SequenceBatcher::Dispatch(std::vector<StepItem>&& step)
+{
+    auto items = std::make_shared<std::vector<StepItem>>(std::move(step));
+    auto dispatched = Profiler::Now();
+    uint32_t rows = 0;
+    for(const auto& item : *items)
+    {
+        Profiler::Record("queue:batcher", "queue", item.request.enqueued, dispatched);
+        rows = std::max(rows, item.slot + 1);
+    }
+    DLOG(INFO) << "SequenceBatcher dispatching step of " << items->size() << " sequences";
+
+    m_Runner.Infer(
+        rows,
+        [this, items, rows](Bindings& bindings) {
+            // slots without a request in this step are not ready
+            for(uint32_t slot = 0; slot < rows; slot++)
+            {
+                for(auto id : {m_StartInput, m_EndInput, m_ReadyInput, m_CorrelationIdInput})
+                {
+                    WriteControl(bindings, id, slot, 0);
+                }
+            }
+            for(auto& item : *items)
+            {
+                const auto flags = item.request.flags;
+                WriteControl(bindings, m_StartInput, item.slot, (flags & kStart) ? 1 : 0);
+                WriteControl(bindings, m_EndInput, item.slot, (flags & kEnd) ? 1 : 0);
+                WriteControl(bindings, m_ReadyInput, item.slot, 1);
+                WriteControl(bindings, m_CorrelationIdInput, item.slot, item.correlation_id);
+                BatchItem batch_item(bindings, item.slot);
+                item.request.pre(batch_item);
+            }
+        },
+        [this, items](std::shared_ptr<Bindings>& bindings) {
+            for(auto& item : *items)
+            {
+                BatchItem batch_item(*bindings, item.slot);
+                item.request.post(batch_item);
+            }
+            bindings.reset();
+            // notify under the lock; the destructor may return as soon as it is released
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_InFlight = false;
+            m_Condition.notify_all();
+        });
+}
+
+} // namespace TensorRT
+} // namespace trtlab
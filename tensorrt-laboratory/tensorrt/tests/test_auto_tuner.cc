@@ -0,0 +1,171 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/auto_tuner.h"
+#include "tensorrt/laboratory/host_model.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestAutoTuner : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Factory = [] { return std::make_shared<DenseModel>(8, 64, 16); };
+        m_Options.latency_slo = 1.0;
+        m_Options.concurrency = 4;
+        m_Options.seconds = 0.03;
+        m_Options.warmup = 0.0;
+    }
+
+    AutoTuner::ModelFactory m_Factory;
+    TuningOptions m_Options;
+};
+
+template<typename T>
+bool Contains(const std::vector<T>& values, T value)
+{
+    return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+TEST_F(TestAutoTuner, BestWithinSpace)
+{
+    TuningSpace space;
+    space.executions = {1, 2};
+    space.pre_threads = {1};
+    space.post_threads = {1, 2};
+
+    AutoTuner tuner(m_Factory, space, m_Options);
+    auto best = tuner.Run();
+    ASSERT_NE(best, nullptr);
+
+    // batch sizes 1, 2, 4 and 8 for each combination of executions and post threads
+    EXPECT_EQ(tuner.Trials().size(), 16);
+    EXPECT_TRUE(best->meets_slo);
+    EXPECT_LE(best->results.at(kLatencyP99), m_Options.latency_slo);
+    EXPECT_TRUE(Contains(space.executions, best->config.max_executions));
+    EXPECT_EQ(best->config.max_buffers, 2 * best->config.max_executions);
+    EXPECT_EQ(best->config.cuda_threads, best->config.max_executions);
+    EXPECT_TRUE(Contains<uint32_t>({1, 2, 4, 8}, best->config.batch_size));
+    EXPECT_EQ(best->config.pre_threads, 1);
+    EXPECT_TRUE(Contains(space.post_threads, best->config.post_threads));
+    EXPECT_GT(best->memory, 0);
+
+    auto json = AutoTuner::ToJSON(*best);
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"max_executions\""), std::string::npos);
+    EXPECT_NE(json.find("\"post_threads\""), std::string::npos);
+    EXPECT_NE(json.find("\"meets_slo\": true"), std::string::npos);
+    EXPECT_NE(json.find("\"latency_p99\""), std::string::npos);
+}
+
+TEST_F(TestAutoTuner, ImpossibleSLO)
+{
+    TuningSpace space;
+    space.executions = {1, 2};
+    space.pre_threads = {1};
+    space.post_threads = {1};
+    m_Options.latency_slo = 0.0;
+
+    AutoTuner tuner(m_Factory, space, m_Options);
+    EXPECT_EQ(tuner.Run(), nullptr);
+
+    // larger batch sizes are skipped once the smallest misses the SLO
+    ASSERT_EQ(tuner.Trials().size(), 2);
+    for(const auto& trial : tuner.Trials())
+    {
+        EXPECT_FALSE(trial.meets_slo);
+        EXPECT_EQ(trial.config.batch_size, 1);
+    }
+}
+
+TEST_F(TestAutoTuner, PreThreadsBoundThroughput)
+{
+    TuningSpace space;
+    space.executions = {1};
+    space.batch_sizes = {1};
+    space.pre_threads = {1, 4};
+    space.post_threads = {1};
+    m_Options.concurrency = 8;
+    m_Options.seconds = 0.1;
+
+    AutoTuner tuner(m_Factory, space, m_Options);
+    tuner.SetRequestWork(
+        [](Bindings&) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }, nullptr);
+    auto best = tuner.Run();
+    ASSERT_NE(best, nullptr);
+    EXPECT_EQ(best->config.pre_threads, 4);
+}
+
+TEST_F(TestAutoTuner, SmallestFootprintOfEquallyFast)
+{
+    TuningSpace space;
+    space.executions = {1};
+    space.buffers = {8, 2};
+    space.batch_sizes = {1};
+    space.pre_threads = {1};
+    space.post_threads = {1};
+    m_Options.throughput_tolerance = 0.5;
+
+    // the single pre thread bounds the throughput of both trials
+    AutoTuner tuner(m_Factory, space, m_Options);
+    tuner.SetRequestWork(
+        [](Bindings&) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }, nullptr);
+    auto best = tuner.Run();
+    ASSERT_NE(best, nullptr);
+    ASSERT_EQ(tuner.Trials().size(), 2);
+    EXPECT_LT(tuner.Trials()[1].memory, tuner.Trials()[0].memory);
+    EXPECT_EQ(best->config.max_buffers, 2);
+}
+
+TEST_F(TestAutoTuner, InvalidSpace)
+{
+    TuningSpace space;
+    space.executions = {};
+    EXPECT_THROW(AutoTuner(m_Factory, space, m_Options), std::runtime_error);
+
+    space = TuningSpace();
+    space.pre_threads = {0};
+    EXPECT_THROW(AutoTuner(m_Factory, space, m_Options), std::runtime_error);
+
+    space = TuningSpace();
+    space.batch_sizes = {16};
+    AutoTuner tuner(m_Factory, space, m_Options);
+    EXPECT_THROW(tuner.Run(), std::runtime_error);
+}
+
+} // namespace
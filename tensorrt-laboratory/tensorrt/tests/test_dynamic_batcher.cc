@@ -0,0 +1,156 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/dynamic_batcher.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/inference_manager.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <vector>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestDynamicBatcher : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Resources = std::make_shared<InferenceManager>(2, 4);
+        m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterModel("echo", std::make_shared<EchoModel>(8, std::vector<size_t>{2}));
+        m_Resources->AllocateResources();
+    }
+
+    void TearDown() override { m_Resources.reset(); }
+
+    // each request echoes {value, -value}
+    std::vector<std::shared_future<float>> Submit(DynamicBatcher& batcher, int count)
+    {
+        std::vector<std::shared_future<float>> futures;
+        for(int i = 0; i < count; i++)
+        {
+            auto value = static_cast<float>(i + 1);
+            futures.push_back(batcher.Infer(
+                [value](BatchItem& item) {
+                    auto input = static_cast<float*>(item.HostAddress("input"));
+                    input[0] = value;
+                    input[1] = -value;
+                },
+                [](BatchItem& item) -> float {
+                    auto output = static_cast<float*>(item.HostAddress("output"));
+                    EXPECT_EQ(output[0], -output[1]);
+                    return output[0];
+                }));
+        }
+        return futures;
+    }
+
+    std::shared_ptr<InferenceManager> m_Resources;
+};
+
+TEST_F(TestDynamicBatcher, CoalescesToMaxBatchSize)
+{
+    DynamicBatchingPolicy policy;
+    policy.max_queue_delay = std::chrono::seconds(10);
+    DynamicBatcher batcher(m_Resources->GetModel("echo"), m_Resources, policy);
+
+    auto futures = Submit(batcher, 16);
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        EXPECT_EQ(futures[i].get(), static_cast<float>(i + 1));
+    }
+
+    auto stats = batcher.GetStats();
+    EXPECT_EQ(stats.requests, 16);
+    EXPECT_EQ(stats.batches, 2);
+    EXPECT_EQ(stats.batch_sizes[8], 2);
+}
+
+TEST_F(TestDynamicBatcher, DispatchesPartialBatchAfterQueueDelay)
+{
+    DynamicBatchingPolicy policy;
+    policy.max_queue_delay = std::chrono::milliseconds(20);
+    DynamicBatcher batcher(m_Resources->GetModel("echo"), m_Resources, policy);
+
+    auto start = std::chrono::steady_clock::now();
+    auto futures = Submit(batcher, 3);
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        EXPECT_EQ(futures[i].get(), static_cast<float>(i + 1));
+    }
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    auto stats = batcher.GetStats();
+    EXPECT_EQ(stats.batches, 1);
+    EXPECT_EQ(stats.batch_sizes[3], 1);
+}
+
+TEST_F(TestDynamicBatcher, PreferredBatchSizes)
+{
+    DynamicBatchingPolicy policy;
+    policy.max_queue_delay = std::chrono::milliseconds(200);
+    policy.preferred_batch_sizes = {2, 4, 16};
+    DynamicBatcher batcher(m_Resources->GetModel("echo"), m_Resources, policy);
+
+    // 16 exceeds the model's max batch size and is ignored: 7 = 4 + 2 + 1
+    auto futures = Submit(batcher, 7);
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        EXPECT_EQ(futures[i].get(), static_cast<float>(i + 1));
+    }
+
+    auto stats = batcher.GetStats();
+    EXPECT_EQ(stats.batches, 3);
+    EXPECT_EQ(stats.batch_sizes[4], 1);
+    EXPECT_EQ(stats.batch_sizes[2], 1);
+    EXPECT_EQ(stats.batch_sizes[1], 1);
+}
+
+TEST_F(TestDynamicBatcher, DestructorFlushesQueue)
+{
+    std::vector<std::shared_future<float>> futures;
+    {
+        DynamicBatchingPolicy policy;
+        policy.max_queue_delay = std::chrono::seconds(10);
+        DynamicBatcher batcher(m_Resources->GetModel("echo"), m_Resources, policy);
+        futures = Submit(batcher, 5);
+    }
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        ASSERT_EQ(futures[i].wait_for(std::chrono::seconds(0)), std::future_status::ready);
+        EXPECT_EQ(futures[i].get(), static_cast<float>(i + 1));
+    }
+}
+
+} // namespace
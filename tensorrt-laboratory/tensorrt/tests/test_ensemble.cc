@@ -0,0 +1,302 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/ensemble.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/inference_manager.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+// Elementwise sum of bindings "a" and "b"
+class AddModel final : public HostModel
+{
+  public:
+    AddModel(int max_batch_size, size_t size) : HostModel(max_batch_size)
+    {
+        AddHostBinding("a", true, {size});
+        AddHostBinding("b", true, {size});
+        AddHostBinding("sum", false, {size});
+    }
+    ~AddModel() final override {}
+
+    void Execute(Bindings& bindings) const final override
+    {
+        auto a = static_cast<const float*>(bindings.HostAddress(BindingId("a")));
+        auto b = static_cast<const float*>(bindings.HostAddress(BindingId("b")));
+        auto sum = static_cast<float*>(bindings.HostAddress(BindingId("sum")));
+        auto count = GetBinding(BindingId("sum")).elementsPerBatchItem * BatchSize(bindings);
+        for(size_t i = 0; i < count; i++)
+        {
+            sum[i] = a[i] + b[i];
+        }
+    }
+};
+
+class TestEnsemble : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Resources = std::make_shared<InferenceManager>(2, 8);
+        m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(2));
+        m_Resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterModel("echo", std::make_shared<EchoModel>(8, std::vector<size_t>{16}));
+        m_Resources->RegisterModel("dense", std::make_shared<DenseModel>(4, 16, 16, 7));
+        m_Resources->RegisterModel("add", std::make_shared<AddModel>(8, 16));
+        m_Resources->AllocateResources();
+    }
+
+    void TearDown() override { m_Resources.reset(); }
+
+    std::vector<float> Dense(const std::vector<float>& x)
+    {
+        auto model = std::static_pointer_cast<DenseModel>(m_Resources->GetModel("dense"));
+        std::vector<float> y(16);
+        for(size_t o = 0; o < 16; o++)
+        {
+            float sum = model->Bias()[o];
+            for(size_t i = 0; i < 16; i++)
+            {
+                sum += model->Weights()[o * 16 + i] * x[i];
+            }
+            y[o] = std::max(sum, 0.0f);
+        }
+        return y;
+    }
+
+    std::shared_ptr<InferenceManager> m_Resources;
+};
+
+TEST_F(TestEnsemble, ChainSharesHostMemory)
+{
+    Ensemble ensemble(m_Resources);
+    ensemble.AddStep("pre", "echo");
+    ensemble.AddStep("model", "dense");
+    ensemble.AddInput("x", "pre", "input");
+    ensemble.Connect("pre", "output", "model", "input");
+    ensemble.AddOutput("y", "model", "output");
+    ensemble.Finalize();
+    EXPECT_EQ(ensemble.GetMaxBatchSize(), 4);
+    EXPECT_EQ(ensemble.Steps(), (std::vector<std::string>{"pre", "model"}));
+
+    std::vector<float> x(16);
+    for(size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = static_cast<float>(i % 5) - 2.0f;
+    }
+    auto expected = Dense(x);
+
+    auto future = ensemble.Infer(
+        1,
+        [&x](EnsembleBindings& bindings) {
+            EXPECT_EQ(bindings.BatchSize(), 1);
+            EXPECT_EQ(bindings.BindingSize("x"), 16 * sizeof(float));
+            std::copy(x.begin(), x.end(), static_cast<float*>(bindings.HostAddress("x")));
+        },
+        [&expected](std::shared_ptr<EnsembleBindings>& bindings) -> bool {
+            auto& pre = bindings->StepBindings("pre");
+            auto& model = bindings->StepBindings("model");
+            EXPECT_EQ(pre.HostAddress(1), model.HostAddress(0));
+            EXPECT_EQ(model.DeviceAddress(0), model.HostAddress(0));
+            auto y = static_cast<float*>(bindings->HostAddress("y"));
+            for(size_t i = 0; i < expected.size(); i++)
+            {
+                EXPECT_FLOAT_EQ(y[i], expected[i]) << i;
+            }
+            return true;
+        });
+    EXPECT_TRUE(future.get());
+}
+
+TEST_F(TestEnsemble, DiamondJoinsBranches)
+{
+    Ensemble ensemble(m_Resources);
+    ensemble.AddStep("join", "add");
+    ensemble.AddStep("left", "echo");
+    ensemble.AddStep("right", "dense");
+    ensemble.AddInput("x", "left", "input");
+    ensemble.AddInput("x", "right", "input");
+    ensemble.Connect("left", "output", "join", "a");
+    ensemble.Connect("right", "output", "join", "b");
+    ensemble.AddOutput("sum", "join", "sum");
+    ensemble.AddOutput("dense", "right", "output");
+    ensemble.Finalize();
+    EXPECT_EQ(ensemble.Steps().back(), "join");
+
+    std::vector<float> x(16);
+    for(size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = static_cast<float>(i) / 4.0f - 1.0f;
+    }
+    auto dense = Dense(x);
+
+    std::vector<std::shared_future<void>> futures;
+    for(uint32_t batch_size = 1; batch_size <= 4; batch_size++)
+    {
+        futures.push_back(ensemble.Infer(
+            batch_size,
+            [&x](EnsembleBindings& bindings) {
+                auto input = static_cast<float*>(bindings.HostAddress("x"));
+                for(uint32_t b = 0; b < bindings.BatchSize(); b++)
+                {
+                    std::copy(x.begin(), x.end(), input + b * 16);
+                }
+                // both branches read the same memory
+                EXPECT_EQ(bindings.StepBindings("left").HostAddress(0),
+                          bindings.StepBindings("right").HostAddress(0));
+            },
+            [&x, &dense](std::shared_ptr<EnsembleBindings>& bindings) {
+                auto sum = static_cast<float*>(bindings->HostAddress("sum"));
+                auto y = static_cast<float*>(bindings->HostAddress("dense"));
+                for(uint32_t b = 0; b < bindings->BatchSize(); b++)
+                {
+                    for(size_t i = 0; i < 16; i++)
+                    {
+                        EXPECT_FLOAT_EQ(y[b * 16 + i], dense[i]);
+                        EXPECT_FLOAT_EQ(sum[b * 16 + i], x[i] + dense[i]);
+                    }
+                }
+            }));
+    }
+    for(auto& future : futures)
+    {
+        future.get();
+    }
+}
+
+TEST_F(TestEnsemble, ConcurrentRequests)
+{
+    Ensemble ensemble(m_Resources);
+    ensemble.AddStep("first", "echo");
+    ensemble.AddStep("second", "echo");
+    ensemble.AddInput("x", "first", "input");
+    ensemble.Connect("first", "output", "second", "input");
+    ensemble.AddOutput("y", "second", "output");
+    ensemble.Finalize();
+
+    std::vector<std::shared_future<bool>> futures;
+    for(int r = 0; r < 64; r++)
+    {
+        futures.push_back(ensemble.Infer(
+            1 + r % 8,
+            [r](EnsembleBindings& bindings) {
+                auto x = static_cast<float*>(bindings.HostAddress("x"));
+                std::fill(x, x + bindings.BatchSize() * 16, static_cast<float>(r));
+            },
+            [r](std::shared_ptr<EnsembleBindings>& bindings) -> bool {
+                auto y = static_cast<float*>(bindings->HostAddress("y"));
+                return std::all_of(y, y + bindings->BatchSize() * 16,
+                                   [r](float v) { return v == static_cast<float>(r); });
+            }));
+    }
+    for(auto& future : futures)
+    {
+        EXPECT_TRUE(future.get());
+    }
+}
+
+TEST_F(TestEnsemble, InvalidGraphs)
+{
+    {
+        Ensemble ensemble(m_Resources);
+        ensemble.AddStep("join", "add");
+        ensemble.AddInput("a", "join", "a");
+        EXPECT_THROW(ensemble.Finalize(), std::runtime_error);
+    }
+    {
+        Ensemble ensemble(m_Resources);
+        ensemble.AddStep("first", "echo");
+        ensemble.AddStep("second", "echo");
+        ensemble.Connect("first", "output", "second", "input");
+        ensemble.Connect("second", "output", "first", "input");
+        EXPECT_THROW(ensemble.Finalize(), std::runtime_error);
+    }
+    {
+        Ensemble ensemble(m_Resources);
+        ensemble.AddStep("first", "echo");
+        EXPECT_THROW(ensemble.AddStep("first", "dense"), std::runtime_error);
+        EXPECT_THROW(ensemble.AddInput("x", "first", "output"), std::runtime_error);
+        EXPECT_THROW(ensemble.AddInput("x", "missing", "input"), std::runtime_error);
+        ensemble.AddInput("x", "first", "input");
+        EXPECT_THROW(ensemble.AddInput("y", "first", "input"), std::runtime_error);
+        EXPECT_THROW(ensemble.Connect("first", "output", "first", "input"), std::runtime_error);
+    }
+}
+
+TEST_F(TestEnsemble, MismatchedTensors)
+{
+    m_Resources = std::make_shared<InferenceManager>(1, 2);
+    m_Resources->RegisterModel("small", std::make_shared<EchoModel>(4, std::vector<size_t>{8}));
+    m_Resources->RegisterModel("large", std::make_shared<EchoModel>(4, std::vector<size_t>{16}));
+
+    Ensemble ensemble(m_Resources);
+    ensemble.AddStep("small", "small");
+    ensemble.AddStep("large", "large");
+    EXPECT_THROW(ensemble.Connect("small", "output", "large", "input"), std::runtime_error);
+}
+
+TEST_F(TestEnsemble, BuffersPoolTooSmall)
+{
+    m_Resources = std::make_shared<InferenceManager>(1, 2);
+    m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+    m_Resources->RegisterModel("echo", std::make_shared<EchoModel>(4, std::vector<size_t>{8}));
+
+    auto chain = [](Ensemble& ensemble) {
+        ensemble.AddStep("first", "echo");
+        ensemble.AddStep("second", "echo");
+        ensemble.AddStep("third", "echo");
+        ensemble.AddInput("x", "first", "input");
+        ensemble.Connect("first", "output", "second", "input");
+        ensemble.Connect("second", "output", "third", "input");
+        ensemble.AddOutput("y", "third", "output");
+    };
+
+    // resources allocated after Finalize are checked by the first request
+    Ensemble late(m_Resources);
+    chain(late);
+    late.Finalize();
+    m_Resources->AllocateResources();
+    ASSERT_EQ(m_Resources->GetBuffersPool(m_Resources->GetModel("echo").get()).second, 2);
+    EXPECT_THROW(late.Infer([](EnsembleBindings&) {},
+                            [](std::shared_ptr<EnsembleBindings>&) {}),
+                 std::runtime_error);
+
+    Ensemble ensemble(m_Resources);
+    chain(ensemble);
+    EXPECT_THROW(ensemble.Finalize(), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,199 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/execution_scheduler.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/inference_manager.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestExecutionScheduler : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_A = std::make_shared<EchoModel>(1, std::vector<size_t>{1});
+        m_B = std::make_shared<EchoModel>(1, std::vector<size_t>{1});
+    }
+
+    void WaitForQueueDepth(ExecutionScheduler& scheduler, const BaseModel* model, uint32_t depth)
+    {
+        while(scheduler.GetStats(model).queue_depth != depth)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    std::shared_ptr<EchoModel> m_A;
+    std::shared_ptr<EchoModel> m_B;
+};
+
+TEST_F(TestExecutionScheduler, WeightedFairShare)
+{
+    ExecutionScheduler scheduler(1);
+    scheduler.AddModel(m_A.get(), 1);
+    scheduler.AddModel(m_B.get(), 1);
+    SchedulingPolicy policy;
+    policy.weight = 3.0;
+    scheduler.SetPolicy(m_A.get(), policy);
+
+    // hold the only slot while both models queue up
+    scheduler.Acquire(m_B.get());
+
+    std::mutex mutex;
+    std::vector<const BaseModel*> grants;
+    std::vector<std::thread> threads;
+    for(auto model : {m_A.get(), m_B.get()})
+    {
+        for(int i = 0; i < 8; i++)
+        {
+            threads.emplace_back([&scheduler, &mutex, &grants, model] {
+                scheduler.Acquire(model);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    grants.push_back(model);
+                }
+                scheduler.Release(model);
+            });
+        }
+    }
+    WaitForQueueDepth(scheduler, m_A.get(), 8);
+    WaitForQueueDepth(scheduler, m_B.get(), 8);
+    scheduler.Release(m_B.get());
+
+    for(auto& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(grants.size(), 16);
+    auto a_in_first_eight = std::count(grants.begin(), grants.begin() + 8, m_A.get());
+    EXPECT_GE(a_in_first_eight, 5);
+    EXPECT_LE(a_in_first_eight, 7);
+
+    auto stats = scheduler.GetStats(m_A.get());
+    EXPECT_EQ(stats.granted, 8);
+    EXPECT_EQ(stats.queue_depth, 0);
+    EXPECT_EQ(stats.in_flight, 0);
+    EXPECT_GT(stats.max_wait.count(), 0);
+}
+
+TEST_F(TestExecutionScheduler, ConcurrencyLimit)
+{
+    ExecutionScheduler scheduler(2);
+    scheduler.AddModel(m_A.get(), 2);
+    scheduler.AddModel(m_B.get(), 2);
+    SchedulingPolicy policy;
+    policy.max_concurrency = 1;
+    scheduler.SetPolicy(m_A.get(), policy);
+
+    scheduler.Acquire(m_A.get());
+    std::atomic<bool> acquired{false};
+    std::thread second([&] {
+        scheduler.Acquire(m_A.get());
+        acquired = true;
+    });
+    WaitForQueueDepth(scheduler, m_A.get(), 1);
+
+    // the free slot goes to B, not to A's second request
+    scheduler.Acquire(m_B.get());
+    EXPECT_FALSE(acquired);
+    scheduler.Release(m_B.get());
+    EXPECT_FALSE(acquired);
+
+    scheduler.Release(m_A.get());
+    second.join();
+    EXPECT_TRUE(acquired);
+    scheduler.Release(m_A.get());
+}
+
+TEST_F(TestExecutionScheduler, MinimumReservation)
+{
+    ExecutionScheduler scheduler(2);
+    scheduler.AddModel(m_A.get(), 2);
+    scheduler.AddModel(m_B.get(), 2);
+    SchedulingPolicy policy;
+    policy.min_reserved = 1;
+    scheduler.SetPolicy(m_A.get(), policy);
+
+    scheduler.Acquire(m_B.get());
+    std::atomic<bool> acquired{false};
+    std::thread second([&] {
+        scheduler.Acquire(m_B.get());
+        acquired = true;
+    });
+    WaitForQueueDepth(scheduler, m_B.get(), 1);
+
+    // the second slot is held back for idle A
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(acquired);
+    scheduler.Acquire(m_A.get());
+    scheduler.Release(m_A.get());
+    EXPECT_FALSE(acquired);
+
+    // once B's first slot returns, B can use the unreserved slot
+    scheduler.Release(m_B.get());
+    second.join();
+    EXPECT_TRUE(acquired);
+    scheduler.Release(m_B.get());
+}
+
+TEST_F(TestExecutionScheduler, InferenceManagerStats)
+{
+    auto resources = std::make_shared<InferenceManager>(1, 2);
+    resources->RegisterModel("a", m_A);
+    resources->RegisterModel("b", m_B);
+    resources->AllocateResources();
+    SchedulingPolicy policy;
+    policy.weight = 2.0;
+    resources->SetSchedulingPolicy("a", policy);
+
+    for(int i = 0; i < 3; i++)
+    {
+        auto buffers = resources->GetBuffers();
+        auto bindings = buffers->CreateBindings(m_A);
+        auto ctx = resources->GetExecutionContext(m_A);
+        ctx->Infer(bindings);
+        ctx->Synchronize();
+    }
+
+    auto stats = resources->GetSchedulingStats("a");
+    EXPECT_EQ(stats.granted, 3);
+    EXPECT_EQ(stats.in_flight, 0);
+    EXPECT_EQ(resources->GetSchedulingStats("b").granted, 0);
+}
+
+} // namespace
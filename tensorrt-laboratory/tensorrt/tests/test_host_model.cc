@@ -0,0 +1,301 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/core/profiler.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/infer_runner.h"
+#include "tensorrt/laboratory/inference_manager.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestHostModel : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Resources = std::make_shared<InferenceManager>(2, 4);
+        m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(1));
+    }
+
+    void TearDown() override { m_Resources.reset(); }
+
+    std::shared_ptr<InferenceManager> m_Resources;
+};
+
+TEST_F(TestHostModel, EchoEndToEnd)
+{
+    auto model = std::make_shared<EchoModel>(8, std::vector<size_t>{4, 4});
+    ASSERT_TRUE(model->ExecutesOnHost());
+    m_Resources->RegisterModel("echo", model);
+    m_Resources->AllocateResources();
+    EXPECT_EQ(m_Resources->FindModel("echo"), model);
+    EXPECT_EQ(m_Resources->FindModel("missing"), nullptr);
+
+    InferRunner runner(m_Resources->GetModel("echo"), m_Resources);
+    auto future = runner.Infer(
+        [](Bindings& bindings) {
+            bindings.SetBatchSize(3);
+            auto input = static_cast<float*>(bindings.HostAddress(0));
+            for(int i = 0; i < 3 * 16; i++)
+            {
+                input[i] = static_cast<float>(i);
+            }
+        },
+        [](std::shared_ptr<Bindings>& bindings) -> bool {
+            EXPECT_EQ(bindings->HostAddress(1), bindings->DeviceAddress(1));
+            auto output = static_cast<float*>(bindings->HostAddress(1));
+            for(int i = 0; i < 3 * 16; i++)
+            {
+                if(output[i] != static_cast<float>(i))
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+    EXPECT_TRUE(future.get());
+}
+
+TEST_F(TestHostModel, DenseMatchesReference)
+{
+    const size_t inputs = 32;
+    const size_t outputs = 8;
+    auto model = std::make_shared<DenseModel>(4, inputs, outputs, 42);
+    EXPECT_EQ(model->GetWeightsMemorySize(), (inputs * outputs + outputs) * sizeof(float));
+    m_Resources->RegisterModel("dense", model);
+    m_Resources->AllocateResources();
+
+    std::vector<float> x(inputs);
+    for(size_t i = 0; i < inputs; i++)
+    {
+        x[i] = static_cast<float>(i % 5) - 2.0f;
+    }
+
+    std::vector<float> expected(outputs);
+    for(size_t o = 0; o < outputs; o++)
+    {
+        float sum = model->Bias()[o];
+        for(size_t i = 0; i < inputs; i++)
+        {
+            sum += model->Weights()[o * inputs + i] * x[i];
+        }
+        expected[o] = std::max(sum, 0.0f);
+    }
+
+    auto buffers = m_Resources->GetBuffers();
+    auto bindings = buffers->CreateBindings(model);
+    bindings->SetBatchSize(1);
+    std::copy(x.begin(), x.end(), static_cast<float*>(bindings->HostAddress(0)));
+
+    auto ctx = m_Resources->GetExecutionContext(model);
+    ctx->Infer(bindings);
+    ctx->Synchronize();
+
+    auto y = static_cast<float*>(bindings->HostAddress(1));
+    for(size_t o = 0; o < outputs; o++)
+    {
+        EXPECT_FLOAT_EQ(y[o], expected[o]);
+    }
+}
+
+TEST_F(TestHostModel, HostOnlyBuffersHaveNoStream)
+{
+    m_Resources->RegisterModel("echo", std::make_shared<EchoModel>(1, std::vector<size_t>{1}));
+    m_Resources->AllocateResources();
+    // host-only InferenceManagers allocate host-resident Buffers without a stream
+    EXPECT_EQ(m_Resources->GetBuffers()->Stream(), nullptr);
+}
+
+TEST_F(TestHostModel, BindingsSizedForBatch)
+{
+    // 64 bytes per batch item and binding, a multiple of the host alignment
+    auto model = std::make_shared<EchoModel>(8, std::vector<size_t>{4, 4});
+    m_Resources->RegisterModel("echo", model);
+    m_Resources->AllocateResources();
+
+    auto buffers = m_Resources->GetBuffers();
+    std::vector<std::shared_ptr<Bindings>> small;
+    while(buffers->Fits(*model, 1))
+    {
+        auto bindings = buffers->CreateBindings(model, 1);
+        EXPECT_EQ(bindings->BatchSize(), 1);
+        EXPECT_EQ(bindings->AllocatedBatchSize(), 1);
+        EXPECT_EQ(bindings->BindingSize(0), 64);
+        EXPECT_EQ(bindings->BindingCapacity(1), 64);
+        small.push_back(bindings);
+    }
+    for(size_t i = 1; i < small.size(); i++)
+    {
+        EXPECT_NE(small[i]->HostAddress(0), small[i - 1]->HostAddress(0));
+    }
+
+    auto other = m_Resources->GetBuffers();
+    std::vector<std::shared_ptr<Bindings>> full;
+    while(other->Fits(*model, 8))
+    {
+        full.push_back(other->CreateBindings(model));
+    }
+    // single-item requests share the stack rather than each reserving a max batch
+    ASSERT_GT(full.size(), 0);
+    EXPECT_EQ(small.size(), 8 * full.size());
+
+    full[0]->SetBatchSize(3);
+    EXPECT_EQ(full[0]->BindingSize(0), 3 * 64);
+    EXPECT_EQ(full[0]->BindingCapacity(0), 8 * 64);
+}
+
+TEST_F(TestHostModel, BatchSizedInfer)
+{
+    auto model = std::make_shared<EchoModel>(8, std::vector<size_t>{4});
+    m_Resources->RegisterModel("echo", model);
+    m_Resources->AllocateResources();
+
+    InferRunner runner(m_Resources->GetModel("echo"), m_Resources);
+    auto future = runner.Infer(
+        2,
+        [](Bindings& bindings) {
+            EXPECT_EQ(bindings.BatchSize(), 2);
+            auto input = static_cast<float*>(bindings.HostAddress(0));
+            for(int i = 0; i < 2 * 4; i++)
+            {
+                input[i] = static_cast<float>(i);
+            }
+        },
+        [](std::shared_ptr<Bindings>& bindings) -> size_t {
+            auto output = static_cast<float*>(bindings->HostAddress(1));
+            EXPECT_FLOAT_EQ(output[7], 7.0f);
+            return bindings->BindingCapacity(1);
+        });
+    EXPECT_EQ(future.get(), 2 * 4 * sizeof(float));
+}
+
+TEST_F(TestHostModel, BindingsHoldBuffers)
+{
+    m_Resources = std::make_shared<InferenceManager>(1, 1);
+    auto model = std::make_shared<EchoModel>(4, std::vector<size_t>{4});
+    m_Resources->RegisterModel("echo", model);
+    m_Resources->AllocateResources();
+
+    auto bindings = m_Resources->GetBuffers()->CreateBindings(model, 1);
+    // the only Buffers object stays checked out while its Bindings are alive
+    auto pending = std::async(std::launch::async, [this] { return m_Resources->GetBuffers(); });
+    EXPECT_EQ(pending.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+    bindings.reset();
+    EXPECT_EQ(pending.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+TEST_F(TestHostModel, ProfiledStages)
+{
+    m_Resources->RegisterModel("echo", std::make_shared<EchoModel>(2, std::vector<size_t>{4}));
+    m_Resources->AllocateResources();
+
+    Profiler::Clear();
+    Profiler::Enable();
+    InferRunner runner(m_Resources->GetModel("echo"), m_Resources);
+    runner.Infer([](Bindings&) {}, [](std::shared_ptr<Bindings>&) {}).wait();
+    Profiler::Enable(false);
+
+    auto trace = Profiler::ExportChromeTrace();
+    for(auto name : {"queue:pre", "wait:buffers", "pre", "queue:cuda", "copy:h2d",
+                     "wait:execution_context", "compute", "copy:d2h", "queue:post", "sync", "post"})
+    {
+        EXPECT_NE(trace.find(std::string("\"name\": \"") + name + "\""), std::string::npos)
+            << name;
+    }
+    Profiler::Clear();
+}
+
+TEST_F(TestHostModel, CyclicBuffersMixedBatches)
+{
+    BuffersPolicy policy;
+    policy.strategy = BuffersPolicy::Strategy::kCyclic;
+    policy.segment_factor = 1.5;
+    policy.segments = 2;
+    m_Resources->SetBuffersPolicy(policy);
+    auto model = std::make_shared<EchoModel>(64, std::vector<size_t>{256});
+    m_Resources->RegisterModel("echo", model);
+    m_Resources->AllocateResources();
+
+    // 4 fixed stacks for batch 64 vs. 2 segments of 1.5 requests of batch 64
+    auto fixed = m_Resources->GetBuffersPlan().Footprint();
+    EXPECT_LT(m_Resources->BuffersFootprint(), fixed);
+
+    InferRunner runner(m_Resources->GetModel("echo"), m_Resources);
+    std::vector<std::shared_future<bool>> futures;
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        uint32_t batch_size = (i % 4 == 0) ? 64 : 1 + i % 7;
+        futures.push_back(runner.Infer(
+            batch_size,
+            [i](Bindings& bindings) {
+                auto input = static_cast<float*>(bindings.HostAddress(0));
+                std::fill(input, input + bindings.BatchSize() * 256, static_cast<float>(i));
+            },
+            [i](std::shared_ptr<Bindings>& bindings) -> bool {
+                auto output = static_cast<float*>(bindings->HostAddress(1));
+                auto count = bindings->BatchSize() * 256;
+                return std::all_of(output, output + count,
+                                   [i](float value) { return value == static_cast<float>(i); });
+            }));
+    }
+    for(auto& future : futures)
+    {
+        EXPECT_TRUE(future.get());
+    }
+}
+
+TEST_F(TestHostModel, CyclicBindingsShareOneAllocation)
+{
+    BuffersPolicy policy;
+    policy.strategy = BuffersPolicy::Strategy::kCyclic;
+    m_Resources->SetBuffersPolicy(policy);
+    auto model = std::make_shared<EchoModel>(8, std::vector<size_t>{4});
+    m_Resources->RegisterModel("echo", model);
+    m_Resources->AllocateResources();
+
+    auto buffers = m_Resources->GetBuffers();
+    EXPECT_EQ(buffers->Stream(), nullptr);
+    auto bindings = buffers->CreateBindings(model, 3);
+    auto input = static_cast<char*>(bindings->HostAddress(0));
+    auto output = static_cast<char*>(bindings->HostAddress(1));
+    EXPECT_EQ(bindings->DeviceAddress(1), bindings->HostAddress(1));
+    EXPECT_GE(output - input, 3 * 4 * sizeof(float));
+    EXPECT_LT(output - input, 3 * 4 * sizeof(float) + HostMemory::DefaultAlignment());
+    EXPECT_EQ(bindings->BindingCapacity(0), 3 * 4 * sizeof(float));
+}
+
+} // namespace
@@ -0,0 +1,104 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/infer_bench.h"
+#include "tensorrt/laboratory/host_model.h"
+
+#include "gtest/gtest.h"
+
+#include <limits>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestInferBench : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Resources = std::make_shared<InferenceManager>(2, 4);
+        m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(2));
+        m_Model = std::make_shared<DenseModel>(8, 64, 16);
+        m_Resources->RegisterModel("dense", m_Model);
+        m_Resources->AllocateResources();
+    }
+
+    void TearDown() override { m_Resources.reset(); }
+
+    std::shared_ptr<InferenceManager> m_Resources;
+    std::shared_ptr<BaseModel> m_Model;
+};
+
+TEST_F(TestInferBench, LatencyPercentiles)
+{
+    InferBench bench(m_Resources);
+    auto results = bench.Run({m_Model}, 4, 0.05, 0.01, 2);
+    auto& r = *results;
+    EXPECT_GT(r[kBatchesComputed], 0);
+    EXPECT_EQ(r[kBatchSize], 4);
+    EXPECT_EQ(r[kConcurrency], 2);
+    EXPECT_DOUBLE_EQ(r[kWarmupTime], 0.01);
+    EXPECT_GT(r[kLatencyP50], 0.0);
+    EXPECT_LE(r[kLatencyP50], r[kLatencyP90]);
+    EXPECT_LE(r[kLatencyP90], r[kLatencyP99]);
+    EXPECT_LE(r[kLatencyP99], r[kLatencyP999]);
+    EXPECT_LE(r[kLatencyP999], r[kLatencyMax]);
+}
+
+TEST_F(TestInferBench, Sweep)
+{
+    InferBench bench(m_Resources);
+    auto results = bench.Sweep({m_Model}, {1, 8}, {1, 2, 4}, 0.02, 0.0);
+    ASSERT_EQ(results.size(), 6);
+    EXPECT_EQ((*results[0])[kBatchSize], 1);
+    EXPECT_EQ((*results[0])[kConcurrency], 1);
+    EXPECT_EQ((*results[5])[kBatchSize], 8);
+    EXPECT_EQ((*results[5])[kConcurrency], 4);
+}
+
+TEST_F(TestInferBench, JSON)
+{
+    InferBench::Results results;
+    results[kBatchSize] = 8;
+    results[kLatencyP999] = 0.25;
+    results[kLatencyMax] = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(InferBench::ToJSON(results),
+              "{\"batch_size\": 8, \"latency_p99.9\": 0.25, \"latency_max\": null}");
+
+    InferBench bench(m_Resources);
+    auto list = bench.Sweep({m_Model}, {2}, {1, 2}, 0.01, 0.0);
+    auto json = InferBench::ToJSON(list);
+    EXPECT_EQ(json.front(), '[');
+    EXPECT_EQ(json.back(), ']');
+    EXPECT_NE(json.find("\"latency_p99\""), std::string::npos);
+    EXPECT_NE(json.find("\"inferences_per_second\""), std::string::npos);
+}
+
+} // namespace
@@ -0,0 +1,200 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/memory_planner.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/inference_manager.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <random>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestMemoryPlanner : public ::testing::Test
+{
+};
+
+TEST_F(TestMemoryPlanner, SingleModel)
+{
+    MemoryPlanner planner(4);
+    planner.AddModel("a", 1000, 0);
+    auto plan = planner.Compute();
+    ASSERT_EQ(plan.slots.size(), 1);
+    EXPECT_EQ(plan.slots[0].bytes, 1000);
+    EXPECT_EQ(plan.slots[0].count, 4);
+    EXPECT_EQ(plan.Footprint(), 4000);
+    EXPECT_EQ(plan.Footprint(), plan.UniformFootprint());
+}
+
+TEST_F(TestMemoryPlanner, UnboundedModelsShareSlots)
+{
+    // every model may use all slots, so one pool sized for the largest model is best
+    MemoryPlanner planner(4);
+    planner.AddModel("large", 1000, 0);
+    planner.AddModel("small", 10, 0);
+    auto plan = planner.Compute();
+    ASSERT_EQ(plan.slots.size(), 1);
+    EXPECT_EQ(plan.SlotCount(), 4);
+    EXPECT_EQ(plan.Footprint(), 4000);
+    EXPECT_EQ(plan.assignment["small"], 0);
+}
+
+TEST_F(TestMemoryPlanner, BoundedLargeModelGetsOwnSlots)
+{
+    MemoryPlanner planner(4);
+    planner.AddModel("large", 1000, 1);
+    planner.AddModel("small", 10, 4);
+    auto plan = planner.Compute();
+    ASSERT_EQ(plan.slots.size(), 2);
+    EXPECT_EQ(plan.slots[0].bytes, 1000);
+    EXPECT_EQ(plan.slots[0].count, 1);
+    EXPECT_EQ(plan.slots[1].bytes, 10);
+    EXPECT_EQ(plan.slots[1].count, 4);
+    EXPECT_EQ(plan.assignment["large"], 0);
+    EXPECT_EQ(plan.assignment["small"], 1);
+    EXPECT_EQ(plan.Footprint(), 1040);
+    EXPECT_EQ(plan.UniformFootprint(), 4000);
+}
+
+TEST_F(TestMemoryPlanner, ExclusiveGroupSharesSlots)
+{
+    MemoryPlanner planner(8);
+    planner.AddModel("a", 1000, 2, "stage");
+    planner.AddModel("b", 600, 3, "stage");
+    planner.AddModel("c", 100, 2);
+    auto plan = planner.Compute();
+    ASSERT_EQ(plan.slots.size(), 2);
+    // a and b never run at the same time: 3 slots sized for a
+    EXPECT_EQ(plan.slots[0].bytes, 1000);
+    EXPECT_EQ(plan.slots[0].count, 3);
+    EXPECT_EQ(plan.assignment["a"], plan.assignment["b"]);
+    EXPECT_EQ(plan.slots[1].count, 2);
+    EXPECT_EQ(plan.Footprint(), 3200);
+}
+
+TEST_F(TestMemoryPlanner, SyntheticModels)
+{
+    std::mt19937 rng(7);
+    for(int trial = 0; trial < 100; trial++)
+    {
+        const uint32_t max_slots = 1 + rng() % 8;
+        MemoryPlanner planner(max_slots);
+        std::map<std::string, std::pair<size_t, uint32_t>> models;
+        size_t separate = 0;
+        const int count = 1 + rng() % 10;
+        for(int i = 0; i < count; i++)
+        {
+            auto name = "m" + std::to_string(i);
+            size_t bytes = 1 + rng() % 100000;
+            uint32_t concurrency = 1 + rng() % max_slots;
+            planner.AddModel(name, bytes, concurrency);
+            models[name] = std::make_pair(bytes, concurrency);
+            separate += bytes * concurrency;
+        }
+        auto plan = planner.Compute();
+        EXPECT_LE(plan.Footprint(), plan.UniformFootprint());
+        EXPECT_LE(plan.Footprint(), separate);
+        for(const auto& item : models)
+        {
+            const auto& slots = plan.slots[plan.assignment.at(item.first)];
+            EXPECT_GE(slots.bytes, item.second.first);
+            EXPECT_GE(slots.count, item.second.second);
+            EXPECT_LE(slots.count, max_slots);
+        }
+    }
+}
+
+TEST_F(TestMemoryPlanner, InferenceManagerUsesPlan)
+{
+    auto resources = std::make_shared<InferenceManager>(2, 4);
+    auto large = std::make_shared<EchoModel>(64, std::vector<size_t>{1024});
+    auto small = std::make_shared<EchoModel>(1, std::vector<size_t>{4});
+    resources->RegisterModel("large", large, 1);
+    resources->RegisterModel("small", small, 2);
+    resources->AllocateResources();
+
+    const auto& plan = resources->GetBuffersPlan();
+    ASSERT_EQ(plan.slots.size(), 2);
+    EXPECT_LT(plan.Footprint(), plan.UniformFootprint());
+    EXPECT_EQ(plan.slots[plan.assignment.at("large")].count, 2);
+
+    auto buffers = resources->GetBuffers(small);
+    EXPECT_TRUE(buffers->Fits(*small, 1));
+    EXPECT_FALSE(buffers->Fits(*large, 64));
+    EXPECT_TRUE(resources->GetBuffers(large)->Fits(*large, 64));
+    // the unplanned variant hands out Buffers that fit any model
+    EXPECT_TRUE(resources->GetBuffers()->Fits(*large, 64));
+}
+
+TEST_F(TestMemoryPlanner, InferenceManagerExclusiveGroup)
+{
+    auto resources = std::make_shared<InferenceManager>(2, 4);
+    auto a = std::make_shared<EchoModel>(64, std::vector<size_t>{1024});
+    auto b = std::make_shared<EchoModel>(64, std::vector<size_t>{512});
+    resources->RegisterModel("a", a, 1);
+    resources->RegisterModel("b", b, 1);
+    resources->SetExclusiveGroup("a", "pipeline");
+    resources->SetExclusiveGroup("b", "pipeline");
+    resources->AllocateResources();
+
+    const auto& plan = resources->GetBuffersPlan();
+    ASSERT_EQ(plan.slots.size(), 1);
+    EXPECT_EQ(plan.slots[0].count, 2);
+    EXPECT_EQ(plan.slots[0].models.size(), 2);
+}
+
+TEST_F(TestMemoryPlanner, LateModelConcurrencyCappedToItsClass)
+{
+    auto resources = std::make_shared<InferenceManager>(4, 8);
+    resources->RegisterModel("planned", std::make_shared<EchoModel>(1, std::vector<size_t>{4}), 1);
+    resources->AllocateResources();
+    ASSERT_EQ(resources->GetWorkspacePlan().slots.size(), 1);
+    ASSERT_EQ(resources->GetWorkspacePlan().slots[0].count, 1);
+
+    // the late model would be granted 4 executions by default; its class holds 1 context
+    auto late = std::make_shared<EchoModel>(1, std::vector<size_t>{4});
+    resources->RegisterModel("late", late);
+    auto ctx = resources->GetExecutionContext(late);
+    auto waiting = std::async(std::launch::async,
+                              [resources, late] { return resources->GetExecutionContext(late); });
+    ASSERT_EQ(waiting.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+    // the second request waits for the scheduler rather than holding a grant
+    auto stats = resources->GetSchedulingStats("late");
+    EXPECT_EQ(stats.in_flight, 1);
+    EXPECT_EQ(stats.queue_depth, 1);
+
+    ctx.reset();
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    waiting.get().reset();
+}
+
+} // namespace
@@ -0,0 +1,177 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/model_loader.h"
+#include "tensorrt/laboratory/host_model.h"
+
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestModelLoader : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Dir = "/tmp/trtlab_test_model_loader." + std::to_string(getpid());
+        mkdir(m_Dir.c_str(), 0700);
+    }
+
+    void TearDown() override
+    {
+        for(const auto& path : m_Files)
+        {
+            std::remove(path.c_str());
+        }
+        rmdir(m_Dir.c_str());
+    }
+
+    // an engine file whose contents are its size repeated as a single character
+    std::string Write(const std::string& name, size_t bytes)
+    {
+        auto path = m_Dir + "/" + name;
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(bytes, static_cast<char>('a' + bytes % 26));
+        m_Files.push_back(path);
+        return path;
+    }
+
+    std::string m_Dir;
+    std::vector<std::string> m_Files;
+};
+
+TEST_F(TestModelLoader, BoundedConcurrentLoads)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        Write("model" + std::to_string(i) + ".engine", 1000 + i);
+    }
+    Write("notes.txt", 10);
+
+    auto files = ModelLoader::Directory(m_Dir);
+    ASSERT_EQ(files.size(), 8);
+    EXPECT_EQ(files["model3"], m_Dir + "/model3.engine");
+
+    std::mutex mutex;
+    size_t mapped = 0, max_mapped = 0;
+    int concurrent = 0, max_concurrent = 0;
+
+    ModelLoader loader(4, 3500);
+    auto models = loader.Load(files, [&](const void* data, size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            mapped += size;
+            max_mapped = std::max(max_mapped, mapped);
+            max_concurrent = std::max(max_concurrent, ++concurrent);
+        }
+        auto bytes = static_cast<const char*>(data);
+        EXPECT_TRUE(std::all_of(bytes, bytes + size, [size](char c) {
+            return c == static_cast<char>('a' + size % 26);
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            mapped -= size;
+            concurrent--;
+        }
+        return std::make_shared<EchoModel>(1, std::vector<size_t>{size});
+    });
+
+    ASSERT_EQ(models.size(), 8);
+    EXPECT_EQ(models["model5"]->GetBinding(0).bytesPerBatchItem, 1005 * sizeof(float));
+    // three files fit in the budget at a time
+    EXPECT_LE(max_mapped, 3500);
+    EXPECT_GT(max_concurrent, 1);
+    EXPECT_LE(max_concurrent, 3);
+}
+
+TEST_F(TestModelLoader, FileLargerThanLimit)
+{
+    auto files = ModelLoader::FileMap{{"small", Write("small.engine", 10)},
+                                      {"large", Write("large.engine", 5000)}};
+    ModelLoader loader(2, 1000);
+    auto models = loader.Load(files, [](const void*, size_t size) {
+        return std::make_shared<EchoModel>(1, std::vector<size_t>{size});
+    });
+    EXPECT_EQ(models.size(), 2);
+}
+
+TEST_F(TestModelLoader, Failures)
+{
+    auto files = ModelLoader::FileMap{{"good", Write("good.engine", 10)},
+                                      {"bad", Write("bad.engine", 20)}};
+    ModelLoader loader(2, 1000);
+    EXPECT_THROW(loader.Load(files,
+                             [](const void*, size_t size) -> std::shared_ptr<BaseModel> {
+                                 if(size == 20)
+                                 {
+                                     throw std::runtime_error("corrupt engine");
+                                 }
+                                 return std::make_shared<EchoModel>(1, std::vector<size_t>{1});
+                             }),
+                 std::runtime_error);
+
+    files["missing"] = m_Dir + "/missing.engine";
+    EXPECT_THROW(loader.Load(files,
+                             [](const void*, size_t) {
+                                 return std::make_shared<EchoModel>(1, std::vector<size_t>{1});
+                             }),
+                 std::runtime_error);
+    EXPECT_THROW(ModelLoader::Directory(m_Dir + "/missing"), std::runtime_error);
+}
+
+TEST_F(TestModelLoader, MissingFileDoesNotStopOtherLoads)
+{
+    // the missing file is first in order; the files after it are still loaded before Load throws
+    auto files = ModelLoader::FileMap{{"a", m_Dir + "/missing.engine"},
+                                      {"b", Write("b.engine", 10)},
+                                      {"c", Write("c.engine", 10)}};
+    ModelLoader loader(2, 1000);
+    std::atomic<int> loaded(0);
+    EXPECT_THROW(loader.Load(files,
+                             [&loaded](const void*, size_t) {
+                                 loaded++;
+                                 return std::make_shared<EchoModel>(1, std::vector<size_t>{1});
+                             }),
+                 std::runtime_error);
+    EXPECT_EQ(loaded, 2);
+}
+
+} // namespace
@@ -0,0 +1,192 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/model_registry.h"
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/infer_runner.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+class TestModelRegistry : public ::testing::Test
+{
+  protected:
+    void SetUp() override { m_Registry = ModelRegistry::Create(300); }
+
+    // adds an EchoModel of 100 bytes that counts its loads
+    void AddEcho(const std::string& name)
+    {
+        m_Registry->Add(name,
+                        [this, name] {
+                            m_Loads[name]++;
+                            return std::make_shared<EchoModel>(1, std::vector<size_t>{4});
+                        },
+                        100);
+    }
+
+    std::shared_ptr<ModelRegistry> m_Registry;
+    std::map<std::string, int> m_Loads;
+};
+
+TEST_F(TestModelRegistry, LoadsOnFirstUse)
+{
+    AddEcho("a");
+    EXPECT_FALSE(m_Registry->IsLoaded("a"));
+    EXPECT_EQ(m_Registry->Resident(), 0);
+
+    m_Registry->Acquire("a");
+    m_Registry->Acquire("a");
+    EXPECT_TRUE(m_Registry->IsLoaded("a"));
+    EXPECT_EQ(m_Loads["a"], 1);
+    EXPECT_EQ(m_Registry->Resident(), 100);
+    EXPECT_EQ(m_Registry->GetStats().hits, 1);
+}
+
+TEST_F(TestModelRegistry, EvictsLeastRecentlyUsed)
+{
+    for(auto name : {"a", "b", "c", "d"})
+    {
+        AddEcho(name);
+    }
+    m_Registry->Acquire("a");
+    m_Registry->Acquire("b");
+    m_Registry->Acquire("c");
+    m_Registry->Acquire("a");
+
+    m_Registry->Acquire("d");
+    EXPECT_FALSE(m_Registry->IsLoaded("b"));
+    EXPECT_TRUE(m_Registry->IsLoaded("a"));
+    EXPECT_TRUE(m_Registry->IsLoaded("c"));
+    EXPECT_EQ(m_Registry->Resident(), 300);
+
+    m_Registry->Acquire("b");
+    EXPECT_FALSE(m_Registry->IsLoaded("c"));
+    EXPECT_EQ(m_Loads["b"], 2);
+    EXPECT_EQ(m_Registry->GetStats().evictions, 2);
+}
+
+TEST_F(TestModelRegistry, ModelsInUseAreNotEvicted)
+{
+    for(auto name : {"a", "b", "c", "d"})
+    {
+        AddEcho(name);
+    }
+    auto a = m_Registry->Acquire("a");
+    auto b = m_Registry->Acquire("b");
+    auto c = m_Registry->Acquire("c");
+    auto d = std::async(std::launch::async, [this] { return m_Registry->Acquire("d"); });
+    EXPECT_EQ(d.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+    EXPECT_EQ(m_Registry->Resident(), 300);
+
+    b.reset();
+    d.get();
+    EXPECT_FALSE(m_Registry->IsLoaded("b"));
+    EXPECT_TRUE(m_Registry->IsLoaded("a"));
+}
+
+TEST_F(TestModelRegistry, PinnedModelsAreNotEvicted)
+{
+    for(auto name : {"a", "b", "c", "d"})
+    {
+        AddEcho(name);
+    }
+    m_Registry->Pin("a");
+    m_Registry->Acquire("a");
+    m_Registry->Acquire("b");
+    m_Registry->Acquire("c");
+    m_Registry->Acquire("d");
+    m_Registry->Acquire("b");
+    EXPECT_TRUE(m_Registry->IsLoaded("a"));
+    EXPECT_EQ(m_Loads["a"], 1);
+
+    m_Registry->Add("large", [] { return std::make_shared<EchoModel>(1, std::vector<size_t>{4}); },
+                    250);
+    EXPECT_THROW(m_Registry->Acquire("large"), std::runtime_error);
+    m_Registry->Pin("a", false);
+    m_Registry->Acquire("large");
+    EXPECT_FALSE(m_Registry->IsLoaded("a"));
+}
+
+TEST_F(TestModelRegistry, MeasuredSize)
+{
+    // 16 x 4 weights and 4 biases
+    m_Registry->Add("dense", [] { return std::make_shared<DenseModel>(1, 16, 4); });
+    m_Registry->Acquire("dense");
+    EXPECT_EQ(m_Registry->Resident(), (16 * 4 + 4) * sizeof(float));
+}
+
+TEST_F(TestModelRegistry, MeasuredSizeExceedsBudget)
+{
+    auto registry = ModelRegistry::Create(1024);
+    registry->Add("dense", [] { return std::make_shared<DenseModel>(1, 64, 64); });
+    EXPECT_THROW(registry->Acquire("dense"), std::runtime_error);
+    EXPECT_FALSE(registry->IsLoaded("dense"));
+    EXPECT_EQ(registry->Resident(), 0);
+}
+
+TEST_F(TestModelRegistry, RegistersWithInferenceManager)
+{
+    auto resources = std::make_shared<InferenceManager>(1, 2);
+    resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+    resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+    resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(1));
+    // size the resources for the largest model
+    resources->RegisterModel("template", std::make_shared<EchoModel>(1, std::vector<size_t>{4}));
+    resources->AllocateResources();
+    resources->UnregisterModel("template");
+
+    auto registry = ModelRegistry::Create(100, resources);
+    registry->Add("a", [] { return std::make_shared<EchoModel>(1, std::vector<size_t>{4}); }, 100);
+    registry->Add("b", [] { return std::make_shared<EchoModel>(1, std::vector<size_t>{4}); }, 100);
+
+    for(auto name : {"a", "b", "a"})
+    {
+        InferRunner runner(registry->Acquire(name), resources);
+        auto future = runner.Infer(
+            [](Bindings& bindings) {
+                bindings.SetBatchSize(1);
+                static_cast<float*>(bindings.HostAddress(0))[3] = 42.0f;
+            },
+            [](std::shared_ptr<Bindings>& bindings) {
+                return static_cast<float*>(bindings->HostAddress(1))[3];
+            });
+        EXPECT_EQ(future.get(), 42.0f);
+    }
+    EXPECT_EQ(registry->GetStats().evictions, 2);
+    int count = 0;
+    resources->ForEachModel([&count](const BaseModel&) { count++; });
+    EXPECT_EQ(count, 1);
+}
+
+} // namespace
@@ -0,0 +1,353 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/model_repository.h"
+#include "tensorrt/laboratory/host_model.h"
+
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+static const char* kEchoConfig = R"(
+# echo model
+name: "echo"
+platform: "tensorrt_plan"
+max_batch_size: 4
+input [
+  {
+    name: "input"
+    data_type: TYPE_FP32
+    dims: [ 2 ]
+  }
+]
+output { name: "output", data_type: TYPE_FP32, dims: 2 }
+instance_group [ { count: 1 }, { count: 1, gpus: [ 0 ] } ]
+)";
+
+class TestModelRepository : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Path = "/tmp/trtlab_test_model_repository." + std::to_string(getpid());
+        Remove();
+        mkdir(m_Path.c_str(), 0700);
+
+        m_Resources = std::make_shared<InferenceManager>(2, 4);
+        m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(1));
+
+        // the stub runtime: a model file holds the size of the echo bindings
+        m_Repository = std::make_unique<ModelRepository>(
+            m_Path, m_Resources, [](const std::string& path) {
+                std::ifstream file(path);
+                size_t size;
+                file >> size;
+                return std::make_shared<EchoModel>(8, std::vector<size_t>{size});
+            });
+    }
+
+    void TearDown() override
+    {
+        m_Repository.reset();
+        m_Resources.reset();
+        Remove();
+    }
+
+    void Remove() { std::system(("rm -rf " + m_Path).c_str()); }
+
+    void WriteConfig(const std::string& model, const std::string& text)
+    {
+        mkdir((m_Path + "/" + model).c_str(), 0700);
+        std::ofstream(m_Path + "/" + model + "/config.pbtxt") << text;
+    }
+
+    void WriteVersion(const std::string& model, int version, size_t size)
+    {
+        auto dir = m_Path + "/" + model + "/" + std::to_string(version);
+        mkdir(dir.c_str(), 0700);
+        std::ofstream(dir + "/model.plan") << size;
+    }
+
+    void RemoveVersion(const std::string& model, int version)
+    {
+        std::system(("rm -rf " + m_Path + "/" + model + "/" + std::to_string(version)).c_str());
+    }
+
+    size_t Registered()
+    {
+        size_t count = 0;
+        m_Resources->ForEachModel([&count](const BaseModel&) { count++; });
+        return count;
+    }
+
+    std::string m_Path;
+    std::shared_ptr<InferenceManager> m_Resources;
+    std::unique_ptr<ModelRepository> m_Repository;
+};
+
+TEST_F(TestModelRepository, ParseConfig)
+{
+    auto config = ModelConfig::Parse(std::string(kEchoConfig) + R"(
+default_model_filename: 'echo.plan'
+version_policy { specific { versions: [1, 3] } }
+dynamic_batching {
+  preferred_batch_size: [ 2, 4 ]
+  max_queue_delay_microseconds: 100
+}
+cc_model_filenames { key: "7.0" value: "echo_sm70.plan" }
+)");
+    EXPECT_EQ(config.name, "echo");
+    EXPECT_EQ(config.platform, "tensorrt_plan");
+    EXPECT_EQ(config.max_batch_size, 4);
+    ASSERT_EQ(config.inputs.size(), 1);
+    EXPECT_EQ(config.inputs[0].name, "input");
+    EXPECT_EQ(config.inputs[0].data_type, "TYPE_FP32");
+    EXPECT_EQ(config.inputs[0].dims, std::vector<int64_t>{2});
+    ASSERT_EQ(config.outputs.size(), 1);
+    EXPECT_EQ(config.outputs[0].dims, std::vector<int64_t>{2});
+    EXPECT_EQ(config.instance_count, 2);
+    EXPECT_EQ(config.default_model_filename, "echo.plan");
+    EXPECT_EQ(config.version_policy, ModelConfig::VersionPolicy::kSpecific);
+    EXPECT_EQ(config.versions, (std::vector<int64_t>{1, 3}));
+    EXPECT_TRUE(config.dynamic_batching);
+    EXPECT_EQ(config.batching.max_batch_size, 4);
+    EXPECT_EQ(config.batching.max_queue_delay, std::chrono::microseconds(100));
+    EXPECT_EQ(config.batching.preferred_batch_sizes, (std::vector<uint32_t>{2, 4}));
+
+    config = ModelConfig::Parse("version_policy: { all {} }");
+    EXPECT_EQ(config.version_policy, ModelConfig::VersionPolicy::kAll);
+    EXPECT_FALSE(config.dynamic_batching);
+
+    EXPECT_THROW(ModelConfig::Parse("name: \"echo"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("input { name: \"input\""), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("max_batch_size: eight"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("dims: [1, 2"), std::runtime_error);
+
+    // fields model_config.proto does not declare are rejected at every level
+    EXPECT_THROW(ModelConfig::Parse("max_batch_szie: 8"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("instance_groups { count: 1 }"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("dynamic_batchng {}"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("input { name: \"input\" dim: 2 }"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("instance_group { cuont: 1 }"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("version_policy { latest { versions: 2 } }"),
+                 std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("dynamic_batching { max_queue_delay: 100 }"),
+                 std::runtime_error);
+
+    // counts are unsigned
+    EXPECT_THROW(ModelConfig::Parse("instance_group { count: -1 }"), std::runtime_error);
+    EXPECT_THROW(ModelConfig::Parse("version_policy { latest { num_versions: -1 } }"),
+                 std::runtime_error);
+}
+
+TEST_F(TestModelRepository, ValidateConfig)
+{
+    EchoModel model(8, {2});
+    auto config = ModelConfig::Parse(kEchoConfig);
+    config.Validate(model);
+
+    auto invalid = config;
+    invalid.max_batch_size = 16;
+    EXPECT_THROW(invalid.Validate(model), std::runtime_error);
+
+    invalid = config;
+    invalid.inputs[0].dims = {3};
+    EXPECT_THROW(invalid.Validate(model), std::runtime_error);
+
+    invalid = config;
+    invalid.inputs[0].dims = {-1};
+    invalid.Validate(model);
+
+    invalid = config;
+    invalid.outputs[0].data_type = "TYPE_INT32";
+    EXPECT_THROW(invalid.Validate(model), std::runtime_error);
+
+    invalid = config;
+    invalid.outputs[0].name = "input";
+    EXPECT_THROW(invalid.Validate(model), std::runtime_error);
+
+    invalid = config;
+    invalid.outputs.clear();
+    EXPECT_THROW(invalid.Validate(model), std::runtime_error);
+
+    invalid = config;
+    invalid.platform = "tensorflow_graphdef";
+    EXPECT_THROW(invalid.Validate(model), std::runtime_error);
+}
+
+TEST_F(TestModelRepository, LoadsVersionsByPolicy)
+{
+    WriteConfig("echo", kEchoConfig);
+    WriteVersion("echo", 1, 2);
+    WriteVersion("echo", 2, 2);
+    WriteConfig("all", "version_policy { all {} }");
+    WriteVersion("all", 1, 4);
+    WriteVersion("all", 7, 4);
+    mkdir((m_Path + "/no_config").c_str(), 0700);
+
+    m_Repository->Poll();
+    EXPECT_EQ(m_Repository->Models(), (std::vector<std::string>{"all", "echo"}));
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{2});
+    EXPECT_EQ(m_Repository->Versions("all"), (std::vector<int64_t>{1, 7}));
+    EXPECT_EQ(m_Repository->GetConfig("echo").instance_count, 2);
+    EXPECT_EQ(m_Repository->GetModel("all"), m_Repository->GetModel("all", 7));
+    EXPECT_EQ(m_Resources->GetModel(ModelRepository::RegisteredName("echo", 2)),
+              m_Repository->GetModel("echo"));
+    EXPECT_THROW(m_Repository->GetModel("echo", 1), std::runtime_error);
+    EXPECT_THROW(m_Repository->GetModel("no_config"), std::runtime_error);
+}
+
+TEST_F(TestModelRepository, AddsAndRemovesVersions)
+{
+    WriteConfig("echo", kEchoConfig);
+    WriteVersion("echo", 1, 2);
+    m_Repository->Poll();
+    auto v1 = m_Repository->GetModel("echo");
+
+    WriteVersion("echo", 2, 2);
+    m_Repository->Poll();
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{2});
+    EXPECT_NE(m_Repository->GetModel("echo"), v1);
+    // the unloaded version stays registered while it is in use
+    EXPECT_EQ(Registered(), 2);
+
+    // an invalid version is not served and the previous version stays loaded
+    WriteVersion("echo", 3, 5);
+    m_Repository->Poll();
+    m_Repository->Poll();
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{2});
+
+    // version 1 is added back once its previous instance is released
+    RemoveVersion("echo", 3);
+    RemoveVersion("echo", 2);
+    m_Repository->Poll();
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{2});
+    v1.reset();
+    EXPECT_EQ(Registered(), 1);
+    m_Repository->Poll();
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{1});
+
+    // an invalid config keeps the loaded versions
+    WriteConfig("echo", "max_batch_size: [");
+    m_Repository->Poll();
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{1});
+
+    std::system(("rm -rf " + m_Path + "/echo").c_str());
+    m_Repository->Poll();
+    EXPECT_TRUE(m_Repository->Models().empty());
+}
+
+TEST_F(TestModelRepository, Watch)
+{
+    WriteConfig("echo", kEchoConfig);
+    m_Repository->Watch(std::chrono::milliseconds(5));
+
+    WriteVersion("echo", 1, 2);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(m_Repository->Versions("echo").empty() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(m_Repository->Versions("echo"), std::vector<int64_t>{1});
+    m_Repository->StopWatching();
+}
+
+TEST_F(TestModelRepository, DynamicBatching)
+{
+    WriteConfig("echo", kEchoConfig);
+    WriteVersion("echo", 1, 2);
+    WriteConfig("batched", std::string(kEchoConfig) + R"(
+dynamic_batching { max_queue_delay_microseconds: 1000000 }
+)");
+    // the name in the config must match the directory
+    m_Repository->Poll();
+    EXPECT_TRUE(m_Repository->Models() == std::vector<std::string>{"echo"});
+
+    WriteConfig("batched", R"(
+max_batch_size: 4
+dynamic_batching { max_queue_delay_microseconds: 1000000 }
+)");
+    WriteVersion("batched", 1, 2);
+    m_Repository->Poll();
+    m_Resources->AllocateResources();
+
+    EXPECT_EQ(m_Repository->GetBatcher("echo"), nullptr);
+    auto batcher = m_Repository->GetBatcher("batched");
+    ASSERT_NE(batcher, nullptr);
+    EXPECT_EQ(batcher, m_Repository->GetBatcher("batched", 1));
+
+    // the config's max_batch_size of 4 dispatches before the queue delay
+    std::vector<std::shared_future<float>> futures;
+    for(int i = 0; i < 4; i++)
+    {
+        futures.push_back(batcher->Infer(
+            [i](BatchItem& item) { static_cast<float*>(item.HostAddress("input"))[0] = i; },
+            [](BatchItem& item) { return static_cast<float*>(item.HostAddress("output"))[0]; }));
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(futures[i].wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(futures[i].get(), i);
+    }
+    EXPECT_EQ(batcher->GetStats().batch_sizes[4], 1);
+
+    // an unloaded version keeps serving the batcher it handed out until it is released
+    RemoveVersion("batched", 1);
+    m_Repository->Poll();
+    EXPECT_THROW(m_Repository->GetBatcher("batched"), std::runtime_error);
+    EXPECT_EQ(Registered(), 2);
+    futures.clear();
+    for(int i = 0; i < 4; i++)
+    {
+        futures.push_back(batcher->Infer(
+            [i](BatchItem& item) { static_cast<float*>(item.HostAddress("input"))[0] = i; },
+            [](BatchItem& item) { return static_cast<float*>(item.HostAddress("output"))[0]; }));
+    }
+    for(int i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(futures[i].wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(futures[i].get(), i);
+    }
+    batcher.reset();
+    EXPECT_EQ(Registered(), 1);
+}
+
+} // namespace
@@ -0,0 +1,214 @@
+/* Copyright (c) 2018-2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "tensorrt/laboratory/host_model.h"
+#include "tensorrt/laboratory/inference_manager.h"
+#include "tensorrt/laboratory/sequence_batcher.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace trtlab;
+using namespace trtlab::TensorRT;
+
+namespace {
+
+// Stateful stub; OUTPUT is the running sum of INPUT over the sequence of each batch item
+class AccumulatorModel final : public HostModel
+{
+  public:
+    AccumulatorModel(int max_batch_size) : HostModel(max_batch_size), m_State(max_batch_size)
+    {
+        AddHostBinding("INPUT", true, {1});
+        AddHostBinding("START", true, {1}, nvinfer1::DataType::kINT32);
+        AddHostBinding("READY", true, {1}, nvinfer1::DataType::kINT32);
+        AddHostBinding("OUTPUT", false, {1});
+    }
+    ~AccumulatorModel() final override {}
+
+    void Execute(Bindings& bindings) const final override
+    {
+        auto input = static_cast<const float*>(bindings.HostAddress(BindingId("INPUT")));
+        auto start = static_cast<const int32_t*>(bindings.HostAddress(BindingId("START")));
+        auto ready = static_cast<const int32_t*>(bindings.HostAddress(BindingId("READY")));
+        auto output = static_cast<float*>(bindings.HostAddress(BindingId("OUTPUT")));
+        for(uint32_t i = 0; i < BatchSize(bindings); i++)
+        {
+            if(!ready[i])
+            {
+                continue;
+            }
+            m_State[i] = (start[i] ? 0.0f : m_State[i]) + input[i];
+            output[i] = m_State[i];
+        }
+    }
+
+  private:
+    mutable std::vector<float> m_State;
+};
+
+class TestSequenceBatcher : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_Resources = std::make_shared<InferenceManager>(1, 2);
+        m_Resources->RegisterThreadPool("pre", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("cuda", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterThreadPool("post", std::make_unique<ThreadPool>(1));
+        m_Resources->RegisterModel("accumulator", std::make_shared<AccumulatorModel>(4));
+        m_Resources->AllocateResources();
+    }
+
+    void TearDown() override { m_Resources.reset(); }
+
+    std::shared_future<float> Send(SequenceBatcher& batcher, uint64_t id, uint32_t flags,
+                                   float value)
+    {
+        return batcher.Infer(
+            id, flags,
+            [value](BatchItem& item) {
+                *static_cast<float*>(item.HostAddress("INPUT")) = value;
+            },
+            [](BatchItem& item) -> float {
+                return *static_cast<float*>(item.HostAddress("OUTPUT"));
+            });
+    }
+
+    std::shared_ptr<BaseModel> Model() { return m_Resources->GetModel("accumulator"); }
+
+    std::shared_ptr<InferenceManager> m_Resources;
+};
+
+TEST_F(TestSequenceBatcher, SequencesKeepTheirSlot)
+{
+    SequenceBatchingPolicy policy;
+    policy.max_queue_delay = std::chrono::milliseconds(50);
+    SequenceBatcher batcher(Model(), m_Resources, policy);
+    EXPECT_EQ(batcher.MaxSequences(), 4);
+
+    const std::vector<uint64_t> ids = {101, 202, 303};
+    std::vector<std::vector<std::shared_future<float>>> futures(ids.size());
+    std::vector<int> slots;
+    for(int step = 0; step < 5; step++)
+    {
+        for(size_t s = 0; s < ids.size(); s++)
+        {
+            uint32_t flags = SequenceBatcher::kNone;
+            if(step == 0) flags |= SequenceBatcher::kStart;
+            if(step == 4) flags |= SequenceBatcher::kEnd;
+            futures[s].push_back(Send(batcher, ids[s], flags, static_cast<float>(s + 1)));
+            if(step == 0)
+            {
+                slots.push_back(batcher.Slot(ids[s]));
+            }
+            else if(step < 4)
+            {
+                EXPECT_EQ(batcher.Slot(ids[s]), slots[s]);
+            }
+        }
+    }
+    for(size_t s = 0; s < ids.size(); s++)
+    {
+        for(int step = 0; step < 5; step++)
+        {
+            EXPECT_FLOAT_EQ(futures[s][step].get(), (s + 1) * (step + 1));
+        }
+    }
+
+    auto stats = batcher.GetStats();
+    EXPECT_EQ(stats.requests, 15);
+    EXPECT_EQ(stats.sequences_started, 3);
+    EXPECT_EQ(stats.sequences_ended, 3);
+    EXPECT_EQ(stats.active_sequences, 0);
+    // requests of different sequences are batched into the same steps
+    EXPECT_LT(stats.steps, stats.requests);
+    EXPECT_GE(stats.steps, 5);
+}
+
+TEST_F(TestSequenceBatcher, RejectsRequestsOutsideASequence)
+{
+    SequenceBatcher batcher(Model(), m_Resources);
+    EXPECT_THROW(Send(batcher, 1, SequenceBatcher::kNone, 1.0f), std::runtime_error);
+
+    auto first = Send(batcher, 1, SequenceBatcher::kStart, 1.0f);
+    EXPECT_THROW(Send(batcher, 1, SequenceBatcher::kStart, 1.0f), std::runtime_error);
+    auto last = Send(batcher, 1, SequenceBatcher::kEnd, 2.0f);
+    EXPECT_THROW(Send(batcher, 1, SequenceBatcher::kNone, 1.0f), std::runtime_error);
+
+    // the correlation id can be reused once the sequence ended; the state starts over
+    auto reused = Send(batcher, 1, SequenceBatcher::kStart | SequenceBatcher::kEnd, 5.0f);
+    EXPECT_FLOAT_EQ(first.get(), 1.0f);
+    EXPECT_FLOAT_EQ(last.get(), 3.0f);
+    EXPECT_FLOAT_EQ(reused.get(), 5.0f);
+}
+
+TEST_F(TestSequenceBatcher, SequencesWaitForAFreeSlot)
+{
+    SequenceBatchingPolicy policy;
+    policy.max_sequences = 1;
+    SequenceBatcher batcher(Model(), m_Resources, policy);
+
+    auto a0 = Send(batcher, 1, SequenceBatcher::kStart, 1.0f);
+    auto b0 = Send(batcher, 2, SequenceBatcher::kStart, 10.0f);
+    auto b1 = Send(batcher, 2, SequenceBatcher::kEnd, 10.0f);
+    EXPECT_EQ(batcher.Slot(1), 0);
+    EXPECT_EQ(batcher.Slot(2), -1);
+    EXPECT_FLOAT_EQ(a0.get(), 1.0f);
+    EXPECT_EQ(batcher.GetStats().waiting_sequences, 1);
+
+    auto a1 = Send(batcher, 1, SequenceBatcher::kEnd, 1.0f);
+    EXPECT_FLOAT_EQ(a1.get(), 2.0f);
+    EXPECT_FLOAT_EQ(b0.get(), 10.0f);
+    EXPECT_FLOAT_EQ(b1.get(), 20.0f);
+    EXPECT_EQ(batcher.GetStats().waiting_sequences, 0);
+}
+
+TEST_F(TestSequenceBatcher, IdleSequencesTimeOut)
+{
+    SequenceBatchingPolicy policy;
+    policy.max_sequences = 1;
+    policy.idle_timeout = std::chrono::milliseconds(20);
+    SequenceBatcher batcher(Model(), m_Resources, policy);
+
+    EXPECT_FLOAT_EQ(Send(batcher, 1, SequenceBatcher::kStart, 1.0f).get(), 1.0f);
+    // the idle sequence gives its only slot to the waiting one
+    auto other = Send(batcher, 2, SequenceBatcher::kStart | SequenceBatcher::kEnd, 7.0f);
+    EXPECT_EQ(other.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_FLOAT_EQ(other.get(), 7.0f);
+
+    EXPECT_THROW(Send(batcher, 1, SequenceBatcher::kNone, 1.0f), std::runtime_error);
+    auto stats = batcher.GetStats();
+    EXPECT_EQ(stats.sequences_timed_out, 1);
+    EXPECT_EQ(stats.sequences_ended, 1);
+}
+
+} // namespace